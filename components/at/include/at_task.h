@@ -1,19 +1,21 @@
 #ifndef AT_TASK_H_
 #define AT_TASK_H_
 
+#include <driver/uart.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
-#define AT_TASK_RX_BUFFER_SIZE 256
+#define AT_TASK_RX_BUFFER_SIZE 256
+#define AT_TASK_RX_SPAN_SIZE   64
 #define AT_TASK_TX_BUFFER_SIZE 0
 
 /**
  * @brief Start AT task
  *
- * @param file
+ * @param port uart number
  * @return TaskHandle_t
  */
-TaskHandle_t at_task_start(int fd);
+TaskHandle_t at_task_start(uart_port_t port);
 
 /**
  * @brief Stop AT task
@@ -1,6 +1,7 @@
 #ifndef AT_H_
 #define AT_H_
 
+#include <driver/uart.h>
 #include <sys/queue.h>
 
 #include "cat.h"
@@ -11,14 +12,23 @@
 
 #define AT_TASK_CONTEXT_INDEX 1
 
+#define AT_TASK_IO_BUF_SIZE 128
+
+#define AT_TASK_REPORT_BUF_SIZE 256
+
+#define AT_SUBSCRIBE_TICK_MS 250
+
 /**
  * @brief AT subscribe read command entry
  *
  */
 typedef struct at_subscribe_entry_s {
     const struct cat_command* command;
-    uint32_t period;
-    TickType_t last_tick;
+    uint32_t period;     // in AT_SUBSCRIBE_TICK_MS ticks
+    uint32_t next_tick;  // in AT_SUBSCRIBE_TICK_MS ticks, multiple of period
+    uint32_t last_hash;
+    bool on_change : 1;
+    bool reported : 1;
     SLIST_ENTRY(at_subscribe_entry_s) entries;
 } at_subscribe_entry_t;
 
@@ -43,10 +53,24 @@ typedef struct {
     uint8_t aux_output_index;
     uint8_t aux_analog_input_index;
     bool can_read : 1;
-    int fd;
+    uart_port_t port;
+    const uint8_t* rx_data;  // receive span of serial port
+    size_t rx_pos;
+    size_t rx_len;
+    char tx_buf[AT_TASK_IO_BUF_SIZE];
+    uint8_t tx_len;
+    bool capture : 1;
+    bool join_reports : 1;    // all due subscriptions in one line
+    bool report_sep : 1;      // separator before next joined response
+    bool report_open : 1;     // joined line is partially written
+    bool report_flushed : 1;  // part of current response is written
+    char report_buf[AT_TASK_REPORT_BUF_SIZE];
+    uint16_t report_len;
+    uint16_t report_start;  // start of current response
+    uint32_t report_hash;   // of current response
 } at_task_context_t;
 
-bool at_task_context_subscribe(at_task_context_t* context, const char* command_name, uint32_t period);
+bool at_task_context_subscribe(at_task_context_t* context, const char* command_name, uint32_t period, bool on_change);
 
 bool at_task_context_unsubscribe(at_task_context_t* context, const char* command_name);
 
@@ -31,15 +31,40 @@ static struct cat_variable vars_subscribe[] = {
         .data_size = sizeof(var_u32_1),
         .access = CAT_VAR_ACCESS_WRITE_ONLY,
     },
+    {
+        .type = CAT_VAR_UINT_DEC,
+        .data = &var_u8_1,
+        .data_size = sizeof(var_u8_1),
+        .access = CAT_VAR_ACCESS_WRITE_ONLY,
+    },
 };
 
 static cat_return_state vars_subscribe_write(const struct cat_command* cmd, const uint8_t* data, const size_t data_size, const size_t args_num)
 {
     at_task_context_t* context = (at_task_context_t*)pvTaskGetThreadLocalStoragePointer(NULL, AT_TASK_CONTEXT_INDEX);
 
-    return at_task_context_subscribe(context, var_str32_1, var_u32_1) ? CAT_RETURN_STATE_OK : CAT_RETURN_STATE_ERROR;
+    // optional third argument, report only changed values
+    bool on_change = args_num > 2 && var_u8_1;
+
+    return at_task_context_subscribe(context, var_str32_1, var_u32_1, on_change) ? CAT_RETURN_STATE_OK : CAT_RETURN_STATE_ERROR;
+}
+
+static uint8_t subscribe_join_get(void)
+{
+    at_task_context_t* context = (at_task_context_t*)pvTaskGetThreadLocalStoragePointer(NULL, AT_TASK_CONTEXT_INDEX);
+
+    return context->join_reports;
 }
 
+static void subscribe_join_set(uint8_t value)
+{
+    at_task_context_t* context = (at_task_context_t*)pvTaskGetThreadLocalStoragePointer(NULL, AT_TASK_CONTEXT_INDEX);
+
+    context->join_reports = value;
+}
+
+DEF_AT_VARS_RW_NO_CHECK(vars_subscribe_join, CAT_VAR_UINT_DEC, var_u8_1, subscribe_join_get, subscribe_join_set);
+
 static struct cat_variable vars_unsubscribe[] = { {
     .type = CAT_VAR_BUF_STRING,
     .data = var_str32_1,
@@ -80,6 +105,12 @@ static struct cat_command cmds[] = {
         .write = vars_unsubscribe_write,
         .need_all_vars = false,
     },
+    {
+        .name = "+SUBJOIN",
+        .var = vars_subscribe_join,
+        .var_num = sizeof(vars_subscribe_join) / sizeof(vars_subscribe_join[0]),
+        .need_all_vars = true,
+    },
 };
 
 struct cat_command_group at_cmd_basic_group = {
@@ -6,6 +6,7 @@
 #include <sys/time.h>
 
 #include "cat.h"
+#include "logger.h"
 #include "schedule_restart.h"
 #include "scheduler.h"
 #include "temp_sensor.h"
@@ -262,6 +263,75 @@ static struct cat_variable vars_uptime[] = {
     },
 };
 
+static int vars_syslog_read(const struct cat_variable* var)
+{
+    var_u8_1 = logger_is_syslog_enabled();
+    logger_get_syslog_host(var_str32_1, sizeof(var_str32_1));
+    var_u16_1 = logger_get_syslog_port();
+    strlcpy(var_str32_2, logger_syslog_format_to_str(logger_get_syslog_format()), sizeof(var_str32_2));
+    var_u16_2 = logger_get_syslog_rate();
+
+    return 0;
+}
+
+static struct cat_variable vars_syslog[] = {
+    {
+        .type = CAT_VAR_UINT_DEC,
+        .data = &var_u8_1,
+        .data_size = sizeof(var_u8_1),
+        .access = CAT_VAR_ACCESS_READ_WRITE,
+        .read = vars_syslog_read,
+    },
+    {
+        .type = CAT_VAR_BUF_STRING,
+        .data = var_str32_1,
+        .data_size = sizeof(var_str32_1),
+        .access = CAT_VAR_ACCESS_READ_WRITE,
+    },
+    {
+        .type = CAT_VAR_UINT_DEC,
+        .data = &var_u16_1,
+        .data_size = sizeof(var_u16_1),
+        .access = CAT_VAR_ACCESS_READ_WRITE,
+    },
+    {
+        .type = CAT_VAR_BUF_STRING,
+        .data = var_str32_2,
+        .data_size = sizeof(var_str32_2),
+        .access = CAT_VAR_ACCESS_READ_WRITE,
+    },
+    {
+        .type = CAT_VAR_UINT_DEC,
+        .data = &var_u16_2,
+        .data_size = sizeof(var_u16_2),
+        .access = CAT_VAR_ACCESS_READ_WRITE,
+    },
+};
+
+static cat_return_state vars_syslog_write(const struct cat_command* cmd, const uint8_t* data, const size_t data_size, const size_t args_num)
+{
+    bool enabled = var_u8_1 > 0;
+    const char* host = NULL;
+    uint16_t port = logger_get_syslog_port();
+    logger_syslog_format_t format = logger_get_syslog_format();
+    uint16_t rate = logger_get_syslog_rate();
+
+    if (args_num > 1) {
+        host = var_str32_1;
+    }
+    if (args_num > 2) {
+        port = var_u16_1;
+    }
+    if (args_num > 3) {
+        format = logger_str_to_syslog_format(var_str32_2);
+    }
+    if (args_num > 4) {
+        rate = var_u16_2;
+    }
+
+    return logger_set_syslog_config(enabled, host, port, format, rate) == ESP_OK ? CAT_RETURN_STATE_OK : CAT_RETURN_STATE_ERROR;
+}
+
 static struct cat_command cmds[] = {
     {
         .name = "+RST",
@@ -317,6 +387,12 @@ static struct cat_command cmds[] = {
         .var = vars_uptime,
         .var_num = sizeof(vars_uptime) / sizeof(vars_uptime[0]),
     },
+    {
+        .name = "+SYSLOG",
+        .var = vars_syslog,
+        .var_num = sizeof(vars_syslog) / sizeof(vars_syslog[0]),
+        .write = vars_syslog_write,
+    },
 };
 
 struct cat_command_group at_cmd_system_group = {
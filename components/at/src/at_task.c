@@ -1,17 +1,114 @@
 #include "at_task.h"
 
-#include <unistd.h>
+#include <string.h>
 
 #include "at.h"
+#include "serial_port.h"
 
-#define BUF_SIZE  256
-#define READY_MSG "\n\nRDY\n"
+#define BUF_SIZE       256
+#define CMD_INDEX_SIZE 128  // power of two, greater than count of commands
+#define READY_MSG      "\n\nRDY\n"
+
+static void flush_tx(at_task_context_t* context)
+{
+    if (context->tx_len > 0) {
+        serial_port_write(context->port, context->tx_buf, context->tx_len);
+        context->tx_len = 0;
+    }
+}
+
+static void put_tx(at_task_context_t* context, char ch)
+{
+    if (context->tx_len >= sizeof(context->tx_buf)) {
+        flush_tx(context);
+    }
+    context->tx_buf[context->tx_len++] = ch;
+}
+
+/**
+ * Write pending responses and report, joined report is enclosed in new lines
+ */
+static void write_report(at_task_context_t* context, size_t len, bool end)
+{
+    bool join = context->join_reports;
+
+    serial_port_iov_t iov[] = {
+        { .data = context->tx_buf, .len = context->tx_len },
+        { .data = "\n", .len = join && !context->report_open ? 1 : 0 },
+        { .data = context->report_buf, .len = len },
+        { .data = "\n", .len = join && end ? 1 : 0 },
+    };
+    serial_port_writev(context->port, iov, sizeof(iov) / sizeof(iov[0]));
+
+    context->tx_len = 0;
+    context->report_open = join && !end;
+}
+
+static void append_report(at_task_context_t* context, char ch)
+{
+    if (context->report_len >= sizeof(context->report_buf)) {
+        if (context->report_start > 0) {
+            // previous responses are complete line, current response continues on new line without separator
+            size_t start = context->report_start;
+            write_report(context, start, true);
+            if (context->report_buf[start] == ';') start++;
+            context->report_len -= start;
+            memmove(context->report_buf, &context->report_buf[start], context->report_len);
+            context->report_start = 0;
+        } else {
+            // single response longer than buffer is written in parts
+            write_report(context, context->report_len, !context->join_reports);
+            context->report_len = 0;
+            context->report_flushed = true;
+        }
+    }
+
+    context->report_buf[context->report_len++] = ch;
+}
+
+/**
+ * Append captured response to report, when joined lines are separated by ';' and ';' in values is escaped as "\;",
+ * cat escapes backslash in string values, so "\;" is not ambiguous
+ */
+static void put_report(at_task_context_t* context, char ch)
+{
+    // FNV-1a of captured response
+    context->report_hash = (context->report_hash ^ (uint8_t)ch) * 16777619;
+
+    if (!context->join_reports) {
+        append_report(context, ch);
+        return;
+    }
+
+    if (ch == '\r') return;
+
+    if (ch == '\n') {
+        context->report_sep = true;
+        return;
+    }
+
+    if (context->report_sep && (context->report_len > 0 || context->report_open)) {
+        append_report(context, ';');
+    }
+    context->report_sep = false;
+
+    if (ch == ';') {
+        append_report(context, '\\');
+    }
+    append_report(context, ch);
+}
 
 static int write_char(char ch)
 {
     at_task_context_t* context = (at_task_context_t*)pvTaskGetThreadLocalStoragePointer(NULL, AT_TASK_CONTEXT_INDEX);
 
-    return write(context->fd, &ch, 1);
+    if (context->capture) {
+        put_report(context, ch);
+    } else {
+        put_tx(context, ch);
+    }
+
+    return 1;
 }
 
 static int read_char(char* ch)
@@ -20,38 +117,79 @@ static int read_char(char* ch)
 
     if (!context->can_read) return 0;
 
-    int readed = read(context->fd, ch, 1) > 0 ? 1 : 0;
+    if (context->rx_pos >= context->rx_len) {
+        // previous span is processed, get what is received up to span size
+        serial_port_consume(context->port, context->rx_len);
+        context->rx_len = serial_port_read_span(context->port, &context->rx_data);
+        context->rx_pos = 0;
+        if (context->rx_len == 0) return 0;
+    }
+
+    *ch = context->rx_data[context->rx_pos++];
 
-    if (readed > 0 && context->echo) {
-        write(context->fd, ch, 1);
-        fsync(context->fd);
+    if (context->echo) {
+        put_tx(context, *ch);
     }
 
-    return readed;
+    return 1;
 }
 
+/**
+ * Due subscriptions are captured, each is written as line, or all are joined to one report line when enabled by AT+SUBJOIN
+ */
 static void handle_subscription(at_task_context_t* context)
 {
-    TickType_t now = xTaskGetTickCount();
+    uint32_t tick = xTaskGetTickCount() / pdMS_TO_TICKS(AT_SUBSCRIBE_TICK_MS);
+
+    context->report_len = 0;
+    context->report_sep = false;
+    context->report_open = false;
 
     at_subscribe_entry_t* entry;
     SLIST_FOREACH (entry, context->subscribe_list, entries) {
-        if ((now - entry->last_tick) >= pdMS_TO_TICKS(entry->period)) {
-            cat_trigger_unsolicited_read(context->at, entry->command);
-            entry->last_tick = now;
+        if ((int32_t)(tick - entry->next_tick) < 0) continue;
 
-            // this prevents overflow of unsolicited buffer, context.can_read must be false
-            while (cat_service(context->at) != 0) {
-            };
+        // align to shared tick, so subscriptions with related periods are due together
+        entry->next_tick = (tick / entry->period + 1) * entry->period;
+
+        context->report_start = context->report_len;
+        context->report_hash = 2166136261;
+        context->report_flushed = false;
+        bool report_sep = context->report_sep;
+
+        context->capture = true;
+        cat_trigger_unsolicited_read(context->at, entry->command);
+
+        // this prevents overflow of unsolicited buffer, context.can_read must be false
+        while (cat_service(context->at) != 0) {
+        };
+        context->capture = false;
+
+        if (entry->on_change && entry->reported && context->report_hash == entry->last_hash && !context->report_flushed) {
+            // unchanged, drop from report
+            context->report_len = context->report_start;
+            context->report_sep = report_sep;
+        }
+        entry->last_hash = context->report_hash;
+        entry->reported = true;
+
+        if (!context->join_reports && context->report_len > 0) {
+            write_report(context, context->report_len, true);
+            context->report_len = 0;
         }
     }
+
+    if (context->report_len > 0 || context->report_open) {
+        write_report(context, context->report_len, true);
+    }
 }
 
 static void at_task_func(void* param)
 {
-    int fd = (int)(intptr_t)param;
+    uart_port_t port = (uart_port_t)(intptr_t)param;
 
     uint8_t buf[BUF_SIZE];
+    uint16_t cmd_index[CMD_INDEX_SIZE];
     struct cat_command_group* cmd_desc[] = AT_CMD_GROUPS;
 
     struct cat_descriptor desc = {
@@ -59,6 +197,8 @@ static void at_task_func(void* param)
         .cmd_group_num = sizeof(cmd_desc) / sizeof(cmd_desc[0]),
         .buf = buf,
         .buf_size = sizeof(buf),
+        .cmd_index = cmd_index,
+        .cmd_index_size = CMD_INDEX_SIZE,
     };
 
     struct cat_io_interface iface = {
@@ -74,41 +214,47 @@ static void at_task_func(void* param)
         .echo = false,
         .wifi_scan_ap_list = NULL,
         .can_read = false,
-        .fd = fd,
+        .port = port,
+        .rx_data = NULL,
+        .rx_pos = 0,
+        .rx_len = 0,
+        .tx_len = 0,
+        .capture = false,
+        .join_reports = false,
+        .report_len = 0,
     };
     context.subscribe_list = (at_subscribe_list_t*)malloc(sizeof(at_subscribe_list_t));
     SLIST_INIT(context.subscribe_list);
 
     vTaskSetThreadLocalStoragePointer(NULL, AT_TASK_CONTEXT_INDEX, &context);
 
-    write(fd, READY_MSG, sizeof(READY_MSG));
+    serial_port_write(port, READY_MSG, sizeof(READY_MSG));
 
     while (true) {
-        struct timeval tv = {
-            .tv_sec = 0,
-            .tv_usec = 250 * 1000,
-        };
-        fd_set read_set;
-        FD_ZERO(&read_set);
-        FD_SET(fd, &read_set);
-
-        if (select(fd + 1, &read_set, NULL, NULL, &tv) > 0) {
-            if (FD_ISSET(fd, &read_set)) {
-                context.can_read = true;
-                while (cat_service(&at) != 0) {
-                };
-                context.can_read = false;
-            }
+        // already received data in rx buffer are processed without waiting
+        bool readable = context.rx_pos < context.rx_len;
+        if (!readable) {
+            readable = serial_port_wait(port, AT_SUBSCRIBE_TICK_MS) != SERIAL_PORT_EVENT_NONE;
+        }
+
+        if (readable) {
+            context.can_read = true;
+            while (cat_service(&at) != 0) {
+            };
+            context.can_read = false;
         }
 
         handle_subscription(&context);
+
+        // responses and echo are written in blocks when parser is idle
+        flush_tx(&context);
     }
 }
 
-TaskHandle_t at_task_start(int fd)
+TaskHandle_t at_task_start(uart_port_t port)
 {
     TaskHandle_t handle = NULL;
-    xTaskCreate(at_task_func, "at", 4 * 1024, (void*)fd, 5, &handle);
+    xTaskCreate(at_task_func, "at", 5 * 1024, (void*)(intptr_t)port, 5, &handle);
     return handle;
 }
 
@@ -134,7 +280,7 @@ void at_task_stop(TaskHandle_t task)
     vTaskDelete(task);
 }
 
-bool at_task_context_subscribe(at_task_context_t* context, const char* command_name, uint32_t period)
+bool at_task_context_subscribe(at_task_context_t* context, const char* command_name, uint32_t period, bool on_change)
 {
     const struct cat_command* command = cat_search_command_by_name(context->at, command_name);
     if (command == NULL) {
@@ -143,18 +289,27 @@ bool at_task_context_subscribe(at_task_context_t* context, const char* command_n
 
     // try update existing subscription if exists
     at_subscribe_entry_t* entry;
+    bool found = false;
     SLIST_FOREACH (entry, context->subscribe_list, entries) {
         if (entry->command == command) {
-            entry->period = period;
-            return true;
+            found = true;
+            break;
         }
     }
 
-    entry = (at_subscribe_entry_t*)malloc(sizeof(at_subscribe_entry_t));
-    entry->command = command;
-    entry->last_tick = 0;
-    entry->period = period;
-    SLIST_INSERT_HEAD(context->subscribe_list, entry, entries);
+    if (!found) {
+        entry = (at_subscribe_entry_t*)malloc(sizeof(at_subscribe_entry_t));
+        entry->command = command;
+        SLIST_INSERT_HEAD(context->subscribe_list, entry, entries);
+    }
+
+    // period is rounded up to whole ticks
+    entry->period = (period + AT_SUBSCRIBE_TICK_MS - 1) / AT_SUBSCRIBE_TICK_MS;
+    if (entry->period == 0) entry->period = 1;
+    entry->next_tick = 0;
+    entry->last_hash = 0;
+    entry->on_change = on_change;
+    entry->reported = false;
 
     return true;
 }
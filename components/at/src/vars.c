@@ -8,6 +8,7 @@ uint8_t var_u8_3;
 uint8_t var_u8_4;
 
 uint16_t var_u16_1;
+uint16_t var_u16_2;
 
 int32_t var_i32_1;
 int32_t var_i32_2;
@@ -75,6 +75,7 @@ extern uint8_t var_u8_3;
 extern uint8_t var_u8_4;
 
 extern uint16_t var_u16_1;
+extern uint16_t var_u16_2;
 
 extern int32_t var_i32_1;
 extern int32_t var_i32_2;
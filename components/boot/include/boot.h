@@ -0,0 +1,72 @@
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BOOT_STAGE_MAX        16
+#define BOOT_REPORT_MAX       24
+#define BOOT_STAGE_BIT(stage) (1UL << (stage))
+
+typedef struct {
+    const char* name;
+    void (*init)(void);
+    uint32_t deps;
+} boot_stage_t;
+
+typedef struct {
+    const char* name;
+    int64_t start;
+    int64_t end;
+} boot_report_entry_t;
+
+/**
+ * @brief Record timing of stage executed directly by caller, from start to now
+ *
+ * @param name static string
+ * @param start esp_timer_get_time when stage started
+ */
+void boot_record(const char* name, int64_t start);
+
+/**
+ * @brief Run stages on worker tasks, stage starts when all stages in deps completed
+ *
+ * @param stages static array, BOOT_STAGE_BIT of index is used in deps
+ * @param count stages count, max BOOT_STAGE_MAX
+ * @param workers number of concurrent worker tasks
+ */
+void boot_run(const boot_stage_t* stages, uint8_t count, uint8_t workers);
+
+/**
+ * @brief Wait until stages completed
+ *
+ * @param stages BOOT_STAGE_BIT mask
+ * @param timeout_ms
+ * @return true when all stages completed
+ */
+bool boot_wait(uint32_t stages, uint32_t timeout_ms);
+
+/**
+ * @brief Return true when stages completed, without blocking
+ *
+ * @param stages BOOT_STAGE_BIT mask
+ * @return true when all stages completed
+ */
+bool boot_is_done(uint32_t stages);
+
+/**
+ * @brief Return true when all stages passed to boot_run completed
+ *
+ */
+bool boot_is_complete(void);
+
+/**
+ * @brief Copy boot report, in order of completion
+ *
+ * @param entries
+ * @param size max entries
+ * @return uint8_t number of copied entries
+ */
+uint8_t boot_get_report(boot_report_entry_t* entries, uint8_t size);
+
+#endif /* BOOT_H_ */
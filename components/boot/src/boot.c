@@ -0,0 +1,135 @@
+#include "boot.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+#include <inttypes.h>
+
+#define WORKER_STACK_SIZE 4096
+#define WORKER_PRIORITY   1
+
+static const char* TAG = "boot";
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static EventGroupHandle_t done_group = NULL;
+
+static const boot_stage_t* stages = NULL;
+
+static uint32_t all_bits = 0;
+
+static uint32_t started_bits = 0;
+
+static boot_report_entry_t report[BOOT_REPORT_MAX];
+
+static uint8_t report_count = 0;
+
+void boot_record(const char* name, int64_t start)
+{
+    int64_t end = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&lock);
+    if (report_count < BOOT_REPORT_MAX) {
+        report[report_count].name = name;
+        report[report_count].start = start;
+        report[report_count].end = end;
+        report_count++;
+    }
+    taskEXIT_CRITICAL(&lock);
+
+    ESP_LOGI(TAG, "Stage %s done in %" PRId64 " ms", name, (end - start) / 1000);
+}
+
+/**
+ * Pick not started stage with all dependencies completed, -1 when none is ready
+ */
+static int take_ready_stage(uint32_t done_bits)
+{
+    int ready = -1;
+
+    taskENTER_CRITICAL(&lock);
+    for (int i = 0; i < BOOT_STAGE_MAX; i++) {
+        uint32_t bit = BOOT_STAGE_BIT(i);
+        if ((all_bits & bit) && !(started_bits & bit) && (stages[i].deps & done_bits) == stages[i].deps) {
+            started_bits |= bit;
+            ready = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&lock);
+
+    return ready;
+}
+
+static void worker_task_func(void* param)
+{
+    while (true) {
+        uint32_t done_bits = xEventGroupGetBits(done_group);
+
+        taskENTER_CRITICAL(&lock);
+        bool pending = (started_bits & all_bits) != all_bits;
+        taskEXIT_CRITICAL(&lock);
+        if (!pending) break;
+
+        int stage = take_ready_stage(done_bits);
+        if (stage < 0) {
+            // wait for any other stage completion
+            xEventGroupWaitBits(done_group, all_bits & ~done_bits, pdFALSE, pdFALSE, portMAX_DELAY);
+            continue;
+        }
+
+        int64_t start = esp_timer_get_time();
+        stages[stage].init();
+        boot_record(stages[stage].name, start);
+
+        xEventGroupSetBits(done_group, BOOT_STAGE_BIT(stage));
+    }
+
+    vTaskDelete(NULL);
+}
+
+void boot_run(const boot_stage_t* boot_stages, uint8_t count, uint8_t workers)
+{
+    stages = boot_stages;
+    started_bits = 0;
+    all_bits = count >= BOOT_STAGE_MAX ? BOOT_STAGE_BIT(BOOT_STAGE_MAX) - 1 : BOOT_STAGE_BIT(count) - 1;
+    done_group = xEventGroupCreate();
+
+    for (uint8_t i = 0; i < workers; i++) {
+        xTaskCreate(worker_task_func, "boot", WORKER_STACK_SIZE, NULL, WORKER_PRIORITY, NULL);
+    }
+}
+
+bool boot_wait(uint32_t stage_bits, uint32_t timeout_ms)
+{
+    if (!done_group) return false;
+
+    EventBits_t bits = xEventGroupWaitBits(done_group, stage_bits, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    return (bits & stage_bits) == stage_bits;
+}
+
+bool boot_is_done(uint32_t stage_bits)
+{
+    if (!done_group) return false;
+
+    return (xEventGroupGetBits(done_group) & stage_bits) == stage_bits;
+}
+
+bool boot_is_complete(void)
+{
+    return boot_is_done(all_bits);
+}
+
+uint8_t boot_get_report(boot_report_entry_t* entries, uint8_t size)
+{
+    taskENTER_CRITICAL(&lock);
+    uint8_t count = report_count < size ? report_count : size;
+    for (uint8_t i = 0; i < count; i++) {
+        entries[i] = report[i];
+    }
+    taskEXIT_CRITICAL(&lock);
+
+    return count;
+}
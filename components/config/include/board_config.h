@@ -14,6 +14,7 @@
 #define BOARD_CFG_SERIAL_COUNT           SOC_UART_NUM
 #define BOARD_CFG_OTA_CHANNEL_COUNT      3
 #define BOARD_CFG_OTA_CHANNEL_NAME_SIZE  16
+#define BOARD_CFG_OTA_CHANNEL_PATH_SIZE  128
 
 #define board_cfg_is_proximity(config)      (config.proximity.adc_channel != -1)
 #define board_cfg_is_ac_relay_l2_l3(config) (config.ac_relay.gpios[BOARD_CFG_AC_RELAY_GPIO_L2_L3] != -1)
@@ -30,7 +31,7 @@
     (config.energy_meter.cur_adc_channel[BOARD_CFG_ENERGY_METER_ADC_CHANNEL_L2] != -1 && config.energy_meter.cur_adc_channel[BOARD_CFG_ENERGY_METER_ADC_CHANNEL_L3] != -1)
 #define board_cfg_is_energy_meter_vlt_3p(config) \
     (config.energy_meter.vlt_adc_channel[BOARD_CFG_ENERGY_METER_ADC_CHANNEL_L2] != -1 && config.energy_meter.vlt_adc_channel[BOARD_CFG_ENERGY_METER_ADC_CHANNEL_L3] != -1)
-#define board_cfg_is_ota_channel(config, idx) (config.ota.channels[idx].path != NULL)
+#define board_cfg_is_ota_channel(config, idx) (config.ota.channels[idx].path[0] != '\0')
 
 typedef enum {
     BOARD_CFG_PILOT_LEVEL_12,
@@ -62,7 +63,7 @@ typedef enum {
 
 typedef struct {
     char name[BOARD_CFG_OTA_CHANNEL_NAME_SIZE];
-    const char* path;
+    char path[BOARD_CFG_OTA_CHANNEL_PATH_SIZE];
 } board_cfg_ota_channel_t;
 
 typedef struct {
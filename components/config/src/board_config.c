@@ -1,27 +1,114 @@
 #include "board_config.h"
 
+#include <esp_app_desc.h>
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+#include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "board_config_parser.h"
 
 #define BOARD_CONFIG_YAML         "/usr/board.yaml"
 #define BOARD_CONFIG_INVALID_YAML "/usr/board_invalid.yaml"
+#define BOARD_CONFIG_BIN          "/usr/board.bin"
+#define BOARD_CONFIG_BIN_MAGIC    0x47464342  // BCFG
+#define BOARD_CONFIG_BIN_VERSION  2
+#define ELF_SHA256_LEN            16  // hex digits, enough to detect another firmware
+#define READ_BUF_SIZE             256
 
 static const char* TAG = "board_config";
 
 extern const char board_yaml_start[] asm("_binary_board_" CONFIG_IDF_TARGET "_yaml_start");
 extern const char board_yaml_end[] asm("_binary_board_" CONFIG_IDF_TARGET "_yaml_end");
 
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t yaml_hash;
+    char elf_sha256[ELF_SHA256_LEN + 1];  // board_cfg_t layout and parser are bound to firmware
+    uint32_t crc;
+} bin_header_t;
+
 board_cfg_t board_config;
 
+static uint32_t file_hash(FILE* file)
+{
+    // FNV-1a of file content
+    uint32_t hash = 2166136261;
+    uint8_t buf[READ_BUF_SIZE];
+    size_t len;
+
+    while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
+        for (size_t i = 0; i < len; i++) {
+            hash = (hash ^ buf[i]) * 16777619;
+        }
+    }
+    rewind(file);
+
+    return hash;
+}
+
+static bool bin_load(uint32_t yaml_hash, board_cfg_t* config)
+{
+    bool ret = false;
+
+    char elf_sha256[ELF_SHA256_LEN + 1];
+    esp_app_get_elf_sha256(elf_sha256, sizeof(elf_sha256));
+
+    FILE* file = fopen(BOARD_CONFIG_BIN, "rb");
+    if (file) {
+        bin_header_t header;
+        if (fread(&header, sizeof(bin_header_t), 1, file) == 1 && header.magic == BOARD_CONFIG_BIN_MAGIC && header.version == BOARD_CONFIG_BIN_VERSION &&
+            header.size == sizeof(board_cfg_t) && header.yaml_hash == yaml_hash && !strncmp(header.elf_sha256, elf_sha256, sizeof(elf_sha256)) &&
+            fread(config, sizeof(board_cfg_t), 1, file) == 1) {
+            ret = esp_rom_crc32_le(0, (uint8_t*)config, sizeof(board_cfg_t)) == header.crc;
+            if (!ret) ESP_LOGW(TAG, "Invalid CRC of " BOARD_CONFIG_BIN);
+        }
+        fclose(file);
+    }
+
+    return ret;
+}
+
+static void bin_store(uint32_t yaml_hash, const board_cfg_t* config)
+{
+    FILE* file = fopen(BOARD_CONFIG_BIN, "wb");
+    if (!file) {
+        ESP_LOGW(TAG, "Can't create " BOARD_CONFIG_BIN);
+        return;
+    }
+
+    bin_header_t header = {
+        .magic = BOARD_CONFIG_BIN_MAGIC,
+        .version = BOARD_CONFIG_BIN_VERSION,
+        .size = sizeof(board_cfg_t),
+        .yaml_hash = yaml_hash,
+        .crc = esp_rom_crc32_le(0, (const uint8_t*)config, sizeof(board_cfg_t)),
+    };
+    esp_app_get_elf_sha256(header.elf_sha256, sizeof(header.elf_sha256));
+
+    bool ok = fwrite(&header, sizeof(bin_header_t), 1, file) == 1 && fwrite(config, sizeof(board_cfg_t), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok) {
+        ESP_LOGW(TAG, "Can't store " BOARD_CONFIG_BIN);
+        remove(BOARD_CONFIG_BIN);
+    }
+}
+
 void board_config_load(bool reset)
 {
+    int64_t start = esp_timer_get_time();
+
     if (reset) {
         ESP_LOGW(TAG, "Removing config");
         rename(BOARD_CONFIG_YAML, BOARD_CONFIG_INVALID_YAML);
+        remove(BOARD_CONFIG_BIN);
     }
 
     FILE* file = fopen(BOARD_CONFIG_YAML, "r");
@@ -32,12 +119,22 @@ void board_config_load(bool reset)
         file = freopen(BOARD_CONFIG_YAML, "r", file);
     }
 
-    esp_err_t ret = board_config_parse_file(file, &board_config);
+    esp_err_t ret = ESP_OK;
+    uint32_t yaml_hash = file_hash(file);
+    bool cached = bin_load(yaml_hash, &board_config);
+    if (!cached) {
+        ret = board_config_parse_file(file, &board_config);
+        if (ret == ESP_OK) {
+            bin_store(yaml_hash, &board_config);
+        }
+    }
     fclose(file);
 
 #ifdef CONFIG_ESP_CONSOLE_UART
     board_config.serials[CONFIG_ESP_CONSOLE_UART_NUM].type = BOARD_CFG_SERIAL_TYPE_NONE;
 #endif /*CONFIG_ESP_CONSOLE_UART*/
 
+    ESP_LOGI(TAG, "Loaded %s in %" PRId64 " us", cached ? "cached config" : "config", esp_timer_get_time() - start);
+
     ESP_ERROR_CHECK(ret);
 }
@@ -27,11 +27,6 @@
         if (condition) strncpy(config->prop, value, size - 1); \
         break;
 
-#define CASE_SET_SEQ_VALUE_STRDUP(level, prop, condition) \
-    case level:                                           \
-        if (condition) config->prop = strdup(value);      \
-        break;
-
 #define CASE_DEFAULT() \
     default:           \
         return false;
@@ -108,9 +103,9 @@ typedef enum {
     KEY_PATH,
     //
     KEY_MAX,
-} key_t;
+} cfg_key_t;
 
-// string values of key_t, must match key_t order
+// string values of cfg_key_t, must match cfg_key_t order
 static const char* keys[] = {
     "deviceName", "leds",        "charging", "error",         "wifi",           "button",       "acRelay",  "pilot",       "proximity",
     "socketLock", "rcm",         "aux",      "inputs",        "outputs",        "analogInputs", "gpio",     "gpios",       "name",
@@ -119,15 +114,68 @@ static const char* keys[] = {
     "ota",        "channels",    "path",
 };
 
-static key_t get_key(const char* key)
+_Static_assert(sizeof(keys) / sizeof(keys[0]) == KEY_MAX, "Wrong keys size");
+
+#define KEY_HASH_SEED  0x13D6F0
+#define KEY_HASH_SHIFT 26
+#define KEY_HASH_SIZE  64
+
+// perfect hash of keys, slot is top bits of FNV-1a with KEY_HASH_SEED, seed was searched so all keys have distinct slot
+// must be regenerated when keys change (sim test_board_config_keys prints new table), empty slots are rejected by string compare in get_key
+static const int8_t key_slots[KEY_HASH_SIZE] = {
+    [0] = KEY_NAME,
+    [1] = KEY_RCM,
+    [3] = KEY_PILOT,
+    [4] = KEY_DEVICE_NAME,
+    [5] = KEY_VOLTAGE,
+    [7] = KEY_WIFI,
+    [8] = KEY_RXD_GPIO,
+    [9] = KEY_LEDS,
+    [10] = KEY_LEVELS,
+    [13] = KEY_TXD_GPIO,
+    [15] = KEY_SOCKET_LOCK,
+    [17] = KEY_ERROR,
+    [18] = KEY_SERIALS,
+    [19] = KEY_BUTTON,
+    [20] = KEY_AUX,
+    [21] = KEY_TYPE,
+    [23] = KEY_SCALE,
+    [24] = KEY_OTA,
+    [25] = KEY_MIN_BREAK_TIME,
+    [27] = KEY_DETECTION_DELAY,
+    [28] = KEY_CURRENT,
+    [29] = KEY_PATH,
+    [32] = KEY_ANALOG_INPUTS,
+    [33] = KEY_ENERGY_METER,
+    [35] = KEY_AC_RELAY,
+    [37] = KEY_CHARGING,
+    [40] = KEY_CHANNELS,
+    [45] = KEY_ADC_CHANNEL,
+    [46] = KEY_GPIO,
+    [47] = KEY_DETECTION_GPIO,
+    [49] = KEY_PROXIMITY,
+    [53] = KEY_TEMPERATURE_SENSOR,
+    [55] = KEY_ONEWIRE,
+    [56] = KEY_ADC_CHANNELS,
+    [58] = KEY_GPIOS,
+    [59] = KEY_INPUTS,
+    [60] = KEY_RTS_GPIO,
+    [62] = KEY_OUTPUTS,
+    [63] = KEY_TEST_GPIO,
+};
+
+static cfg_key_t get_key(const char* key)
 {
-    for (key_t i = KEY_NONE + 1; i < KEY_MAX; i++) {
-        if (!strcmp(key, keys[i])) return i;
+    uint32_t hash = KEY_HASH_SEED;
+    for (const char* c = key; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619;
     }
-    return KEY_NONE;
+
+    cfg_key_t i = key_slots[hash >> KEY_HASH_SHIFT];
+    return strcmp(key, keys[i]) == 0 ? i : KEY_NONE;
 }
 
-static bool set_key_value(board_cfg_t* config, const key_t* key, const int* seq_idx, const char* value)
+static bool set_key_value(board_cfg_t* config, const cfg_key_t* key, const int* seq_idx, const char* value)
 {
     switch (key[0]) {
         CASE_SET_VALUE_STR(KEY_DEVICE_NAME, device_name, BOARD_CFG_DEVICE_NAME_SIZE);
@@ -267,7 +315,7 @@ static bool set_key_value(board_cfg_t* config, const key_t* key, const int* seq_
         case KEY_CHANNELS:
             switch (key[2]) {
                 CASE_SET_SEQ_VALUE_STR(KEY_NAME, ota.channels[seq_idx[1]].name, BOARD_CFG_SERIAL_NAME_SIZE, seq_idx[1] < BOARD_CFG_OTA_CHANNEL_COUNT);
-                CASE_SET_SEQ_VALUE_STRDUP(KEY_PATH, ota.channels[seq_idx[1]].path, seq_idx[1] < BOARD_CFG_OTA_CHANNEL_COUNT);
+                CASE_SET_SEQ_VALUE_STR(KEY_PATH, ota.channels[seq_idx[1]].path, BOARD_CFG_OTA_CHANNEL_PATH_SIZE, seq_idx[1] < BOARD_CFG_OTA_CHANNEL_COUNT);
                 CASE_DEFAULT();
             }
             break;
@@ -318,17 +366,13 @@ static void empty_config(board_cfg_t* config)
         config->serials[i].txd_gpio = -1;
         config->serials[i].rts_gpio = -1;
     }
-    for (int i = 0; i < BOARD_CFG_OTA_CHANNEL_COUNT; i++) {
-        config->ota.channels[i].name[0] = '\0';
-        config->ota.channels[i].path = NULL;
-    }
 }
 
 esp_err_t board_config_parse_file(FILE* src, board_cfg_t* board_cfg)
 {
     yaml_parser_t parser;
     yaml_event_t event;
-    yaml_mark_t key_mark;
+    yaml_mark_t key_mark = { 0 };
 
     if (!yaml_parser_initialize(&parser)) {
         ESP_LOGE(TAG, "Can initialize yaml parser");
@@ -341,7 +385,7 @@ esp_err_t board_config_parse_file(FILE* src, board_cfg_t* board_cfg)
 
     int level = -1;
     uint8_t seq_level = 0;
-    key_t key[YAML_MAX_LEVEL];
+    cfg_key_t key[YAML_MAX_LEVEL];
     int seq_idx[YAML_MAX_LEVEL] = { 0 };
     for (int i = 0; i < YAML_MAX_LEVEL; i++) {
         key[i] = KEY_NONE;
@@ -397,7 +441,7 @@ esp_err_t board_config_parse_file(FILE* src, board_cfg_t* board_cfg)
         case YAML_MAPPING_END_EVENT:
             if (level < YAML_MAX_LEVEL) key[level] = KEY_NONE;
             level--;
-            if (level < YAML_MAX_LEVEL) {
+            if (level >= 0 && level < YAML_MAX_LEVEL) {
                 if (seq_level & (1 << level))
                     seq_idx[level]++;  // for array of objects, key[level] clear YAML_SEQUENCE_END_EVENT
                 else
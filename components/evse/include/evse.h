@@ -75,6 +75,19 @@ void evse_process(void);
  */
 evse_state_t evse_get_state(void);
 
+/**
+ * @brief State change callback, called from evse_process
+ *
+ */
+typedef void (*evse_state_change_cb_t)(evse_state_t state);
+
+/**
+ * @brief Set state change callback, NULL for remove
+ *
+ * @param cb
+ */
+void evse_set_state_change_cb(evse_state_change_cb_t cb);
+
 /**
  * @brief Format to string value
  *
@@ -102,6 +102,8 @@ static enum pilot_state_e pilot_state = PILOT_STATE_12V;
 
 static bool socket_lock_locked = false;
 
+static evse_state_change_cb_t state_change_cb = NULL;
+
 // timeout helper to improve readability, should probably go to a separate header if needed elsewhere
 // set a timeout value in ms
 static inline void set_timeout(TickType_t* to, uint32_t ms)
@@ -485,6 +487,10 @@ void evse_process(void)
         }
         enter_new_state(new_state);
         prev_state = new_state;
+
+        if (state_change_cb) {
+            state_change_cb(new_state);
+        }
     }
 
     error_cleared = false;
@@ -557,6 +563,11 @@ evse_state_t evse_get_state(void)
     return error ? EVSE_STATE_E : state;
 }
 
+void evse_set_state_change_cb(evse_state_change_cb_t cb)
+{
+    state_change_cb = cb;
+}
+
 const char* evse_state_to_str(evse_state_t state)
 {
     switch (state) {
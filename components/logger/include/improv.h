@@ -1,13 +1,15 @@
 #ifndef IMPROV_H_
 #define IMPROV_H_
 
+#include <driver/uart.h>
+
 #define IMPROV_PACKET_SIZE 266
 
 /**
- * @brief Handle improv protocol response in file descriptor
+ * @brief Handle improv protocol response on serial port
  *
- * @param fd
+ * @param port uart number
  */
-void improv_handle(int fd);
+void improv_handle(uart_port_t port);
 
 #endif /* IMPROV_H_ */
\ No newline at end of file
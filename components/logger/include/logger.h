@@ -1,11 +1,36 @@
 #ifndef LOGGER_H_
 #define LOGGER_H_
 
+#include <esp_err.h>
+#include <esp_log.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <time.h>
 
+#define LOGGER_LINE_SIZE    512
+#define LOGGER_BINARY_SIZE  672
+#define LOGGER_ELF_SHA_SIZE 16
+
+/**
+ * @brief Syslog datagram format
+ *
+ */
+typedef enum {
+    LOGGER_SYSLOG_FORMAT_RFC5424,
+    LOGGER_SYSLOG_FORMAT_RAW,
+    LOGGER_SYSLOG_FORMAT_MAX
+} logger_syslog_format_t;
+
+/**
+ * @brief Log entries filter
+ *
+ */
+typedef struct {
+    esp_log_level_t level;  // maximal level
+    const char* tag;        // NULL for all tags
+} logger_filter_t;
+
 /**
  * @brief Initialize logger
  *
@@ -13,22 +38,159 @@
 void logger_init(void);
 
 /**
- * @brief Get log bugger lengt
+ * @brief Get sequence number of next log entry
  *
- * @return uint16_t
+ * @return uint32_t
  */
-uint16_t logger_log_buffer_get_count(void);
+uint32_t logger_log_buffer_get_count(void);
 
 /**
- * @brief Read logs from buffer from index, set index for reading next entry
+ * @brief Read logs from buffer from sequence number formatted as text, set index for reading next entry
  *
- * @param index
- * @param str
- * @param v
+ * @param index Sequence number
+ * @param filter Filter entries, NULL for all
+ * @param str Output buffer, LOGGER_LINE_SIZE is enough
+ * @param size Size of output buffer
+ * @param len Length of entry
+ * @return true When has next entry
+ * @return false When no entry left
+ */
+bool logger_log_bugger_read(uint32_t* index, const logger_filter_t* filter, char* str, uint16_t size, uint16_t* len);
+
+/**
+ * @brief Write header of binary log dump, with format version, flash data segment base and ELF hash
+ *
+ * @param data
+ * @param size
+ * @return uint16_t Length of header
+ */
+uint16_t logger_log_buffer_get_binary_header(uint8_t* data, uint16_t size);
+
+/**
+ * @brief Read logs from buffer from sequence number as binary records, set index for reading next entry
+ *
+ * @param index Sequence number
+ * @param filter Filter entries, NULL for all
+ * @param data Output buffer, LOGGER_BINARY_SIZE is enough
+ * @param size Size of output buffer
+ * @param len Length of entry
  * @return true When has next entry
  * @return false When no entry left
  */
-bool logger_log_bugger_read(uint16_t* index, char** str, uint16_t* len);
+bool logger_log_buffer_read_binary(uint32_t* index, const logger_filter_t* filter, uint8_t* data, uint16_t size, uint16_t* len);
+
+/**
+ * @brief Get count of log messages dropped because of full log queue
+ *
+ * @return uint32_t
+ */
+uint32_t logger_get_dropped_count(void);
+
+/**
+ * @brief Initialize persistent log storage, must be called after NVS and file system initialization
+ *
+ */
+void logger_storage_init(void);
+
+/**
+ * @brief Initialize syslog sink, must be called after NVS initialization
+ *
+ */
+void logger_syslog_init(void);
+
+/**
+ * @brief Set persistent log storage enabled, stored in NVS
+ *
+ * @param enabled
+ */
+void logger_set_storage_enabled(bool enabled);
+
+/**
+ * @brief Get persistent log storage enabled, stored in NVS
+ *
+ * @return true
+ * @return false
+ */
+bool logger_is_storage_enabled(void);
+
+/**
+ * @brief Callback for reading persistent logs
+ */
+typedef esp_err_t (*logger_storage_read_cb_t)(const char* buf, size_t len, void* ctx);
+
+/**
+ * @brief Read all persistent logs from oldest, callback is called by chunks
+ *
+ * @param cb
+ * @param ctx
+ * @return esp_err_t
+ */
+esp_err_t logger_storage_read(logger_storage_read_cb_t cb, void* ctx);
+
+/**
+ * @brief Set syslog sink config, stored in NVS. Each line is sent as single UDP datagram
+ *
+ * @param enabled
+ * @param host Host name or IP address, when NULL is not changed
+ * @param port When 0 is used default 514
+ * @param format
+ * @param rate Maximal lines per second, 0 for unlimited
+ * @return esp_err_t
+ */
+esp_err_t logger_set_syslog_config(bool enabled, const char* host, uint16_t port, logger_syslog_format_t format, uint16_t rate);
+
+/**
+ * @brief Get syslog sink enabled, stored in NVS
+ *
+ * @return true
+ * @return false
+ */
+bool logger_is_syslog_enabled(void);
+
+/**
+ * @brief Get syslog host, stored in NVS
+ *
+ * @param value
+ * @param value_size
+ */
+void logger_get_syslog_host(char* value, size_t value_size);
+
+/**
+ * @brief Get syslog port, stored in NVS
+ *
+ * @return uint16_t
+ */
+uint16_t logger_get_syslog_port(void);
+
+/**
+ * @brief Get syslog format, stored in NVS
+ *
+ * @return logger_syslog_format_t
+ */
+logger_syslog_format_t logger_get_syslog_format(void);
+
+/**
+ * @brief Get syslog rate limit in lines per second, stored in NVS
+ *
+ * @return uint16_t
+ */
+uint16_t logger_get_syslog_rate(void);
+
+/**
+ * @brief Serialize to string
+ *
+ * @param value
+ * @return const char*
+ */
+const char* logger_syslog_format_to_str(logger_syslog_format_t value);
+
+/**
+ * @brief Parse from string
+ *
+ * @param str
+ * @return logger_syslog_format_t
+ */
+logger_syslog_format_t logger_str_to_syslog_format(const char* str);
 
 /**
  * @brief Get panic time, if no panic return 0
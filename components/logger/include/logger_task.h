@@ -1,6 +1,7 @@
 #ifndef LOGGER_TASK_H_
 #define LOGGER_TASK_H_
 
+#include <driver/uart.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
@@ -9,16 +10,17 @@
 /**
  * @brief Logger also implement Improv protocol
  */
-#define LOGGER_TASK_RX_BUFFER_SIZE IMPROV_PACKET_SIZE
+#define LOGGER_TASK_RX_BUFFER_SIZE (2 * IMPROV_PACKET_SIZE)
+#define LOGGER_TASK_RX_SPAN_SIZE   IMPROV_PACKET_SIZE
 #define LOGGER_TASK_TX_BUFFER_SIZE 0
 
 /**
  * @brief Start logger task
  *
- * @param file
+ * @param port uart number
  * @return TaskHandle_t
  */
-TaskHandle_t logger_task_start(int fd);
+TaskHandle_t logger_task_start(uart_port_t port);
 
 /**
  * @brief Stop logger task
@@ -4,17 +4,29 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/**
+ * @brief Average entry size, used for sizing entry offset index
+ */
+#define OUTPUT_BUFFER_AVG_ENTRY_SIZE 32
+
+/**
+ * @brief Circular buffer of text entries, each entry is identified by monotonically increasing sequence number
+ */
 typedef struct {
     uint16_t size;
-    uint16_t count;
+    uint16_t index_size;
     uint8_t* data;
-    uint8_t* append;
+    uint16_t* index;  // data offset of entry, indexed by sequence modulo index_size
+    uint16_t head;    // data offset of oldest entry
+    uint16_t tail;    // data offset for next entry
+    uint32_t first;   // sequence of oldest entry
+    uint32_t next;    // sequence of next appended entry
     bool is_static : 1;
 } output_buffer_t;
 
 output_buffer_t* output_buffer_create(uint16_t size);
 
-output_buffer_t* output_buffer_create_static(uint16_t size, uint8_t* buf);
+output_buffer_t* output_buffer_create_static(uint16_t size, uint16_t index_size, uint8_t* buf);
 
 void output_buffer_delete(output_buffer_t* buffer);
 
@@ -22,6 +34,16 @@ void output_buffer_append_buf(output_buffer_t* buffer, const char* buf, uint16_t
 
 void output_buffer_append_str(output_buffer_t* buffer, const char* str);
 
-bool output_buffer_read(output_buffer_t* buffer, uint16_t* index, char** str, uint16_t* len);
-
-#endif /* OUTPUT_BUFFER_H_ */
\ No newline at end of file
+/**
+ * @brief Read entry by sequence number, set index to sequence of next entry
+ *
+ * @param buffer
+ * @param index Sequence number, when entry was already overwritten, is moved to oldest available
+ * @param str
+ * @param len
+ * @return true When has next entry
+ * @return false When no entry left
+ */
+bool output_buffer_read(output_buffer_t* buffer, uint32_t* index, char** str, uint16_t* len);
+
+#endif /* OUTPUT_BUFFER_H_ */
@@ -0,0 +1,237 @@
+#!/usr/bin/env python
+
+# Decode binary log dump (GET /api/v1/log?format=binary) with firmware ELF file
+# Usage: log-decode.py firmware.elf dump.bin [--level W] [--tag evse] [--no-color]
+
+import argparse
+import hashlib
+import math
+import re
+import struct
+import sys
+
+MAGIC = b"ELOG"
+VERSION = 2
+HEADER_SIZE = 25
+
+HEADER_LEVEL_MASK = 0x07
+HEADER_TRUNCATED = 0x08
+HEADER_TAG = 0x10
+
+LEVELS = "NEWIDV"
+
+EM_RISCV = 243
+
+SPEC_RE = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L)?(.)")
+COLOR_RE = re.compile(r"\033\[[0-9;]*m")
+V1_PREFIX_RE = re.compile(r"^(?:\033\[[0-9;]*m)?[EWIDV] \(%l?u\) %s: ")
+
+
+class Elf:
+    def __init__(self, path):
+        self.data = open(path, "rb").read()
+        self.sha = hashlib.sha256(self.data).hexdigest()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            raise ValueError("not ELF32 file")
+
+        # long double is binary128 on RISC-V, same as double on Xtensa
+        (machine,) = struct.unpack_from("<H", self.data, 0x12)
+        self.long_double_size = 16 if machine == EM_RISCV else 8
+
+        (shoff,) = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+
+        self.sections = []
+        for i in range(shnum):
+            sh_type, sh_flags, sh_addr, sh_offset, sh_size = struct.unpack_from("<IIIII", self.data, shoff + i * shentsize + 4)
+            if sh_flags & 0x2 and sh_type == 1:  # SHF_ALLOC, SHT_PROGBITS
+                self.sections.append((sh_addr, sh_offset, sh_size))
+
+    def read_str(self, addr):
+        for sh_addr, sh_offset, sh_size in self.sections:
+            if sh_addr <= addr < sh_addr + sh_size:
+                start = sh_offset + addr - sh_addr
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode("utf-8", "replace")
+        return "<0x{:08x}>".format(addr)
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def eof(self):
+        return self.pos >= len(self.data)
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            b = self.data[self.pos]
+            self.pos += 1
+            value |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return value
+
+    def zigzag(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def bytes(self, size):
+        value = self.data[self.pos:self.pos + size]
+        if len(value) != size:
+            raise IndexError
+        self.pos += size
+        return value
+
+
+def unpack_float(data):
+    if len(data) == 8:
+        return struct.unpack("<d", data)[0]
+    # binary128, mantissa is truncated to double precision
+    value = int.from_bytes(data, "little")
+    sign = -1.0 if value >> 127 else 1.0
+    exponent = (value >> 112) & 0x7FFF
+    mantissa = value & ((1 << 112) - 1)
+    if exponent == 0x7FFF:
+        return sign * float("inf") if mantissa == 0 else float("nan")
+    if exponent == 0:
+        exponent = 1
+    else:
+        mantissa |= 1 << 112
+    try:
+        return sign * math.ldexp(float(mantissa >> 60), exponent - 16383 - 52)
+    except OverflowError:
+        return sign * float("inf")
+
+
+def format_arg(flags, width, precision, length, conv, value):
+    spec = "%" + flags + width + ("." + precision if precision is not None else "")
+    if conv in "di":
+        return (spec + "d") % value
+    if conv in "uoxX":
+        bits = 64 if length in ("ll", "j") else 32
+        return (spec + ("d" if conv == "u" else conv)) % (value & ((1 << bits) - 1))
+    if conv == "c":
+        return (spec + "s") % chr(value & 0xFF)
+    if conv == "p":
+        return (spec + "s") % "0x{:x}".format(value)
+    if conv in "fFeEgGaA":
+        return (spec + (conv if conv not in "aA" else "e")) % value
+    if conv == "s":
+        return (spec + "s") % value
+    return ""
+
+
+def read_str_arg(elf, drom_base, r):
+    v = r.varint()
+    if v & 1:
+        return elf.read_str(drom_base + (v >> 1))
+    return r.bytes(v >> 1).decode("utf-8", "replace")
+
+
+def decode_record(elf, drom_base, data):
+    r = Reader(data)
+    header = r.data[0]
+    r.pos = 1
+    level = header & HEADER_LEVEL_MASK
+    time = r.varint()
+    fmt = elf.read_str(drom_base + r.varint())
+
+    out = []
+    tag = None
+    last = 0
+    index = 0
+    truncated = bool(header & HEADER_TRUNCATED)
+    # tag of esp_log call precedes arguments, without it tag can be in Log V1 prefix of esp_log_write
+    v1_prefix = not header & HEADER_TAG and V1_PREFIX_RE.match(fmt)
+    if header & HEADER_TAG:
+        try:
+            tag = read_str_arg(elf, drom_base, r)
+        except IndexError:
+            return level, None, "...\n"
+        out.append("{} ({}) {}: ".format(LEVELS[min(level, 5)], time, tag))
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, precision, length, conv = m.groups()
+        length = length or ""
+        if conv == "%":
+            out.append("%")
+            continue
+        if conv not in "diouxXcfFeEgGaAspn":
+            out.append(m.group(0))
+            continue
+        try:
+            if r.eof():
+                truncated = True
+                break
+            if width == "*":
+                width = str(r.zigzag())
+            if precision == "*":
+                precision = str(r.zigzag())
+            if conv in "diouxXc":
+                value = r.zigzag()
+            elif conv in "fFeEgGaA":
+                value = unpack_float(r.bytes(elf.long_double_size if length == "L" else 8))
+            elif conv in "pn":
+                value = r.varint()
+            else:
+                value = read_str_arg(elf, drom_base, r)
+                if v1_prefix and index == 1:
+                    tag = value
+        except IndexError:
+            truncated = True
+            break
+        index += 1
+        if conv != "n":
+            out.append(format_arg(flags, width or "", precision, length, conv, value))
+    else:
+        out.append(fmt[last:])
+
+    line = "".join(out)
+    if truncated:
+        line += "...\n"
+    elif header & HEADER_TAG:
+        line += "\n"
+    return level, tag, line
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode ESP32 EVSE binary log dump")
+    parser.add_argument("elf", help="firmware ELF file")
+    parser.add_argument("dump", help="binary log dump, - for stdin")
+    parser.add_argument("--level", default="V", help="maximal level (E, W, I, D, V)")
+    parser.add_argument("--tag", help="show only tag")
+    parser.add_argument("--no-color", action="store_true", help="strip colors")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    dump = sys.stdin.buffer.read() if args.dump == "-" else open(args.dump, "rb").read()
+
+    if dump[:4] != MAGIC or dump[4] != VERSION:
+        sys.exit("Unsupported dump format")
+    (drom_base,) = struct.unpack_from("<I", dump, 5)
+    elf_sha = dump[9:HEADER_SIZE].decode()
+    if not elf.sha.startswith(elf_sha):
+        print("Warning: ELF file does not match firmware ({} != {})".format(elf.sha[:16], elf_sha), file=sys.stderr)
+
+    max_level = LEVELS.find(args.level[0].upper())
+    pos = HEADER_SIZE
+    while pos + 2 <= len(dump):
+        (length,) = struct.unpack_from("<H", dump, pos)
+        pos += 2
+        level, tag, line = decode_record(elf, drom_base, dump[pos:pos + length])
+        pos += length
+
+        if level > max_level or (args.tag and tag != args.tag):
+            continue
+        if args.no_color:
+            line = COLOR_RE.sub("", line)
+        sys.stdout.write(line)
+
+
+if __name__ == "__main__":
+    main()
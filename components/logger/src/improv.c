@@ -3,11 +3,11 @@
 #include <esp_ota_ops.h>
 #include <string.h>
 #include <sys/param.h>
-#include <unistd.h>
 
 #include "sdkconfig.h"
 
 #include "board_config.h"
+#include "serial_port.h"
 #include "wifi.h"
 
 #define IMPROV_TYPE_CURRENT_STATE 0x01
@@ -62,7 +62,7 @@ static void improv_append_str(uint8_t* data, uint8_t* pos, const char* str)
     *pos += len + 1;
 }
 
-static void improv_send_state(int fd, uint8_t state)
+static void improv_send_state(uart_port_t port, uint8_t state)
 {
     uint8_t data[11];
     memcpy(data, IMPROV_HEADER, sizeof(IMPROV_HEADER));
@@ -72,11 +72,10 @@ static void improv_send_state(int fd, uint8_t state)
 
     improv_append_checksum(data, 10);
 
-    write(fd, data, 11);
-    fsync(fd);
+    serial_port_write(port, data, 11);
 }
 
-static void improv_send_error(int fd, uint8_t error)
+static void improv_send_error(uart_port_t port, uint8_t error)
 {
     uint8_t data[11];
     memcpy(data, IMPROV_HEADER, sizeof(IMPROV_HEADER));
@@ -86,11 +85,10 @@ static void improv_send_error(int fd, uint8_t error)
 
     improv_append_checksum(data, 10);
 
-    write(fd, data, 11);
-    fsync(fd);
+    serial_port_write(port, data, 11);
 }
 
-static void improv_send_device_url(int fd, uint8_t cmd)
+static void improv_send_device_url(uart_port_t port, uint8_t cmd)
 {
     uint8_t data[IMPROV_PACKET_SIZE];
     memcpy(data, IMPROV_HEADER, sizeof(IMPROV_HEADER));
@@ -110,21 +108,20 @@ static void improv_send_device_url(int fd, uint8_t cmd)
 
     improv_append_checksum(data, pos + 11);
 
-    write(fd, data, pos + 12);
-    fsync(fd);
+    serial_port_write(port, data, pos + 12);
 }
 
-static void improv_handle_rpc_current_state(int fd)
+static void improv_handle_rpc_current_state(uart_port_t port)
 {
     if (wifi_is_sta_connected()) {
-        improv_send_state(fd, IMPROV_STATE_PROVISIONED);
-        improv_send_device_url(fd, IMPROV_CMD_CURRENT_STATE);
+        improv_send_state(port, IMPROV_STATE_PROVISIONED);
+        improv_send_device_url(port, IMPROV_CMD_CURRENT_STATE);
     } else {
-        improv_send_state(fd, IMPROV_STATE_READY);
+        improv_send_state(port, IMPROV_STATE_READY);
     }
 }
 
-static void improv_handle_rpc_device_info(int fd)
+static void improv_handle_rpc_device_info(uart_port_t port)
 {
     uint8_t data[IMPROV_PACKET_SIZE];
     memcpy(data, IMPROV_HEADER, sizeof(IMPROV_HEADER));
@@ -143,11 +140,10 @@ static void improv_handle_rpc_device_info(int fd)
 
     improv_append_checksum(data, pos + 11);
 
-    write(fd, data, pos + 12);
-    fsync(fd);
+    serial_port_write(port, data, pos + 12);
 }
 
-static void improv_send_response_wifi_network(int fd, wifi_scan_ap_entry_t* scan_ap)
+static void improv_send_response_wifi_network(uart_port_t port, wifi_scan_ap_entry_t* scan_ap)
 {
     uint8_t data[IMPROV_PACKET_SIZE];
     memcpy(data, IMPROV_HEADER, sizeof(IMPROV_HEADER));
@@ -173,26 +169,25 @@ static void improv_send_response_wifi_network(int fd, wifi_scan_ap_entry_t* scan
 
     improv_append_checksum(data, pos + 11);
 
-    write(fd, data, pos + 12);
-    fsync(fd);
+    serial_port_write(port, data, pos + 12);
 }
 
-static void improv_handle_rpc_wifi_networks(int fd)
+static void improv_handle_rpc_wifi_networks(uart_port_t port)
 {
     wifi_scan_ap_list_t* list = wifi_scan_aps();
 
     wifi_scan_ap_entry_t* entry;
     SLIST_FOREACH (entry, list, entries) {
-        improv_send_response_wifi_network(fd, entry);
+        improv_send_response_wifi_network(port, entry);
     }
-    improv_send_response_wifi_network(fd, NULL);
+    improv_send_response_wifi_network(port, NULL);
 
     wifi_scan_aps_free(list);
 }
 
-static void improv_handle_rpc_wifi_settings(int fd, uint8_t* data, uint8_t data_len)
+static void improv_handle_rpc_wifi_settings(uart_port_t port, const uint8_t* data, uint8_t data_len)
 {
-    improv_send_state(fd, IMPROV_STATE_PROVISIONED);
+    improv_send_state(port, IMPROV_STATE_PROVISIONED);
     uint8_t ssid_len = data[2];
     uint8_t password_len = data[3 + ssid_len];
 
@@ -200,82 +195,73 @@ static void improv_handle_rpc_wifi_settings(int fd, uint8_t* data, uint8_t data_
     char password[WIFI_PASSWORD_SIZE + 1] = { 0 };
 
     if (ssid_len + 3 > data_len || 4 + ssid_len + password_len > data_len) {
-        improv_send_error(fd, IMPROV_ERROR_INVALID_RPC);
+        improv_send_error(port, IMPROV_ERROR_INVALID_RPC);
     } else {
         strncpy(ssid, (char*)&data[3], MIN(ssid_len, WIFI_SSID_SIZE));
         strncpy(password, (char*)&data[4 + ssid_len], MIN(password_len, WIFI_PASSWORD_SIZE));
 
         if (wifi_set_config(true, ssid, password) == ESP_OK) {
             if (wifi_sta_wait_connect(pdMS_TO_TICKS(10000))) {
-                improv_send_state(fd, IMPROV_STATE_PROVISIONED);
-                improv_send_device_url(fd, IMPROV_CMD_WIFI_SETTINGS);
+                improv_send_state(port, IMPROV_STATE_PROVISIONED);
+                improv_send_device_url(port, IMPROV_CMD_WIFI_SETTINGS);
             } else {
-                improv_send_state(fd, IMPROV_STATE_STOPPED);
-                improv_send_error(fd, IMPROV_ERROR_UNABLE_TO_CONNECT);
+                improv_send_state(port, IMPROV_STATE_STOPPED);
+                improv_send_error(port, IMPROV_ERROR_UNABLE_TO_CONNECT);
             }
         } else {
-            improv_send_error(fd, IMPROV_ERROR_INVALID_RPC);
+            improv_send_error(port, IMPROV_ERROR_INVALID_RPC);
         }
     }
 }
 
-static void improv_handle_rpc(int fd, uint8_t* data, uint8_t data_len)
+static void improv_handle_rpc(uart_port_t port, const uint8_t* data, uint8_t data_len)
 {
     switch (data[0]) {
     case IMPROV_CMD_CURRENT_STATE:
-        improv_handle_rpc_current_state(fd);
+        improv_handle_rpc_current_state(port);
         break;
     case IMPROV_CMD_DEVICE_INFO:
-        improv_handle_rpc_device_info(fd);
+        improv_handle_rpc_device_info(port);
         break;
     case IMPROV_CMD_WIFI_NETWORKS:
-        improv_handle_rpc_wifi_networks(fd);
+        improv_handle_rpc_wifi_networks(port);
         break;
     case IMPROV_CMD_WIFI_SETTINGS:
-        improv_handle_rpc_wifi_settings(fd, data, data_len);
+        improv_handle_rpc_wifi_settings(port, data, data_len);
         break;
     default:
-        improv_send_error(fd, IMPROV_ERROR_UNKNOWN_RPC);
+        improv_send_error(port, IMPROV_ERROR_UNKNOWN_RPC);
         break;
     }
 }
 
-void improv_handle(int fd)
+void improv_handle(uart_port_t port)
 {
-    uint8_t buf[IMPROV_PACKET_SIZE];
-
-    struct timeval tv = {
-        .tv_sec = 0,
-        .tv_usec = 250 * 1000,
-    };
-    fd_set read_set;
-    FD_ZERO(&read_set);
-    FD_SET(fd, &read_set);
-
-    if (select(fd + 1, &read_set, NULL, NULL, &tv) > 0) {
-        if (FD_ISSET(fd, &read_set)) {
-            int readed = read(fd, buf, IMPROV_PACKET_SIZE);
-            if (readed > 10) {  // check to minimal improv packet size
-                if (memcmp(buf, IMPROV_HEADER, sizeof(IMPROV_HEADER)) == 0) {
-                    uint8_t type = buf[7];
-                    uint8_t data_len = buf[8];
-
-                    if (8 + data_len + 1 <= readed) {
-                        uint8_t checksum = 0x00;
-                        for (int i = 0; i < 9 + data_len; i++) {
-                            checksum += buf[i];
-                        }
-
-                        if (checksum != buf[8 + data_len + 1]) {
-                            improv_send_error(fd, IMPROV_ERROR_INVALID_RPC);
-                        } else {
-                            if (type == IMPROV_TYPE_RPC) {
-                                improv_handle_rpc(fd, &buf[9], readed - 8);
-                            }
-                        }
+    if (serial_port_wait(port, 250) == SERIAL_PORT_EVENT_NONE) return;
+
+    // packet is parsed in place of receive span
+    const uint8_t* buf;
+    size_t len = serial_port_read_span(port, &buf);
+    if (len > 10) {  // check to minimal improv packet size
+        if (memcmp(buf, IMPROV_HEADER, sizeof(IMPROV_HEADER)) == 0) {
+            uint8_t type = buf[7];
+            uint8_t data_len = buf[8];
+
+            if (9 + data_len + 1 <= len) {
+                uint8_t checksum = 0x00;
+                for (int i = 0; i < 9 + data_len; i++) {
+                    checksum += buf[i];
+                }
+
+                if (checksum != buf[9 + data_len]) {
+                    improv_send_error(port, IMPROV_ERROR_INVALID_RPC);
+                } else {
+                    if (type == IMPROV_TYPE_RPC) {
+                        improv_handle_rpc(port, &buf[9], len - 8);
                     }
                 }
             }
         }
     }
+    serial_port_consume(port, len);
 }
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "log_lz.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+// Block header is raw length and data length (both uint16), data length equal to raw length means stored block.
+// Compressed data are groups of flag byte and 8 items, bit set is literal byte, otherwise 2 bytes match of 12 bits distance and 4 bits length.
+
+#define LZ_MIN_MATCH  3
+#define LZ_MAX_MATCH  (LZ_MIN_MATCH + 15)
+#define LZ_HASH_BITS  10
+#define LZ_HASH_SIZE  (1 << LZ_HASH_BITS)
+#define LZ_HASH_EMPTY 0xFFFF
+
+typedef struct {
+    uint16_t raw_len;
+    uint16_t data_len;
+} block_header_t;
+
+static uint16_t hash3(const uint8_t* p)
+{
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+static uint16_t lz_compress(const uint8_t* in, uint16_t in_len, uint8_t* out, uint16_t out_size, uint16_t* hash)
+{
+    memset(hash, 0xFF, sizeof(uint16_t) * LZ_HASH_SIZE);
+
+    uint16_t pos = 0;
+    uint16_t out_len = 0;
+    uint8_t* flags = NULL;
+    uint8_t bit = 8;
+
+    while (pos < in_len) {
+        if (bit == 8) {
+            if (out_len >= out_size) return 0;
+            flags = &out[out_len++];
+            *flags = 0;
+            bit = 0;
+        }
+
+        uint16_t match_len = 0;
+        uint16_t match_dist = 0;
+        if (pos + LZ_MIN_MATCH <= in_len) {
+            uint16_t h = hash3(&in[pos]);
+            uint16_t candidate = hash[h];
+            hash[h] = pos;
+
+            if (candidate != LZ_HASH_EMPTY) {
+                uint16_t max_len = MIN(LZ_MAX_MATCH, in_len - pos);
+                while (match_len < max_len && in[candidate + match_len] == in[pos + match_len]) match_len++;
+                match_dist = pos - candidate;
+            }
+        }
+
+        if (match_len >= LZ_MIN_MATCH) {
+            if (out_len + 2 > out_size) return 0;
+            uint16_t code = (match_dist << 4) | (match_len - LZ_MIN_MATCH);
+            out[out_len++] = code >> 8;
+            out[out_len++] = code & 0xFF;
+
+            for (uint16_t i = 1; i < match_len && pos + i + LZ_MIN_MATCH <= in_len; i++) {
+                hash[hash3(&in[pos + i])] = pos + i;
+            }
+            pos += match_len;
+        } else {
+            if (out_len >= out_size) return 0;
+            *flags |= 1 << bit;
+            out[out_len++] = in[pos++];
+        }
+        bit++;
+    }
+
+    return out_len;
+}
+
+static int lz_decompress(const uint8_t* in, uint16_t in_len, uint8_t* out, uint16_t out_size)
+{
+    uint16_t in_pos = 0;
+    uint16_t out_len = 0;
+
+    while (in_pos < in_len) {
+        uint8_t flags = in[in_pos++];
+
+        for (uint8_t bit = 0; bit < 8 && in_pos < in_len; bit++) {
+            if (flags & (1 << bit)) {
+                if (out_len >= out_size) return -1;
+                out[out_len++] = in[in_pos++];
+            } else {
+                if (in_pos + 2 > in_len) return -1;
+                uint16_t code = (in[in_pos] << 8) | in[in_pos + 1];
+                in_pos += 2;
+
+                uint16_t dist = code >> 4;
+                uint16_t len = (code & 0x0F) + LZ_MIN_MATCH;
+                if (dist == 0 || dist > out_len || out_len + len > out_size) return -1;
+
+                for (uint16_t i = 0; i < len; i++, out_len++) {
+                    out[out_len] = out[out_len - dist];
+                }
+            }
+        }
+    }
+
+    return out_len;
+}
+
+esp_err_t log_lz_compress_file(const char* src_path, const char* dst_path)
+{
+    esp_err_t ret = ESP_OK;
+
+    uint8_t* in = (uint8_t*)malloc(LOG_LZ_BLOCK_SIZE);
+    uint8_t* out = (uint8_t*)malloc(LOG_LZ_BLOCK_SIZE);
+    uint16_t* hash = (uint16_t*)malloc(sizeof(uint16_t) * LZ_HASH_SIZE);
+    FILE* src = fopen(src_path, "r");
+    FILE* dst = fopen(dst_path, "w");
+
+    if (!in || !out || !hash) {
+        ret = ESP_ERR_NO_MEM;
+    } else if (!src || !dst) {
+        ret = ESP_FAIL;
+    } else {
+        size_t in_len;
+        while ((in_len = fread(in, 1, LOG_LZ_BLOCK_SIZE, src)) > 0) {
+            block_header_t header = {
+                .raw_len = in_len,
+                .data_len = lz_compress(in, in_len, out, in_len - 1, hash),
+            };
+
+            const uint8_t* data = out;
+            if (header.data_len == 0) {
+                // not compressible, store
+                header.data_len = in_len;
+                data = in;
+            }
+
+            if (fwrite(&header, sizeof(block_header_t), 1, dst) != 1 || fwrite(data, 1, header.data_len, dst) != header.data_len) {
+                ret = ESP_FAIL;
+                break;
+            }
+        }
+    }
+
+    if (src) fclose(src);
+    if (dst && fclose(dst) != 0) ret = ESP_FAIL;
+    free((void*)in);
+    free((void*)out);
+    free((void*)hash);
+
+    if (ret != ESP_OK) {
+        remove(dst_path);
+    }
+
+    return ret;
+}
+
+esp_err_t log_lz_decompress_file(const char* path, log_lz_read_cb_t cb, void* ctx)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_OK;
+
+    uint8_t* in = (uint8_t*)malloc(LOG_LZ_BLOCK_SIZE);
+    uint8_t* out = (uint8_t*)malloc(LOG_LZ_BLOCK_SIZE);
+
+    if (!in || !out) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        block_header_t header;
+        while (ret == ESP_OK && fread(&header, sizeof(block_header_t), 1, file) == 1) {
+            if (header.raw_len > LOG_LZ_BLOCK_SIZE || header.data_len > header.raw_len || fread(in, 1, header.data_len, file) != header.data_len) {
+                ret = ESP_ERR_INVALID_SIZE;
+                break;
+            }
+
+            if (header.data_len == header.raw_len) {
+                ret = cb((const char*)in, header.raw_len, ctx);
+            } else {
+                int len = lz_decompress(in, header.data_len, out, header.raw_len);
+                if (len != header.raw_len) {
+                    ret = ESP_ERR_INVALID_CRC;
+                    break;
+                }
+                ret = cb((const char*)out, len, ctx);
+            }
+        }
+    }
+
+    fclose(file);
+    free((void*)in);
+    free((void*)out);
+
+    return ret;
+}
@@ -0,0 +1,34 @@
+#ifndef LOG_LZ_H_
+#define LOG_LZ_H_
+
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_LZ_BLOCK_SIZE 4096
+
+/**
+ * @brief Callback for decompressed data
+ */
+typedef esp_err_t (*log_lz_read_cb_t)(const char* buf, size_t len, void* ctx);
+
+/**
+ * @brief Compress file by independent LZSS blocks
+ *
+ * @param src_path
+ * @param dst_path
+ * @return esp_err_t
+ */
+esp_err_t log_lz_compress_file(const char* src_path, const char* dst_path);
+
+/**
+ * @brief Decompress file block by block
+ *
+ * @param path
+ * @param cb
+ * @param ctx
+ * @return esp_err_t
+ */
+esp_err_t log_lz_decompress_file(const char* path, log_lz_read_cb_t cb, void* ctx);
+
+#endif /* LOG_LZ_H_ */
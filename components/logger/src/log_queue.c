@@ -0,0 +1,113 @@
+#include "log_queue.h"
+
+#include <string.h>
+
+#define LOG_QUEUE_MASK  (LOG_QUEUE_SIZE - 1)
+#define ENTRY_ALIGN     alignof(log_record_t)
+#define ENTRY_HEADER    ((sizeof(entry_header_t) + ENTRY_ALIGN - 1) & ~(ENTRY_ALIGN - 1))
+#define STATE_COMMITTED 0x01
+#define STATE_PADDING   0x02
+
+/**
+ * Entry in ring, record follows header, free space is zeroed by consumer so reserved entry is not committed
+ */
+typedef struct {
+    atomic_uint_least32_t state;
+    uint32_t size;
+} entry_header_t;
+
+static entry_header_t* get_entry(log_queue_t* queue, uint32_t pos)
+{
+    return (entry_header_t*)&queue->buf[pos & LOG_QUEUE_MASK];
+}
+
+void log_queue_init(log_queue_t* queue)
+{
+    memset(queue->buf, 0, LOG_QUEUE_SIZE);
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->dropped, 0);
+}
+
+log_record_t* log_queue_reserve(log_queue_t* queue, size_t size)
+{
+    uint32_t entry_size = (ENTRY_HEADER + size + ENTRY_ALIGN - 1) & ~(ENTRY_ALIGN - 1);
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint32_t padding;
+
+    while (true) {
+        uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        uint32_t offset = head & LOG_QUEUE_MASK;
+
+        // entry is contiguous, rest of ring is skipped by padding entry
+        padding = offset + entry_size > LOG_QUEUE_SIZE ? LOG_QUEUE_SIZE - offset : 0;
+
+        if (head + padding + entry_size - tail > LOG_QUEUE_SIZE) {
+            atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+            return NULL;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&queue->head, &head, head + padding + entry_size, memory_order_relaxed, memory_order_relaxed)) {
+            break;
+        }
+        // head was updated by failed exchange
+    }
+
+    if (padding) {
+        entry_header_t* entry = get_entry(queue, head);
+        entry->size = padding;
+        atomic_store_explicit(&entry->state, STATE_COMMITTED | STATE_PADDING, memory_order_release);
+        head += padding;
+    }
+
+    entry_header_t* entry = get_entry(queue, head);
+    entry->size = entry_size;
+
+    return (log_record_t*)((uint8_t*)entry + ENTRY_HEADER);
+}
+
+void log_queue_commit(log_record_t* record)
+{
+    entry_header_t* entry = (entry_header_t*)((uint8_t*)record - ENTRY_HEADER);
+
+    atomic_store_explicit(&entry->state, STATE_COMMITTED, memory_order_release);
+}
+
+static void release(log_queue_t* queue, uint32_t tail, entry_header_t* entry)
+{
+    uint32_t size = entry->size;
+
+    memset(entry, 0, size);
+    atomic_store_explicit(&queue->tail, tail + size, memory_order_release);
+}
+
+log_record_t* log_queue_peek(log_queue_t* queue)
+{
+    while (true) {
+        uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        entry_header_t* entry = get_entry(queue, tail);
+        uint32_t state = atomic_load_explicit(&entry->state, memory_order_acquire);
+
+        if (!(state & STATE_COMMITTED)) return NULL;
+        if (!(state & STATE_PADDING)) return (log_record_t*)((uint8_t*)entry + ENTRY_HEADER);
+
+        release(queue, tail, entry);
+    }
+}
+
+void log_queue_pop(log_queue_t* queue)
+{
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    release(queue, tail, get_entry(queue, tail));
+}
+
+uint32_t log_queue_get_used(log_queue_t* queue)
+{
+    return atomic_load_explicit(&queue->head, memory_order_relaxed) - atomic_load_explicit(&queue->tail, memory_order_relaxed);
+}
+
+uint32_t log_queue_take_dropped(log_queue_t* queue)
+{
+    return atomic_exchange_explicit(&queue->dropped, 0, memory_order_relaxed);
+}
@@ -0,0 +1,79 @@
+#ifndef LOG_QUEUE_H_
+#define LOG_QUEUE_H_
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "log_record.h"
+
+#define LOG_QUEUE_SIZE 4096  // bytes, must be power of two, holds burst of about 50 typical lines
+
+/**
+ * @brief Bounded lock-free multi producer single consumer queue of log records with variable length
+ *
+ * Records are stored in byte ring only with length of their captured arguments
+ */
+typedef struct {
+    alignas(log_record_t) uint8_t buf[LOG_QUEUE_SIZE];
+    atomic_uint_least32_t head;
+    atomic_uint_least32_t tail;
+    atomic_uint_least32_t dropped;
+} log_queue_t;
+
+/**
+ * @brief Initialize queue
+ *
+ * @param queue
+ */
+void log_queue_init(log_queue_t* queue);
+
+/**
+ * @brief Reserve record for writing, never blocks
+ *
+ * @param queue
+ * @param size Size of record, from log_record_measure
+ * @return log_record_t* Reserved record, NULL when queue is full and message was dropped
+ */
+log_record_t* log_queue_reserve(log_queue_t* queue, size_t size);
+
+/**
+ * @brief Publish written record to consumer
+ *
+ * @param record
+ */
+void log_queue_commit(log_record_t* record);
+
+/**
+ * @brief Get oldest record, only from consumer
+ *
+ * @param queue
+ * @return log_record_t* NULL when queue is empty
+ */
+log_record_t* log_queue_peek(log_queue_t* queue);
+
+/**
+ * @brief Remove oldest record, only from consumer after successful peek
+ *
+ * @param queue
+ */
+void log_queue_pop(log_queue_t* queue);
+
+/**
+ * @brief Get count of bytes used by records waiting in queue
+ *
+ * @param queue
+ * @return uint32_t
+ */
+uint32_t log_queue_get_used(log_queue_t* queue);
+
+/**
+ * @brief Get and reset count of dropped messages
+ *
+ * @param queue
+ * @return uint32_t
+ */
+uint32_t log_queue_take_dropped(log_queue_t* queue);
+
+#endif /* LOG_QUEUE_H_ */
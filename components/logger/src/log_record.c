@@ -0,0 +1,892 @@
+#include "log_record.h"
+
+#include <ctype.h>
+#include <esp_memory_utils.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <soc/soc.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "sdkconfig.h"
+
+#define SPEC_SIZE 24
+
+#define STR_KIND_INLINE 0
+#define STR_KIND_REF    1
+
+#define HEADER_LEVEL_MASK 0x07
+#define HEADER_TRUNCATED  0x08
+#define HEADER_TAG        0x10
+
+#define DROM_SIZE (SOC_DROM_HIGH - SOC_DROM_LOW)
+
+#define LEVEL_LETTERS "NEWIDV"
+
+typedef enum {
+    ARG_TYPE_NONE,
+    ARG_TYPE_INT,
+    ARG_TYPE_LONG,
+    ARG_TYPE_LONG_LONG,
+    ARG_TYPE_DOUBLE,
+    ARG_TYPE_LONG_DOUBLE,
+    ARG_TYPE_PTR,
+    ARG_TYPE_STR,
+    ARG_TYPE_PERCENT,
+    ARG_TYPE_UNKNOWN,
+} arg_type_t;
+
+typedef struct {
+    const char* start;
+    const char* end;
+    bool width_arg : 1;
+    bool precision_arg : 1;
+    int precision;
+    arg_type_t type;
+} conv_spec_t;
+
+/**
+ * Destination of captured arguments, without buffer only length is measured
+ */
+typedef struct {
+    uint8_t* args;
+    uint16_t len;
+    uint16_t size;
+    bool truncated;
+} args_writer_t;
+
+static const char* parse_spec(const char* p, conv_spec_t* spec)
+{
+    spec->start = p++;
+    spec->width_arg = false;
+    spec->precision_arg = false;
+    spec->precision = -1;
+
+    while (*p && strchr("-+ #0", *p)) p++;
+
+    if (*p == '*') {
+        spec->width_arg = true;
+        p++;
+    } else {
+        while (isdigit((unsigned char)*p)) p++;
+    }
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->precision_arg = true;
+            p++;
+        } else {
+            spec->precision = 0;
+            while (isdigit((unsigned char)*p)) {
+                spec->precision = spec->precision * 10 + (*p++ - '0');
+            }
+        }
+    }
+
+    arg_type_t int_type = ARG_TYPE_INT;
+    bool long_double = false;
+    switch (*p) {
+    case 'h':
+        p++;
+        if (*p == 'h') p++;
+        break;
+    case 'l':
+        p++;
+        int_type = ARG_TYPE_LONG;
+        if (*p == 'l') {
+            p++;
+            int_type = ARG_TYPE_LONG_LONG;
+        }
+        break;
+    case 'j':
+        p++;
+        int_type = sizeof(intmax_t) == sizeof(long long) ? ARG_TYPE_LONG_LONG : ARG_TYPE_LONG;
+        break;
+    case 'z':
+    case 't':
+        p++;
+        int_type = sizeof(size_t) == sizeof(long long) ? ARG_TYPE_LONG_LONG : ARG_TYPE_LONG;
+        break;
+    case 'L':
+        p++;
+        long_double = true;
+        break;
+    }
+
+    switch (*p) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+    case 'c':
+        spec->type = int_type;
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        spec->type = long_double ? ARG_TYPE_LONG_DOUBLE : ARG_TYPE_DOUBLE;
+        break;
+    case 's':
+        spec->type = ARG_TYPE_STR;
+        break;
+    case 'p':
+    case 'n':
+        spec->type = ARG_TYPE_PTR;
+        break;
+    case '%':
+        spec->type = ARG_TYPE_PERCENT;
+        break;
+    default:
+        spec->type = ARG_TYPE_UNKNOWN;
+        break;
+    }
+
+    if (*p) p++;
+    spec->end = p;
+
+    return p;
+}
+
+static size_t arg_type_size(arg_type_t type)
+{
+    switch (type) {
+    case ARG_TYPE_INT:
+        return sizeof(int);
+    case ARG_TYPE_LONG:
+        return sizeof(long);
+    case ARG_TYPE_LONG_LONG:
+        return sizeof(long long);
+    case ARG_TYPE_DOUBLE:
+        return sizeof(double);
+    case ARG_TYPE_LONG_DOUBLE:
+        return sizeof(long double);
+    case ARG_TYPE_PTR:
+        return sizeof(void*);
+    default:
+        return 0;
+    }
+}
+
+static bool capture_arg(args_writer_t* writer, const void* value, size_t size)
+{
+    if (writer->len + size > writer->size) {
+        writer->truncated = true;
+        return false;
+    }
+
+    if (writer->args) memcpy(&writer->args[writer->len], value, size);
+    writer->len += size;
+
+    return true;
+}
+
+static bool capture_inline_str(args_writer_t* writer, const char* str, size_t len)
+{
+    size_t avail = writer->size - writer->len;
+    if (avail < 2) {
+        writer->truncated = true;
+        return false;
+    }
+    if (len > avail - 2) {
+        len = avail - 2;
+        writer->truncated = true;
+    }
+
+    if (writer->args) {
+        writer->args[writer->len] = STR_KIND_INLINE;
+        memcpy(&writer->args[writer->len + 1], str, len);
+        writer->args[writer->len + 1 + len] = '\0';
+    }
+    writer->len += len + 2;
+
+    return true;
+}
+
+static bool capture_str(args_writer_t* writer, const char* str, int precision)
+{
+    if (!str) str = "(null)";
+
+    if (precision < 0 && esp_ptr_in_drom(str)) {
+        // string in flash, like tag, store only reference
+        uint8_t kind = STR_KIND_REF;
+        return capture_arg(writer, &kind, sizeof(uint8_t)) && capture_arg(writer, &str, sizeof(const char*));
+    }
+
+    return capture_inline_str(writer, str, strnlen(str, precision >= 0 ? (size_t)precision : writer->size));
+}
+
+esp_log_level_t log_record_parse_level(const char* fmt)
+{
+    // skip color
+    if (fmt[0] == '\033') {
+        const char* m = strchr(fmt, 'm');
+        if (m) fmt = m + 1;
+    }
+
+    if (fmt[0] == '\0' || fmt[1] != ' ') {
+        return ESP_LOG_NONE;
+    }
+
+    switch (fmt[0]) {
+    case 'E':
+        return ESP_LOG_ERROR;
+    case 'W':
+        return ESP_LOG_WARN;
+    case 'I':
+        return ESP_LOG_INFO;
+    case 'D':
+        return ESP_LOG_DEBUG;
+    case 'V':
+        return ESP_LOG_VERBOSE;
+    default:
+        return ESP_LOG_NONE;
+    }
+}
+
+static void capture_args(args_writer_t* writer, const char* tag, const char* fmt, va_list l)
+{
+    if (tag && !capture_str(writer, tag, -1)) return;
+
+    if (!esp_ptr_in_drom(fmt)) {
+        // format string is not in flash and can be freed after return, format immediately
+        size_t avail = writer->size - writer->len;
+        if (avail < 2) {
+            writer->truncated = true;
+            return;
+        }
+        if (writer->args) {
+            writer->args[writer->len] = STR_KIND_INLINE;
+            int len = vsnprintf((char*)&writer->args[writer->len + 1], avail - 1, fmt, l);
+            if (len < 0) len = 0;
+            if ((size_t)len > avail - 2) {
+                len = avail - 2;
+                writer->truncated = true;
+            }
+            writer->len += len + 2;
+        } else {
+            int len = vsnprintf(NULL, 0, fmt, l);
+            writer->len += MIN((size_t)MAX(len, 0), avail - 2) + 2;
+        }
+        return;
+    }
+
+    const char* p = fmt;
+    while ((p = strchr(p, '%')) != NULL) {
+        conv_spec_t spec;
+        p = parse_spec(p, &spec);
+
+        if (spec.width_arg) {
+            int width = va_arg(l, int);
+            if (!capture_arg(writer, &width, sizeof(int))) return;
+        }
+        if (spec.precision_arg) {
+            spec.precision = va_arg(l, int);
+            if (!capture_arg(writer, &spec.precision, sizeof(int))) return;
+        }
+
+        switch (spec.type) {
+        case ARG_TYPE_INT: {
+            int value = va_arg(l, int);
+            if (!capture_arg(writer, &value, sizeof(value))) return;
+            break;
+        }
+        case ARG_TYPE_LONG: {
+            long value = va_arg(l, long);
+            if (!capture_arg(writer, &value, sizeof(value))) return;
+            break;
+        }
+        case ARG_TYPE_LONG_LONG: {
+            long long value = va_arg(l, long long);
+            if (!capture_arg(writer, &value, sizeof(value))) return;
+            break;
+        }
+        case ARG_TYPE_DOUBLE: {
+            double value = va_arg(l, double);
+            if (!capture_arg(writer, &value, sizeof(value))) return;
+            break;
+        }
+        case ARG_TYPE_LONG_DOUBLE: {
+            long double value = va_arg(l, long double);
+            if (!capture_arg(writer, &value, sizeof(value))) return;
+            break;
+        }
+        case ARG_TYPE_PTR: {
+            void* value = va_arg(l, void*);
+            if (!capture_arg(writer, &value, sizeof(value))) return;
+            break;
+        }
+        case ARG_TYPE_STR:
+            if (!capture_str(writer, va_arg(l, const char*), spec.precision)) return;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+size_t log_record_measure(const char* tag, const char* fmt, va_list l)
+{
+    args_writer_t writer = {
+        .args = NULL,
+        .len = 0,
+        .size = LOG_RECORD_ARGS_SIZE,
+        .truncated = false,
+    };
+    capture_args(&writer, tag, fmt, l);
+
+    return offsetof(log_record_t, args) + writer.len;
+}
+
+void log_record_capture(log_record_t* record, size_t size, esp_log_level_t level, const char* tag, const char* fmt, va_list l)
+{
+    record->time = esp_timer_get_time();
+    record->level = level != ESP_LOG_NONE ? level : log_record_parse_level(fmt);
+    record->tagged = tag != NULL;
+    record->fmt = esp_ptr_in_drom(fmt) ? fmt : "%s";
+
+    args_writer_t writer = {
+        .args = record->args,
+        .len = 0,
+        .size = MIN(size - offsetof(log_record_t, args), LOG_RECORD_ARGS_SIZE),
+        .truncated = false,
+    };
+    capture_args(&writer, tag, fmt, l);
+
+    record->args_len = writer.len;
+    record->truncated = writer.truncated;
+}
+
+static const char* read_str(const log_record_t* record, uint16_t* args_pos)
+{
+    if (*args_pos >= record->args_len) return NULL;
+
+    const char* str;
+    if (record->args[(*args_pos)++] == STR_KIND_REF) {
+        if (*args_pos + sizeof(const char*) > record->args_len) return NULL;
+        memcpy(&str, &record->args[*args_pos], sizeof(const char*));
+        *args_pos += sizeof(const char*);
+    } else {
+        if (*args_pos >= record->args_len) return NULL;
+        str = (const char*)&record->args[*args_pos];
+        *args_pos += strlen(str) + 1;
+    }
+
+    return str;
+}
+
+static int append_spec(char* spec_str, int spec_len, const uint8_t* args, uint16_t* args_pos, uint16_t args_len)
+{
+    int value;
+    if (*args_pos + sizeof(int) > args_len) return -1;
+    memcpy(&value, &args[*args_pos], sizeof(int));
+    *args_pos += sizeof(int);
+
+    return snprintf(&spec_str[spec_len], SPEC_SIZE - spec_len, "%d", value);
+}
+
+static void append(char* buf, size_t size, size_t* len, const char* fmt, ...)
+{
+    va_list l;
+    va_start(l, fmt);
+    int n = vsnprintf(&buf[*len], size - *len, fmt, l);
+    va_end(l);
+
+    if (n > 0) {
+        *len = (*len + n < size) ? *len + n : size - 1;
+    }
+}
+
+/**
+ * Timestamp as printed by esp_log for configured source, record time is esp timer, wall clock is shifted by record age
+ */
+static void format_timestamp(const log_record_t* record, char* buf, size_t size)
+{
+#if CONFIG_LOG_TIMESTAMP_SOURCE_SYSTEM || CONFIG_LOG_TIMESTAMP_SOURCE_SYSTEM_FULL
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - (esp_timer_get_time() - record->time);
+    time_t sec = us / 1000000;
+    struct tm tm;
+    localtime_r(&sec, &tm);
+
+#if CONFIG_LOG_TIMESTAMP_SOURCE_SYSTEM_FULL
+    size_t len = strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm);
+#else
+    size_t len = strftime(buf, size, "%H:%M:%S", &tm);
+#endif
+    snprintf(&buf[len], size - len, ".%03d", (int)(us / 1000 % 1000));
+#else
+    snprintf(buf, size, "%" PRIu32, (uint32_t)(record->time / 1000));
+#endif
+}
+
+/**
+ * Format message from format and arguments from position, returns true when arguments are missing
+ */
+static bool render_format(const log_record_t* record, const char* fmt, uint16_t* args_pos, char* buf, size_t size, size_t* len_out)
+{
+    size_t len = *len_out;
+    const char* p = fmt;
+    bool truncated = false;
+    buf[len] = '\0';
+    while (*p && len < size - 1) {
+        const char* percent = strchr(p, '%');
+        if (!percent) {
+            append(buf, size, &len, "%s", p);
+            break;
+        }
+        if (percent != p) {
+            append(buf, size, &len, "%.*s", (int)(percent - p), p);
+        }
+
+        conv_spec_t spec;
+        p = parse_spec(percent, &spec);
+
+        if (spec.type == ARG_TYPE_PERCENT) {
+            append(buf, size, &len, "%%");
+            continue;
+        }
+        if (spec.type == ARG_TYPE_UNKNOWN) {
+            append(buf, size, &len, "%.*s", (int)(spec.end - spec.start), spec.start);
+            continue;
+        }
+
+        // rebuild spec with width and precision arguments substituted
+        char spec_str[SPEC_SIZE];
+        int spec_len = 0;
+        for (const char* s = spec.start; s < spec.end && spec_len < SPEC_SIZE - 1; s++) {
+            if (*s == '*') {
+                int n = append_spec(spec_str, spec_len, record->args, args_pos, record->args_len);
+                if (n < 0) {
+                    truncated = true;
+                    break;
+                }
+                spec_len += n;
+            } else {
+                spec_str[spec_len++] = *s;
+            }
+        }
+        if (truncated) break;
+        spec_str[spec_len] = '\0';
+
+        if (spec.type == ARG_TYPE_STR) {
+            const char* str = read_str(record, args_pos);
+            if (!str) {
+                truncated = true;
+                break;
+            }
+            append(buf, size, &len, spec_str, str);
+            continue;
+        }
+
+        size_t arg_size = arg_type_size(spec.type);
+        if (*args_pos + arg_size > record->args_len) {
+            truncated = true;
+            break;
+        }
+        const uint8_t* arg = &record->args[*args_pos];
+        *args_pos += arg_size;
+
+        switch (spec.type) {
+        case ARG_TYPE_INT: {
+            int value;
+            memcpy(&value, arg, sizeof(value));
+            append(buf, size, &len, spec_str, value);
+            break;
+        }
+        case ARG_TYPE_LONG: {
+            long value;
+            memcpy(&value, arg, sizeof(value));
+            append(buf, size, &len, spec_str, value);
+            break;
+        }
+        case ARG_TYPE_LONG_LONG: {
+            long long value;
+            memcpy(&value, arg, sizeof(value));
+            append(buf, size, &len, spec_str, value);
+            break;
+        }
+        case ARG_TYPE_DOUBLE: {
+            double value;
+            memcpy(&value, arg, sizeof(value));
+            append(buf, size, &len, spec_str, value);
+            break;
+        }
+        case ARG_TYPE_LONG_DOUBLE: {
+            long double value;
+            memcpy(&value, arg, sizeof(value));
+            append(buf, size, &len, spec_str, value);
+            break;
+        }
+        case ARG_TYPE_PTR:
+            if (spec_str[spec_len - 1] == 'p') {
+                void* value;
+                memcpy(&value, arg, sizeof(value));
+                append(buf, size, &len, spec_str, value);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    *len_out = len;
+
+    return truncated;
+}
+
+int log_record_render(const log_record_t* record, char* buf, size_t size)
+{
+    size_t len = 0;
+    uint16_t args_pos = 0;
+
+    if (record->tagged) {
+        // prefix of esp_log, message format is without it
+        const char* tag = read_str(record, &args_pos);
+        if (!tag) tag = "";
+#if CONFIG_LOG_TIMESTAMP_SOURCE_NONE
+        append(buf, size, &len, "%c %s: ", LEVEL_LETTERS[MIN(record->level, ESP_LOG_VERBOSE)], tag);
+#else
+        char timestamp[32];
+        format_timestamp(record, timestamp, sizeof(timestamp));
+        append(buf, size, &len, "%c (%s) %s: ", LEVEL_LETTERS[MIN(record->level, ESP_LOG_VERBOSE)], timestamp, tag);
+#endif
+    }
+
+    bool truncated = render_format(record, record->fmt, &args_pos, buf, size, &len);
+
+    if (truncated || record->truncated) {
+        append(buf, size, &len, "...\n");
+    } else if (record->tagged) {
+        append(buf, size, &len, "\n");
+    }
+    if ((truncated || record->truncated || record->tagged) && len == size - 1) {
+        // line cut by buffer still ends with new line
+        buf[len - 1] = '\n';
+    }
+
+    return len;
+}
+
+static bool is_esp_format(const char* fmt, esp_log_level_t level)
+{
+    // ESP_LOGx format starts with level letter, timestamp and tag
+    if (level == ESP_LOG_NONE) return false;
+
+    conv_spec_t spec;
+    const char* p = strchr(fmt, '%');
+    if (!p) return false;
+    p = parse_spec(p, &spec);
+    if ((spec.type != ARG_TYPE_INT && spec.type != ARG_TYPE_LONG) || spec.width_arg || spec.precision_arg) return false;
+
+    if (!(p = strchr(p, '%'))) return false;
+    parse_spec(p, &spec);
+    return spec.type == ARG_TYPE_STR && !spec.width_arg && !spec.precision_arg;
+}
+
+int log_record_render_message(const log_record_t* record, char* buf, size_t size)
+{
+    size_t len = 0;
+    uint16_t args_pos = 0;
+    const char* fmt = record->fmt;
+
+    if (record->tagged) {
+        read_str(record, &args_pos);
+    } else if (is_esp_format(fmt, record->level)) {
+        // skip Log V1 prefix with timestamp and tag arguments
+        conv_spec_t spec;
+        fmt = parse_spec(strchr(fmt, '%'), &spec);
+        args_pos = arg_type_size(spec.type);
+        fmt = parse_spec(strchr(fmt, '%'), &spec);
+        read_str(record, &args_pos);
+        if (fmt[0] == ':') fmt++;
+        if (fmt[0] == ' ') fmt++;
+    }
+
+    if (render_format(record, fmt, &args_pos, buf, size, &len) || record->truncated) {
+        append(buf, size, &len, "...");
+    }
+    while (len > 0 && buf[len - 1] == '\n') {
+        buf[--len] = '\0';
+    }
+
+    return len;
+}
+
+static bool put_varint(uint8_t* buf, uint16_t size, uint16_t* len, uint64_t value)
+{
+    do {
+        if (*len >= size) return false;
+        uint8_t b = value & 0x7F;
+        value >>= 7;
+        buf[(*len)++] = b | (value ? 0x80 : 0);
+    } while (value);
+
+    return true;
+}
+
+static bool get_varint(const uint8_t* buf, uint16_t len, uint16_t* pos, uint64_t* value)
+{
+    *value = 0;
+    for (uint8_t shift = 0; shift < 64; shift += 7) {
+        if (*pos >= len) return false;
+        uint8_t b = buf[(*pos)++];
+        *value |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+
+    return false;
+}
+
+static uint64_t zigzag_encode(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static bool read_int_arg(const log_record_t* record, uint16_t* args_pos, arg_type_t type, int64_t* value)
+{
+    size_t arg_size = arg_type_size(type);
+    if (*args_pos + arg_size > record->args_len) return false;
+
+    const uint8_t* arg = &record->args[*args_pos];
+    *args_pos += arg_size;
+
+    switch (type) {
+    case ARG_TYPE_INT: {
+        int v;
+        memcpy(&v, arg, sizeof(v));
+        *value = v;
+        break;
+    }
+    case ARG_TYPE_LONG: {
+        long v;
+        memcpy(&v, arg, sizeof(v));
+        *value = v;
+        break;
+    }
+    default: {
+        long long v;
+        memcpy(&v, arg, sizeof(v));
+        *value = v;
+        break;
+    }
+    }
+
+    return true;
+}
+
+static bool write_int_arg(args_writer_t* writer, arg_type_t type, int64_t value)
+{
+    switch (type) {
+    case ARG_TYPE_INT: {
+        int v = value;
+        return capture_arg(writer, &v, sizeof(v));
+    }
+    case ARG_TYPE_LONG: {
+        long v = value;
+        return capture_arg(writer, &v, sizeof(v));
+    }
+    default: {
+        long long v = value;
+        return capture_arg(writer, &v, sizeof(v));
+    }
+    }
+}
+
+static bool encode_arg(const log_record_t* record, uint16_t* args_pos, arg_type_t type, uint8_t* buf, uint16_t size, uint16_t* len)
+{
+    switch (type) {
+    case ARG_TYPE_INT:
+    case ARG_TYPE_LONG:
+    case ARG_TYPE_LONG_LONG: {
+        int64_t value;
+        return read_int_arg(record, args_pos, type, &value) && put_varint(buf, size, len, zigzag_encode(value));
+    }
+    case ARG_TYPE_PTR: {
+        uintptr_t value;
+        if (*args_pos + sizeof(void*) > record->args_len) return false;
+        memcpy(&value, &record->args[*args_pos], sizeof(void*));
+        *args_pos += sizeof(void*);
+        return put_varint(buf, size, len, value);
+    }
+    case ARG_TYPE_DOUBLE:
+    case ARG_TYPE_LONG_DOUBLE: {
+        size_t arg_size = arg_type_size(type);
+        if (*args_pos + arg_size > record->args_len || *len + arg_size > size) return false;
+        memcpy(&buf[*len], &record->args[*args_pos], arg_size);
+        *args_pos += arg_size;
+        *len += arg_size;
+        return true;
+    }
+    case ARG_TYPE_STR: {
+        if (*args_pos >= record->args_len) return false;
+        bool ref = record->args[*args_pos] == STR_KIND_REF;
+        const char* str = read_str(record, args_pos);
+        if (!str) return false;
+
+        if (ref) {
+            return put_varint(buf, size, len, ((uint64_t)((uintptr_t)str - SOC_DROM_LOW) << 1) | 1);
+        }
+
+        size_t str_len = strlen(str);
+        if (!put_varint(buf, size, len, str_len << 1) || *len + str_len > size) return false;
+        memcpy(&buf[*len], str, str_len);
+        *len += str_len;
+        return true;
+    }
+    default:
+        return true;
+    }
+}
+
+uint16_t log_record_encode(const log_record_t* record, uint8_t* buf, uint16_t size)
+{
+    uint16_t args_pos = 0;
+    uint16_t len = 1;
+    uint8_t header = record->level & HEADER_LEVEL_MASK;
+
+    if (!put_varint(buf, size, &len, record->time / 1000) || !put_varint(buf, size, &len, (uintptr_t)record->fmt - SOC_DROM_LOW)) {
+        return 0;
+    }
+
+    bool truncated = record->truncated;
+    if (record->tagged) {
+        // tag of esp_log call precedes arguments of message
+        header |= HEADER_TAG;
+        if (!encode_arg(record, &args_pos, ARG_TYPE_STR, buf, size, &len)) return 0;
+    }
+
+    const char* p = record->fmt;
+    conv_spec_t spec;
+    while (args_pos < record->args_len && (p = strchr(p, '%')) != NULL) {
+        p = parse_spec(p, &spec);
+
+        if ((spec.width_arg && !encode_arg(record, &args_pos, ARG_TYPE_INT, buf, size, &len)) ||
+            (spec.precision_arg && !encode_arg(record, &args_pos, ARG_TYPE_INT, buf, size, &len)) ||
+            !encode_arg(record, &args_pos, spec.type, buf, size, &len)) {
+            truncated = true;
+            break;
+        }
+    }
+
+    if (truncated) header |= HEADER_TRUNCATED;
+    buf[0] = header;
+
+    return len;
+}
+
+static bool decode_arg(const uint8_t* buf, uint16_t len, uint16_t* pos, arg_type_t type, args_writer_t* writer)
+{
+    uint64_t value;
+
+    switch (type) {
+    case ARG_TYPE_INT:
+    case ARG_TYPE_LONG:
+    case ARG_TYPE_LONG_LONG:
+        return get_varint(buf, len, pos, &value) && write_int_arg(writer, type, zigzag_decode(value));
+    case ARG_TYPE_PTR: {
+        if (!get_varint(buf, len, pos, &value)) return false;
+        void* ptr = (void*)(uintptr_t)value;
+        return capture_arg(writer, &ptr, sizeof(void*));
+    }
+    case ARG_TYPE_DOUBLE:
+    case ARG_TYPE_LONG_DOUBLE: {
+        size_t arg_size = arg_type_size(type);
+        if (*pos + arg_size > len) return false;
+        bool ret = capture_arg(writer, &buf[*pos], arg_size);
+        *pos += arg_size;
+        return ret;
+    }
+    case ARG_TYPE_STR: {
+        if (!get_varint(buf, len, pos, &value)) return false;
+        if (value & 1) {
+            if ((value >> 1) >= DROM_SIZE) return false;
+            uint8_t kind = STR_KIND_REF;
+            const char* str = (const char*)(uintptr_t)(SOC_DROM_LOW + (value >> 1));
+            return capture_arg(writer, &kind, sizeof(uint8_t)) && capture_arg(writer, &str, sizeof(const char*));
+        }
+        size_t str_len = value >> 1;
+        if (*pos + str_len > len || memchr(&buf[*pos], '\0', str_len)) return false;
+        bool ret = capture_inline_str(writer, (const char*)&buf[*pos], str_len);
+        *pos += str_len;
+        return ret && !writer->truncated;
+    }
+    default:
+        return true;
+    }
+}
+
+bool log_record_decode(const uint8_t* buf, uint16_t len, log_record_t* record)
+{
+    uint16_t pos = 1;
+    uint64_t time;
+    uint64_t fmt_offset;
+
+    if (len < 1 || !get_varint(buf, len, &pos, &time) || !get_varint(buf, len, &pos, &fmt_offset) || fmt_offset >= DROM_SIZE) {
+        return false;
+    }
+
+    record->level = buf[0] & HEADER_LEVEL_MASK;
+    record->truncated = buf[0] & HEADER_TRUNCATED;
+    record->tagged = buf[0] & HEADER_TAG;
+    record->time = time * 1000;
+    record->fmt = (const char*)(uintptr_t)(SOC_DROM_LOW + fmt_offset);
+
+    args_writer_t writer = {
+        .args = record->args,
+        .len = 0,
+        .size = LOG_RECORD_ARGS_SIZE,
+        .truncated = false,
+    };
+
+    if (record->tagged && !decode_arg(buf, len, &pos, ARG_TYPE_STR, &writer)) return false;
+
+    const char* p = record->fmt;
+    conv_spec_t spec;
+    while (pos < len && (p = strchr(p, '%')) != NULL) {
+        p = parse_spec(p, &spec);
+
+        if ((spec.width_arg && !decode_arg(buf, len, &pos, ARG_TYPE_INT, &writer)) ||
+            (spec.precision_arg && !decode_arg(buf, len, &pos, ARG_TYPE_INT, &writer)) ||
+            !decode_arg(buf, len, &pos, spec.type, &writer)) {
+            record->truncated = true;
+            break;
+        }
+    }
+    record->args_len = writer.len;
+
+    return true;
+}
+
+const char* log_record_get_tag(const log_record_t* record)
+{
+    uint16_t args_pos = 0;
+
+    if (!record->tagged) {
+        // output of esp_log_write with Log V1 format, like from precompiled libraries, has tag in second argument
+        if (!is_esp_format(record->fmt, record->level)) return NULL;
+
+        conv_spec_t spec;
+        parse_spec(strchr(record->fmt, '%'), &spec);
+        args_pos = arg_type_size(spec.type);
+    }
+
+    return read_str(record, &args_pos);
+}
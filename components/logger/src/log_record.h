@@ -0,0 +1,107 @@
+#ifndef LOG_RECORD_H_
+#define LOG_RECORD_H_
+
+#include <esp_log.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_RECORD_ARGS_SIZE    512  // same as console line of logger, longer messages are truncated
+#define LOG_RECORD_ENCODED_SIZE (LOG_RECORD_ARGS_SIZE + LOG_RECORD_ARGS_SIZE / 4 + 16)
+
+/**
+ * @brief Unformatted log message, arguments are captured by format string, strings are copied
+ *
+ * Records in queue are allocated only with captured length of arguments, args is sized for decoded records
+ */
+typedef struct {
+    int64_t time;
+    const char* fmt;
+    esp_log_level_t level;
+    uint16_t args_len;
+    bool truncated : 1;
+    bool tagged : 1;  // from esp_log, tag is first argument and format is message without prefix
+    uint8_t args[LOG_RECORD_ARGS_SIZE];
+} log_record_t;
+
+/**
+ * @brief Get level of message formatted with Log V1 prefix, like from esp_log_write
+ *
+ * @param fmt
+ * @return esp_log_level_t ESP_LOG_NONE when format has no prefix
+ */
+esp_log_level_t log_record_parse_level(const char* fmt);
+
+/**
+ * @brief Get size of record needed to capture log message
+ *
+ * @param tag Tag of esp_log call, NULL for output of vprintf
+ * @param fmt
+ * @param l Consumed, pass copy
+ * @return size_t
+ */
+size_t log_record_measure(const char* tag, const char* fmt, va_list l);
+
+/**
+ * @brief Capture time, level and arguments of log message
+ *
+ * @param record
+ * @param size Size of record, arguments exceeding it are truncated
+ * @param level Level of esp_log call, ESP_LOG_NONE to parse it from format of vprintf
+ * @param tag Tag of esp_log call, NULL for output of vprintf
+ * @param fmt
+ * @param l
+ */
+void log_record_capture(log_record_t* record, size_t size, esp_log_level_t level, const char* tag, const char* fmt, va_list l);
+
+/**
+ * @brief Format log message, with esp_log prefix and new line for tagged records
+ *
+ * @param record
+ * @param buf
+ * @param size
+ * @return int Length of formatted message
+ */
+int log_record_render(const log_record_t* record, char* buf, size_t size);
+
+/**
+ * @brief Format only message of log record, without esp_log prefix and trailing new line
+ *
+ * @param record
+ * @param buf
+ * @param size
+ * @return int Length of formatted message
+ */
+int log_record_render_message(const log_record_t* record, char* buf, size_t size);
+
+/**
+ * @brief Encode log message to compact binary form, format and strings in flash are stored as offset to flash data segment
+ *
+ * @param record
+ * @param buf
+ * @param size
+ * @return uint16_t Length of encoded message
+ */
+uint16_t log_record_encode(const log_record_t* record, uint8_t* buf, uint16_t size);
+
+/**
+ * @brief Decode log message from compact binary form
+ *
+ * @param buf
+ * @param len
+ * @param record
+ * @return true When successfully decoded
+ * @return false When malformed
+ */
+bool log_record_decode(const uint8_t* buf, uint16_t len, log_record_t* record);
+
+/**
+ * @brief Get tag of log message written by ESP_LOGx macro or esp_log_write
+ *
+ * @param record
+ * @return const char* Tag or NULL when record has no tag
+ */
+const char* log_record_get_tag(const log_record_t* record);
+
+#endif /* LOG_RECORD_H_ */
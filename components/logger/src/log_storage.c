@@ -0,0 +1,416 @@
+#include "log_storage.h"
+
+#include <dirent.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <nvs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include "log_lz.h"
+#include "logger.h"
+
+#define STORAGE_DIR           "/usr/log"
+#define STORAGE_CURRENT       STORAGE_DIR "/current.log"
+#define STORAGE_PENDING       STORAGE_DIR "/pending.log"
+#define STORAGE_COMPRESS_TMP  STORAGE_DIR "/segment.tmp"
+#define STORAGE_SEGMENT_EXT   ".lz"
+#define STORAGE_BLOCK_SIZE    LOG_LZ_BLOCK_SIZE
+#define STORAGE_SEGMENT_SIZE  (32 * 1024)
+#define STORAGE_SEGMENT_COUNT 8
+#define STORAGE_FLUSH_PERIOD  60000
+#define STORAGE_READ_BUF_SIZE 1024
+#define COMPRESS_RETRY_PERIOD 60000
+#define COMPRESS_STACK_SIZE   (3 * 1024)
+#define COMPRESS_PRIORITY     1  // below logger flush task, queues are drained while compressing
+
+#define NVS_NAMESPACE "logger"
+#define NVS_STORAGE   "storage"
+
+static const char* TAG = "log_storage";
+
+static nvs_handle_t nvs;
+
+static SemaphoreHandle_t storage_mutex = NULL;
+
+static bool enabled = false;
+
+static char* block = NULL;
+
+static uint16_t block_len = 0;
+
+static TickType_t block_tick = 0;
+
+static uint32_t segment_first = 0;
+
+static uint32_t segment_next = 0;
+
+static uint8_t readers = 0;
+
+// full segment waiting for compression, becomes segment segment_next
+static bool pending = false;
+
+static TaskHandle_t compress_task = NULL;
+
+static void segment_path(char* path, size_t size, uint32_t segment)
+{
+    snprintf(path, size, STORAGE_DIR "/%" PRIu32 STORAGE_SEGMENT_EXT, segment);
+}
+
+static void scan_segments(void)
+{
+    bool found = false;
+
+    DIR* dir = opendir(STORAGE_DIR);
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            char* end;
+            uint32_t segment = strtoul(entry->d_name, &end, 10);
+            if (end != entry->d_name && !strcmp(end, STORAGE_SEGMENT_EXT)) {
+                if (!found || segment < segment_first) segment_first = segment;
+                if (!found || segment >= segment_next) segment_next = segment + 1;
+                found = true;
+            }
+        }
+        closedir(dir);
+    }
+}
+
+/**
+ * Remove oldest segments over count, segments are kept while some reader is reading them, mutex must be locked
+ */
+static void remove_old_segments(uint32_t count)
+{
+    char path[32];
+
+    while (readers == 0 && segment_next - segment_first > count) {
+        segment_path(path, sizeof(path), segment_first++);
+        remove(path);
+    }
+}
+
+/**
+ * Compress pending segment, runs without mutex, pending file is not changed until it is compressed
+ */
+static void compress_pending(void)
+{
+    char path[32];
+    segment_path(path, sizeof(path), segment_next);
+
+    // segment appears complete or not at all
+    esp_err_t ret = log_lz_compress_file(STORAGE_PENDING, STORAGE_COMPRESS_TMP);
+    if (ret == ESP_OK && rename(STORAGE_COMPRESS_TMP, path) != 0) {
+        ret = ESP_FAIL;
+    }
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    if (ret == ESP_OK) {
+        segment_next++;
+        pending = false;
+        remove(STORAGE_PENDING);
+        remove_old_segments(STORAGE_SEGMENT_COUNT);
+    } else {
+        ESP_LOGE(TAG, "Failed to compress segment (%s)", esp_err_to_name(ret));
+        remove(STORAGE_COMPRESS_TMP);
+        // pending file is kept and compressed on retry, free space for it
+        remove_old_segments(segment_next - segment_first > 0 ? segment_next - segment_first - 1 : 0);
+    }
+    xSemaphoreGive(storage_mutex);
+}
+
+static void compress_task_func(void* param)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pending ? pdMS_TO_TICKS(COMPRESS_RETRY_PERIOD) : portMAX_DELAY);
+
+        if (pending) {
+            compress_pending();
+        }
+    }
+}
+
+/**
+ * Hand full current file to compress task, mutex must be locked
+ */
+static void rotate(long size)
+{
+    if (!pending) {
+        if (rename(STORAGE_CURRENT, STORAGE_PENDING) == 0) {
+            pending = true;
+            xTaskNotifyGive(compress_task);
+        }
+    } else if (size >= 2 * STORAGE_SEGMENT_SIZE && readers == 0) {
+        // previous segment still not compressed, current file is discarded only when no reader has offset in it
+        ESP_LOGE(TAG, "Current segment discarded");
+        remove(STORAGE_CURRENT);
+    }
+}
+
+static void write_block(void)
+{
+    if (block_len > 0) {
+        FILE* file = fopen(STORAGE_CURRENT, "a");
+        if (file) {
+            fwrite(block, sizeof(char), block_len, file);
+            long size = ftell(file);
+            fclose(file);
+
+            if (size >= STORAGE_SEGMENT_SIZE) {
+                rotate(size);
+            }
+        }
+        block_len = 0;
+    }
+}
+
+static void shutdown_handler(void)
+{
+    if (xSemaphoreTake(storage_mutex, pdMS_TO_TICKS(1000))) {
+        write_block();
+        xSemaphoreGive(storage_mutex);
+    }
+}
+
+void log_storage_init(void)
+{
+    ESP_ERROR_CHECK(nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs));
+
+    uint8_t u8;
+    if (nvs_get_u8(nvs, NVS_STORAGE, &u8) == ESP_OK) {
+        enabled = u8;
+    }
+
+    mkdir(STORAGE_DIR, 0755);
+    scan_segments();
+
+    struct stat st;
+    pending = stat(STORAGE_PENDING, &st) == 0;
+    remove(STORAGE_COMPRESS_TMP);
+
+    block = (char*)malloc(STORAGE_BLOCK_SIZE);
+    storage_mutex = xSemaphoreCreateMutex();
+
+    xTaskCreate(compress_task_func, "log_compress", COMPRESS_STACK_SIZE, NULL, COMPRESS_PRIORITY, &compress_task);
+    if (pending) {
+        xTaskNotifyGive(compress_task);
+    }
+
+    esp_register_shutdown_handler(shutdown_handler);
+}
+
+void log_storage_append(const char* str, uint16_t len)
+{
+    if (!enabled || !block) return;
+
+    // reader holds mutex only for short chunks
+    if (xSemaphoreTake(storage_mutex, portMAX_DELAY)) {
+        if (block_len == 0) {
+            block_tick = xTaskGetTickCount();
+        }
+
+        while (len > 0) {
+            uint16_t chunk = len < STORAGE_BLOCK_SIZE - block_len ? len : STORAGE_BLOCK_SIZE - block_len;
+            memcpy(&block[block_len], str, chunk);
+            block_len += chunk;
+            str += chunk;
+            len -= chunk;
+
+            if (block_len == STORAGE_BLOCK_SIZE) {
+                write_block();
+                block_tick = xTaskGetTickCount();
+            }
+        }
+
+        xSemaphoreGive(storage_mutex);
+    }
+}
+
+void log_storage_process(void)
+{
+    if (block_len > 0 && (!enabled || xTaskGetTickCount() - block_tick >= pdMS_TO_TICKS(STORAGE_FLUSH_PERIOD))) {
+        if (xSemaphoreTake(storage_mutex, portMAX_DELAY)) {
+            write_block();
+            xSemaphoreGive(storage_mutex);
+        }
+    }
+}
+
+void logger_set_storage_enabled(bool _enabled)
+{
+    enabled = _enabled;
+
+    nvs_set_u8(nvs, NVS_STORAGE, enabled);
+    nvs_commit(nvs);
+}
+
+bool logger_is_storage_enabled(void)
+{
+    return enabled;
+}
+
+typedef struct {
+    logger_storage_read_cb_t cb;
+    void* ctx;
+    size_t pos;
+    size_t end;
+} range_ctx_t;
+
+/**
+ * Pass only range of segment, beginning was already read from current file before rotation, rest was appended after read started
+ */
+static esp_err_t range_cb(const char* buf, size_t len, void* ctx)
+{
+    range_ctx_t* range = (range_ctx_t*)ctx;
+
+    size_t from = MIN(range->pos, len);
+    size_t to = MIN(range->end, len);
+    range->pos -= from;
+    range->end -= to;
+
+    return to > from ? range->cb(buf + from, to - from, range->ctx) : ESP_OK;
+}
+
+/**
+ * Get size of file, mutex must be locked
+ */
+static size_t file_size(const char* path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_size : 0;
+}
+
+/**
+ * Read chunk of file, mutex must be locked
+ */
+static size_t read_file(const char* path, size_t pos, char* buf, size_t size)
+{
+    size_t len = 0;
+    FILE* file = fopen(path, "r");
+    if (file) {
+        if (fseek(file, pos, SEEK_SET) == 0) {
+            len = fread(buf, sizeof(char), size, file);
+        }
+        fclose(file);
+    }
+
+    return len;
+}
+
+/**
+ * Read chunk of current file followed by pending block, mutex must be locked
+ */
+static size_t read_current(size_t pos, char* buf, size_t size)
+{
+    size_t size_file = file_size(STORAGE_CURRENT);
+
+    if (pos < size_file) {
+        return read_file(STORAGE_CURRENT, pos, buf, MIN(size, size_file - pos));
+    }
+
+    pos -= size_file;
+    size_t len = 0;
+    if (pos < block_len) {
+        len = MIN(block_len - pos, size);
+        memcpy(buf, &block[pos], len);
+    }
+
+    return len;
+}
+
+/**
+ * Read range of not yet compressed segment, pending file or current file, from its compressed segment when it was compressed meanwhile
+ */
+static esp_err_t read_uncompressed(uint32_t segment, size_t end, char* buf, logger_storage_read_cb_t cb, void* ctx)
+{
+    esp_err_t ret = ESP_OK;
+    size_t pos = 0;
+
+    while (ret == ESP_OK && pos < end) {
+        xSemaphoreTake(storage_mutex, portMAX_DELAY);
+        if (segment_next > segment) {
+            xSemaphoreGive(storage_mutex);
+
+            range_ctx_t range = {
+                .cb = cb,
+                .ctx = ctx,
+                .pos = pos,
+                .end = end,
+            };
+            char path[32];
+            segment_path(path, sizeof(path), segment);
+            ret = log_lz_decompress_file(path, range_cb, &range);
+            if (ret == ESP_ERR_NOT_FOUND) ret = ESP_OK;
+            break;
+        }
+        size_t len;
+        if (pending && segment == segment_next) {
+            len = read_file(STORAGE_PENDING, pos, buf, MIN(end - pos, STORAGE_READ_BUF_SIZE));
+        } else {
+            len = read_current(pos, buf, MIN(end - pos, STORAGE_READ_BUF_SIZE));
+        }
+        xSemaphoreGive(storage_mutex);
+
+        if (len == 0) break;
+        ret = cb(buf, len, ctx);
+        pos += len;
+    }
+
+    return ret;
+}
+
+esp_err_t logger_storage_read(logger_storage_read_cb_t cb, void* ctx)
+{
+    if (!storage_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    char* buf = (char*)malloc(STORAGE_READ_BUF_SIZE);
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // mutex is held only for short chunks, callback is called without it and appending is not blocked for whole download
+    // logs appended after start are not read, pending and current file are read from their segments when compressed meanwhile
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    readers++;
+    uint32_t segment = segment_first;
+    uint32_t last_segment = segment_next;
+    size_t pending_end = pending ? file_size(STORAGE_PENDING) : 0;
+    uint32_t current_segment = segment_next + (pending ? 1 : 0);
+    size_t end = file_size(STORAGE_CURRENT) + block_len;
+    xSemaphoreGive(storage_mutex);
+
+    esp_err_t ret = ESP_OK;
+    char path[32];
+
+    // segments are not removed while reading
+    for (; ret == ESP_OK && segment < last_segment; segment++) {
+        segment_path(path, sizeof(path), segment);
+        ret = log_lz_decompress_file(path, cb, ctx);
+        if (ret == ESP_ERR_NOT_FOUND) ret = ESP_OK;
+    }
+
+    if (ret == ESP_OK && pending_end > 0) {
+        ret = read_uncompressed(last_segment, pending_end, buf, cb, ctx);
+    }
+
+    if (ret == ESP_OK) {
+        ret = read_uncompressed(current_segment, end, buf, cb, ctx);
+    }
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    readers--;
+    remove_old_segments(STORAGE_SEGMENT_COUNT);
+    xSemaphoreGive(storage_mutex);
+
+    free((void*)buf);
+
+    return ret;
+}
@@ -0,0 +1,26 @@
+#ifndef LOG_STORAGE_H_
+#define LOG_STORAGE_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Initialize log storage, requires NVS and mounted file system, call only from logger flush task
+ *
+ */
+void log_storage_init(void);
+
+/**
+ * @brief Append log line to pending block, call only from logger flush task
+ *
+ * @param str
+ * @param len
+ */
+void log_storage_append(const char* str, uint16_t len);
+
+/**
+ * @brief Write pending block when flush period elapsed, call only from logger flush task
+ *
+ */
+void log_storage_process(void);
+
+#endif /* LOG_STORAGE_H_ */
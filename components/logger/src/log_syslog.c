@@ -0,0 +1,360 @@
+#include "log_syslog.h"
+
+#include <esp_app_desc.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <inttypes.h>
+#include <lwip/netdb.h>
+#include <lwip/sockets.h>
+#include <nvs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "discovery.h"
+#include "logger.h"
+#include "wifi.h"
+
+#define NVS_NAMESPACE     "logger"
+#define NVS_SYSLOG        "syslog"
+#define NVS_SYSLOG_HOST   "syslog_host"
+#define NVS_SYSLOG_PORT   "syslog_port"
+#define NVS_SYSLOG_FORMAT "syslog_format"
+#define NVS_SYSLOG_RATE   "syslog_rate"
+
+#define DEFAULT_PORT    514
+#define DEFAULT_RATE    20
+#define DATAGRAM_SIZE   1024  // fits into single ethernet frame
+#define HEADER_SIZE     160
+#define RESOLVE_PERIOD  30000
+#define FACILITY_LOCAL0 16
+#define MIN_VALID_TIME  1609459200  // 2021-01-01, before NTP sync timestamp is omitted
+
+static const char* TAG = "log_syslog";
+
+static nvs_handle_t nvs;
+
+static SemaphoreHandle_t syslog_mutex = NULL;
+
+static bool enabled = false;
+
+static char host[64];
+
+static uint16_t port = DEFAULT_PORT;
+
+static logger_syslog_format_t format = LOGGER_SYSLOG_FORMAT_RFC5424;
+
+static uint16_t rate = DEFAULT_RATE;
+
+static int sock = -1;
+
+static struct sockaddr_in addr;
+
+static bool addr_valid = false;
+
+static bool resolve_pending = true;
+
+static TickType_t resolve_tick = 0;
+
+static char* datagram = NULL;
+
+static uint16_t datagram_len = 0;
+
+static char hostname[32];
+
+static uint16_t tokens = 0;
+
+static TickType_t tokens_tick = 0;
+
+static uint32_t suppressed = 0;
+
+static bool resolve(void)
+{
+    if (addr_valid) return true;
+
+    if (!resolve_pending && xTaskGetTickCount() - resolve_tick < pdMS_TO_TICKS(RESOLVE_PERIOD)) return false;
+    resolve_pending = false;
+    resolve_tick = xTaskGetTickCount();
+
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_DGRAM,
+    };
+    struct addrinfo* res = NULL;
+
+    // blocks flush task only for host names, queued lines wait meanwhile
+    if (getaddrinfo(host, NULL, &hints, &res) != 0 || !res) {
+        ESP_LOGW(TAG, "Failed to resolve %s", host);
+        return false;
+    }
+
+    memcpy(&addr, res->ai_addr, sizeof(addr));
+    addr.sin_port = htons(port);
+    freeaddrinfo(res);
+
+    if (sock < 0) {
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    }
+    addr_valid = sock >= 0;
+
+    return addr_valid;
+}
+
+static void send_datagram(void)
+{
+    if (datagram_len > 0 && wifi_event_group && wifi_is_sta_connected() && resolve()) {
+        sendto(sock, datagram, datagram_len, 0, (struct sockaddr*)&addr, sizeof(addr));
+    }
+    datagram_len = 0;
+}
+
+static bool rate_take(void)
+{
+    if (!rate) return true;
+
+    TickType_t now = xTaskGetTickCount();
+    uint32_t refill = pdTICKS_TO_MS(now - tokens_tick) * rate / 1000;
+    if (refill > 0) {
+        tokens = MIN(tokens + refill, rate);
+        tokens_tick = now;
+    }
+
+    if (tokens > 0) {
+        tokens--;
+        return true;
+    }
+
+    return false;
+}
+
+static uint8_t level_to_severity(esp_log_level_t level)
+{
+    switch (level) {
+    case ESP_LOG_ERROR:
+        return 3;
+    case ESP_LOG_WARN:
+        return 4;
+    case ESP_LOG_INFO:
+        return 6;
+    case ESP_LOG_DEBUG:
+    case ESP_LOG_VERBOSE:
+        return 7;
+    default:
+        return 5;
+    }
+}
+
+static void format_timestamp(char* buf, size_t size, int64_t record_time)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if (tv.tv_sec < MIN_VALID_TIME) {
+        strlcpy(buf, "-", size);
+        return;
+    }
+
+    // record time is esp timer, shift wall clock by record age
+    int64_t us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - (esp_timer_get_time() - record_time);
+    time_t sec = us / 1000000;
+    struct tm tm;
+    gmtime_r(&sec, &tm);
+
+    size_t len = strftime(buf, size, "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(&buf[len], size - len, ".%03dZ", (int)(us / 1000 % 1000));
+}
+
+static uint16_t copy_message(char* dst, uint16_t size, const char* src, uint16_t len)
+{
+    // strip colors, message is single line
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < len && n < size; i++) {
+        if (src[i] == '\033') {
+            while (i < len && src[i] != 'm') i++;
+        } else if (n > 0 || src[i] != ' ') {
+            dst[n++] = src[i] == '\n' || src[i] == '\r' ? ' ' : src[i];
+        }
+    }
+    while (n > 0 && dst[n - 1] == ' ') n--;
+
+    return n;
+}
+
+/**
+ * Send message as single datagram, RFC 5426 does not allow more messages in one datagram
+ */
+static void send_message(esp_log_level_t level, const char* tag, int64_t time, const char* msg, uint16_t len)
+{
+    char header[HEADER_SIZE];
+    int header_len = 0;
+    if (format == LOGGER_SYSLOG_FORMAT_RFC5424) {
+        discovery_get_hostname(hostname, sizeof(hostname));
+
+        char timestamp[32];
+        format_timestamp(timestamp, sizeof(timestamp), time);
+
+        header_len = snprintf(header, sizeof(header), "<%d>1 %s %s %s - %.32s - ", FACILITY_LOCAL0 * 8 + level_to_severity(level), timestamp, hostname,
+                              esp_app_get_description()->project_name, tag ? tag : "-");
+        header_len = MIN(header_len, (int)sizeof(header) - 1);
+    }
+
+    memcpy(datagram, header, header_len);
+    datagram_len = header_len;
+    datagram_len += copy_message(&datagram[datagram_len], DATAGRAM_SIZE - datagram_len - 1, msg, len);
+    if (format == LOGGER_SYSLOG_FORMAT_RAW) {
+        datagram[datagram_len++] = '\n';
+    }
+
+    send_datagram();
+}
+
+void log_syslog_init(void)
+{
+    ESP_ERROR_CHECK(nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs));
+
+    uint8_t u8;
+    if (nvs_get_u8(nvs, NVS_SYSLOG, &u8) == ESP_OK) {
+        enabled = u8;
+    }
+    size_t len = sizeof(host);
+    nvs_get_str(nvs, NVS_SYSLOG_HOST, host, &len);
+    nvs_get_u16(nvs, NVS_SYSLOG_PORT, &port);
+    if (nvs_get_u8(nvs, NVS_SYSLOG_FORMAT, &u8) == ESP_OK && u8 < LOGGER_SYSLOG_FORMAT_MAX) {
+        format = u8;
+    }
+    nvs_get_u16(nvs, NVS_SYSLOG_RATE, &rate);
+    tokens = rate;
+
+    syslog_mutex = xSemaphoreCreateMutex();
+}
+
+void log_syslog_append(const log_record_t* record, const char* line, uint16_t len)
+{
+    if (!enabled || !syslog_mutex) return;
+
+    xSemaphoreTake(syslog_mutex, portMAX_DELAY);
+
+    if (!datagram) {
+        datagram = (char*)malloc(DATAGRAM_SIZE);
+    }
+
+    if (datagram) {
+        if (rate_take()) {
+            if (suppressed) {
+                char note[64];
+                int note_len = snprintf(note, sizeof(note), "%" PRIu32 " messages suppressed by rate limit", suppressed);
+                send_message(ESP_LOG_WARN, TAG, record->time, note, note_len);
+                suppressed = 0;
+            }
+            if (format == LOGGER_SYSLOG_FORMAT_RFC5424) {
+                // message body without esp_log prefix, level is in PRI and tag in MSGID
+                char body[LOGGER_LINE_SIZE];
+                uint16_t body_len = log_record_render_message(record, body, sizeof(body));
+                send_message(record->level, log_record_get_tag(record), record->time, body, body_len);
+            } else {
+                send_message(record->level, log_record_get_tag(record), record->time, line, len);
+            }
+        } else {
+            suppressed++;
+        }
+    }
+
+    xSemaphoreGive(syslog_mutex);
+}
+
+esp_err_t logger_set_syslog_config(bool _enabled, const char* _host, uint16_t _port, logger_syslog_format_t _format, uint16_t _rate)
+{
+    if (!syslog_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (_host && strlen(_host) >= sizeof(host)) {
+        ESP_LOGE(TAG, "Host too long");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (_enabled && (_host ? !strlen(_host) : !strlen(host))) {
+        ESP_LOGE(TAG, "Host required");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (_format >= LOGGER_SYSLOG_FORMAT_MAX) {
+        ESP_LOGE(TAG, "Invalid format");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(syslog_mutex, portMAX_DELAY);
+
+    enabled = _enabled;
+    if (_host) {
+        strlcpy(host, _host, sizeof(host));
+    }
+    port = _port ? _port : DEFAULT_PORT;
+    format = _format;
+    rate = _rate;
+
+    addr_valid = false;
+    resolve_pending = true;
+    datagram_len = 0;
+    tokens = rate;
+    suppressed = 0;
+    if (!enabled) {
+        free((void*)datagram);
+        datagram = NULL;
+    }
+
+    xSemaphoreGive(syslog_mutex);
+
+    nvs_set_u8(nvs, NVS_SYSLOG, enabled);
+    nvs_set_str(nvs, NVS_SYSLOG_HOST, host);
+    nvs_set_u16(nvs, NVS_SYSLOG_PORT, port);
+    nvs_set_u8(nvs, NVS_SYSLOG_FORMAT, format);
+    nvs_set_u16(nvs, NVS_SYSLOG_RATE, rate);
+    nvs_commit(nvs);
+
+    return ESP_OK;
+}
+
+bool logger_is_syslog_enabled(void)
+{
+    return enabled;
+}
+
+void logger_get_syslog_host(char* value, size_t value_size)
+{
+    strlcpy(value, host, value_size);
+}
+
+uint16_t logger_get_syslog_port(void)
+{
+    return port;
+}
+
+logger_syslog_format_t logger_get_syslog_format(void)
+{
+    return format;
+}
+
+uint16_t logger_get_syslog_rate(void)
+{
+    return rate;
+}
+
+const char* logger_syslog_format_to_str(logger_syslog_format_t value)
+{
+    switch (value) {
+    case LOGGER_SYSLOG_FORMAT_RAW:
+        return "raw";
+    default:
+        return "rfc5424";
+    }
+}
+
+logger_syslog_format_t logger_str_to_syslog_format(const char* str)
+{
+    if (str && !strcmp(str, "raw")) {
+        return LOGGER_SYSLOG_FORMAT_RAW;
+    }
+    return LOGGER_SYSLOG_FORMAT_RFC5424;
+}
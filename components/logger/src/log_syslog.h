@@ -0,0 +1,23 @@
+#ifndef LOG_SYSLOG_H_
+#define LOG_SYSLOG_H_
+
+#include <stdint.h>
+
+#include "log_record.h"
+
+/**
+ * @brief Initialize syslog sink, requires NVS, call only from logger flush task
+ *
+ */
+void log_syslog_init(void);
+
+/**
+ * @brief Send log record as datagram, call only from logger flush task
+ *
+ * @param record Source record, for level, tag, time and message
+ * @param line Formatted line, sent as is in raw format
+ * @param len
+ */
+void log_syslog_append(const log_record_t* record, const char* line, uint16_t len);
+
+#endif /* LOG_SYSLOG_H_ */
@@ -1,24 +1,52 @@
 #include "logger.h"
 
+#include <esp_app_desc.h>
 #include <esp_log.h>
 #include <esp_private/panic_internal.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <memory.h>
 #include <stdio.h>
+#include <soc/soc.h>
 #include <sys/param.h>
 
 #include "sdkconfig.h"
 
+#include "log_queue.h"
+#include "log_storage.h"
+#include "log_syslog.h"
 #include "output_buffer.h"
 
-#define LOG_BUFFER_SIZE 6096  // 4096
-#define LOG_LINE_SIZE   512
-#define PANIC_MAGIC     0xDEADC0DE
-#define PANIC_LOG_SIZE  2048
+#define LOG_BUFFER_SIZE       6096  // 4096
+#define LOG_BUFFER_INDEX_SIZE (LOG_BUFFER_SIZE / 16)
+#define BINARY_MAGIC          "ELOG"
+#define BINARY_VERSION        2
+#define PANIC_MAGIC           0xDEADC0DE
+#define PANIC_LOG_SIZE        2048
+#define FLUSH_PERIOD          100
+#define FLUSH_THRESHOLD       (LOG_QUEUE_SIZE / 2)  // bytes
+#define FLUSH_STACK_SIZE      (5 * 1024)
+#define FLUSH_PRIORITY        5
+
+ESP_STATIC_ASSERT(LOGGER_BINARY_SIZE >= LOG_RECORD_ENCODED_SIZE, "Binary entry size too small");
+
+static const char* TAG = "logger";
 
 static SemaphoreHandle_t s_mutex;
 
+static log_queue_t s_queues[portNUM_PROCESSORS];
+
+static TaskHandle_t s_flush_task;
+
+static uint32_t s_dropped_count;
+
+static volatile bool s_storage_init = false;
+
+static volatile bool s_syslog_init = false;
+
+static bool s_panic_new = false;
+
 static uint8_t s_log_buffer_data[LOG_BUFFER_SIZE];
 
 static output_buffer_t* s_log_buffer;
@@ -32,46 +60,249 @@ typedef struct {
 
 static RTC_NOINIT_ATTR panic_t s_panic;
 
+static void logger_capture(esp_log_level_t level, const char* tag, const char* fmt, va_list l)
+{
+    // called from any task, only capture arguments, formatting is deferred to flush task
+    log_queue_t* queue = &s_queues[xPortGetCoreID()];
+
+    va_list copy;
+    va_copy(copy, l);
+    size_t size = log_record_measure(tag, fmt, copy);
+    va_end(copy);
+
+    log_record_t* record = log_queue_reserve(queue, size);
+    if (record) {
+        log_record_capture(record, size, level, tag, fmt, l);
+        level = record->level;
+        log_queue_commit(record);
+
+        // errors are flushed immediately, they are not lost when system crashes shortly after
+        if (s_flush_task && (level == ESP_LOG_ERROR || log_queue_get_used(queue) >= FLUSH_THRESHOLD)) {
+            if (xPortInIsrContext()) {
+                vTaskNotifyGiveFromISR(s_flush_task, NULL);
+            } else {
+                xTaskNotifyGive(s_flush_task);
+            }
+        }
+    }
+}
+
 static int logger_vprintf(const char* str, va_list l)
 {
+    // output of esp_log_write and printf to log, without tag
+    logger_capture(ESP_LOG_NONE, NULL, str, l);
+
+    return 0;
+}
+
+static void logger_output(const log_record_t* record, char* line)
+{
+    // RAM buffer keeps compact binary records, text is formatted only for console and storage
+    uint8_t data[LOG_RECORD_ENCODED_SIZE];
+    uint16_t data_len = log_record_encode(record, data, sizeof(data));
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    output_buffer_append_buf(s_log_buffer, (const char*)data, data_len);
+    xSemaphoreGive(s_mutex);
+
+#ifndef CONFIG_ESP_CONSOLE_UART
+    if (logger_is_storage_enabled() || logger_is_syslog_enabled())
+#endif /* CONFIG_ESP_CONSOLE_UART */
+    {
+        int len = log_record_render(record, line, LOGGER_LINE_SIZE);
 #ifdef CONFIG_ESP_CONSOLE_UART
-    vprintf(str, l);
+        fwrite(line, sizeof(char), len, stdout);
 #endif /* CONFIG_ESP_CONSOLE_UART */
+        log_storage_append(line, len);
+        log_syslog_append(record, line, len);
+    }
+}
 
-    xSemaphoreTake(s_mutex, portMAX_DELAY);
+static void logger_storage_start(char* line)
+{
+    log_storage_init();
 
-    static char log[LOG_LINE_SIZE];
-    int len = vsnprintf(log, LOG_LINE_SIZE, str, l);
+    if (s_panic_new) {
+        const char* panic_header = "Panic log:\n";
+        log_storage_append(panic_header, strlen(panic_header));
+        log_storage_append(s_panic.log, s_panic.log_len);
+    }
+
+    // persist lines logged before storage init, flush task is the only writer of log buffer
+    uint32_t index = 0;
+    char* data;
+    uint16_t data_len;
+    log_record_t record;
+    while (output_buffer_read(s_log_buffer, &index, &data, &data_len)) {
+        if (log_record_decode((const uint8_t*)data, data_len, &record)) {
+            log_storage_append(line, log_record_render(&record, line, LOGGER_LINE_SIZE));
+        }
+    }
+}
 
-    output_buffer_append_buf(s_log_buffer, log, len);
+static void logger_flush(char* line)
+{
+    uint32_t dropped = 0;
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        dropped += log_queue_take_dropped(&s_queues[i]);
+    }
+    if (dropped) {
+        s_dropped_count += dropped;
+        ESP_LOGW(TAG, "%" PRIu32 " messages dropped", dropped);
+    }
 
-    xSemaphoreGive(s_mutex);
+    while (true) {
+        // merge queues by call time
+        log_queue_t* queue = NULL;
+        log_record_t* record = NULL;
+        for (int i = 0; i < portNUM_PROCESSORS; i++) {
+            log_record_t* candidate = log_queue_peek(&s_queues[i]);
+            if (candidate && (!record || candidate->time < record->time)) {
+                queue = &s_queues[i];
+                record = candidate;
+            }
+        }
+        if (!record) break;
 
-    return len;
+        logger_output(record, line);
+        log_queue_pop(queue);
+    }
+}
+
+static void logger_flush_task_func(void* param)
+{
+    char line[LOGGER_LINE_SIZE];
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FLUSH_PERIOD));
+
+        if (s_syslog_init) {
+            s_syslog_init = false;
+            log_syslog_init();
+        }
+
+        if (s_storage_init) {
+            s_storage_init = false;
+            logger_storage_start(line);
+        }
+
+        logger_flush(line);
+        log_storage_process();
+    }
 }
 
 void logger_init(void)
 {
     s_mutex = xSemaphoreCreateMutex();
 
-    s_log_buffer = output_buffer_create_static(LOG_BUFFER_SIZE, s_log_buffer_data);
+    s_log_buffer = output_buffer_create_static(LOG_BUFFER_SIZE, LOG_BUFFER_INDEX_SIZE, s_log_buffer_data);
+
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        log_queue_init(&s_queues[i]);
+    }
 
     esp_log_set_vprintf(logger_vprintf);
 
+    xTaskCreate(logger_flush_task_func, "logger_flush", FLUSH_STACK_SIZE, NULL, FLUSH_PRIORITY, &s_flush_task);
+
     // Set panic time, after reboot
-    if (s_panic.magic == PANIC_MAGIC && !s_panic.time) s_panic.time = time(NULL);
+    if (s_panic.magic == PANIC_MAGIC && !s_panic.time) {
+        s_panic.time = time(NULL);
+        s_panic_new = true;
+    }
+}
+
+void logger_storage_init(void)
+{
+    s_storage_init = true;
+    xTaskNotifyGive(s_flush_task);
+}
+
+void logger_syslog_init(void)
+{
+    s_syslog_init = true;
+    xTaskNotifyGive(s_flush_task);
+}
+
+uint32_t logger_log_buffer_get_count(void)
+{
+    return s_log_buffer->next;
+}
+
+uint32_t logger_get_dropped_count(void)
+{
+    return s_dropped_count;
+}
+
+static bool logger_filter_match(const logger_filter_t* filter, const log_record_t* record)
+{
+    if (!filter) return true;
+
+    if (record->level != ESP_LOG_NONE && record->level > filter->level) return false;
+
+    if (filter->tag) {
+        const char* tag = log_record_get_tag(record);
+        if (!tag || strcmp(tag, filter->tag)) return false;
+    }
+
+    return true;
+}
+
+bool logger_log_bugger_read(uint32_t* index, const logger_filter_t* filter, char* str, uint16_t size, uint16_t* len)
+{
+    bool has_next = false;
+    char* data;
+    uint16_t data_len;
+    log_record_t record;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    while (!has_next && output_buffer_read(s_log_buffer, index, &data, &data_len)) {
+        if (log_record_decode((const uint8_t*)data, data_len, &record) && logger_filter_match(filter, &record)) {
+            *len = log_record_render(&record, str, size);
+            has_next = true;
+        }
+    }
+
+    xSemaphoreGive(s_mutex);
+
+    return has_next;
 }
 
-uint16_t logger_log_buffer_get_count(void)
+uint16_t logger_log_buffer_get_binary_header(uint8_t* data, uint16_t size)
 {
-    return s_log_buffer->count;
+    uint16_t len = sizeof(BINARY_MAGIC) - 1 + sizeof(uint8_t) + sizeof(uint32_t) + LOGGER_ELF_SHA_SIZE;
+    if (size < len) return 0;
+
+    uint32_t drom_base = SOC_DROM_LOW;
+    memcpy(data, BINARY_MAGIC, sizeof(BINARY_MAGIC) - 1);
+    data[4] = BINARY_VERSION;
+    memcpy(&data[5], &drom_base, sizeof(uint32_t));
+
+    char elf_sha[LOGGER_ELF_SHA_SIZE + 1];
+    esp_app_get_elf_sha256(elf_sha, sizeof(elf_sha));
+    memcpy(&data[9], elf_sha, LOGGER_ELF_SHA_SIZE);
+
+    return len;
 }
 
-bool logger_log_bugger_read(uint16_t* index, char** str, uint16_t* len)
+bool logger_log_buffer_read_binary(uint32_t* index, const logger_filter_t* filter, uint8_t* data, uint16_t size, uint16_t* len)
 {
+    bool has_next = false;
+    char* entry;
+    uint16_t entry_len;
+    log_record_t record;
+
     xSemaphoreTake(s_mutex, portMAX_DELAY);
 
-    bool has_next = output_buffer_read(s_log_buffer, index, str, len);
+    while (!has_next && output_buffer_read(s_log_buffer, index, &entry, &entry_len)) {
+        // level and tag are known only from decoded record
+        if (!filter || (log_record_decode((const uint8_t*)entry, entry_len, &record) && logger_filter_match(filter, &record))) {
+            *len = MIN(entry_len, size);
+            memcpy(data, entry, *len);
+            has_next = true;
+        }
+    }
 
     xSemaphoreGive(s_mutex);
 
@@ -115,3 +346,38 @@ void IRAM_ATTR __wrap_esp_panic_handler(panic_info_t* info)
 
     __real_esp_panic_handler(info);
 }
+
+#if CONFIG_LOG_VERSION_2
+extern void __real_esp_log_va(esp_log_config_t config, const char* tag, const char* format, va_list args);
+
+/**
+ * Log V2 writes prefix, message and new line with separate vprintf calls, whole ESP_LOGx call is captured as one record here
+ */
+void __wrap_esp_log_va(esp_log_config_t config, const char* tag, const char* format, va_list args)
+{
+    esp_log_level_t level = config.opts.log_level;
+
+    if (!s_flush_task || config.opts.constrained_env) {
+        // before init or from early boot, cache disabled or panic
+        __real_esp_log_va(config, tag, format, args);
+        return;
+    }
+
+#if CONFIG_LOG_DYNAMIC_LEVEL_CONTROL
+    if (level > esp_log_level_get(tag)) return;
+#else
+    if (level > CONFIG_LOG_DEFAULT_LEVEL) return;
+#endif /* CONFIG_LOG_DYNAMIC_LEVEL_CONTROL */
+
+    // without formatting flag message is already prefixed
+    logger_capture(level, config.opts.require_formatting ? tag : NULL, format, args);
+}
+
+void __wrap_esp_log(esp_log_config_t config, const char* tag, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    __wrap_esp_log_va(config, tag, format, args);
+    va_end(args);
+}
+#endif /* CONFIG_LOG_VERSION_2 */
@@ -1,31 +1,29 @@
 #include "logger_task.h"
 
-#include <unistd.h>
-
 #include "improv.h"
 #include "logger.h"
+#include "serial_port.h"
 
 static void logger_task_func(void* param)
 {
-    int fd = (int)(intptr_t)param;
+    uart_port_t port = (uart_port_t)(intptr_t)param;
 
-    char* str;
+    char str[LOGGER_LINE_SIZE];
     uint16_t str_len;
-    uint16_t index = 0;
+    uint32_t index = 0;
     while (true) {
-        while (logger_log_bugger_read(&index, &str, &str_len)) {
-            write(fd, str, str_len);
-            fsync(fd);
+        while (logger_log_bugger_read(&index, NULL, str, sizeof(str), &str_len)) {
+            serial_port_write(port, str, str_len);
         }
 
-        improv_handle(fd);  // max delay 250ms
+        improv_handle(port);  // max delay 250ms
     }
 }
 
-TaskHandle_t logger_task_start(int fd)
+TaskHandle_t logger_task_start(uart_port_t port)
 {
     TaskHandle_t handle = NULL;
-    xTaskCreate(logger_task_func, "logger", 3 * 1024, (void*)fd, 5, &handle);
+    xTaskCreate(logger_task_func, "logger", 4 * 1024, (void*)port, 5, &handle);
     return handle;
 }
 
@@ -3,28 +3,35 @@
 #include <memory.h>
 #include <stdlib.h>
 
+static void output_buffer_init(output_buffer_t* buffer, uint16_t size, uint16_t index_size)
+{
+    buffer->size = size;
+    buffer->index_size = index_size;
+    buffer->index = (uint16_t*)malloc(sizeof(uint16_t) * buffer->index_size);
+    buffer->head = 0;
+    buffer->tail = 0;
+    buffer->first = 0;
+    buffer->next = 0;
+}
+
 output_buffer_t* output_buffer_create(uint16_t size)
 {
     output_buffer_t* buffer = (output_buffer_t*)malloc(sizeof(output_buffer_t));
 
+    output_buffer_init(buffer, size, size / OUTPUT_BUFFER_AVG_ENTRY_SIZE);
     buffer->is_static = false;
-    buffer->size = size;
-    buffer->count = 0;
     buffer->data = (uint8_t*)malloc(sizeof(uint8_t) * size);
-    buffer->append = buffer->data;
 
     return buffer;
 }
 
-output_buffer_t* output_buffer_create_static(uint16_t size, uint8_t* buf)
+output_buffer_t* output_buffer_create_static(uint16_t size, uint16_t index_size, uint8_t* buf)
 {
     output_buffer_t* buffer = (output_buffer_t*)malloc(sizeof(output_buffer_t));
 
+    output_buffer_init(buffer, size, index_size);
     buffer->is_static = true;
-    buffer->size = size;
-    buffer->count = 0;
     buffer->data = buf;
-    buffer->append = buffer->data;
 
     return buffer;
 }
@@ -32,35 +39,55 @@ output_buffer_t* output_buffer_create_static(uint16_t size, uint8_t* buf)
 void output_buffer_delete(output_buffer_t* buffer)
 {
     if (!buffer->is_static) free((void*)buffer->data);
+    free((void*)buffer->index);
     free((void*)buffer);
 }
 
+static void drop_oldest(output_buffer_t* buffer)
+{
+    buffer->first++;
+    if (buffer->first != buffer->next) {
+        buffer->head = buffer->index[buffer->first % buffer->index_size];
+    }
+}
+
 void output_buffer_append_buf(output_buffer_t* buffer, const char* str, uint16_t len)
 {
-    if (((buffer->append - buffer->data) + sizeof(uint16_t) + len) >= buffer->size) {
-        // rotate buffer
-        uint8_t* pos = buffer->data;
-        uint16_t rotate_count = 0;
-        while ((pos - buffer->data) < buffer->size / 2) {
-            // seek first half
-            uint16_t entry_len;
-            memcpy((void*)&entry_len, (void*)pos, sizeof(uint16_t));
-            pos += entry_len + sizeof(uint16_t);
-            rotate_count++;
+    if (sizeof(uint16_t) + len > buffer->size) {
+        len = buffer->size - sizeof(uint16_t);
+    }
+    uint16_t entry_size = sizeof(uint16_t) + len;
+
+    // entries are stored contiguous, find free space at tail or at begin of data, drop oldest entries until fit
+    while (true) {
+        uint32_t count = buffer->next - buffer->first;
+        if (count == 0) {
+            buffer->head = 0;
+            buffer->tail = 0;
+            break;
         }
-
-        memmove((void*)buffer->data, (void*)pos, buffer->size - (pos - buffer->data));
-        buffer->count -= rotate_count;
-        buffer->append -= (pos - buffer->data);
+        if (count < buffer->index_size) {
+            if (buffer->head < buffer->tail) {
+                if (buffer->size - buffer->tail >= entry_size) break;
+                if (buffer->head >= entry_size) {
+                    // wrap, rest of data after tail stays unused
+                    buffer->tail = 0;
+                    break;
+                }
+            } else if (buffer->head - buffer->tail >= entry_size) {
+                break;
+            }
+        }
+        drop_oldest(buffer);
     }
 
-    memcpy((void*)buffer->append, (void*)&len, sizeof(uint16_t));
-    buffer->append += sizeof(uint16_t);
-
-    memcpy((void*)buffer->append, (void*)str, len);
-    buffer->append += len;
+    uint8_t* append = buffer->data + buffer->tail;
+    memcpy((void*)append, (void*)&len, sizeof(uint16_t));
+    memcpy((void*)(append + sizeof(uint16_t)), (void*)str, len);
 
-    buffer->count++;
+    buffer->index[buffer->next % buffer->index_size] = buffer->tail;
+    buffer->tail += entry_size;
+    buffer->next++;
 }
 
 void output_buffer_append_str(output_buffer_t* buffer, const char* str)
@@ -68,33 +95,25 @@ void output_buffer_append_str(output_buffer_t* buffer, const char* str)
     output_buffer_append_buf(buffer, str, strlen(str));
 }
 
-bool output_buffer_read(output_buffer_t* buffer, uint16_t* index, char** str, uint16_t* len)
+bool output_buffer_read(output_buffer_t* buffer, uint32_t* index, char** str, uint16_t* len)
 {
-    if (*index > buffer->count) {
-        *index = buffer->count;
+    if (*index < buffer->first) {
+        *index = buffer->first;
+    }
+    if (*index > buffer->next) {
+        *index = buffer->next;
     }
 
-    bool has_next = false;
-
-    if (*index < buffer->count) {
-        uint8_t* pos = buffer->data;
-        uint16_t current = 0;
-
-        while (current != *index) {
-            uint16_t entry_len;
-            memcpy((void*)&entry_len, (void*)pos, sizeof(uint16_t));
-            pos += entry_len + sizeof(uint16_t);
-            current++;
-        }
+    if (*index == buffer->next) {
+        return false;
+    }
 
-        memcpy((void*)len, (void*)pos, sizeof(uint16_t));
-        pos += sizeof(uint16_t);
-        *str = (char*)pos;
+    uint8_t* pos = buffer->data + buffer->index[*index % buffer->index_size];
 
-        (*index)++;
+    memcpy((void*)len, (void*)pos, sizeof(uint16_t));
+    *str = (char*)(pos + sizeof(uint16_t));
 
-        has_next = true;
-    }
+    (*index)++;
 
-    return has_next;
-}
\ No newline at end of file
+    return true;
+}
@@ -1,19 +1,21 @@
 #ifndef MODBUS_RTU_TASK_H_
 #define MODBUS_RTU_TASK_H_
 
+#include <driver/uart.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
-#define MODBUS_RTU_TASK_RX_BUFFER_SIZE 256
+#define MODBUS_RTU_TASK_RX_BUFFER_SIZE 256
+#define MODBUS_RTU_TASK_RX_SPAN_SIZE   0
 #define MODBUS_RTU_TASK_TX_BUFFER_SIZE 0
 
 /**
  * @brief Start Modbus-RTU task
  *
- * @param file
+ * @param port uart number
  * @return TaskHandle_t
  */
-TaskHandle_t modbus_rtu_task_start(int fd);
+TaskHandle_t modbus_rtu_task_start(uart_port_t port);
 
 /**
  * @brief Stop Modbus-RTU task
@@ -1,10 +1,9 @@
 #include "modbus_rtu_task.h"
 
 #include <esp_log.h>
-#include <fcntl.h>
-#include <unistd.h>
 
 #include "modbus.h"
+#include "serial_port.h"
 
 #define BUF_SIZE     256
 #define LOG_LVL_DATA ESP_LOG_VERBOSE
@@ -51,23 +50,15 @@ static uint16_t compute_crc(uint8_t* buf, uint16_t len)
 
 static void modbus_rtu_task_func(void* param)
 {
-    int fd = (int)(intptr_t)param;
+    uart_port_t port = (uart_port_t)(intptr_t)param;
 
     uint8_t buf[BUF_SIZE];
 
     while (true) {
-        struct timeval tv = {
-            .tv_sec = 1,
-            .tv_usec = 0,
-        };
-        fd_set read_set;
-        FD_ZERO(&read_set);
-        FD_SET(fd, &read_set);
-
-        if (select(fd + 1, &read_set, NULL, NULL, &tv) > 0) {
-            if (FD_ISSET(fd, &read_set)) {
-                uint16_t len = read(fd, buf, BUF_SIZE);
-
+        // data event is posted on receive timeout, when frame is complete
+        if (serial_port_wait(port, 1000) == SERIAL_PORT_EVENT_DATA) {
+            uint16_t len = serial_port_read(port, buf, BUF_SIZE);
+            if (len > 2) {
                 ESP_LOG_LEVEL(LOG_LVL_DATA, TAG, "Received buffer length %d", len);
                 ESP_LOG_BUFFER_HEX_LEVEL(TAG, buf, len, LOG_LVL_DATA);
 
@@ -82,7 +73,7 @@ static void modbus_rtu_task_func(void* param)
                             ESP_LOG_LEVEL(LOG_LVL_DATA, TAG, "Write buffer length %d", len);
                             ESP_LOG_BUFFER_HEX_LEVEL(TAG, buf, len, LOG_LVL_DATA);
 
-                            write(fd, buf, len);
+                            serial_port_write(port, buf, len);
                         }
                     } else {
                         ESP_LOGW(TAG, "Invalid packet CRC");
@@ -93,10 +84,10 @@ static void modbus_rtu_task_func(void* param)
     }
 }
 
-TaskHandle_t modbus_rtu_task_start(int fd)
+TaskHandle_t modbus_rtu_task_start(uart_port_t port)
 {
     TaskHandle_t handle = NULL;
-    xTaskCreate(modbus_rtu_task_func, "modbus_rtu", 2 * 1024, (void*)fd, 5, &handle);
+    xTaskCreate(modbus_rtu_task_func, "modbus_rtu", 2 * 1024, (void*)port, 5, &handle);
     return handle;
 }
 
@@ -12,7 +12,9 @@
 
 #include "modbus.h"
 
-#define TCP_PORT     502
+#ifndef TCP_PORT
+#define TCP_PORT 502
+#endif /* TCP_PORT */
 #define TCP_MAX_CONN 3
 #define TCP_BACKLOG  5
 #define TCP_BUF_SIZE (MODBUS_PACKET_SIZE + 7)
@@ -37,4 +37,17 @@ esp_err_t aux_write(const char *name, bool value);
  */
 esp_err_t aux_analog_read(const char *name, int *value);
 
+/**
+ * @brief Digital input change callback, called from ISR on any edge
+ *
+ */
+typedef void (*aux_input_change_cb_t)(void);
+
+/**
+ * @brief Set digital input change callback, NULL for remove, callback must be in IRAM
+ *
+ * @param cb
+ */
+void aux_set_input_change_cb(aux_input_change_cb_t cb);
+
 #endif /* AUX_IO_H_ */
\ No newline at end of file
@@ -1,6 +1,10 @@
 #ifndef PERIPHERALS_H
 #define PERIPHERALS_H
 
+/**
+ * @brief Initialize peripherals, except temperature sensor which blocks on bus scan, call temp_sensor_init separately
+ *
+ */
 void peripherals_init(void);
 
 #endif /* PERIPHERALS_H */
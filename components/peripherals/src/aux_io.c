@@ -10,6 +10,28 @@
 #include "adc.h"
 #include "board_config.h"
 
+#define INPUT_DEBOUNCE_MS 20
+
+static volatile aux_input_change_cb_t input_change_cb = NULL;
+
+static TickType_t input_edge_tick[BOARD_CFG_AUX_INPUT_COUNT] = { 0 };
+
+static void IRAM_ATTR input_isr_handler(void* arg)
+{
+    // edges of bouncing contact following reported edge are ignored
+    int i = (intptr_t)arg;
+    TickType_t now = xTaskGetTickCountFromISR();
+    if (now - input_edge_tick[i] < pdMS_TO_TICKS(INPUT_DEBOUNCE_MS)) {
+        return;
+    }
+    input_edge_tick[i] = now;
+
+    aux_input_change_cb_t cb = input_change_cb;
+    if (cb) {
+        cb();
+    }
+}
+
 void aux_init(void)
 {
     // digital inputs
@@ -32,6 +54,14 @@ void aux_init(void)
         ESP_ERROR_CHECK(gpio_config(&io_conf));
     }
 
+    for (int i = 0; i < BOARD_CFG_AUX_INPUT_COUNT; i++) {
+        if (board_cfg_is_aux_input(board_config, i)) {
+            gpio_set_intr_type(board_config.aux.inputs[i].gpio, GPIO_INTR_ANYEDGE);
+            ESP_ERROR_CHECK(gpio_isr_handler_add(board_config.aux.inputs[i].gpio, input_isr_handler, (void*)(intptr_t)i));
+            gpio_intr_disable(board_config.aux.inputs[i].gpio);
+        }
+    }
+
     // digital outputs
 
     io_conf.mode = GPIO_MODE_OUTPUT;
@@ -96,4 +126,19 @@ esp_err_t aux_analog_read(const char* name, int* value)
         }
     }
     return ESP_ERR_NOT_FOUND;
+}
+
+void aux_set_input_change_cb(aux_input_change_cb_t cb)
+{
+    input_change_cb = cb;
+
+    for (int i = 0; i < BOARD_CFG_AUX_INPUT_COUNT; i++) {
+        if (board_cfg_is_aux_input(board_config, i)) {
+            if (cb) {
+                gpio_intr_enable(board_config.aux.inputs[i].gpio);
+            } else {
+                gpio_intr_disable(board_config.aux.inputs[i].gpio);
+            }
+        }
+    }
 }
\ No newline at end of file
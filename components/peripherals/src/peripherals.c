@@ -9,7 +9,6 @@
 #include "proximity.h"
 #include "rcm.h"
 #include "socket_lock.h"
-#include "temp_sensor.h"
 
 void peripherals_init(void)
 {
@@ -22,5 +21,4 @@ void peripherals_init(void)
     energy_meter_init();
     led_init();
     aux_init();
-    temp_sensor_init();
 }
\ No newline at end of file
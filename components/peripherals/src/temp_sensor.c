@@ -25,6 +25,9 @@ static int16_t high_temp = 0;
 
 static uint8_t measure_err_count = 0;
 
+// readings are valid after first successful measurement, until then temperature fault stays asserted
+static bool measured = false;
+
 static void temp_sensor_timer_callback(TimerHandle_t timer)
 {
     int16_t temps[MAX_SENSORS];
@@ -42,6 +45,7 @@ static void temp_sensor_timer_callback(TimerHandle_t timer)
         low_temp = low;
         high_temp = high;
         measure_err_count = 0;
+        measured = true;
     } else {
         ESP_LOGW(TAG, "Measure error %d (%s)", err, esp_err_to_name(err));
         measure_err_count++;
@@ -89,5 +93,5 @@ int16_t temp_sensor_get_high(void)
 
 bool temp_sensor_is_error(void)
 {
-    return sensor_count == 0 || measure_err_count > MEASURE_ERR_THRESHOLD;
+    return sensor_count == 0 || !measured || measure_err_count > MEASURE_ERR_THRESHOLD;
 }
\ No newline at end of file
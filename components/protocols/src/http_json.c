@@ -14,10 +14,12 @@
 #include "sdkconfig.h"
 
 #include "board_config.h"
+#include "boot.h"
 #include "discovery.h"
 #include "energy_meter.h"
 #include "evse.h"
 #include "http.h"
+#include "logger.h"
 #include "modbus.h"
 #include "ota.h"
 #include "proximity.h"
@@ -76,6 +78,7 @@ cJSON* http_json_get_config(void)
     cJSON_AddItemToObject(json, "modbus", http_json_get_config_modbus());
     cJSON_AddItemToObject(json, "script", http_json_get_config_script());
     cJSON_AddItemToObject(json, "scheduler", http_json_get_config_scheduler());
+    cJSON_AddItemToObject(json, "log", http_json_get_config_log());
 
     return json;
 }
@@ -455,6 +458,8 @@ cJSON* http_json_get_config_script(void)
 
     cJSON_AddBoolToObject(json, "enabled", script_is_enabled());
     cJSON_AddBoolToObject(json, "autoReload", script_is_auto_reload());
+    cJSON_AddNumberToObject(json, "memoryLimit", script_get_memory_limit());
+    cJSON_AddNumberToObject(json, "cpuBudget", script_get_cpu_budget());
 
     return json;
 }
@@ -464,8 +469,83 @@ esp_err_t http_json_set_config_script(cJSON* json)
     bool enabled = cJSON_IsTrue(cJSON_GetObjectItem(json, "enabled"));
     bool auto_reload = cJSON_IsTrue(cJSON_GetObjectItem(json, "autoReload"));
 
+    // validated before anything is changed
+    cJSON* memory_limit_json = cJSON_GetObjectItem(json, "memoryLimit");
+    if (cJSON_IsNumber(memory_limit_json)) {
+        double value = memory_limit_json->valuedouble;
+        if (value != 0 && (value < SCRIPT_MEMORY_LIMIT_MIN || value > UINT32_MAX)) return ESP_ERR_INVALID_ARG;
+    }
+    cJSON* cpu_budget_json = cJSON_GetObjectItem(json, "cpuBudget");
+    if (cJSON_IsNumber(cpu_budget_json)) {
+        double value = cpu_budget_json->valuedouble;
+        if (value < 0 || value > SCRIPT_CPU_BUDGET_MAX) return ESP_ERR_INVALID_ARG;
+    }
+
     script_set_enabled(enabled);
     script_set_auto_reload(auto_reload);
+    if (cJSON_IsNumber(memory_limit_json)) {
+        script_set_memory_limit(memory_limit_json->valuedouble);
+    }
+    if (cJSON_IsNumber(cpu_budget_json)) {
+        script_set_cpu_budget(cpu_budget_json->valuedouble);
+    }
+
+    return ESP_OK;
+}
+
+cJSON* http_json_get_config_log(void)
+{
+    cJSON* json = cJSON_CreateObject();
+
+    cJSON_AddBoolToObject(json, "storage", logger_is_storage_enabled());
+
+    cJSON* syslog_json = cJSON_CreateObject();
+    char host[64];
+    cJSON_AddBoolToObject(syslog_json, "enabled", logger_is_syslog_enabled());
+    logger_get_syslog_host(host, sizeof(host));
+    cJSON_AddStringToObject(syslog_json, "host", host);
+    cJSON_AddNumberToObject(syslog_json, "port", logger_get_syslog_port());
+    cJSON_AddStringToObject(syslog_json, "format", logger_syslog_format_to_str(logger_get_syslog_format()));
+    cJSON_AddNumberToObject(syslog_json, "rate", logger_get_syslog_rate());
+    cJSON_AddItemToObject(json, "syslog", syslog_json);
+
+    return json;
+}
+
+esp_err_t http_json_set_config_log(cJSON* json)
+{
+    if (cJSON_IsBool(cJSON_GetObjectItem(json, "storage"))) {
+        logger_set_storage_enabled(cJSON_IsTrue(cJSON_GetObjectItem(json, "storage")));
+    }
+
+    cJSON* syslog_json = cJSON_GetObjectItem(json, "syslog");
+    if (cJSON_IsObject(syslog_json)) {
+        // omitted fields are not changed
+        bool enabled = logger_is_syslog_enabled();
+        uint16_t port = logger_get_syslog_port();
+        logger_syslog_format_t format = logger_get_syslog_format();
+        uint16_t rate = logger_get_syslog_rate();
+
+        if (cJSON_IsBool(cJSON_GetObjectItem(syslog_json, "enabled"))) {
+            enabled = cJSON_IsTrue(cJSON_GetObjectItem(syslog_json, "enabled"));
+        }
+        char* host = cJSON_GetStringValue(cJSON_GetObjectItem(syslog_json, "host"));
+        if (cJSON_IsNumber(cJSON_GetObjectItem(syslog_json, "port"))) {
+            double value = cJSON_GetObjectItem(syslog_json, "port")->valuedouble;
+            if (value < 0 || value > UINT16_MAX) return ESP_ERR_INVALID_ARG;
+            port = value;
+        }
+        if (cJSON_IsString(cJSON_GetObjectItem(syslog_json, "format"))) {
+            format = logger_str_to_syslog_format(cJSON_GetStringValue(cJSON_GetObjectItem(syslog_json, "format")));
+        }
+        if (cJSON_IsNumber(cJSON_GetObjectItem(syslog_json, "rate"))) {
+            double value = cJSON_GetObjectItem(syslog_json, "rate")->valuedouble;
+            if (value < 0 || value > UINT16_MAX) return ESP_ERR_INVALID_ARG;
+            rate = value;
+        }
+
+        RETURN_ON_ERROR(logger_set_syslog_config(enabled, host, port, format, rate));
+    }
 
     return ESP_OK;
 }
@@ -482,6 +562,11 @@ cJSON* http_json_get_script_components(void)
             cJSON_AddStringToObject(component_json, "id", component->id);
             cJSON_AddStringToObject(component_json, "name", component->name);
             cJSON_AddStringToObject(component_json, "description", component->description);
+            cJSON_AddNumberToObject(component_json, "memory", component->memory);
+            cJSON_AddNumberToObject(component_json, "budget", component->budget);
+            cJSON_AddNumberToObject(component_json, "runTime", component->run_time);
+            cJSON_AddNumberToObject(component_json, "maxSlice", component->max_slice);
+            cJSON_AddNumberToObject(component_json, "overruns", component->overruns);
             cJSON_AddItemToArray(json, component_json);
         }
     }
@@ -489,6 +574,19 @@ cJSON* http_json_get_script_components(void)
     return json;
 }
 
+esp_err_t http_json_set_script_profile(cJSON* json)
+{
+    bool enabled = cJSON_IsTrue(cJSON_GetObjectItem(json, "enabled"));
+    uint32_t period = 0;
+    if (cJSON_IsNumber(cJSON_GetObjectItem(json, "period"))) {
+        double value = cJSON_GetObjectItem(json, "period")->valuedouble;
+        if (value < 0 || value > UINT32_MAX) return ESP_ERR_INVALID_ARG;
+        period = value;
+    }
+
+    return script_set_profiler_enabled(enabled, period);
+}
+
 cJSON* http_json_get_script_component_config(const char* id)
 {
     cJSON* json;
@@ -823,6 +921,52 @@ cJSON* http_json_get_info_heap(void)
     return json;
 }
 
+cJSON* http_json_get_info_script(void)
+{
+    cJSON* json = cJSON_CreateObject();
+
+    script_memory_info_t memory_info;
+    if (script_get_memory_info(&memory_info) == ESP_OK) {
+        cJSON_AddNumberToObject(json, "allocated", memory_info.used);
+        cJSON_AddNumberToObject(json, "peak", memory_info.peak);
+        cJSON_AddNumberToObject(json, "poolSize", memory_info.pool_size);
+    }
+    cJSON_AddNumberToObject(json, "limit", script_get_memory_limit());
+
+    cJSON* components_json = cJSON_CreateArray();
+    script_component_list_t* component_list = script_get_components();
+    if (component_list) {
+        script_component_entry_t* component;
+        SLIST_FOREACH (component, component_list, entries) {
+            cJSON* component_json = cJSON_CreateObject();
+            cJSON_AddStringToObject(component_json, "id", component->id);
+            cJSON_AddNumberToObject(component_json, "allocated", component->memory);
+            cJSON_AddItemToArray(components_json, component_json);
+        }
+        script_components_free(component_list);
+    }
+    cJSON_AddItemToObject(json, "components", components_json);
+
+    return json;
+}
+
+cJSON* http_json_get_info_boot(void)
+{
+    cJSON* json = cJSON_CreateArray();
+
+    boot_report_entry_t entries[BOOT_REPORT_MAX];
+    uint8_t count = boot_get_report(entries, BOOT_REPORT_MAX);
+    for (uint8_t i = 0; i < count; i++) {
+        cJSON* entry_json = cJSON_CreateObject();
+        cJSON_AddStringToObject(entry_json, "name", entries[i].name);
+        cJSON_AddNumberToObject(entry_json, "start", entries[i].start / 1000.0);
+        cJSON_AddNumberToObject(entry_json, "end", entries[i].end / 1000.0);
+        cJSON_AddItemToArray(json, entry_json);
+    }
+
+    return json;
+}
+
 cJSON* http_json_get_info(void)
 {
     cJSON* json = cJSON_CreateObject();
@@ -840,10 +984,13 @@ cJSON* http_json_get_info(void)
     cJSON_AddNumberToObject(json, "chipRevision", chip_info.revision / 100);
 
     cJSON_AddItemToObject(json, "heap", http_json_get_info_heap());
+    cJSON_AddItemToObject(json, "script", http_json_get_info_script());
+    cJSON_AddItemToObject(json, "boot", http_json_get_info_boot());
 
     cJSON_AddNumberToObject(json, "temperatureSensorCount", temp_sensor_get_count());
     cJSON_AddNumberToObject(json, "temperatureLow", temp_sensor_get_low() / 100.0);
     cJSON_AddNumberToObject(json, "temperatureHigh", temp_sensor_get_high() / 100.0);
+    cJSON_AddNumberToObject(json, "logDropped", logger_get_dropped_count());
     return json;
 }
 
@@ -993,6 +1140,18 @@ cJSON* http_json_get_nextion_info(void)
 {
     cJSON* json;
 
+    serial_nextion_upload_progress_t progress;
+    if (serial_nextion_get_upload_progress(&progress)) {
+        // display is not accessible while uploading
+        json = cJSON_CreateObject();
+        cJSON* upload_json = cJSON_CreateObject();
+        cJSON_AddNumberToObject(upload_json, "fileSize", progress.file_size);
+        cJSON_AddNumberToObject(upload_json, "offset", progress.offset);
+        cJSON_AddNumberToObject(upload_json, "rate", progress.rate);
+        cJSON_AddItemToObject(json, "upload", upload_json);
+        return json;
+    }
+
     serial_nextion_info_t info;
     if (serial_nextion_get_info(&info) == ESP_OK) {
         json = cJSON_CreateObject();
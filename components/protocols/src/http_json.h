@@ -37,12 +37,18 @@ cJSON* http_json_get_config_script(void);
 
 esp_err_t http_json_set_config_script(cJSON* json);
 
+cJSON* http_json_get_config_log(void);
+
+esp_err_t http_json_set_config_log(cJSON* json);
+
 cJSON* http_json_get_script_components(void);
 
 cJSON* http_json_get_script_component_config(const char* id);
 
 esp_err_t http_json_set_script_component_config(const char* id, cJSON* json);
 
+esp_err_t http_json_set_script_profile(cJSON* json);
+
 cJSON* http_json_get_config_scheduler(void);
 
 esp_err_t http_json_set_config_scheduler(cJSON* json);
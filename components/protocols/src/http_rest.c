@@ -6,6 +6,8 @@
 #include <esp_https_ota.h>
 #include <esp_log.h>
 #include <esp_ota_ops.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <string.h>
 #include <sys/param.h>
 #include <time.h>
@@ -24,9 +26,15 @@
 #define SCRATCH_BUFSIZE   1024
 #define MAX_JSON_SIZE     (50 * 1024)  // 50 KB
 #define MAX_JSON_SIZE_STR "50KB"
+#define PROFILE_LINE_SIZE 640
+
+#define NEXTION_UPLOAD_TASK_STACK_SIZE 4096
+#define NEXTION_UPLOAD_TASK_PRIORITY   5
 
 static const char* TAG = "http_rest";
 
+static volatile bool nextion_uploading = false;
+
 typedef enum {
     URI_NONE = -1,
     //
@@ -46,12 +54,15 @@ typedef enum {
     URI_CONFIG_MODBUS,
     URI_CONFIG_SCRIPT,
     URI_CONFIG_SCHEDULER,
+    URI_CONFIG_LOG,
     URI_CONFIG,
     URI_WIFI_SCAN,
     URI_WIFI_STATE_AP,
     URI_WIFI_STATE,
     URI_SCRIPT_OUTPUT,
     URI_SCRIPT_RELOAD,
+    URI_SCRIPT_PROFILE,
+    URI_SCRIPT_PARAMS,
     URI_SCRIPT_COMPONENTS_ID,
     URI_SCRIPT_COMPONENTS,
     URI_FIRMWARE_CHANNELS,
@@ -62,6 +73,7 @@ typedef enum {
     URI_NEXTION_INFO,
     URI_NEXTION_UPLOAD,
     URI_LOG_PANIC,
+    URI_LOG_HISTORY,
     URI_LOG,
     URI_INFO,
     URI_BOARD_CONFIG,
@@ -90,12 +102,15 @@ static const char* uris[] = {
     "/config/modbus",
     "/config/script",
     "/config/scheduler",
+    "/config/log",
     "/config",
     "/wifi/scan",
     "/wifi/state/ap",
     "/wifi/state",
     "/script/output",
     "/script/reload",
+    "/script/profile",
+    "/script/params",
     "/script/components/",
     "/script/components",
     "/firmware/channels",
@@ -106,6 +121,7 @@ static const char* uris[] = {
     "/nextion/info",
     "/nextion/upload",
     "/log/panic",
+    "/log/history",
     "/log",
     "/info",
     "/board-config",
@@ -233,26 +249,87 @@ static esp_err_t handle_log_panic(httpd_req_t* req)
     return ESP_OK;
 }
 
+static esp_log_level_t str_to_log_level(const char* str)
+{
+    switch (str[0]) {
+    case 'E':
+        return ESP_LOG_ERROR;
+    case 'W':
+        return ESP_LOG_WARN;
+    case 'I':
+        return ESP_LOG_INFO;
+    case 'D':
+        return ESP_LOG_DEBUG;
+    default:
+        return ESP_LOG_VERBOSE;
+    }
+}
+
+static esp_err_t handle_log_binary(httpd_req_t* req, uint32_t index, uint32_t count, const logger_filter_t* filter)
+{
+    httpd_resp_set_type(req, "application/octet-stream");
+
+    uint8_t data[sizeof(uint16_t) + LOGGER_BINARY_SIZE];
+    uint16_t len = logger_log_buffer_get_binary_header(data, sizeof(data));
+    esp_err_t ret = httpd_resp_send_chunk(req, (const char*)data, len);
+
+    while (ret == ESP_OK && logger_log_buffer_read_binary(&index, filter, &data[sizeof(uint16_t)], LOGGER_BINARY_SIZE, &len) && index <= count) {
+        memcpy(data, &len, sizeof(uint16_t));
+        ret = httpd_resp_send_chunk(req, (const char*)data, sizeof(uint16_t) + len);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Sending failed");
+        httpd_resp_sendstr_chunk(req, NULL);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
+
+    httpd_resp_send_chunk(req, NULL, 0);
+
+    return ESP_OK;
+}
+
 static esp_err_t handle_log(httpd_req_t* req)
 {
-    uint16_t count = logger_log_buffer_get_count();
+    uint32_t count = logger_log_buffer_get_count();
     char count_str[16];
-    snprintf(count_str, sizeof(count_str), "%" PRIu16, count);
+    snprintf(count_str, sizeof(count_str), "%" PRIu32, count);
     httpd_resp_set_hdr(req, "X-Count", count_str);
 
-    uint16_t index = 0;
-    char buf[24];
+    uint32_t index = 0;
+    bool binary = false;
+    logger_filter_t filter = {
+        .level = ESP_LOG_VERBOSE,
+        .tag = NULL,
+    };
+    char buf[64];
     char param[16];
+    char tag[16];
     if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
         if (httpd_query_key_value(buf, "index", param, sizeof(param)) == ESP_OK) {
-            index = atoi(param);
+            index = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "level", param, sizeof(param)) == ESP_OK) {
+            filter.level = str_to_log_level(param);
+        }
+        if (httpd_query_key_value(buf, "tag", tag, sizeof(tag)) == ESP_OK) {
+            filter.tag = tag;
+        }
+        if (httpd_query_key_value(buf, "format", param, sizeof(param)) == ESP_OK) {
+            binary = !strcmp(param, "binary");
         }
     }
 
+    if (binary) {
+        // records are decoded only for filtering
+        return handle_log_binary(req, index, count, filter.tag || filter.level != ESP_LOG_VERBOSE ? &filter : NULL);
+    }
+
     httpd_resp_set_type(req, "text/plain");
-    char* line;
+    char line[LOGGER_LINE_SIZE];
     uint16_t line_len;
-    while (logger_log_bugger_read(&index, &line, &line_len) && index <= count) {
+    while (logger_log_bugger_read(&index, &filter, line, sizeof(line), &line_len) && index <= count) {
         if (httpd_resp_send_chunk(req, line, line_len) != ESP_OK) {
             ESP_LOGE(TAG, "Sending failed");
             httpd_resp_sendstr_chunk(req, NULL);
@@ -266,19 +343,40 @@ static esp_err_t handle_log(httpd_req_t* req)
     return ESP_OK;
 }
 
+static esp_err_t send_resp_chunk(const char* buf, size_t len, void* ctx)
+{
+    return httpd_resp_send_chunk((httpd_req_t*)ctx, buf, len);
+}
+
+static esp_err_t handle_log_history(httpd_req_t* req)
+{
+    httpd_resp_set_type(req, "text/plain");
+
+    if (logger_storage_read(send_resp_chunk, req) != ESP_OK) {
+        ESP_LOGE(TAG, "Sending failed");
+        httpd_resp_sendstr_chunk(req, NULL);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
+
+    httpd_resp_send_chunk(req, NULL, 0);
+
+    return ESP_OK;
+}
+
 static esp_err_t handle_script_output(httpd_req_t* req)
 {
-    uint16_t count = script_output_count();
+    uint32_t count = script_output_count();
     char count_str[16];
-    snprintf(count_str, sizeof(count_str), "%" PRIu16, count);
+    snprintf(count_str, sizeof(count_str), "%" PRIu32, count);
     httpd_resp_set_hdr(req, "X-Count", count_str);
 
-    uint16_t index = 0;
+    uint32_t index = 0;
     char buf[24];
     char param[16];
     if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
         if (httpd_query_key_value(buf, "index", param, sizeof(param)) == ESP_OK) {
-            index = atoi(param);
+            index = strtoul(param, NULL, 10);
         }
     }
 
@@ -299,6 +397,52 @@ static esp_err_t handle_script_output(httpd_req_t* req)
     return ESP_OK;
 }
 
+static esp_err_t handle_script_params(httpd_req_t* req)
+{
+    httpd_resp_set_type(req, "text/yaml");
+
+    if (script_export_component_params(send_resp_chunk, req) != ESP_OK) {
+        ESP_LOGE(TAG, "Sending failed");
+        httpd_resp_sendstr_chunk(req, NULL);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
+
+    httpd_resp_send_chunk(req, NULL, 0);
+
+    return ESP_OK;
+}
+
+static esp_err_t handle_script_profile(httpd_req_t* req)
+{
+    httpd_resp_set_hdr(req, "X-Enabled", script_is_profiler_enabled() ? "true" : "false");
+    httpd_resp_set_type(req, "text/plain");
+
+    char* buf = (char*)malloc(sizeof(char) * PROFILE_LINE_SIZE);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory");
+        httpd_resp_send_custom_err(req, "512 Failed To Allocate Memory", "Failed to allocate memory");
+        return ESP_FAIL;
+    }
+
+    uint16_t index = 0;
+    while (script_read_profile(&index, buf, PROFILE_LINE_SIZE)) {
+        if (httpd_resp_sendstr_chunk(req, buf) != ESP_OK) {
+            ESP_LOGE(TAG, "Sending failed");
+            httpd_resp_sendstr_chunk(req, NULL);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+            free((void*)buf);
+            return ESP_FAIL;
+        }
+    }
+
+    httpd_resp_send_chunk(req, NULL, 0);
+
+    free((void*)buf);
+
+    return ESP_OK;
+}
+
 esp_err_t handle_json_request(httpd_req_t* req, esp_err_t (*action)(cJSON*))
 {
     cJSON* json = read_request_json(req);
@@ -463,75 +607,99 @@ static esp_err_t handle_firmware_upload(httpd_req_t* req)
     return ESP_OK;
 }
 
-static esp_err_t handle_nextion_upload(httpd_req_t* req)
+static esp_err_t nextion_upload(httpd_req_t* req)
 {
-    esp_err_t err;
-
-    size_t remaining = req->content_len;
-
-    char* buf = (char*)malloc(sizeof(char) * SERIAL_NEXTION_UPLOAD_BATCH_SIZE);
-    if (!buf) {
+    // double buffered, next chunk is received while previous is transmitted
+    char* buf[2];
+    buf[0] = (char*)malloc(sizeof(char) * SERIAL_NEXTION_UPLOAD_BATCH_SIZE * 2);
+    if (!buf[0]) {
         ESP_LOGE(TAG, "Failed to allocate memory");
         httpd_resp_send_custom_err(req, "512 Failed To Allocate Memory", "Failed to allocate memory");
         return ESP_FAIL;
     }
+    buf[1] = buf[0] + SERIAL_NEXTION_UPLOAD_BATCH_SIZE;
 
     uint32_t baud_rate = 921600;
     char param[16];
-    size_t skip_remaining, skip_to;
-    if (httpd_req_get_url_query_str(req, buf, SERIAL_NEXTION_UPLOAD_BATCH_SIZE) == ESP_OK) {
-        if (httpd_query_key_value(buf, "baud-rate", param, sizeof(param)) == ESP_OK) {
+    if (httpd_req_get_url_query_str(req, buf[0], SERIAL_NEXTION_UPLOAD_BATCH_SIZE) == ESP_OK) {
+        if (httpd_query_key_value(buf[0], "baud-rate", param, sizeof(param)) == ESP_OK) {
             baud_rate = atoi(param);
         }
     }
 
-    if (serial_nextion_upload_begin(remaining, baud_rate) != ESP_OK) {
+    if (serial_nextion_upload_begin(req->content_len, baud_rate) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to begin write program");
         httpd_resp_send_custom_err(req, "531 Failed To Write Program", "Failed to write program");
-        free((void*)buf);
+        free((void*)buf[0]);
         return ESP_FAIL;
     }
 
-    while (remaining > 0) {
-        int received = 0;
-        do {
-            int ret = httpd_req_recv(req, &buf[received], MIN(remaining, SERIAL_NEXTION_UPLOAD_BATCH_SIZE) - received);
+    int cur = 0;
+    size_t offset = 0;  // file offset of buf[cur]
+    size_t len = 0;     // received bytes in buf[cur]
+    size_t skip_to;
+    bool pending = false;
+
+    while (true) {
+        size_t chunk = MIN(req->content_len - offset, SERIAL_NEXTION_UPLOAD_BATCH_SIZE);
+        while (len < chunk) {
+            int ret = httpd_req_recv(req, &buf[cur][len], chunk - len);
             if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
                 continue;
             } else if (ret <= 0) {
                 ESP_LOGE(TAG, "File receive failed");
                 httpd_resp_send_custom_err(req, "532 Failed To Receive Program", "Failed to receive program");
-                free((void*)buf);
                 serial_nextion_upload_end();
+                free((void*)buf[0]);
                 return ESP_FAIL;
             }
-
-            received += ret;
-        } while (received < MIN(remaining, SERIAL_NEXTION_UPLOAD_BATCH_SIZE));
-        remaining -= received;
-
-        err = serial_nextion_upload_write(buf, received, &skip_to);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to write program");
-            httpd_resp_send_custom_err(req, "531 Failed To Write Program", "Failed to write program");
-            free((void*)buf);
-            return ESP_FAIL;
+            len += ret;
         }
 
-        if (skip_to > 0) {
-            skip_remaining = skip_to - (req->content_len - remaining);
-            while (skip_remaining > 0) {
-                if ((received = httpd_req_recv(req, buf, MIN(skip_remaining, SERIAL_NEXTION_UPLOAD_BATCH_SIZE))) <= 0) {
-                    ESP_LOGE(TAG, "File receive failed");
-                    httpd_resp_send_custom_err(req, "532 Failed To Receive Program", "Failed to receive program");
-                    free((void*)buf);
-                    serial_nextion_upload_end();
-                    return ESP_FAIL;
+        if (pending) {
+            pending = false;
+            if (serial_nextion_upload_wait(&skip_to) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to write program");
+                httpd_resp_send_custom_err(req, "531 Failed To Write Program", "Failed to write program");
+                free((void*)buf[0]);
+                return ESP_FAIL;
+            }
+
+            if (skip_to > offset) {
+                // display already has data up to skip_to, drop them from received and pending
+                size_t skip_len = MIN(skip_to, req->content_len) - offset;
+                if (skip_len < len) {
+                    memmove(buf[cur], &buf[cur][skip_len], len - skip_len);
+                    len -= skip_len;
+                } else {
+                    skip_len -= len;
+                    len = 0;
+                    while (skip_len > 0) {
+                        int ret = httpd_req_recv(req, buf[cur], MIN(skip_len, SERIAL_NEXTION_UPLOAD_BATCH_SIZE));
+                        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                            continue;
+                        } else if (ret <= 0) {
+                            ESP_LOGE(TAG, "File receive failed");
+                            httpd_resp_send_custom_err(req, "532 Failed To Receive Program", "Failed to receive program");
+                            serial_nextion_upload_end();
+                            free((void*)buf[0]);
+                            return ESP_FAIL;
+                        }
+                        skip_len -= ret;
+                    }
                 }
-                skip_remaining -= received;
-                remaining -= received;
+                offset = MIN(skip_to, req->content_len);
+                continue;
             }
         }
+
+        if (len == 0) break;
+
+        serial_nextion_upload_send(buf[cur], len);
+        pending = true;
+        offset += len;
+        len = 0;
+        cur ^= 1;
     }
 
     serial_nextion_upload_end();
@@ -539,7 +707,46 @@ static esp_err_t handle_nextion_upload(httpd_req_t* req)
     httpd_resp_set_type(req, "text/plain");
     httpd_resp_sendstr(req, "OK");
 
-    free((void*)buf);
+    free((void*)buf[0]);
+
+    return ESP_OK;
+}
+
+static void nextion_upload_task_func(void* param)
+{
+    httpd_req_t* req = (httpd_req_t*)param;
+
+    nextion_upload(req);
+
+    httpd_req_async_handler_complete(req);
+    nextion_uploading = false;
+
+    vTaskDelete(NULL);
+}
+
+/**
+ * Upload runs in own task, so server can respond to GET /nextion/info with progress
+ */
+static esp_err_t handle_nextion_upload(httpd_req_t* req)
+{
+    if (nextion_uploading) {
+        httpd_resp_send_custom_err(req, "409 Conflict", "Upload in progress");
+        return ESP_FAIL;
+    }
+
+    httpd_req_t* async_req;
+    if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        return ESP_FAIL;
+    }
+
+    nextion_uploading = true;
+    if (xTaskCreate(nextion_upload_task_func, "nextion_http", NEXTION_UPLOAD_TASK_STACK_SIZE, async_req, NEXTION_UPLOAD_TASK_PRIORITY, NULL) != pdPASS) {
+        nextion_uploading = false;
+        httpd_resp_send_custom_err(async_req, "512 Failed To Allocate Memory", "Failed to allocate memory");
+        httpd_req_async_handler_complete(async_req);
+        return ESP_FAIL;
+    }
 
     return ESP_OK;
 }
@@ -567,6 +774,8 @@ static esp_err_t get_handler(httpd_req_t* req)
         return handle_json_response(req, http_json_get_config_script());
     case URI_CONFIG_SCHEDULER:
         return handle_json_response(req, http_json_get_config_scheduler());
+    case URI_CONFIG_LOG:
+        return handle_json_response(req, http_json_get_config_log());
     case URI_CONFIG:
         return handle_json_response(req, http_json_get_config());
     case URI_WIFI_SCAN:
@@ -575,6 +784,10 @@ static esp_err_t get_handler(httpd_req_t* req)
         return handle_json_response(req, http_json_get_wifi_state());
     case URI_SCRIPT_OUTPUT:
         return handle_script_output(req);
+    case URI_SCRIPT_PROFILE:
+        return handle_script_profile(req);
+    case URI_SCRIPT_PARAMS:
+        return handle_script_params(req);
     case URI_SCRIPT_COMPONENTS:
         return handle_json_response(req, http_json_get_script_components());
     case URI_SCRIPT_COMPONENTS_ID:
@@ -589,6 +802,8 @@ static esp_err_t get_handler(httpd_req_t* req)
         return handle_json_response(req, http_json_get_nextion_info());
     case URI_LOG_PANIC:
         return handle_log_panic(req);
+    case URI_LOG_HISTORY:
+        return handle_log_history(req);
     case URI_LOG:
         return handle_log(req);
     case URI_INFO:
@@ -643,8 +858,12 @@ static esp_err_t post_handler(httpd_req_t* req)
         return handle_json_request(req, http_json_set_config_script);
     case URI_CONFIG_SCHEDULER:
         return handle_json_request(req, http_json_set_config_scheduler);
+    case URI_CONFIG_LOG:
+        return handle_json_request(req, http_json_set_config_log);
     case URI_SCRIPT_RELOAD:
         return handle_void_request(req, script_reload);
+    case URI_SCRIPT_PROFILE:
+        return handle_json_request(req, http_json_set_script_profile);
     case URI_SCRIPT_COMPONENTS_ID:
         return handle_str_json_request(req, req->uri + uri_full_length(URI_SCRIPT_COMPONENTS_ID), http_json_set_script_component_config);
     case URI_FIRMWARE_CHANNEL:
@@ -675,6 +894,8 @@ static esp_err_t delete_handler(httpd_req_t* req)
     switch (get_uri(req->uri)) {
     case URI_LOG_PANIC:
         return handle_void_request(req, logger_clear_panic);
+    case URI_SCRIPT_PROFILE:
+        return handle_void_request(req, script_clear_profile);
     default:
         return handle_not_found(req);
     }
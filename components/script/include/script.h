@@ -5,6 +5,9 @@
 #include <stdbool.h>
 #include <sys/queue.h>
 
+#define SCRIPT_MEMORY_LIMIT_MIN (64 * 1024)  // bytes, Lua state with opened libraries takes about 40KB
+#define SCRIPT_CPU_BUDGET_MAX   2000         // ms, script mutex is held for whole resume
+
 /**
  * @brief Initialize script VM
  *
@@ -47,6 +50,54 @@ void script_set_auto_reload(bool auto_reload);
  */
 bool script_is_auto_reload(void);
 
+/**
+ * @brief Set memory limit of script VM, stored in NVS
+ *
+ * @param limit Limit in bytes, 0 for unlimited, otherwise at least SCRIPT_MEMORY_LIMIT_MIN
+ * @return esp_err_t ESP_ERR_INVALID_ARG when limit is too small
+ */
+esp_err_t script_set_memory_limit(uint32_t limit);
+
+/**
+ * @brief Get memory limit of script VM, stored in NVS
+ *
+ * @return uint32_t Limit in bytes, 0 for unlimited
+ */
+uint32_t script_get_memory_limit(void);
+
+/**
+ * @brief Set default CPU budget of component resume, stored in NVS
+ *
+ * @param budget Budget in ms, 0 for default, at most SCRIPT_CPU_BUDGET_MAX
+ * @return esp_err_t ESP_ERR_INVALID_ARG when budget is too large
+ */
+esp_err_t script_set_cpu_budget(uint32_t budget);
+
+/**
+ * @brief Get default CPU budget of component resume, stored in NVS
+ *
+ * @return uint32_t Budget in ms
+ */
+uint32_t script_get_cpu_budget(void);
+
+/**
+ * @brief Script VM memory usage
+ *
+ */
+typedef struct {
+    size_t used;
+    size_t peak;
+    size_t pool_size;
+} script_memory_info_t;
+
+/**
+ * @brief Get memory usage of script VM
+ *
+ * @param info
+ * @return esp_err_t ESP_ERR_INVALID_STATE when script not running
+ */
+esp_err_t script_get_memory_info(script_memory_info_t* info);
+
 /**
  * @brief Notify script file was changed
  *
@@ -55,22 +106,56 @@ bool script_is_auto_reload(void);
 void script_file_changed(const char* path);
 
 /**
- * @brief Get entries count
+ * @brief Get sequence number of next entry
  *
- * @return uint16_t
+ * @return uint32_t
  */
-uint16_t script_output_count(void);
+uint32_t script_output_count(void);
 
 /**
- * @brief Read line from index, set index for reading next entry
+ * @brief Read line from sequence number, set index for reading next entry
  *
- * @param index
+ * @param index Sequence number
  * @param str
  * @param v
  * @return true When has next entry
  * @return false When no entry left
  */
-bool script_output_read(uint16_t* index, char** str, uint16_t* len);
+bool script_output_read(uint32_t* index, char** str, uint16_t* len);
+
+/**
+ * @brief Start or stop sampling profiler of script VM, samples are kept until next start
+ *
+ * @param enabled
+ * @param period Sampling period in us, 0 for default
+ * @return esp_err_t
+ */
+esp_err_t script_set_profiler_enabled(bool enabled, uint32_t period);
+
+/**
+ * @brief Get sampling profiler is running
+ *
+ * @return true
+ * @return false
+ */
+bool script_is_profiler_enabled(void);
+
+/**
+ * @brief Stop sampling profiler and free samples
+ *
+ */
+void script_clear_profile(void);
+
+/**
+ * @brief Read sampled stack in folded format "frame;frame;frame us\n", for flame graph tools
+ *
+ * @param index Stack index, start with 0, set for reading next stack
+ * @param buf
+ * @param size
+ * @return true When has next stack
+ * @return false When no stack left
+ */
+bool script_read_profile(uint16_t* index, char* buf, size_t size);
 
 /**
  * @brief Get script drivers count
@@ -154,6 +239,20 @@ void script_set_component_params(const char* id, script_component_param_list_t*
  */
 void script_component_params_free(script_component_param_list_t* list);
 
+/**
+ * @brief Callback for exported component parameters
+ */
+typedef esp_err_t (*script_component_params_export_cb_t)(const char* buf, size_t len, void* ctx);
+
+/**
+ * @brief Export stored parameters of all components in params.yaml format, which can be uploaded back
+ *
+ * @param cb Called with chunks of yaml
+ * @param ctx
+ * @return esp_err_t
+ */
+esp_err_t script_export_component_params(script_component_params_export_cb_t cb, void* ctx);
+
 /**
  * @brief Script component
  *
@@ -162,6 +261,11 @@ typedef struct script_component_entry_s {
     char* id;
     char* name;
     char* description;
+    size_t memory;
+    uint32_t budget;     // ms of CPU per resume, 0 for default
+    int64_t run_time;    // us
+    uint32_t max_slice;  // us
+    uint32_t overruns;
 
     SLIST_ENTRY(script_component_entry_s) entries;
 } script_component_entry_t;
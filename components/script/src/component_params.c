@@ -1,38 +1,234 @@
 #include "component_params.h"
 
+#include <dirent.h>
 #include <esp_log.h>
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "yaml.h"
 
-#define PARAMS_YAML     "/usr/lua/params.yaml"
-#define PARAMS_TMP_YAML "/usr/lua/params_tmp.yaml"
-#define BUF_SIZE        256
+#define PARAMS_YAML         "/usr/lua/params.yaml"
+#define PARAMS_INVALID_YAML "/usr/lua/params_invalid.yaml"
+#define PARAMS_DIR          "/usr/lua/.params"
+#define PARAMS_STAGING_DIR  "/usr/lua/.params_import"
+#define PARAMS_MAGIC        0x4D525043  // CPRM
+#define PARAMS_PATH_LEN     sizeof(PARAMS_STAGING_DIR "/01234567.bin")
+#define PARAMS_STRING_MAX   UINT16_MAX
 
 #define LOG_PARSER_PROBLEM(parser) ESP_LOGW(TAG, "Parsing error: %s (line: %zu column: %zu)", parser.problem, parser.problem_mark.line, parser.problem_mark.column)
 
 static const char* TAG = "component_params";
 
-static component_param_list_t* yaml_file_read(FILE* src, const char* key)
+/**
+ * Record file of one component: header, component id, then count of key, value pairs.
+ * Each string is stored as uint16_t length followed by bytes without terminator.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t count;
+    uint16_t reserved;
+} params_header_t;
+
+static void list_clear(component_param_list_t* list)
 {
-    yaml_parser_t parser;
-    yaml_event_t event;
+    while (!SLIST_EMPTY(list)) {
+        component_param_entry_t* item = SLIST_FIRST(list);
 
-    if (!yaml_parser_initialize(&parser)) {
-        ESP_LOGE(TAG, "Failed to initialize yaml parser");
+        SLIST_REMOVE_HEAD(list, entries);
+
+        if (item->key) free((void*)item->key);
+        if (item->value) free((void*)item->value);
+        free((void*)item);
+    }
+}
+
+static void params_path(const char* dir, const char* component, char* path)
+{
+    // FNV-1a of component id
+    uint32_t hash = 2166136261;
+    for (const char* c = component; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619;
+    }
+    snprintf(path, PARAMS_PATH_LEN, "%s/%08" PRIx32 ".bin", dir, hash);
+}
+
+static bool string_write(FILE* file, const char* str)
+{
+    size_t len = str ? strlen(str) : 0;
+    if (len > PARAMS_STRING_MAX) return false;
+
+    uint16_t len16 = len;
+    return fwrite(&len16, sizeof(uint16_t), 1, file) == 1 && (len == 0 || fwrite(str, len, 1, file) == 1);
+}
+
+static char* string_read(FILE* file)
+{
+    uint16_t len;
+    if (fread(&len, sizeof(uint16_t), 1, file) != 1) return NULL;
+
+    char* str = (char*)malloc(len + 1);
+    if (len > 0 && fread(str, len, 1, file) != 1) {
+        free((void*)str);
+        return NULL;
+    }
+    str[len] = '\0';
+
+    return str;
+}
+
+/**
+ * Read record file, when component is not NULL it must match stored component id
+ */
+static component_param_list_t* params_file_read(FILE* file, const char* component, char** id)
+{
+    params_header_t header;
+    if (fread(&header, sizeof(params_header_t), 1, file) != 1 || header.magic != PARAMS_MAGIC) return NULL;
+
+    char* file_id = string_read(file);
+    if (!file_id) return NULL;
+    if (component && strcmp(component, file_id) != 0) {
+        // hash collision with other component
+        free((void*)file_id);
         return NULL;
     }
 
     component_param_list_t* list = (component_param_list_t*)malloc(sizeof(component_param_list_t));
     SLIST_INIT(list);
 
+    for (uint16_t i = 0; i < header.count; i++) {
+        char* key = string_read(file);
+        char* value = key ? string_read(file) : NULL;
+        if (!value) {
+            ESP_LOGW(TAG, "Truncated params of %s", file_id);
+            if (key) free((void*)key);
+            break;
+        }
+
+        component_param_entry_t* entry = (component_param_entry_t*)malloc(sizeof(component_param_entry_t));
+        entry->key = key;
+        entry->value = value;
+        SLIST_INSERT_HEAD(list, entry, entries);
+    }
+
+    if (id) {
+        *id = file_id;
+    } else {
+        free((void*)file_id);
+    }
+
+    return list;
+}
+
+static bool params_store(const char* dir, const char* component, component_param_list_t* list)
+{
+    char path[PARAMS_PATH_LEN];
+    char tmp[PARAMS_PATH_LEN + sizeof(".tmp")];
+    params_path(dir, component, path);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    mkdir(dir, 0777);
+
+    FILE* file = fopen(tmp, "wb");
+    if (!file) {
+        ESP_LOGE(TAG, "Failed to open %s", tmp);
+        return false;
+    }
+
+    params_header_t header = {
+        .magic = PARAMS_MAGIC,
+        .count = 0,
+        .reserved = 0,
+    };
+    component_param_entry_t* entry;
+    SLIST_FOREACH (entry, list, entries) {
+        header.count++;
+    }
+
+    bool ok = fwrite(&header, sizeof(params_header_t), 1, file) == 1 && string_write(file, component);
+    SLIST_FOREACH (entry, list, entries) {
+        ok = ok && string_write(file, entry->key) && string_write(file, entry->value);
+    }
+    ok = fclose(file) == 0 && ok;
+
+    // replace whole record at once, rename overwrites existing, on failure previous one is kept
+    if (!ok || rename(tmp, path) != 0) {
+        ESP_LOGE(TAG, "Failed to store params of %s", component);
+        remove(tmp);
+        return false;
+    }
+
+    return true;
+}
+
+static void params_clear(const char* dir_path)
+{
+    DIR* dir = opendir(dir_path);
+    if (!dir) return;
+
+    char path[sizeof(PARAMS_STAGING_DIR) + 256];
+    struct dirent* de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", dir_path, de->d_name);
+        remove(path);
+    }
+
+    closedir(dir);
+}
+
+/**
+ * Move records from staging directory, existing records are replaced by rename
+ */
+static void params_commit(void)
+{
+    params_clear(PARAMS_DIR);
+    mkdir(PARAMS_DIR, 0777);
+
+    DIR* dir = opendir(PARAMS_STAGING_DIR);
+    if (!dir) return;
+
+    char src[sizeof(PARAMS_STAGING_DIR) + 256];
+    char dst[sizeof(PARAMS_STAGING_DIR) + 256];
+    struct dirent* de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        snprintf(src, sizeof(src), PARAMS_STAGING_DIR "/%s", de->d_name);
+        snprintf(dst, sizeof(dst), PARAMS_DIR "/%s", de->d_name);
+        if (rename(src, dst) != 0) {
+            ESP_LOGE(TAG, "Failed to move %s", src);
+            remove(src);
+        }
+    }
+
+    closedir(dir);
+    rmdir(PARAMS_STAGING_DIR);
+}
+
+/**
+ * Parse into staging directory, stored params are not touched
+ */
+static bool yaml_file_import(FILE* src)
+{
+    yaml_parser_t parser;
+    yaml_event_t event;
+
+    if (!yaml_parser_initialize(&parser)) {
+        ESP_LOGE(TAG, "Failed to initialize yaml parser");
+        return false;
+    }
+
     yaml_parser_set_input_file(&parser, src);
 
+    component_param_list_t list = SLIST_HEAD_INITIALIZER(list);
     int level = 0;
-    bool match = false;
     bool done = false;
+    char* component = NULL;
     char* entry_key = NULL;
     while (!done) {
         if (!yaml_parser_parse(&parser, &event)) {
@@ -43,17 +239,18 @@ static component_param_list_t* yaml_file_read(FILE* src, const char* key)
         switch (event.type) {
         case YAML_SCALAR_EVENT:
             if (level == 1) {
-                match = strcmp(key, (char*)event.data.scalar.value) == 0;
+                if (component) free((void*)component);
+                component = strdup((char*)event.data.scalar.value);
             }
 
-            if (level == 2 && match) {
+            if (level == 2 && component) {
                 if (!entry_key) {
                     entry_key = strdup((char*)event.data.scalar.value);
                 } else {
                     component_param_entry_t* entry = (component_param_entry_t*)malloc(sizeof(component_param_entry_t));
                     entry->key = entry_key;
                     entry->value = strdup((char*)event.data.scalar.value);
-                    SLIST_INSERT_HEAD(list, entry, entries);
+                    SLIST_INSERT_HEAD(&list, entry, entries);
                     entry_key = NULL;
                 }
             }
@@ -63,6 +260,15 @@ static component_param_list_t* yaml_file_read(FILE* src, const char* key)
             level++;
             break;
         case YAML_MAPPING_END_EVENT:
+            if (level == 2) {
+                if (component) {
+                    bool stored = params_store(PARAMS_STAGING_DIR, component, &list);
+                    free((void*)component);
+                    component = NULL;
+                    if (!stored) goto error;
+                }
+                list_clear(&list);
+            }
             level--;
             break;
         case YAML_STREAM_END_EVENT:
@@ -81,126 +287,116 @@ static component_param_list_t* yaml_file_read(FILE* src, const char* key)
     }
 
     yaml_parser_delete(&parser);
+    if (component) free((void*)component);
 
-    return list;
+    return true;
 
 error:
-    ESP_LOGE(TAG, "Error read");
+    ESP_LOGE(TAG, "Error import");
     yaml_event_delete(&event);
     yaml_parser_delete(&parser);
     if (entry_key) free((void*)entry_key);
-    component_params_free(list);
+    if (component) free((void*)component);
+    list_clear(&list);
 
-    return NULL;
+    return false;
+}
+
+/**
+ * Uploaded params.yaml replaces whole store, it is consumed on first read after upload
+ */
+static void yaml_import(void)
+{
+    FILE* src = fopen(PARAMS_YAML, "r");
+    if (!src) return;
+
+    ESP_LOGI(TAG, "Importing " PARAMS_YAML);
+
+    // leftover of interrupted import
+    params_clear(PARAMS_STAGING_DIR);
+
+    bool ok = yaml_file_import(src);
+    fclose(src);
+
+    if (ok) {
+        params_commit();
+        remove(PARAMS_YAML);
+    } else {
+        params_clear(PARAMS_STAGING_DIR);
+        rmdir(PARAMS_STAGING_DIR);
+        remove(PARAMS_INVALID_YAML);
+        rename(PARAMS_YAML, PARAMS_INVALID_YAML);
+    }
 }
 
 component_param_list_t* component_params_read(const char* component)
 {
+    yaml_import();
+
+    char path[PARAMS_PATH_LEN];
+    params_path(PARAMS_DIR, component, path);
+
     component_param_list_t* list = NULL;
 
-    FILE* src = fopen(PARAMS_YAML, "r");
-    if (src) {
-        list = yaml_file_read(src, component);
-        fclose(src);
+    FILE* file = fopen(path, "rb");
+    if (file) {
+        list = params_file_read(file, component, NULL);
+        fclose(file);
     }
 
     return list;
 }
 
-static void yaml_file_copy(FILE* dst, FILE* src)
+void component_params_write(const char* component, component_param_list_t* list)
 {
-    char buf[BUF_SIZE];
-    size_t count;
+    yaml_import();
 
-    while ((count = fread(buf, 1, BUF_SIZE, src)) > 0) {
-        fwrite(buf, 1, count, dst);
-    }
+    params_store(PARAMS_DIR, component, list);
 }
 
-static void yaml_file_copy_omit(FILE* dst, FILE* src, const char* key)
+void component_params_clear(void)
 {
-    yaml_parser_t parser;
-    yaml_emitter_t emitter;
-    yaml_event_t event;
-
-    if (!yaml_parser_initialize(&parser)) {
-        ESP_LOGE(TAG, "Failed to initialize yaml parser");
-        return;
-    }
-    if (!yaml_emitter_initialize(&emitter)) {
-        ESP_LOGE(TAG, "Failed to initialize yaml emitter");
-        yaml_parser_delete(&parser);
-        return;
-    }
-
-    yaml_parser_set_input_file(&parser, src);
-    yaml_emitter_set_output_file(&emitter, dst);
-    //    yaml_emitter_set_unicode(&emitter, 1);
+    remove(PARAMS_YAML);
+    params_clear(PARAMS_DIR);
+}
 
-    int level = 0;
-    bool skip = false;
-    bool done = false;
-    while (!done) {
-        if (!yaml_parser_parse(&parser, &event)) {
-            LOG_PARSER_PROBLEM(parser);
-            goto error;
-        }
+static bool yaml_emit_scalar(yaml_emitter_t* emitter, const char* value)
+{
+    yaml_event_t event;
 
-        switch (event.type) {
-        case YAML_SCALAR_EVENT:
-            if (level == 1) {
-                skip = strcmp(key, (char*)event.data.scalar.value) == 0;
-            }
-            break;
-        case YAML_MAPPING_START_EVENT:
-            level++;
-            break;
-        case YAML_MAPPING_END_EVENT:
-            if (level == 1) {
-                skip = false;
-            }
-            level--;
-            break;
-        case YAML_STREAM_END_EVENT:
-            done = true;
-            break;
-        default:
-            break;
-        }
+    yaml_scalar_event_initialize(&event, NULL, NULL, (yaml_char_t*)value, -1, 1, 1, YAML_PLAIN_SCALAR_STYLE);
+    return yaml_emitter_emit(emitter, &event);
+}
 
-        if (skip) {
-            yaml_event_delete(&event);
-        } else {
-            if (!yaml_emitter_emit(&emitter, &event)) {
-                ESP_LOGW(TAG, "Emitting error");
-                goto error;
-            }
-        }
-    }
+typedef struct {
+    component_params_export_cb_t cb;
+    void* ctx;
+} export_ctx_t;
 
-    yaml_parser_delete(&parser);
-    yaml_emitter_delete(&emitter);
-    return;
+static int yaml_write_handler(void* data, unsigned char* buffer, size_t size)
+{
+    export_ctx_t* export_ctx = (export_ctx_t*)data;
 
-error:
-    ESP_LOGE(TAG, "Error copy with omit");
-    yaml_event_delete(&event);
-    yaml_parser_delete(&parser);
-    yaml_emitter_delete(&emitter);
-    return;
+    return export_ctx->cb((const char*)buffer, size, export_ctx->ctx) == ESP_OK;
 }
 
-void yaml_file_append(FILE* dst, const char* key, component_param_list_t* list)
+esp_err_t component_params_export(component_params_export_cb_t cb, void* ctx)
 {
     yaml_emitter_t emitter;
     yaml_event_t event;
 
     if (!yaml_emitter_initialize(&emitter)) {
         ESP_LOGE(TAG, "Failed to initialize yaml emitter");
-        return;
+        return ESP_ERR_NO_MEM;
     }
 
-    yaml_emitter_set_output_file(&emitter, dst);
+    export_ctx_t export_ctx = {
+        .cb = cb,
+        .ctx = ctx,
+    };
+    yaml_emitter_set_output(&emitter, yaml_write_handler, &export_ctx);
+
+    DIR* dir = NULL;
 
     yaml_stream_start_event_initialize(&event, YAML_UTF8_ENCODING);
     if (!yaml_emitter_emit(&emitter, &event)) goto error;
@@ -211,93 +407,64 @@ void yaml_file_append(FILE* dst, const char* key, component_param_list_t* list)
     yaml_mapping_start_event_initialize(&event, NULL, NULL, 1, YAML_BLOCK_MAPPING_STYLE);
     if (!yaml_emitter_emit(&emitter, &event)) goto error;
 
-    yaml_scalar_event_initialize(&event, NULL, NULL, (yaml_char_t*)key, -1, 1, 1, YAML_PLAIN_SCALAR_STYLE);
-    if (!yaml_emitter_emit(&emitter, &event)) goto error;
+    dir = opendir(PARAMS_DIR);
+    if (dir) {
+        char path[sizeof(PARAMS_DIR) + 256];
+        struct dirent* de;
+        while ((de = readdir(dir)) != NULL) {
+            size_t name_len = strlen(de->d_name);
+            if (de->d_name[0] == '.' || name_len < 4 || strcmp(de->d_name + name_len - 4, ".bin") != 0) continue;
+            snprintf(path, sizeof(path), PARAMS_DIR "/%s", de->d_name);
+
+            FILE* file = fopen(path, "rb");
+            if (!file) continue;
+            char* id = NULL;
+            component_param_list_t* list = params_file_read(file, NULL, &id);
+            fclose(file);
+            if (!list) continue;
 
-    yaml_mapping_start_event_initialize(&event, NULL, NULL, 1, YAML_BLOCK_MAPPING_STYLE);
-    if (!yaml_emitter_emit(&emitter, &event)) goto error;
+            bool ok = yaml_emit_scalar(&emitter, id);
 
-    component_param_entry_t* entry;
-    SLIST_FOREACH (entry, list, entries) {
-        yaml_scalar_event_initialize(&event, NULL, NULL, (yaml_char_t*)entry->key, -1, 1, 1, YAML_PLAIN_SCALAR_STYLE);
-        if (!yaml_emitter_emit(&emitter, &event)) goto error;
+            yaml_mapping_start_event_initialize(&event, NULL, NULL, 1, YAML_BLOCK_MAPPING_STYLE);
+            ok = ok && yaml_emitter_emit(&emitter, &event);
 
-        yaml_scalar_event_initialize(&event, NULL, NULL, (yaml_char_t*)(entry->value ? entry->value : ""), -1, 1, 1, YAML_PLAIN_SCALAR_STYLE);
-        if (!yaml_emitter_emit(&emitter, &event)) goto error;
+            component_param_entry_t* entry;
+            SLIST_FOREACH (entry, list, entries) {
+                ok = ok && yaml_emit_scalar(&emitter, entry->key) && yaml_emit_scalar(&emitter, entry->value);
+            }
+
+            yaml_mapping_end_event_initialize(&event);
+            ok = ok && yaml_emitter_emit(&emitter, &event);
+
+            free((void*)id);
+            component_params_free(list);
+            if (!ok) goto error;
+        }
+        closedir(dir);
+        dir = NULL;
     }
 
     yaml_mapping_end_event_initialize(&event);
     if (!yaml_emitter_emit(&emitter, &event)) goto error;
 
-    yaml_mapping_end_event_initialize(&event);
+    yaml_document_end_event_initialize(&event, 1);
     if (!yaml_emitter_emit(&emitter, &event)) goto error;
 
-    yaml_document_end_event_initialize(&event, 1);
+    yaml_stream_end_event_initialize(&event);
     if (!yaml_emitter_emit(&emitter, &event)) goto error;
 
     yaml_emitter_delete(&emitter);
-    return;
+    return ESP_OK;
 
 error:
-    ESP_LOGE(TAG, "Error append");
+    ESP_LOGE(TAG, "Error export");
+    if (dir) closedir(dir);
     yaml_emitter_delete(&emitter);
-    return;
-}
-
-void component_params_write(const char* component, component_param_list_t* list)
-{
-    FILE* file = fopen(PARAMS_YAML, "r");
-    if (file) {  // some params.yaml exists
-        FILE* tmp_file = fopen(PARAMS_TMP_YAML, "w");
-        if (!tmp_file) {
-            ESP_LOGE(TAG, "Failed to open " PARAMS_TMP_YAML);
-            fclose(file);
-            return;
-        }
-
-        yaml_file_copy_omit(tmp_file, file, component);
-
-        tmp_file = freopen(PARAMS_TMP_YAML, "r", tmp_file);
-        if (!tmp_file) {
-            ESP_LOGE(TAG, "Failed to open " PARAMS_TMP_YAML);
-            fclose(file);
-            return;
-        }
-        file = freopen(PARAMS_YAML, "w", file);
-        if (!file) {
-            ESP_LOGE(TAG, "Failed to open " PARAMS_YAML);
-            fclose(tmp_file);
-            return;
-        }
-
-        yaml_file_copy(file, tmp_file);
-        yaml_file_append(file, component, list);
-
-        fclose(tmp_file);
-        remove(PARAMS_TMP_YAML);
-    } else {  // no params.yaml exists
-        file = fopen(PARAMS_YAML, "w");
-        if (!file) {
-            ESP_LOGE(TAG, "Failed to open " PARAMS_YAML);
-            return;
-        }
-        yaml_file_append(file, component, list);
-    }
-
-    fclose(file);
+    return ESP_FAIL;
 }
 
 void component_params_free(component_param_list_t* list)
 {
-    while (!SLIST_EMPTY(list)) {
-        component_param_entry_t* item = SLIST_FIRST(list);
-
-        SLIST_REMOVE_HEAD(list, entries);
-
-        if (item->key) free((void*)item->key);
-        if (item->value) free((void*)item->value);
-        free((void*)item);
-    }
-
+    list_clear(list);
     free((void*)list);
-}
\ No newline at end of file
+}
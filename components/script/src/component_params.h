@@ -1,6 +1,8 @@
 #ifndef COMPONENT_PARAMS_H_
 #define COMPONENT_PARAMS_H_
 
+#include <esp_err.h>
+#include <stddef.h>
 #include <sys/queue.h>
 
 typedef struct component_param_entry_s {
@@ -12,9 +14,41 @@ typedef struct component_param_entry_s {
 
 typedef SLIST_HEAD(component_param_list_s, component_param_entry_s) component_param_list_t;
 
+/**
+ * @brief Read params of component from binary record store, uploaded params.yaml is imported first
+ *
+ * @param component
+ * @return component_param_list_t* list of params, NULL when component has no stored params
+ */
 component_param_list_t* component_params_read(const char* component);
 
-void component_params_write(const char* component, component_param_list_t*);
+/**
+ * @brief Atomically replace stored params of single component
+ *
+ * @param component
+ * @param list
+ */
+void component_params_write(const char* component, component_param_list_t* list);
+
+/**
+ * @brief Remove params of all components
+ *
+ */
+void component_params_clear(void);
+
+/**
+ * @brief Callback for exported params.yaml
+ */
+typedef esp_err_t (*component_params_export_cb_t)(const char* buf, size_t len, void* ctx);
+
+/**
+ * @brief Export params of all components in params.yaml format, callback is called by chunks
+ *
+ * @param cb
+ * @param ctx
+ * @return esp_err_t
+ */
+esp_err_t component_params_export(component_params_export_cb_t cb, void* ctx);
 
 void component_params_free(component_param_list_t* list);
 
@@ -1,8 +1,15 @@
 #include "l_aux_lib.h"
 
 #include "aux_io.h"
+#include "l_rotable.h"
 #include "lauxlib.h"
 #include "lua.h"
+#include "script_utils.h"
+
+static void IRAM_ATTR input_change_cb(void)
+{
+    script_event_post_from_isr(SCRIPT_EVENT_AUX);
+}
 
 static int l_write(lua_State* L)
 {
@@ -45,16 +52,18 @@ static int l_analog_read(lua_State* L)
     return 1;
 }
 
-static const luaL_Reg lib[] = {
-    { "write", l_write },
-    { "read", l_read },
-    { "analogread", l_analog_read },
-    { NULL, NULL },
+static const l_rotable_entry_t lib[] = {
+    L_ROTABLE_FUNCTION("write", l_write),
+    L_ROTABLE_FUNCTION("read", l_read),
+    L_ROTABLE_FUNCTION("analogread", l_analog_read),
+    L_ROTABLE_END,
 };
 
 int luaopen_aux(lua_State* L)
 {
-    luaL_newlib(L, lib);
+    aux_set_input_change_cb(input_change_cb);
+
+    l_rotable_push(L, lib);
 
     return 1;
 }
\ No newline at end of file
@@ -0,0 +1,549 @@
+#include "l_bytes_lib.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "l_rotable.h"
+#include "lauxlib.h"
+
+#define MAX_INT_SIZE 8
+#define MAX_LEN      (SIZE_MAX - sizeof(bytes_t))
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+} bytes_t;
+
+typedef enum {
+    KOPT_INT,
+    KOPT_UINT,
+    KOPT_FLOAT,
+    KOPT_DOUBLE,
+    KOPT_CHARS,
+    KOPT_PADDING,
+} kopt_t;
+
+static bytes_t* new_bytes(lua_State* L, size_t len)
+{
+    if (len > MAX_LEN) {
+        luaL_error(L, "bytes too large");
+    }
+
+    // memory follows header, userdata memory is never moved by Lua
+    bytes_t* bytes = (bytes_t*)lua_newuserdatauv(L, sizeof(bytes_t) + len, 1);
+    bytes->data = (uint8_t*)(bytes + 1);
+    bytes->len = len;
+    luaL_setmetatable(L, "bytes");
+
+    return bytes;
+}
+
+uint8_t* l_bytes_check(lua_State* L, int arg, size_t* len)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, arg, "bytes");
+    *len = bytes->len;
+
+    return bytes->data;
+}
+
+const char* l_bytes_todata(lua_State* L, int arg, size_t* len)
+{
+    if (lua_type(L, arg) == LUA_TSTRING) {
+        return lua_tolstring(L, arg, len);
+    }
+
+    bytes_t* bytes = (bytes_t*)luaL_testudata(L, arg, "bytes");
+    if (bytes) {
+        *len = bytes->len;
+        return (const char*)bytes->data;
+    }
+
+    return NULL;
+}
+
+static uint8_t check_byte(lua_State* L, int arg)
+{
+    lua_Integer value = luaL_checkinteger(L, arg);
+    luaL_argcheck(L, value >= 0 && value <= UINT8_MAX, arg, "value out of range");
+
+    return value;
+}
+
+static uint8_t opt_byte(lua_State* L, int arg)
+{
+    return lua_isnoneornil(L, arg) ? 0 : check_byte(L, arg);
+}
+
+static const char* check_data(lua_State* L, int arg, size_t* len)
+{
+    const char* data = l_bytes_todata(L, arg, len);
+    if (!data) {
+        luaL_typeerror(L, arg, "bytes or string");
+    }
+
+    return data;
+}
+
+/**
+ * Translate relative position as string.sub does, negative counts from end
+ */
+static size_t pos_relat(lua_Integer pos, size_t len)
+{
+    if (pos > 0) return (size_t)pos;
+    if (pos == 0) return 1;
+    if (pos < -(lua_Integer)len) return 0;
+    return len + (size_t)pos + 1;
+}
+
+/**
+ * Check range arguments i, j, return 0 based start and length
+ */
+static size_t check_range(lua_State* L, int arg, size_t len, size_t* start)
+{
+    size_t i = pos_relat(luaL_optinteger(L, arg, 1), len);
+    size_t j = pos_relat(luaL_optinteger(L, arg + 1, -1), len);
+    if (i < 1) i = 1;
+    if (j > len) j = len;
+
+    *start = i - 1;
+    return i <= j ? j - i + 1 : 0;
+}
+
+static int l_new(lua_State* L)
+{
+    size_t len;
+    const char* data = l_bytes_todata(L, 1, &len);
+
+    if (data) {
+        bytes_t* bytes = new_bytes(L, len);
+        memcpy(bytes->data, data, len);
+    } else {
+        lua_Integer size = luaL_checkinteger(L, 1);
+        luaL_argcheck(L, size >= 0 && (lua_Unsigned)size <= MAX_LEN, 1, "invalid size");
+        uint8_t fill = opt_byte(L, 2);
+        bytes_t* bytes = new_bytes(L, size);
+        memset(bytes->data, fill, size);
+    }
+
+    return 1;
+}
+
+static int l_slice(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+
+    size_t start;
+    size_t len = check_range(L, 2, bytes->len, &start);
+
+    // view shares memory, keeps parent alive in user value
+    bytes_t* slice = (bytes_t*)lua_newuserdatauv(L, sizeof(bytes_t), 1);
+    slice->data = bytes->data + start;
+    slice->len = len;
+    luaL_setmetatable(L, "bytes");
+    lua_pushvalue(L, 1);
+    lua_setiuservalue(L, -2, 1);
+
+    return 1;
+}
+
+static int l_tostring(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+
+    size_t start;
+    size_t len = check_range(L, 2, bytes->len, &start);
+    lua_pushlstring(L, (const char*)bytes->data + start, len);
+
+    return 1;
+}
+
+static int l_fill(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+    uint8_t value = check_byte(L, 2);
+
+    size_t start;
+    size_t len = check_range(L, 3, bytes->len, &start);
+    memset(bytes->data + start, value, len);
+
+    return 0;
+}
+
+static int l_copy(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+    size_t pos = pos_relat(luaL_checkinteger(L, 2), bytes->len);
+    size_t src_len;
+    const char* src = check_data(L, 3, &src_len);
+
+    size_t src_start;
+    size_t len = check_range(L, 4, src_len, &src_start);
+    luaL_argcheck(L, pos >= 1 && pos - 1 + len <= bytes->len, 2, "out of range");
+    // memmove, source can be view of same memory
+    memmove(bytes->data + pos - 1, src + src_start, len);
+
+    lua_pushinteger(L, pos + len);
+    return 1;
+}
+
+static int l_find(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+
+    size_t needle_len;
+    const char* needle;
+    char needle_byte;
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        needle_byte = luaL_checkinteger(L, 2);
+        needle = &needle_byte;
+        needle_len = 1;
+    } else {
+        needle = check_data(L, 2, &needle_len);
+    }
+    size_t init = pos_relat(luaL_optinteger(L, 3, 1), bytes->len);
+    if (init < 1) init = 1;
+
+    if (needle_len > 0 && init - 1 + needle_len <= bytes->len) {
+        const uint8_t* end = bytes->data + bytes->len - needle_len;
+        for (const uint8_t* p = bytes->data + init - 1; p <= end; p++) {
+            p = (const uint8_t*)memchr(p, needle[0], end - p + 1);
+            if (!p) break;
+            if (memcmp(p, needle, needle_len) == 0) {
+                lua_pushinteger(L, p - bytes->data + 1);
+                lua_pushinteger(L, p - bytes->data + needle_len);
+                return 2;
+            }
+        }
+    }
+
+    lua_pushnil(L);
+    return 1;
+}
+
+static int read_size(const char** fmt, int def)
+{
+    if (**fmt < '0' || **fmt > '9') return def;
+
+    int size = 0;
+    while (**fmt >= '0' && **fmt <= '9' && size < 1000) {
+        size = size * 10 + (*((*fmt)++) - '0');
+    }
+    return size;
+}
+
+/**
+ * Read next format option, subset of string.pack format without alignment and variable length strings
+ */
+static kopt_t get_option(lua_State* L, const char** fmt, bool* little, int* size)
+{
+    while (true) {
+        char opt = *((*fmt)++);
+        switch (opt) {
+        case '<':
+            *little = true;
+            continue;
+        case '>':
+            *little = false;
+            continue;
+        case '=':
+            *little = true;  // ESP32 is little endian
+            continue;
+        case ' ':
+            continue;
+        case '\0':
+            // only modifiers left
+            (*fmt)--;
+            *size = 0;
+            return KOPT_PADDING;
+        case 'b':
+            *size = 1;
+            return KOPT_INT;
+        case 'B':
+            *size = 1;
+            return KOPT_UINT;
+        case 'h':
+            *size = 2;
+            return KOPT_INT;
+        case 'H':
+            *size = 2;
+            return KOPT_UINT;
+        case 'l':
+            *size = sizeof(long);
+            return KOPT_INT;
+        case 'L':
+            *size = sizeof(long);
+            return KOPT_UINT;
+        case 'j':
+            *size = sizeof(lua_Integer);
+            return KOPT_INT;
+        case 'J':
+            *size = sizeof(lua_Integer);
+            return KOPT_UINT;
+        case 'T':
+            *size = sizeof(size_t);
+            return KOPT_UINT;
+        case 'i':
+            *size = read_size(fmt, 4);
+            break;
+        case 'I':
+            *size = read_size(fmt, 4);
+            break;
+        case 'f':
+            *size = sizeof(float);
+            return KOPT_FLOAT;
+        case 'd':
+            *size = sizeof(double);
+            return KOPT_DOUBLE;
+        case 'n':
+            *size = sizeof(lua_Number);
+            return sizeof(lua_Number) == sizeof(float) ? KOPT_FLOAT : KOPT_DOUBLE;
+        case 'x':
+            *size = 1;
+            return KOPT_PADDING;
+        case 'c':
+            *size = read_size(fmt, -1);
+            if (*size < 0) luaL_error(L, "missing size for format option 'c'");
+            return KOPT_CHARS;
+        default:
+            luaL_error(L, "invalid format option '%c'", opt);
+            return KOPT_PADDING;
+        }
+
+        if (*size < 1 || *size > MAX_INT_SIZE) {
+            luaL_error(L, "integral size (%d) out of limits [1,%d]", *size, MAX_INT_SIZE);
+        }
+        return opt == 'i' ? KOPT_INT : KOPT_UINT;
+    }
+}
+
+static void pack_int(uint8_t* p, uint64_t value, bool little, int size)
+{
+    for (int i = 0; i < size; i++) {
+        p[little ? i : size - 1 - i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static uint64_t unpack_int(const uint8_t* p, bool little, int size)
+{
+    uint64_t value = 0;
+    for (int i = size - 1; i >= 0; i--) {
+        value = (value << 8) | p[little ? i : size - 1 - i];
+    }
+    return value;
+}
+
+static int l_pack(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+    size_t pos = pos_relat(luaL_checkinteger(L, 2), bytes->len);
+    luaL_argcheck(L, pos >= 1, 2, "out of range");
+    const char* fmt = luaL_checkstring(L, 3);
+
+    bool little = true;
+    int arg = 4;
+    while (*fmt) {
+        int size;
+        kopt_t opt = get_option(L, &fmt, &little, &size);
+        if (pos - 1 + size > bytes->len) {
+            luaL_argerror(L, 2, "data does not fit");
+        }
+        uint8_t* p = bytes->data + pos - 1;
+
+        switch (opt) {
+        case KOPT_INT:
+        case KOPT_UINT:
+            pack_int(p, (uint64_t)luaL_checkinteger(L, arg++), little, size);
+            break;
+        case KOPT_FLOAT: {
+            float f = (float)luaL_checknumber(L, arg++);
+            uint32_t u;
+            memcpy(&u, &f, sizeof(u));
+            pack_int(p, u, little, size);
+            break;
+        }
+        case KOPT_DOUBLE: {
+            double d = (double)luaL_checknumber(L, arg++);
+            uint64_t u;
+            memcpy(&u, &d, sizeof(u));
+            pack_int(p, u, little, size);
+            break;
+        }
+        case KOPT_CHARS: {
+            size_t len;
+            const char* data = check_data(L, arg++, &len);
+            luaL_argcheck(L, len <= (size_t)size, arg - 1, "longer than given size");
+            memcpy(p, data, len);
+            memset(p + len, 0, size - len);
+            break;
+        }
+        case KOPT_PADDING:
+            memset(p, 0, size);
+            break;
+        }
+        pos += size;
+    }
+
+    lua_pushinteger(L, pos);
+    return 1;
+}
+
+static int l_unpack(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+    size_t pos = pos_relat(luaL_checkinteger(L, 2), bytes->len);
+    luaL_argcheck(L, pos >= 1, 2, "out of range");
+    const char* fmt = luaL_checkstring(L, 3);
+
+    bool little = true;
+    int n = 0;
+    while (*fmt) {
+        int size;
+        kopt_t opt = get_option(L, &fmt, &little, &size);
+        if (pos - 1 + size > bytes->len) {
+            luaL_argerror(L, 2, "data too short");
+        }
+        const uint8_t* p = bytes->data + pos - 1;
+
+        luaL_checkstack(L, 2, "too many results");
+        switch (opt) {
+        case KOPT_INT: {
+            uint64_t value = unpack_int(p, little, size);
+            if (size < 8) {
+                uint64_t mask = 1ULL << (size * 8 - 1);
+                value = (value ^ mask) - mask;  // sign extend
+            }
+            lua_pushinteger(L, (lua_Integer)value);
+            n++;
+            break;
+        }
+        case KOPT_UINT:
+            lua_pushinteger(L, (lua_Integer)unpack_int(p, little, size));
+            n++;
+            break;
+        case KOPT_FLOAT: {
+            uint32_t u = unpack_int(p, little, size);
+            float f;
+            memcpy(&f, &u, sizeof(f));
+            lua_pushnumber(L, f);
+            n++;
+            break;
+        }
+        case KOPT_DOUBLE: {
+            uint64_t u = unpack_int(p, little, size);
+            double d;
+            memcpy(&d, &u, sizeof(d));
+            lua_pushnumber(L, d);
+            n++;
+            break;
+        }
+        case KOPT_CHARS:
+            lua_pushlstring(L, (const char*)p, size);
+            n++;
+            break;
+        case KOPT_PADDING:
+            break;
+        }
+        pos += size;
+    }
+
+    lua_pushinteger(L, pos);
+    return n + 1;
+}
+
+static int l_index(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        lua_Integer i = luaL_checkinteger(L, 2);
+        if (i >= 1 && (size_t)i <= bytes->len) {
+            lua_pushinteger(L, bytes->data[i - 1]);
+        } else {
+            lua_pushnil(L);
+        }
+    } else {
+        lua_pushvalue(L, 2);
+        lua_rawget(L, lua_upvalueindex(1));
+    }
+
+    return 1;
+}
+
+static int l_newindex(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+    lua_Integer i = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, i >= 1 && (size_t)i <= bytes->len, 2, "out of range");
+
+    bytes->data[i - 1] = check_byte(L, 3);
+
+    return 0;
+}
+
+static int l_len(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+
+    lua_pushinteger(L, bytes->len);
+
+    return 1;
+}
+
+static int l_eq(lua_State* L)
+{
+    bytes_t* a = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+    bytes_t* b = (bytes_t*)luaL_checkudata(L, 2, "bytes");
+
+    lua_pushboolean(L, a->len == b->len && memcmp(a->data, b->data, a->len) == 0);
+
+    return 1;
+}
+
+static int l_name(lua_State* L)
+{
+    bytes_t* bytes = (bytes_t*)luaL_checkudata(L, 1, "bytes");
+
+    lua_pushfstring(L, "bytes (%d): %p", (int)bytes->len, bytes->data);
+
+    return 1;
+}
+
+static const l_rotable_entry_t lib[] = {
+    L_ROTABLE_FUNCTION("new", l_new),
+    L_ROTABLE_END,
+};
+
+static const luaL_Reg methods[] = {
+    { "slice", l_slice },
+    { "tostring", l_tostring },
+    { "fill", l_fill },
+    { "copy", l_copy },
+    { "find", l_find },
+    { "pack", l_pack },
+    { "unpack", l_unpack },
+    { NULL, NULL },
+};
+
+static const luaL_Reg metadata[] = {
+    { "__newindex", l_newindex },
+    { "__len", l_len },
+    { "__eq", l_eq },
+    { "__tostring", l_name },
+    { NULL, NULL },
+};
+
+int luaopen_bytes(lua_State* L)
+{
+    l_rotable_push(L, lib);
+
+    luaL_newmetatable(L, "bytes");
+    luaL_setfuncs(L, metadata, 0);
+    luaL_newlib(L, methods);
+    lua_pushcclosure(L, l_index, 1);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    return 1;
+}
@@ -0,0 +1,31 @@
+#ifndef L_BYTES_LIB_H_
+#define L_BYTES_LIB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lua.h"
+
+int luaopen_bytes(lua_State* L);
+
+/**
+ * @brief Check argument is bytes, return its mutable memory
+ *
+ * @param L
+ * @param arg
+ * @param len Length of memory
+ * @return uint8_t*
+ */
+uint8_t* l_bytes_check(lua_State* L, int arg, size_t* len);
+
+/**
+ * @brief Get memory of bytes or string argument, without copy
+ *
+ * @param L
+ * @param arg
+ * @param len Length of memory
+ * @return const char* NULL when argument is neither bytes nor string
+ */
+const char* l_bytes_todata(lua_State* L, int arg, size_t* len);
+
+#endif /* L_BYTES_LIB_H_ */
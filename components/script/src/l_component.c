@@ -1,15 +1,22 @@
 #include "l_component.h"
 
 #include <esp_log.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
+#include <esp_timer.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/param.h>
 #include <sys/queue.h>
 
 #include "component_params.h"
 #include "lauxlib.h"
 #include "lua.h"
 #include "script.h"
+#include "script_alloc.h"
+#include "script_utils.h"
+#include "script_watchdog.h"
+
+#define HEAP_NONE             UINT16_MAX
+#define DEFAULT_RESUME_PERIOD 50  // ms, coroutine yielded without timeout
 
 // static const char* TAG = "l_component";
 
@@ -21,7 +28,16 @@ typedef struct component_entry_s {
     int params_ref;
     int start_ref;
     int coroutine_ref;
-    TickType_t resume_after;
+    int64_t resume_after;  // esp timer time in us
+    uint16_t heap_index;
+    uint8_t owner;  // script allocator owner of allocations
+    uint32_t await_events;  // SCRIPT_EVENT_x bits awaited by coroutine
+    uint32_t resume_event;  // SCRIPT_EVENT_x bit which woken awaiting coroutine
+    uint32_t budget;        // ms of CPU per resume, 0 for default
+    int64_t run_time;       // us
+    uint32_t max_slice;     // us
+    uint32_t overruns;
+    bool resume_on_event : 1;
 
     SLIST_ENTRY(component_entry_s) entries;
 } component_entry_t;
@@ -30,6 +46,95 @@ typedef SLIST_HEAD(component_list_s, component_entry_s) component_list_t;
 
 static int components_ref = LUA_NOREF;
 
+// yielded value marking await, distinguish it from coroutine.yield
+static char await_marker;
+
+static const struct {
+    const char* name;
+    uint32_t event;
+} events[] = {
+    { "evse", SCRIPT_EVENT_EVSE },
+    { "mqtt", SCRIPT_EVENT_MQTT },
+    { "serial", SCRIPT_EVENT_SERIAL },
+    { "aux", SCRIPT_EVENT_AUX },
+};
+
+// min-heap of scheduled components by resume_after
+static component_entry_t** heap = NULL;
+
+static uint16_t heap_len = 0;
+
+static uint16_t heap_size = 0;
+
+static void heap_set(uint16_t index, component_entry_t* component)
+{
+    heap[index] = component;
+    component->heap_index = index;
+}
+
+static void heap_sift_up(uint16_t index)
+{
+    component_entry_t* component = heap[index];
+    while (index > 0) {
+        uint16_t parent = (index - 1) / 2;
+        if (heap[parent]->resume_after <= component->resume_after) break;
+        heap_set(index, heap[parent]);
+        index = parent;
+    }
+    heap_set(index, component);
+}
+
+static void heap_sift_down(uint16_t index)
+{
+    component_entry_t* component = heap[index];
+    while (true) {
+        uint16_t child = 2 * index + 1;
+        if (child >= heap_len) break;
+        if (child + 1 < heap_len && heap[child + 1]->resume_after < heap[child]->resume_after) child++;
+        if (component->resume_after <= heap[child]->resume_after) break;
+        heap_set(index, heap[child]);
+        index = child;
+    }
+    heap_set(index, component);
+}
+
+static void heap_remove(component_entry_t* component)
+{
+    uint16_t index = component->heap_index;
+    if (index == HEAP_NONE) return;
+
+    component->heap_index = HEAP_NONE;
+    heap_len--;
+    if (index < heap_len) {
+        component_entry_t* last = heap[heap_len];
+        heap_set(index, last);
+        heap_sift_down(index);
+        heap_sift_up(last->heap_index);
+    }
+}
+
+static void schedule(component_entry_t* component, int64_t resume_after)
+{
+    component->resume_after = resume_after;
+
+    if (component->heap_index != HEAP_NONE) {
+        heap_sift_down(component->heap_index);
+        heap_sift_up(component->heap_index);
+        return;
+    }
+
+    if (heap_len == heap_size) {
+        uint16_t size = heap_size ? heap_size * 2 : 4;
+        component_entry_t** new_heap = (component_entry_t**)realloc((void*)heap, sizeof(component_entry_t*) * size);
+        if (!new_heap) return;
+        heap = new_heap;
+        heap_size = size;
+    }
+
+    heap_set(heap_len, component);
+    heap_sift_up(heap_len++);
+}
+
 const char* param_list_get_value(const component_param_list_t* list, const char* key)
 {
     component_param_entry_t* entry;
@@ -129,6 +234,16 @@ static void component_process_params(lua_State* L, component_entry_t* component)
     if (param_list) component_params_free(param_list);
 }
 
+static void component_account(component_entry_t* component)
+{
+    bool overrun;
+    int64_t slice = script_watchdog_stop(&overrun);
+
+    component->run_time += slice;
+    component->max_slice = MAX(component->max_slice, (uint32_t)MIN(slice, UINT32_MAX));
+    if (overrun) component->overruns++;
+}
+
 static void component_restart_coroutine(lua_State* L, component_entry_t* component)
 {
     // end previous coroutine
@@ -146,14 +261,21 @@ static void component_restart_coroutine(lua_State* L, component_entry_t* compone
 
     luaL_unref(L, LUA_REGISTRYINDEX, component->coroutine_ref);
     component->coroutine_ref = LUA_NOREF;
-    component->resume_after = 0;
+    component->await_events = 0;
+    component->resume_event = 0;
+    heap_remove(component);
 
     lua_gc(L, LUA_GCCOLLECT, 0);
 
     // start new coroutine
+    uint8_t prev_owner = script_alloc_set_owner(L, component->owner);
     lua_rawgeti(L, LUA_REGISTRYINDEX, component->start_ref);
     lua_rawgeti(L, LUA_REGISTRYINDEX, component->params_ref);
-    if (lua_pcall(L, 1, 1, 0) != LUA_OK) {
+    script_watchdog_start(component->budget);
+    int status = lua_pcall(L, 1, 1, 0);
+    component_account(component);
+    script_alloc_set_owner(L, prev_owner);
+    if (status != LUA_OK) {
         const char* err = lua_tostring(L, -1);
         lua_writestring(err, strlen(err));
         lua_writeline();
@@ -161,6 +283,8 @@ static void component_restart_coroutine(lua_State* L, component_entry_t* compone
     } else {
         if (lua_isthread(L, -1)) {
             component->coroutine_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+            component->resume_on_event = false;
+            schedule(component, 0);
         } else {
             lua_pop(L, 1);
         }
@@ -198,12 +322,19 @@ static int l_register(lua_State* L)
     luaL_argcheck(L, lua_isfunction(L, -1), 1, "no start function");
     lua_pop(L, 1);
 
+    lua_getfield(L, 1, "budget");
+    luaL_argcheck(L, lua_isnil(L, -1) || (lua_isinteger(L, -1) && lua_tointeger(L, -1) >= 0), 1, "invalid budget field");
+    uint32_t budget = lua_tointeger(L, -1);
+    lua_pop(L, 1);
+
     component_list_t* component_list = get_component_list(L);
     component_entry_t* component;
+    uint8_t count = 0;
     SLIST_FOREACH (component, component_list, entries) {
         if (strcmp(id, component->id) == 0) {
             luaL_argerror(L, 1, "component with duplicate id");
         }
+        count++;
     }
 
     component = (component_entry_t*)malloc(sizeof(component_entry_t));
@@ -216,6 +347,14 @@ static int l_register(lua_State* L)
     component->start_ref = luaL_ref(L, LUA_REGISTRYINDEX);
     component->params_ref = LUA_NOREF;
     component->coroutine_ref = LUA_NOREF;
+    component->heap_index = HEAP_NONE;
+    component->owner = count + 1 < SCRIPT_ALLOC_OWNERS ? count + 1 : 0;  // others share owner with main chunk
+    component->await_events = 0;
+    component->resume_event = 0;
+    component->budget = budget;
+    component->run_time = 0;
+    component->max_slice = 0;
+    component->overruns = 0;
 
     component_process_params(L, component);
     component_restart_coroutine(L, component);
@@ -225,6 +364,69 @@ static int l_register(lua_State* L)
     return 0;
 }
 
+static uint32_t check_event(lua_State* L, int idx, int arg)
+{
+    const char* name = lua_tostring(L, idx);
+    if (name) {
+        for (int i = 0; i < sizeof(events) / sizeof(events[0]); i++) {
+            if (strcmp(events[i].name, name) == 0) {
+                return events[i].event;
+            }
+        }
+    }
+    return luaL_argerror(L, arg, "unknown event source");
+}
+
+/**
+ * Running thread is coroutine started by component scheduler, nested coroutines are yieldable too but not resumed by scheduler
+ */
+static bool is_component_coroutine(lua_State* L)
+{
+    component_entry_t* component;
+    SLIST_FOREACH (component, get_component_list(L), entries) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, component->coroutine_ref);
+        bool found = lua_tothread(L, -1) == L;
+        lua_pop(L, 1);
+        if (found) return true;
+    }
+
+    return false;
+}
+
+static int l_await_cont(lua_State* L, int status, lua_KContext ctx)
+{
+    return lua_gettop(L) - (int)ctx;
+}
+
+static int l_await(lua_State* L)
+{
+    uint32_t await_events = 0;
+
+    if (lua_istable(L, 1)) {
+        int len = luaL_len(L, 1);
+        for (int i = 1; i <= len; i++) {
+            lua_rawgeti(L, 1, i);
+            await_events |= check_event(L, -1, 1);
+            lua_pop(L, 1);
+        }
+        luaL_argcheck(L, await_events, 1, "empty event sources");
+    } else {
+        await_events = check_event(L, 1, 1);
+    }
+
+    lua_Integer timeout = luaL_optinteger(L, 2, -1);
+    if (!lua_isyieldable(L) || !is_component_coroutine(L)) {
+        return luaL_error(L, "await outside of component coroutine");
+    }
+
+    int top = lua_gettop(L);
+    lua_pushlightuserdata(L, &await_marker);
+    lua_pushinteger(L, await_events);
+    lua_pushinteger(L, timeout);
+
+    return lua_yieldk(L, 3, (lua_KContext)top, l_await_cont);
+}
+
 static int l_gc(lua_State* L)
 {
     component_list_t* component_list = get_component_list(L);
@@ -239,11 +441,52 @@ static int l_gc(lua_State* L)
         free((void*)component);
     }
 
+    free((void*)heap);
+    heap = NULL;
+    heap_len = 0;
+    heap_size = 0;
+
     return 0;
 }
 
+static int l_memory(lua_State* L)
+{
+    script_alloc_stats_t stats;
+    bool has_stats = script_alloc_get_stats(L, &stats);
+
+    if (lua_isnoneornil(L, 1)) {
+        if (has_stats) {
+            lua_pushinteger(L, stats.used);
+            lua_pushinteger(L, stats.peak);
+            lua_pushinteger(L, stats.limit);
+        } else {
+            lua_Integer used = lua_gc(L, LUA_GCCOUNT) * 1024 + lua_gc(L, LUA_GCCOUNTB);
+            lua_pushinteger(L, used);
+            lua_pushinteger(L, used);
+            lua_pushinteger(L, 0);
+        }
+        return 3;
+    }
+
+    const char* id = luaL_checkstring(L, 1);
+    component_entry_t* component;
+    SLIST_FOREACH (component, get_component_list(L), entries) {
+        if (strcmp(id, component->id) == 0) {
+            if (has_stats && component->owner) {
+                lua_pushinteger(L, stats.owner_used[component->owner]);
+            } else {
+                lua_pushnil(L);
+            }
+            return 1;
+        }
+    }
+
+    return luaL_argerror(L, 1, "unknown component");
+}
+
 static const luaL_Reg lib[] = {
     { "register", l_register },
+    { "memory", l_memory },
     { NULL, NULL },
 };
 
@@ -265,35 +508,96 @@ int luaopen_component(lua_State* L)
     luaL_setfuncs(L, metadata, 0);
     lua_setmetatable(L, -1);
 
+    lua_register(L, "await", l_await);
+
     return 1;
 }
 
-void l_component_resume(lua_State* L)
+static void component_resume(lua_State* L, component_entry_t* component, int64_t now)
 {
-    component_list_t* component_list = get_component_list(L);
-    component_entry_t* component;
-    SLIST_FOREACH (component, component_list, entries) {
-        if (component->resume_after == 0 || component->resume_after < xTaskGetTickCount()) {
-            lua_rawgeti(L, LUA_REGISTRYINDEX, component->coroutine_ref);
-            if (lua_isthread(L, -1)) {
-                lua_State* co = lua_tothread(L, -1);
-                int status = lua_status(co);
-                if (status == LUA_YIELD || status == LUA_OK) {
-                    int nresults = 0;
-                    status = lua_resume(co, L, 0, &nresults);
-                    if (status == LUA_YIELD || status == LUA_OK) {
-                        if (nresults > 0 && lua_isinteger(co, -nresults)) {
-                            component->resume_after = xTaskGetTickCount() + pdMS_TO_TICKS(lua_tointeger(co, -nresults));
-                        }
-                    } else {
-                        const char* err = lua_tostring(co, -1);
-                        lua_writestring(err, strlen(err));
-                        lua_writeline();
+    lua_rawgeti(L, LUA_REGISTRYINDEX, component->coroutine_ref);
+    if (lua_isthread(L, -1)) {
+        lua_State* co = lua_tothread(L, -1);
+        int status = lua_status(co);
+        if (status == LUA_YIELD || status == LUA_OK) {
+            int nargs = 0;
+            int nresults = 0;
+            if (component->resume_event) {
+                // await returns name of event source, nil on timeout
+                for (int i = 0; i < sizeof(events) / sizeof(events[0]); i++) {
+                    if (events[i].event == component->resume_event) {
+                        lua_pushstring(co, events[i].name);
+                        nargs = 1;
                     }
-                    lua_pop(co, nresults);
                 }
+            } else if (component->await_events) {
+                lua_pushnil(co);
+                nargs = 1;
             }
-            lua_pop(L, 1);
+            component->await_events = 0;
+            component->resume_event = 0;
+
+            uint8_t prev_owner = script_alloc_set_owner(L, component->owner);
+            script_watchdog_start(component->budget);
+            status = lua_resume(co, L, nargs, &nresults);
+            component_account(component);
+            script_alloc_set_owner(L, prev_owner);
+            if (status == LUA_YIELD && nresults == 3 && lua_touserdata(co, -3) == &await_marker) {
+                // await with timeout in ms, without timeout resume only on event
+                component->await_events = lua_tointeger(co, -2);
+                component->resume_on_event = false;
+                lua_Integer timeout = lua_tointeger(co, -1);
+                if (timeout >= 0) {
+                    schedule(component, MAX(esp_timer_get_time() + timeout * 1000, now + 1));
+                }
+            } else if (status == LUA_YIELD) {
+                // yield with timeout in ms, without timeout resume on next event or default period
+                int64_t resume_after;
+                component->resume_on_event = nresults == 0 || !lua_isinteger(co, -nresults);
+                if (component->resume_on_event) {
+                    resume_after = esp_timer_get_time() + DEFAULT_RESUME_PERIOD * 1000;
+                } else {
+                    resume_after = esp_timer_get_time() + MAX(lua_tointeger(co, -nresults), 0) * 1000;
+                }
+                schedule(component, MAX(resume_after, now + 1));
+            } else if (status != LUA_OK) {
+                const char* err = lua_tostring(co, -1);
+                lua_writestring(err, strlen(err));
+                lua_writeline();
+            }
+            lua_pop(co, nresults);
+        }
+    }
+    lua_pop(L, 1);
+}
+
+int64_t l_component_resume(lua_State* L)
+{
+    int64_t now = esp_timer_get_time();
+
+    while (heap_len > 0 && heap[0]->resume_after <= now) {
+        component_entry_t* component = heap[0];
+        heap_remove(component);
+        component_resume(L, component, now);
+    }
+
+    return heap_len > 0 ? heap[0]->resume_after : INT64_MAX;
+}
+
+void l_component_notify_event(lua_State* L, uint32_t events)
+{
+    int64_t now = esp_timer_get_time();
+
+    component_list_t* component_list = get_component_list(L);
+    component_entry_t* component;
+    SLIST_FOREACH (component, component_list, entries) {
+        uint32_t awaited = component->await_events & events;
+        if (awaited) {
+            component->resume_event = awaited & -awaited;
+            component->await_events = 0;
+            schedule(component, now);
+        } else if (component->resume_on_event && component->heap_index != HEAP_NONE && component->resume_after > now) {
+            schedule(component, now);
         }
     }
 }
@@ -303,6 +607,9 @@ script_component_list_t* l_component_get_components(lua_State* L)
     script_component_list_t* list = (script_component_list_t*)malloc(sizeof(script_component_list_t));
     SLIST_INIT(list);
 
+    script_alloc_stats_t stats;
+    bool has_stats = script_alloc_get_stats(L, &stats);
+
     component_list_t* component_list = get_component_list(L);
     component_entry_t* component;
     SLIST_FOREACH (component, component_list, entries) {
@@ -310,6 +617,11 @@ script_component_list_t* l_component_get_components(lua_State* L)
         entry->id = strdup(component->id);
         entry->name = strdup(component->name);
         entry->description = component->description ? strdup(component->description) : NULL;
+        entry->memory = has_stats && component->owner ? stats.owner_used[component->owner] : 0;
+        entry->budget = component->budget;
+        entry->run_time = component->run_time;
+        entry->max_slice = component->max_slice;
+        entry->overruns = component->overruns;
         SLIST_INSERT_HEAD(list, entry, entries);
     }
 
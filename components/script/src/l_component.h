@@ -2,13 +2,28 @@
 #define L_OS_EXT_LIB_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "lua.h"
 #include "script.h"
 
 int luaopen_component(lua_State* L);
 
-void l_component_resume(lua_State* L);
+/**
+ * @brief Resume components with elapsed deadline
+ *
+ * @param L
+ * @return int64_t Next deadline in esp timer time, INT64_MAX when no component scheduled
+ */
+int64_t l_component_resume(lua_State* L);
+
+/**
+ * @brief Make due components awaiting the events and components which yielded without timeout
+ *
+ * @param L
+ * @param events SCRIPT_EVENT_x bits
+ */
+void l_component_notify_event(lua_State* L, uint32_t events);
 
 script_component_list_t* l_component_get_components(lua_State* L);
 
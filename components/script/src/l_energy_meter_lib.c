@@ -1,6 +1,7 @@
 #include "l_energy_meter_lib.h"
 
 #include "energy_meter.h"
+#include "l_rotable.h"
 #include "lauxlib.h"
 #include "lua.h"
 
@@ -99,41 +100,32 @@ static int l_get_current(lua_State* L)
     return 3;
 }
 
-static const luaL_Reg lib[] = {
+static const l_rotable_entry_t lib[] = {
     // states
-    { "MODEDUMMY", NULL },
-    { "MODECUR", NULL },
-    { "MODECURVLT", NULL },
+    L_ROTABLE_INTEGER("MODEDUMMY", ENERGY_METER_MODE_DUMMY),
+    L_ROTABLE_INTEGER("MODECUR", ENERGY_METER_MODE_CUR),
+    L_ROTABLE_INTEGER("MODECURVLT", ENERGY_METER_MODE_CUR_VLT),
     // methods
-    { "getmode", l_get_mode },
-    { "setmode", l_set_mode },
-    { "getacvoltage", l_get_ac_voltage },
-    { "setacvoltage", l_set_ac_voltage },
-    { "getthreephases", l_get_three_phases },
-    { "setthreephases", l_set_three_phases },
-    { "getpower", l_get_power },
-    { "getchargingtime", l_get_charging_time },
-    { "getsessiontime", l_get_session_time },
-    { "getconsumption", l_get_consumption },
-    { "gettotalconsumption", l_get_total_consumption },
-    { "resettotalconsumption", l_reset_total_consumption },
-    { "getvoltage", l_get_voltage },
-    { "getcurrent", l_get_current },
-    { NULL, NULL },
+    L_ROTABLE_FUNCTION("getmode", l_get_mode),
+    L_ROTABLE_FUNCTION("setmode", l_set_mode),
+    L_ROTABLE_FUNCTION("getacvoltage", l_get_ac_voltage),
+    L_ROTABLE_FUNCTION("setacvoltage", l_set_ac_voltage),
+    L_ROTABLE_FUNCTION("getthreephases", l_get_three_phases),
+    L_ROTABLE_FUNCTION("setthreephases", l_set_three_phases),
+    L_ROTABLE_FUNCTION("getpower", l_get_power),
+    L_ROTABLE_FUNCTION("getchargingtime", l_get_charging_time),
+    L_ROTABLE_FUNCTION("getsessiontime", l_get_session_time),
+    L_ROTABLE_FUNCTION("getconsumption", l_get_consumption),
+    L_ROTABLE_FUNCTION("gettotalconsumption", l_get_total_consumption),
+    L_ROTABLE_FUNCTION("resettotalconsumption", l_reset_total_consumption),
+    L_ROTABLE_FUNCTION("getvoltage", l_get_voltage),
+    L_ROTABLE_FUNCTION("getcurrent", l_get_current),
+    L_ROTABLE_END,
 };
 
 int luaopen_energy_meter(lua_State* L)
 {
-    luaL_newlib(L, lib);
-
-    lua_pushinteger(L, ENERGY_METER_MODE_DUMMY);
-    lua_setfield(L, -2, "MODEDUMMY");
-
-    lua_pushinteger(L, ENERGY_METER_MODE_CUR);
-    lua_setfield(L, -2, "MODECUR");
-
-    lua_pushinteger(L, ENERGY_METER_MODE_CUR_VLT);
-    lua_setfield(L, -2, "MODECURVLT");
+    l_rotable_push(L, lib);
 
     return 1;
 }
\ No newline at end of file
@@ -4,10 +4,17 @@
 
 #include "energy_meter.h"  //TODO remove
 #include "evse.h"
+#include "l_rotable.h"
 #include "lauxlib.h"
 #include "lua.h"
+#include "script_utils.h"
 #include "temp_sensor.h"
 
+static void state_change_cb(evse_state_t state)
+{
+    script_event_post(SCRIPT_EVENT_EVSE);
+}
+
 static int l_get_state(lua_State* L)
 {
     lua_pushinteger(L, evse_get_state());
@@ -234,118 +241,69 @@ static int l_get_limit_reached(lua_State* L)
     return 1;
 }
 
-static const luaL_Reg lib[] = {
+static const l_rotable_entry_t lib[] = {
     // states
-    { "STATEA", NULL },
-    { "STATEB1", NULL },
-    { "STATEB2", NULL },
-    { "STATEC1", NULL },
-    { "STATEC2", NULL },
-    { "STATED1", NULL },
-    { "STATED2", NULL },
-    { "STATEE", NULL },
-    { "STATEF", NULL },
+    L_ROTABLE_INTEGER("STATEA", EVSE_STATE_A),
+    L_ROTABLE_INTEGER("STATEB1", EVSE_STATE_B1),
+    L_ROTABLE_INTEGER("STATEB2", EVSE_STATE_B2),
+    L_ROTABLE_INTEGER("STATEC1", EVSE_STATE_C1),
+    L_ROTABLE_INTEGER("STATEC2", EVSE_STATE_C2),
+    L_ROTABLE_INTEGER("STATED1", EVSE_STATE_D1),
+    L_ROTABLE_INTEGER("STATED2", EVSE_STATE_D2),
+    L_ROTABLE_INTEGER("STATEE", EVSE_STATE_E),
+    L_ROTABLE_INTEGER("STATEF", EVSE_STATE_F),
     // error bits
-    { "ERRPILOTFAULTBIT", NULL },
-    { "ERRDIODESHORTBIT", NULL },
-    { "ERRLOCKFAULTBIT", NULL },
-    { "ERRUNLOCKFAULTBIT", NULL },
-    { "ERRRCMTRIGGEREDBIT", NULL },
-    { "ERRRCMSELFTESTFAULTBIT", NULL },
-    { "ERRTEMPERATUREHIGHBIT", NULL },
-    { "ERRTEMPERATUREFAULTBIT", NULL },
+    L_ROTABLE_INTEGER("ERRPILOTFAULTBIT", EVSE_ERR_PILOT_FAULT_BIT),
+    L_ROTABLE_INTEGER("ERRDIODESHORTBIT", EVSE_ERR_DIODE_SHORT_BIT),
+    L_ROTABLE_INTEGER("ERRLOCKFAULTBIT", EVSE_ERR_LOCK_FAULT_BIT),
+    L_ROTABLE_INTEGER("ERRUNLOCKFAULTBIT", EVSE_ERR_UNLOCK_FAULT_BIT),
+    L_ROTABLE_INTEGER("ERRRCMTRIGGEREDBIT", EVSE_ERR_RCM_TRIGGERED_BIT),
+    L_ROTABLE_INTEGER("ERRRCMSELFTESTFAULTBIT", EVSE_ERR_RCM_SELFTEST_FAULT_BIT),
+    L_ROTABLE_INTEGER("ERRTEMPERATUREHIGHBIT", EVSE_ERR_TEMPERATURE_HIGH_BIT),
+    L_ROTABLE_INTEGER("ERRTEMPERATUREFAULTBIT", EVSE_ERR_TEMPERATURE_FAULT_BIT),
     // methods
-    { "getstate", l_get_state },
-    { "geterror", l_get_error },
-    { "getenabled", l_get_enabled },
-    { "setenabled", l_set_enabled },
-    { "getavailable", l_get_available },
-    { "setavailable", l_set_available },
-    { "getrequireauth", l_get_require_auth },
-    { "setrequireauth", l_set_require_auth },
-    { "getpendingauth", l_get_pending_auth },
-    { "authorize", l_authorize },
-    { "getchargingcurrent", l_get_charging_current },
-    { "setchargingcurrent", l_set_charging_current },
-    { "getdefaultchargingcurrent", l_get_default_charging_current },
-    { "setdefaultchargingcurrent", l_set_default_charging_current },
-    { "getmaxchargingcurrent", l_get_max_charging_current },
-    { "setmaxchargingcurrent", l_set_max_charging_current },
-    { "getpower", l_get_power },                 // TODO has energymeter module, remove
-    { "getchargingtime", l_get_charging_time },  // TODO has energymeter module, remove
-    { "getsessiontime", l_get_session_time },    // TODO has energymeter module, remove
-    { "getconsumption", l_get_consumption },     // TODO has energymeter module, remove
-    { "getvoltage", l_get_voltage },             // TODO has energymeter module, remove
-    { "getcurrent", l_get_current },             // TODO has energymeter module, remove
-    { "getlowtemperature", l_get_low_temperature },
-    { "gethightemperature", l_get_high_temperature },
-    { "getconsumptionlimit", l_get_consumption_limit },
-    { "getchargingtimelimit", l_get_charging_time_limit },
-    { "getunderpowerlimit", l_get_under_power_limit },
-    { "setconsumptionlimit", l_set_consumption_limit },
-    { "setchargingtimelimit", l_set_charging_time_limit },
-    { "setunderpowerlimit", l_set_under_power_limit },
-    { "getdefaultconsumptionlimit", l_get_default_consumption_limit },
-    { "getdefaultchargingtimelimit", l_get_default_charging_time_limit },
-    { "getdefaultunderpowerlimit", l_get_default_under_power_limit },
-    { "getlimitreached", l_get_limit_reached },
-    { NULL, NULL },
+    L_ROTABLE_FUNCTION("getstate", l_get_state),
+    L_ROTABLE_FUNCTION("geterror", l_get_error),
+    L_ROTABLE_FUNCTION("getenabled", l_get_enabled),
+    L_ROTABLE_FUNCTION("setenabled", l_set_enabled),
+    L_ROTABLE_FUNCTION("getavailable", l_get_available),
+    L_ROTABLE_FUNCTION("setavailable", l_set_available),
+    L_ROTABLE_FUNCTION("getrequireauth", l_get_require_auth),
+    L_ROTABLE_FUNCTION("setrequireauth", l_set_require_auth),
+    L_ROTABLE_FUNCTION("getpendingauth", l_get_pending_auth),
+    L_ROTABLE_FUNCTION("authorize", l_authorize),
+    L_ROTABLE_FUNCTION("getchargingcurrent", l_get_charging_current),
+    L_ROTABLE_FUNCTION("setchargingcurrent", l_set_charging_current),
+    L_ROTABLE_FUNCTION("getdefaultchargingcurrent", l_get_default_charging_current),
+    L_ROTABLE_FUNCTION("setdefaultchargingcurrent", l_set_default_charging_current),
+    L_ROTABLE_FUNCTION("getmaxchargingcurrent", l_get_max_charging_current),
+    L_ROTABLE_FUNCTION("setmaxchargingcurrent", l_set_max_charging_current),
+    L_ROTABLE_FUNCTION("getpower", l_get_power),                 // TODO has energymeter module, remove
+    L_ROTABLE_FUNCTION("getchargingtime", l_get_charging_time),  // TODO has energymeter module, remove
+    L_ROTABLE_FUNCTION("getsessiontime", l_get_session_time),    // TODO has energymeter module, remove
+    L_ROTABLE_FUNCTION("getconsumption", l_get_consumption),     // TODO has energymeter module, remove
+    L_ROTABLE_FUNCTION("getvoltage", l_get_voltage),             // TODO has energymeter module, remove
+    L_ROTABLE_FUNCTION("getcurrent", l_get_current),             // TODO has energymeter module, remove
+    L_ROTABLE_FUNCTION("getlowtemperature", l_get_low_temperature),
+    L_ROTABLE_FUNCTION("gethightemperature", l_get_high_temperature),
+    L_ROTABLE_FUNCTION("getconsumptionlimit", l_get_consumption_limit),
+    L_ROTABLE_FUNCTION("getchargingtimelimit", l_get_charging_time_limit),
+    L_ROTABLE_FUNCTION("getunderpowerlimit", l_get_under_power_limit),
+    L_ROTABLE_FUNCTION("setconsumptionlimit", l_set_consumption_limit),
+    L_ROTABLE_FUNCTION("setchargingtimelimit", l_set_charging_time_limit),
+    L_ROTABLE_FUNCTION("setunderpowerlimit", l_set_under_power_limit),
+    L_ROTABLE_FUNCTION("getdefaultconsumptionlimit", l_get_default_consumption_limit),
+    L_ROTABLE_FUNCTION("getdefaultchargingtimelimit", l_get_default_charging_time_limit),
+    L_ROTABLE_FUNCTION("getdefaultunderpowerlimit", l_get_default_under_power_limit),
+    L_ROTABLE_FUNCTION("getlimitreached", l_get_limit_reached),
+    L_ROTABLE_END,
 };
 
 int luaopen_evse(lua_State* L)
 {
-    luaL_newlib(L, lib);
-
-    lua_pushinteger(L, EVSE_STATE_A);
-    lua_setfield(L, -2, "STATEA");
-
-    lua_pushinteger(L, EVSE_STATE_B1);
-    lua_setfield(L, -2, "STATEB1");
-
-    lua_pushinteger(L, EVSE_STATE_B2);
-    lua_setfield(L, -2, "STATEB2");
-
-    lua_pushinteger(L, EVSE_STATE_C1);
-    lua_setfield(L, -2, "STATEC1");
-
-    lua_pushinteger(L, EVSE_STATE_C2);
-    lua_setfield(L, -2, "STATEC2");
-
-    lua_pushinteger(L, EVSE_STATE_D1);
-    lua_setfield(L, -2, "STATED1");
-
-    lua_pushinteger(L, EVSE_STATE_D2);
-    lua_setfield(L, -2, "STATED2");
-
-    lua_pushinteger(L, EVSE_STATE_E);
-    lua_setfield(L, -2, "STATEE");
-
-    lua_pushinteger(L, EVSE_STATE_F);
-    lua_setfield(L, -2, "STATEF");
-
-    lua_pushinteger(L, EVSE_ERR_PILOT_FAULT_BIT);
-    lua_setfield(L, -2, "ERRPILOTFAULTBIT");
-
-    lua_pushinteger(L, EVSE_ERR_DIODE_SHORT_BIT);
-    lua_setfield(L, -2, "ERRDIODESHORTBIT");
-
-    lua_pushinteger(L, EVSE_ERR_LOCK_FAULT_BIT);
-    lua_setfield(L, -2, "ERRLOCKFAULTBIT");
-
-    lua_pushinteger(L, EVSE_ERR_UNLOCK_FAULT_BIT);
-    lua_setfield(L, -2, "ERRUNLOCKFAULTBIT");
-
-    lua_pushinteger(L, EVSE_ERR_RCM_TRIGGERED_BIT);
-    lua_setfield(L, -2, "ERRRCMTRIGGEREDBIT");
-
-    lua_pushinteger(L, EVSE_ERR_RCM_SELFTEST_FAULT_BIT);
-    lua_setfield(L, -2, "ERRRCMSELFTESTFAULTBIT");
-
-    lua_pushinteger(L, EVSE_ERR_TEMPERATURE_HIGH_BIT);
-    lua_setfield(L, -2, "ERRTEMPERATUREHIGHBIT");
+    evse_set_state_change_cb(state_change_cb);
 
-    lua_pushinteger(L, EVSE_ERR_TEMPERATURE_FAULT_BIT);
-    lua_setfield(L, -2, "ERRTEMPERATUREFAULTBIT");
+    l_rotable_push(L, lib);
 
     return 1;
 }
\ No newline at end of file
@@ -1,99 +1,564 @@
 #include "l_json_lib.h"
 
-#include <cJSON.h>
+#include <float.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "l_bytes_lib.h"
+#include "l_rotable.h"
 #include "lauxlib.h"
 #include "lua.h"
 
-static void decode_child(lua_State* L, cJSON* obj)
-{
-    if (cJSON_IsBool(obj)) {
-        lua_pushboolean(L, cJSON_IsTrue(obj));
-    } else if (cJSON_IsNumber(obj)) {
-        lua_pushnumber(L, cJSON_GetNumberValue(obj));
-    } else if (cJSON_IsString(obj)) {
-        lua_pushstring(L, cJSON_GetStringValue(obj));
-    } else if (cJSON_IsObject(obj)) {
-        lua_newtable(L);
-        cJSON* child = obj->child;
-        while (child) {
-            lua_pushstring(L, child->string);
-            decode_child(L, child);
-            lua_settable(L, -3);
-
-            child = child->next;
+#define MAX_DEPTH      64
+#define MAX_NUMBER_LEN 48
+#define BUFFER_SIZE    256
+
+typedef struct {
+    lua_State* L;
+    const char* p;
+    const char* end;
+    int depth;
+} decoder_t;
+
+typedef struct {
+    lua_State* L;
+    char* buf;
+    size_t len;
+    size_t size;
+    int buf_idx;
+    bool format;
+    int depth;
+} encoder_t;
+
+static int decode_error(decoder_t* d)
+{
+    return luaL_error(d->L, "failed to decode json");
+}
+
+static void skip_whitespace(decoder_t* d)
+{
+    while (d->p < d->end && (*d->p == ' ' || *d->p == '\t' || *d->p == '\n' || *d->p == '\r')) {
+        d->p++;
+    }
+}
+
+static bool consume(decoder_t* d, char c)
+{
+    skip_whitespace(d);
+    if (d->p < d->end && *d->p == c) {
+        d->p++;
+        return true;
+    }
+    return false;
+}
+
+static bool consume_literal(decoder_t* d, const char* literal, size_t len)
+{
+    if ((size_t)(d->end - d->p) >= len && memcmp(d->p, literal, len) == 0) {
+        d->p += len;
+        return true;
+    }
+    return false;
+}
+
+static int decode_hex4(decoder_t* d)
+{
+    if (d->end - d->p < 4) return -1;
+
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = *d->p++;
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            value |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            value |= c - 'A' + 10;
+        } else {
+            return -1;
+        }
+    }
+    return value;
+}
+
+static void add_utf8(luaL_Buffer* b, uint32_t cp)
+{
+    char buf[4];
+    int len;
+    if (cp < 0x80) {
+        buf[0] = cp;
+        len = 1;
+    } else if (cp < 0x800) {
+        buf[0] = 0xC0 | (cp >> 6);
+        buf[1] = 0x80 | (cp & 0x3F);
+        len = 2;
+    } else if (cp < 0x10000) {
+        buf[0] = 0xE0 | (cp >> 12);
+        buf[1] = 0x80 | ((cp >> 6) & 0x3F);
+        buf[2] = 0x80 | (cp & 0x3F);
+        len = 3;
+    } else {
+        buf[0] = 0xF0 | (cp >> 18);
+        buf[1] = 0x80 | ((cp >> 12) & 0x3F);
+        buf[2] = 0x80 | ((cp >> 6) & 0x3F);
+        buf[3] = 0x80 | (cp & 0x3F);
+        len = 4;
+    }
+    luaL_addlstring(b, buf, len);
+}
+
+static void decode_string(decoder_t* d)
+{
+    // opening quote consumed
+    const char* start = d->p;
+    while (d->p < d->end && *d->p != '"' && *d->p != '\\') {
+        if ((unsigned char)*d->p < 0x20) decode_error(d);
+        d->p++;
+    }
+    if (d->p >= d->end) decode_error(d);
+
+    if (*d->p == '"') {
+        // without escapes string is pushed directly from source
+        lua_pushlstring(d->L, start, d->p - start);
+        d->p++;
+        return;
+    }
+
+    luaL_Buffer b;
+    luaL_buffinit(d->L, &b);
+    luaL_addlstring(&b, start, d->p - start);
+
+    while (true) {
+        if (d->p >= d->end) decode_error(d);
+        char c = *d->p++;
+        if (c == '"') break;
+        if ((unsigned char)c < 0x20) decode_error(d);
+        if (c != '\\') {
+            luaL_addchar(&b, c);
+            continue;
         }
-    } else if (cJSON_IsArray(obj)) {
-        lua_newtable(L);
-        cJSON* child = obj->child;
-        int array_index = 1;
-        while (child) {
-            decode_child(L, child);
-            lua_rawseti(L, -2, array_index++);
-
-            child = child->next;
+
+        if (d->p >= d->end) decode_error(d);
+        c = *d->p++;
+        switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            luaL_addchar(&b, c);
+            break;
+        case 'b':
+            luaL_addchar(&b, '\b');
+            break;
+        case 'f':
+            luaL_addchar(&b, '\f');
+            break;
+        case 'n':
+            luaL_addchar(&b, '\n');
+            break;
+        case 'r':
+            luaL_addchar(&b, '\r');
+            break;
+        case 't':
+            luaL_addchar(&b, '\t');
+            break;
+        case 'u': {
+            int cp = decode_hex4(d);
+            if (cp < 0) decode_error(d);
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                // surrogate pair
+                if (!consume_literal(d, "\\u", 2)) decode_error(d);
+                int low = decode_hex4(d);
+                if (low < 0xDC00 || low > 0xDFFF) decode_error(d);
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            }
+            add_utf8(&b, cp);
+            break;
         }
+        default:
+            decode_error(d);
+        }
+    }
+
+    luaL_pushresult(&b);
+}
+
+static bool skip_digits(decoder_t* d)
+{
+    const char* start = d->p;
+    while (d->p < d->end && *d->p >= '0' && *d->p <= '9') {
+        d->p++;
+    }
+    return d->p > start;
+}
+
+static void decode_number(decoder_t* d)
+{
+    // json grammar, Lua number syntax is wider, eg. hex, leading zeros or "+" sign
+    const char* start = d->p;
+    if (d->p < d->end && *d->p == '-') d->p++;
+    if (d->p < d->end && *d->p == '0') {
+        d->p++;
+    } else if (!skip_digits(d)) {
+        decode_error(d);
+    }
+    if (d->p < d->end && *d->p == '.') {
+        d->p++;
+        if (!skip_digits(d)) decode_error(d);
+    }
+    if (d->p < d->end && (*d->p == 'e' || *d->p == 'E')) {
+        d->p++;
+        if (d->p < d->end && (*d->p == '+' || *d->p == '-')) d->p++;
+        if (!skip_digits(d)) decode_error(d);
+    }
+
+    // integer stays integer, fraction or exponent is float, as in Lua source
+    size_t len = d->p - start;
+    if (len < MAX_NUMBER_LEN) {
+        char buf[MAX_NUMBER_LEN];
+        memcpy(buf, start, len);
+        buf[len] = '\0';
+        if (lua_stringtonumber(d->L, buf) != len + 1) decode_error(d);
     } else {
-        lua_pushnil(L);
+        // long number is terminated by Lua string
+        lua_pushlstring(d->L, start, len);
+        if (lua_stringtonumber(d->L, lua_tostring(d->L, -1)) != len + 1) decode_error(d);
+        lua_remove(d->L, -2);
     }
 }
 
-static cJSON* encode_child(lua_State* L)
+static void decode_value(decoder_t* d);
+
+static void decode_object(decoder_t* d)
+{
+    lua_newtable(d->L);
+
+    if (consume(d, '}')) return;
+
+    do {
+        if (!consume(d, '"')) decode_error(d);
+        decode_string(d);
+        if (!consume(d, ':')) decode_error(d);
+        decode_value(d);
+        lua_rawset(d->L, -3);
+    } while (consume(d, ','));
+
+    if (!consume(d, '}')) decode_error(d);
+}
+
+static void decode_array(decoder_t* d)
 {
-    cJSON* obj;
+    lua_newtable(d->L);
+
+    if (consume(d, ']')) return;
 
-    switch (lua_type(L, -1)) {
-    case LUA_TSTRING:
-        obj = cJSON_CreateString(lua_tostring(L, -1));
+    lua_Integer index = 1;
+    do {
+        decode_value(d);
+        if (lua_isnil(d->L, -1)) {
+            // json.null keeps array without holes
+            lua_pop(d->L, 1);
+            lua_pushlightuserdata(d->L, NULL);
+        }
+        lua_rawseti(d->L, -2, index++);
+    } while (consume(d, ','));
+
+    if (!consume(d, ']')) decode_error(d);
+}
+
+static void decode_value(decoder_t* d)
+{
+    if (++d->depth > MAX_DEPTH) {
+        luaL_error(d->L, "json nesting too deep");
+    }
+    luaL_checkstack(d->L, 3, "json nesting too deep");
+
+    skip_whitespace(d);
+    if (d->p >= d->end) decode_error(d);
+
+    switch (*d->p) {
+    case '{':
+        d->p++;
+        decode_object(d);
         break;
-    case LUA_TNUMBER:
-        obj = cJSON_CreateNumber(lua_tonumber(L, -1));
+    case '[':
+        d->p++;
+        decode_array(d);
         break;
-    case LUA_TBOOLEAN:
-        obj = cJSON_CreateBool(lua_toboolean(L, -1));
+    case '"':
+        d->p++;
+        decode_string(d);
         break;
-    case LUA_TTABLE:
-        int len = lua_rawlen(L, -1);
-        if (len > 0) {
-            // table as array
-            obj = cJSON_CreateArray();
-            for (int i = 1; i <= len; i++) {
-                lua_rawgeti(L, -1, i);
-                cJSON_AddItemToArray(obj, encode_child(L));
-                lua_pop(L, 1);
-            }
+    case 't':
+        if (!consume_literal(d, "true", 4)) decode_error(d);
+        lua_pushboolean(d->L, true);
+        break;
+    case 'f':
+        if (!consume_literal(d, "false", 5)) decode_error(d);
+        lua_pushboolean(d->L, false);
+        break;
+    case 'n':
+        if (!consume_literal(d, "null", 4)) decode_error(d);
+        lua_pushnil(d->L);
+        break;
+    default:
+        decode_number(d);
+        break;
+    }
+
+    d->depth--;
+}
+
+/**
+ * Output buffer is userdata in fixed stack slot, so values can be freely pushed and popped while encoding
+ */
+static void encode_grow(encoder_t* e, size_t len)
+{
+    size_t size = e->size;
+    while (size - e->len < len) {
+        if (size > SIZE_MAX / 2) luaL_error(e->L, "json too large");
+        size *= 2;
+    }
+
+    char* buf = lua_newuserdatauv(e->L, size, 0);
+    memcpy(buf, e->buf, e->len);
+    lua_replace(e->L, e->buf_idx);
+
+    e->buf = buf;
+    e->size = size;
+}
+
+static void encode_addlstring(encoder_t* e, const char* str, size_t len)
+{
+    if (e->size - e->len < len) encode_grow(e, len);
+    memcpy(e->buf + e->len, str, len);
+    e->len += len;
+}
+
+static inline void encode_addchar(encoder_t* e, char c)
+{
+    if (e->len == e->size) encode_grow(e, 1);
+    e->buf[e->len++] = c;
+}
+
+static void encode_string(encoder_t* e, const char* str, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    encode_addchar(e, '"');
+
+    const char* end = str + len;
+    const char* span = str;
+    for (const char* p = str; p < end; p++) {
+        unsigned char c = *p;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        // add run of characters without escaping at once
+        encode_addlstring(e, span, p - span);
+        span = p + 1;
+
+        encode_addchar(e, '\\');
+        switch (c) {
+        case '"':
+        case '\\':
+            encode_addchar(e, c);
+            break;
+        case '\b':
+            encode_addchar(e, 'b');
+            break;
+        case '\f':
+            encode_addchar(e, 'f');
+            break;
+        case '\n':
+            encode_addchar(e, 'n');
+            break;
+        case '\r':
+            encode_addchar(e, 'r');
+            break;
+        case '\t':
+            encode_addchar(e, 't');
+            break;
+        default:
+            encode_addlstring(e, "u00", 3);
+            encode_addchar(e, hex[c >> 4]);
+            encode_addchar(e, hex[c & 0xF]);
+            break;
+        }
+    }
+    encode_addlstring(e, span, end - span);
+
+    encode_addchar(e, '"');
+}
+
+static void encode_number(encoder_t* e, int idx)
+{
+    char buf[MAX_NUMBER_LEN];
+    int len;
+
+    if (lua_isinteger(e->L, idx)) {
+        len = snprintf(buf, sizeof(buf), LUA_INTEGER_FMT, (LUAI_UACINT)lua_tointeger(e->L, idx));
+    } else {
+        lua_Number n = lua_tonumber(e->L, idx);
+        if (isnan(n) || isinf(n)) {
+            // not representable in json
+            len = snprintf(buf, sizeof(buf), "null");
         } else {
-            // table as object
-            obj = cJSON_CreateObject();
-            lua_pushnil(L);
-            while (lua_next(L, -2)) {
-                cJSON_AddItemToObject(obj, lua_tostring(L, -2), encode_child(L));
-                lua_pop(L, 1);
+            // Lua format, or digits which read back exactly when it loses precision
+            // integral float is written without fraction, so it decodes back as integer
+            len = snprintf(buf, sizeof(buf), LUA_NUMBER_FMT, (LUAI_UACNUMBER)n);
+            if (lua_str2number(buf, NULL) != n) {
+                len = snprintf(buf, sizeof(buf), "%.*" LUA_NUMBER_FRMLEN "g", l_floatatt(DECIMAL_DIG), (LUAI_UACNUMBER)n);
             }
         }
-        break;
-    default:
-        obj = cJSON_CreateNull();
     }
 
-    return obj;
+    encode_addlstring(e, buf, len);
 }
 
-static int l_decode(lua_State* L)
+static void encode_newline(encoder_t* e)
 {
-    const char* str = luaL_checkstring(L, 1);
+    if (e->format) {
+        encode_addchar(e, '\n');
+        for (int i = 0; i < e->depth; i++) {
+            encode_addchar(e, '\t');
+        }
+    }
+}
 
-    cJSON* root = cJSON_Parse(str);
+/**
+ * Table is array when all keys are integers 1..n, empty table is object
+ */
+static lua_Integer array_length(lua_State* L, int idx)
+{
+    lua_Integer len = lua_rawlen(L, idx);
+    if (len == 0) return 0;
 
-    if (root == NULL) {
-        luaL_error(L, "failed to decode json");
+    lua_Integer count = 0;
+    lua_pushnil(L);
+    while (lua_next(L, idx)) {
+        lua_pop(L, 1);
+        if (!lua_isinteger(L, -1) || lua_tointeger(L, -1) < 1 || lua_tointeger(L, -1) > len) {
+            lua_pop(L, 1);
+            return 0;
+        }
+        count++;
     }
 
-    decode_child(L, root);
+    return count == len ? len : 0;
+}
+
+static void encode_value(encoder_t* e, int idx);
 
-    cJSON_Delete(root);
+static void encode_table(encoder_t* e, int idx)
+{
+    lua_State* L = e->L;
+
+    if (++e->depth > MAX_DEPTH) {
+        luaL_error(L, "json nesting too deep, or table has cycle");
+    }
+    luaL_checkstack(L, 3, "json nesting too deep");
+
+    lua_Integer len = array_length(L, idx);
+    if (len > 0) {
+        encode_addchar(e, '[');
+        for (lua_Integer i = 1; i <= len; i++) {
+            if (i > 1) encode_addchar(e, ',');
+            encode_newline(e);
+
+            lua_rawgeti(L, idx, i);
+            encode_value(e, lua_gettop(L));
+            lua_pop(L, 1);
+        }
+        e->depth--;
+        encode_newline(e);
+        encode_addchar(e, ']');
+        return;
+    }
+
+    encode_addchar(e, '{');
+
+    bool first = true;
+    lua_pushnil(L);
+    while (lua_next(L, idx)) {
+        if (!first) encode_addchar(e, ',');
+        first = false;
+        encode_newline(e);
+
+        switch (lua_type(L, -2)) {
+        case LUA_TSTRING: {
+            size_t key_len;
+            const char* key = lua_tolstring(L, -2, &key_len);
+            encode_string(e, key, key_len);
+            break;
+        }
+        case LUA_TNUMBER:
+            // number key as string, key is not converted in place to keep lua_next working
+            encode_addchar(e, '"');
+            encode_number(e, lua_gettop(L) - 1);
+            encode_addchar(e, '"');
+            break;
+        default:
+            luaL_error(L, "table key must be a number or string");
+        }
+        encode_addchar(e, ':');
+        if (e->format) encode_addchar(e, ' ');
+
+        encode_value(e, lua_gettop(L));
+        lua_pop(L, 1);
+    }
+
+    e->depth--;
+    if (!first) encode_newline(e);
+    encode_addchar(e, '}');
+}
+
+static void encode_value(encoder_t* e, int idx)
+{
+    switch (lua_type(e->L, idx)) {
+    case LUA_TSTRING: {
+        size_t len;
+        const char* str = lua_tolstring(e->L, idx, &len);
+        encode_string(e, str, len);
+        break;
+    }
+    case LUA_TNUMBER:
+        encode_number(e, idx);
+        break;
+    case LUA_TBOOLEAN:
+        if (lua_toboolean(e->L, idx)) {
+            encode_addlstring(e, "true", 4);
+        } else {
+            encode_addlstring(e, "false", 5);
+        }
+        break;
+    case LUA_TTABLE:
+        encode_table(e, idx);
+        break;
+    default:
+        encode_addlstring(e, "null", 4);
+    }
+}
+
+static int l_decode(lua_State* L)
+{
+    size_t len;
+    const char* str = l_bytes_todata(L, 1, &len);
+    luaL_argexpected(L, str, 1, "string or bytes");
+
+    decoder_t d = {
+        .L = L,
+        .p = str,
+        .end = str + len,
+        .depth = 0,
+    };
+    decode_value(&d);
+
+    skip_whitespace(&d);
+    if (d.p != d.end) decode_error(&d);
 
     return 1;
 }
@@ -107,36 +572,34 @@ static int l_encode(lua_State* L)
         luaL_checktype(L, 2, LUA_TBOOLEAN);
         format = lua_toboolean(L, 2);
     }
+    lua_settop(L, 1);
 
-    lua_pushvalue(L, 1);
-    cJSON* root = encode_child(L);
-    lua_pop(L, 1);
+    encoder_t e = {
+        .L = L,
+        .buf = lua_newuserdatauv(L, BUFFER_SIZE, 0),
+        .len = 0,
+        .size = BUFFER_SIZE,
+        .buf_idx = 2,
+        .format = format,
+        .depth = 0,
+    };
+    encode_value(&e, 1);
 
-    char* json;
-    if (format) {
-        json = cJSON_Print(root);
-    } else {
-        json = cJSON_PrintUnformatted(root);
-    }
-
-    cJSON_Delete(root);
-
-    lua_pushstring(L, json);
-
-    free((void*)json);
+    lua_pushlstring(L, e.buf, e.len);
 
     return 1;
 }
 
-static const luaL_Reg lib[] = {
-    { "decode", l_decode },
-    { "encode", l_encode },
-    { NULL, NULL },
+static const l_rotable_entry_t lib[] = {
+    L_ROTABLE_FUNCTION("decode", l_decode),
+    L_ROTABLE_FUNCTION("encode", l_encode),
+    L_ROTABLE_LIGHTUSERDATA("null", NULL),
+    L_ROTABLE_END,
 };
 
 int luaopen_json(lua_State* L)
 {
-    luaL_newlib(L, lib);
+    l_rotable_push(L, lib);
 
     return 1;
-}
\ No newline at end of file
+}
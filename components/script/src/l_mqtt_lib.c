@@ -1,11 +1,20 @@
 #include "l_mqtt_lib.h"
 
 #include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <string.h>
 
+#include "l_bytes_lib.h"
+#include "l_rotable.h"
 #include "lauxlib.h"
 #include "lua.h"
 #include "mqtt_client.h"
 #include "script_utils.h"
+#include "topic_trie.h"
+
+#define QUEUE_LENGTH  16
+#define MAX_TOPIC_LEN 128
 
 static const char* TAG = "l_mqtt";
 
@@ -16,70 +25,47 @@ typedef enum {
     CLIENT_STATUS_DISCONNECTED
 } client_status_t;
 
+typedef struct {
+    uint16_t topic_len;
+    uint16_t data_len;
+    char buf[];  // topic followed by data
+} message_t;
+
 typedef struct {
     esp_mqtt_client_handle_t client;
     client_status_t client_status : 8;
-    lua_State* L;
-    int handler_table_ref;
+    topic_trie_t* handlers;
+    QueueHandle_t queue;
+    volatile uint32_t dropped;
 } client_userdata_t;
 
-static bool topic_match_pattern(const char* topic, const char* pattern)
-{
-    const char* pattern_ptr = pattern;
-    const char* topic_ptr = topic;
-
-    while (*pattern_ptr && *topic_ptr) {
-        if (*pattern_ptr == '+') {
-            pattern_ptr++;
-            while (*topic_ptr && *topic_ptr != '/') {
-                topic_ptr++;
-            }
-            if (*pattern_ptr == '/') pattern_ptr++;
-            if (*topic_ptr == '/') topic_ptr++;
-            continue;
-        }
-        if (*pattern_ptr == '#') {
-            return true;
-        }
-        if (*pattern_ptr != *topic_ptr) {
-            return false;
-        }
-        pattern_ptr++;
-        topic_ptr++;
-    }
-
-    return (*pattern_ptr == *topic_ptr) || (*pattern_ptr == '#');
-}
+// weak keyed table of clients, which can have queued messages
+static char clients_key;
 
 static void handle_event_data(client_userdata_t* userdata, esp_mqtt_event_handle_t event)
 {
-    char topic[128];
-    size_t topic_len = event->topic_len < sizeof(topic) - 1 ? event->topic_len : sizeof(topic) - 1;
-    memcpy(topic, event->topic, topic_len);
-    topic[topic_len] = '\0';
-
-    lua_State* L = userdata->L;
-
-    lua_rawgeti(L, LUA_REGISTRYINDEX, userdata->handler_table_ref);
-
-    lua_pushnil(L);
-    while (lua_next(L, -2)) {
-        const char* pattern = lua_tostring(L, -2);
-
-        if (topic_match_pattern(topic, pattern)) {
-            lua_pushlstring(L, event->topic, event->topic_len);
-            lua_pushlstring(L, event->data, event->data_len);
-            if (lua_pcall(L, 2, 0, 0) != LUA_OK) {
-                const char* err = lua_tostring(L, -1);
-                lua_writestring(err, strlen(err));
-                lua_writeline();
-            }
-        } else {
-            lua_pop(L, 1);
+    // copy message, dispatched to handlers by script task
+    size_t topic_len = event->topic_len;
+    size_t data_len = event->data_len;
+    if (topic_len > MAX_TOPIC_LEN) topic_len = MAX_TOPIC_LEN;
+    if (data_len > UINT16_MAX) data_len = UINT16_MAX;
+
+    message_t* message = (message_t*)malloc(sizeof(message_t) + topic_len + data_len);
+    if (message) {
+        message->topic_len = topic_len;
+        message->data_len = data_len;
+        memcpy(message->buf, event->topic, topic_len);
+        memcpy(message->buf + topic_len, event->data, data_len);
+
+        if (xQueueSend(userdata->queue, &message, 0) != pdTRUE) {
+            free((void*)message);
+            message = NULL;
         }
     }
 
-    lua_pop(L, 1);
+    if (!message) {
+        userdata->dropped++;
+    }
 }
 
 static void event_handler(void* handler_args, esp_event_base_t base, int32_t event_id, void* event_data)
@@ -90,21 +76,87 @@ static void event_handler(void* handler_args, esp_event_base_t base, int32_t eve
     switch (event_id) {
     case MQTT_EVENT_CONNECTED:
         userdata->client_status = CLIENT_STATUS_CONNECTED;
+        script_event_post(SCRIPT_EVENT_MQTT);
         break;
     case MQTT_EVENT_DISCONNECTED:
         // TODO handle also MQTT_EVENT_ERROR ?
         userdata->client_status = CLIENT_STATUS_DISCONNECTED;
+        script_event_post(SCRIPT_EVENT_MQTT);
         break;
     case MQTT_EVENT_DATA:
-        xSemaphoreTake(script_mutex, portMAX_DELAY);
         handle_event_data(userdata, event);
-        xSemaphoreGive(script_mutex);
+        script_event_post(SCRIPT_EVENT_MQTT);
         break;
     default:
         break;
     }
 }
 
+static void push_handler(int ref, void* ctx)
+{
+    lua_State* L = (lua_State*)ctx;
+
+    if (lua_checkstack(L, 1)) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+    }
+}
+
+static void dispatch_message(lua_State* L, client_userdata_t* userdata, message_t* message)
+{
+    // collect handlers first, handler can unsubscribe
+    int top = lua_gettop(L);
+    topic_trie_match(userdata->handlers, message->buf, message->topic_len, push_handler, L);
+
+    int handlers_top = lua_gettop(L);
+    for (int i = top + 1; i <= handlers_top; i++) {
+        lua_pushvalue(L, i);
+        lua_pushlstring(L, message->buf, message->topic_len);
+        lua_pushlstring(L, message->buf + message->topic_len, message->data_len);
+        if (lua_pcall(L, 2, 0, 0) != LUA_OK) {
+            const char* err = lua_tostring(L, -1);
+            lua_writestring(err, strlen(err));
+            lua_writeline();
+            lua_pop(L, 1);
+        }
+    }
+
+    lua_settop(L, top);
+}
+
+void l_mqtt_process(lua_State* L)
+{
+    if (lua_rawgetp(L, LUA_REGISTRYINDEX, &clients_key) != LUA_TTABLE) {
+        lua_pop(L, 1);
+        return;
+    }
+
+    // keep clients on stack, handler can release them
+    int top = lua_gettop(L);
+    lua_pushnil(L);
+    while (lua_next(L, top)) {
+        lua_pop(L, 1);
+        luaL_checkstack(L, 2, NULL);
+        lua_pushvalue(L, -1);
+        lua_insert(L, top + 1);
+    }
+
+    int clients_top = lua_gettop(L);
+    for (int i = top + 1; i <= clients_top; i++) {
+        client_userdata_t* userdata = (client_userdata_t*)lua_touserdata(L, i);
+        if (userdata->queue == NULL) continue;  // finalized client
+
+        // only messages received until now, next are posted with next event
+        UBaseType_t count = uxQueueMessagesWaiting(userdata->queue);
+        message_t* message;
+        while (count-- > 0 && userdata->queue && xQueueReceive(userdata->queue, &message, 0) == pdTRUE) {
+            if (userdata->handlers) dispatch_message(L, userdata, message);
+            free((void*)message);
+        }
+    }
+
+    lua_settop(L, top - 1);
+}
+
 static int l_client(lua_State* L)
 {
     esp_mqtt_client_config_t cfg = { 0 };
@@ -116,20 +168,28 @@ static int l_client(lua_State* L)
         cfg.credentials.authentication.password = luaL_checkstring(L, 3);
     }
 
-    esp_mqtt_client_handle_t client = esp_mqtt_client_init(&cfg);
-    if (client == NULL) {
+    client_userdata_t* userdata = (client_userdata_t*)lua_newuserdatauv(L, sizeof(client_userdata_t), 0);
+    memset(userdata, 0, sizeof(client_userdata_t));
+    luaL_setmetatable(L, "mqtt.client");
+
+    userdata->client_status = CLIENT_STATUS_INIT;
+    userdata->handlers = topic_trie_create();
+    userdata->queue = xQueueCreate(QUEUE_LENGTH, sizeof(message_t*));
+    if (userdata->handlers == NULL || userdata->queue == NULL) {
+        luaL_error(L, "not enough memory");
+    }
+
+    userdata->client = esp_mqtt_client_init(&cfg);
+    if (userdata->client == NULL) {
         luaL_error(L, "invalid params");
-    } else {
-        client_userdata_t* userdata = (client_userdata_t*)lua_newuserdatauv(L, sizeof(client_userdata_t), 0);
-        luaL_setmetatable(L, "mqtt.client");
-
-        userdata->L = L;
-        userdata->client = client;
-        userdata->client_status = CLIENT_STATUS_INIT;
-        lua_newtable(L);
-        userdata->handler_table_ref = luaL_ref(L, LUA_REGISTRYINDEX);
     }
 
+    lua_rawgetp(L, LUA_REGISTRYINDEX, &clients_key);
+    lua_pushvalue(L, -2);
+    lua_pushboolean(L, true);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+
     return 1;
 }
 
@@ -188,12 +248,14 @@ static int l_client_subscribe(lua_State* L)
         luaL_error(L, "failed to subscribe");
     }
 
-    lua_rawgeti(L, LUA_REGISTRYINDEX, userdata->handler_table_ref);
-
     lua_pushvalue(L, 3);
-    lua_setfield(L, -2, topic);
-
-    lua_pop(L, 1);
+    int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    int prev_ref;
+    if (!topic_trie_insert(userdata->handlers, topic, ref, &prev_ref)) {
+        luaL_unref(L, LUA_REGISTRYINDEX, ref);
+        luaL_error(L, "not enough memory");
+    }
+    luaL_unref(L, LUA_REGISTRYINDEX, prev_ref);
 
     return 0;
 }
@@ -207,12 +269,7 @@ static int l_client_unsubscribe(lua_State* L)
         ESP_LOGW(TAG, "Failed to unsubscribe");
     }
 
-    lua_rawgeti(L, LUA_REGISTRYINDEX, userdata->handler_table_ref);
-
-    lua_pushnil(L);
-    lua_setfield(L, -2, topic);
-
-    lua_pop(L, 1);
+    luaL_unref(L, LUA_REGISTRYINDEX, topic_trie_remove(userdata->handlers, topic));
 
     return 0;
 }
@@ -223,7 +280,9 @@ static int l_client_publish(lua_State* L)
 
     if (userdata->client_status == CLIENT_STATUS_CONNECTED) {
         const char* topic = luaL_checkstring(L, 2);
-        const char* data = luaL_checkstring(L, 3);
+        size_t len;
+        const char* data = l_bytes_todata(L, 3, &len);
+        luaL_argexpected(L, data, 3, "string or bytes");
         int qos = 1;
         if (!lua_isnoneornil(L, 4)) {
             qos = luaL_checkinteger(L, 4);
@@ -233,12 +292,26 @@ static int l_client_publish(lua_State* L)
             retry = luaL_checkinteger(L, 5);
         }
 
-        esp_mqtt_client_publish(userdata->client, topic, data, 0, qos, retry);
+        esp_mqtt_client_publish(userdata->client, topic, data, len, qos, retry);
     }
 
     return 0;
 }
 
+static int l_client_dropped(lua_State* L)
+{
+    client_userdata_t* userdata = (client_userdata_t*)luaL_checkudata(L, 1, "mqtt.client");
+
+    lua_pushinteger(L, userdata->dropped);
+
+    return 1;
+}
+
+static void unref_handler(int ref, void* ctx)
+{
+    luaL_unref((lua_State*)ctx, LUA_REGISTRYINDEX, ref);
+}
+
 static int l_client_gc(lua_State* L)
 {
     client_userdata_t* userdata = (client_userdata_t*)luaL_checkudata(L, 1, "mqtt.client");
@@ -248,20 +321,32 @@ static int l_client_gc(lua_State* L)
         userdata->client = NULL;
     }
 
-    luaL_unref(L, LUA_REGISTRYINDEX, userdata->handler_table_ref);
-    userdata->handler_table_ref = LUA_NOREF;
+    if (userdata->queue != NULL) {
+        message_t* message;
+        while (xQueueReceive(userdata->queue, &message, 0) == pdTRUE) {
+            free((void*)message);
+        }
+        vQueueDelete(userdata->queue);
+        userdata->queue = NULL;
+    }
+
+    if (userdata->handlers != NULL) {
+        topic_trie_delete(userdata->handlers, unref_handler, L);
+        userdata->handlers = NULL;
+    }
 
     return 0;
 }
 
-static const luaL_Reg lib[] = {
-    { "client", l_client },
-    { NULL, NULL },
+static const l_rotable_entry_t lib[] = {
+    L_ROTABLE_FUNCTION("client", l_client),
+    L_ROTABLE_END,
 };
 
 static const luaL_Reg client_fields[] = {
     { "connect", l_client_connect },         { "disconnect", l_client_disconnect }, { "subscribe", l_client_subscribe },
-    { "unsubscribe", l_client_unsubscribe }, { "publish", l_client_publish },       { NULL, NULL },
+    { "unsubscribe", l_client_unsubscribe }, { "publish", l_client_publish },       { "dropped", l_client_dropped },
+    { NULL, NULL },
 };
 
 static const luaL_Reg client_metadata[] = {
@@ -272,7 +357,7 @@ static const luaL_Reg client_metadata[] = {
 
 int luaopen_mqtt(lua_State* L)
 {
-    luaL_newlib(L, lib);
+    l_rotable_push(L, lib);
 
     luaL_newmetatable(L, "mqtt.client");
     luaL_setfuncs(L, client_metadata, 0);
@@ -281,5 +366,12 @@ int luaopen_mqtt(lua_State* L)
     lua_setfield(L, -2, "__index");
     lua_pop(L, 1);
 
+    lua_newtable(L);
+    lua_newtable(L);
+    lua_pushstring(L, "k");
+    lua_setfield(L, -2, "__mode");
+    lua_setmetatable(L, -2);
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &clients_key);
+
     return 1;
 }
\ No newline at end of file
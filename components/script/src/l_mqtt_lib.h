@@ -5,4 +5,11 @@
 
 int luaopen_mqtt(lua_State* L);
 
+/**
+ * @brief Dispatch received messages to subscribed handlers, must be called from script task
+ *
+ * @param L
+ */
+void l_mqtt_process(lua_State* L);
+
 #endif /* L_MQTT_LIB_H_ */
@@ -0,0 +1,136 @@
+#include "l_rotable.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lauxlib.h"
+
+#define CACHE_SIZE 8
+
+typedef struct {
+    const char* key;
+    const l_rotable_entry_t* entry;
+} cache_entry_t;
+
+/**
+ * Upvalue of read only table metamethods
+ */
+typedef struct {
+    const l_rotable_entry_t* entries;
+    // key strings are interned by Lua, so pointer of same short key is usually the same between accesses
+    cache_entry_t cache[CACHE_SIZE];
+} rotable_t;
+
+static const l_rotable_entry_t* lookup(rotable_t* rotable, const char* key)
+{
+    cache_entry_t* cached = &rotable->cache[((uintptr_t)key >> 3) % CACHE_SIZE];
+    // entry name comparison guards against reused string address
+    if (cached->key == key && strcmp(cached->entry->name, key) == 0) {
+        return cached->entry;
+    }
+
+    for (const l_rotable_entry_t* entry = rotable->entries; entry->name; entry++) {
+        if (entry->name[0] == key[0] && strcmp(entry->name, key) == 0) {
+            cached->key = key;
+            cached->entry = entry;
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static void push_value(lua_State* L, const l_rotable_entry_t* entry)
+{
+    switch (entry->type) {
+    case L_ROTABLE_FUNCTION:
+        lua_pushcfunction(L, entry->value.function);
+        break;
+    case L_ROTABLE_INTEGER:
+        lua_pushinteger(L, entry->value.integer);
+        break;
+    case L_ROTABLE_LIGHTUSERDATA:
+        lua_pushlightuserdata(L, entry->value.lightuserdata);
+        break;
+    }
+}
+
+static int l_index(lua_State* L)
+{
+    rotable_t* rotable = (rotable_t*)lua_touserdata(L, lua_upvalueindex(1));
+
+    const l_rotable_entry_t* entry = NULL;
+    if (lua_type(L, 2) == LUA_TSTRING) {
+        entry = lookup(rotable, lua_tostring(L, 2));
+    }
+
+    if (entry) {
+        push_value(L, entry);
+    } else {
+        lua_pushnil(L);
+    }
+
+    return 1;
+}
+
+static int l_newindex(lua_State* L)
+{
+    return luaL_error(L, "attempt to modify read-only table");
+}
+
+static int l_next(lua_State* L)
+{
+    rotable_t* rotable = (rotable_t*)lua_touserdata(L, lua_upvalueindex(1));
+
+    const l_rotable_entry_t* entry = rotable->entries;
+    if (!lua_isnil(L, 2)) {
+        entry = lua_type(L, 2) == LUA_TSTRING ? lookup(rotable, lua_tostring(L, 2)) : NULL;
+        if (!entry) {
+            return luaL_error(L, "invalid key to 'next'");
+        }
+        entry++;
+    }
+
+    if (entry->name) {
+        lua_pushstring(L, entry->name);
+        push_value(L, entry);
+        return 2;
+    } else {
+        lua_pushnil(L);
+        return 1;
+    }
+}
+
+static int l_pairs(lua_State* L)
+{
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_pushcclosure(L, l_next, 1);
+    lua_pushvalue(L, 1);
+    lua_pushnil(L);
+
+    return 3;
+}
+
+static const luaL_Reg metadata[] = {
+    { "__index", l_index },
+    { "__newindex", l_newindex },
+    { "__pairs", l_pairs },
+    { NULL, NULL },
+};
+
+void l_rotable_push(lua_State* L, const l_rotable_entry_t* entries)
+{
+    // empty table with own metatable, type() of library stays table
+    lua_createtable(L, 0, 0);
+    luaL_newlibtable(L, metadata);
+
+    rotable_t* rotable = (rotable_t*)lua_newuserdatauv(L, sizeof(rotable_t), 0);
+    memset(rotable, 0, sizeof(rotable_t));
+    rotable->entries = entries;
+    luaL_setfuncs(L, metadata, 1);
+
+    lua_pushboolean(L, 0);
+    lua_setfield(L, -2, "__metatable");
+
+    lua_setmetatable(L, -2);
+}
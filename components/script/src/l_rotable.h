@@ -0,0 +1,41 @@
+#ifndef L_ROTABLE_H_
+#define L_ROTABLE_H_
+
+#include "lua.h"
+
+typedef enum {
+    L_ROTABLE_FUNCTION,
+    L_ROTABLE_INTEGER,
+    L_ROTABLE_LIGHTUSERDATA,
+} l_rotable_type_t;
+
+/**
+ * @brief Read only table entry, arrays of entries are terminated by L_ROTABLE_END
+ *
+ */
+typedef struct {
+    const char* name;
+    l_rotable_type_t type;
+    union {
+        lua_CFunction function;
+        lua_Integer integer;
+        void* lightuserdata;
+    } value;
+} l_rotable_entry_t;
+
+#define L_ROTABLE_FUNCTION(n, f)      { .name = (n), .type = L_ROTABLE_FUNCTION, .value.function = (f) }
+#define L_ROTABLE_INTEGER(n, i)       { .name = (n), .type = L_ROTABLE_INTEGER, .value.integer = (i) }
+#define L_ROTABLE_LIGHTUSERDATA(n, p) { .name = (n), .type = L_ROTABLE_LIGHTUSERDATA, .value.lightuserdata = (p) }
+#define L_ROTABLE_END                 { .name = NULL }
+
+/**
+ * @brief Push read only table backed by constant entries, fields are looked up on access, no Lua heap is used for entries
+ *
+ * Table is empty, its own metatable with __index, __newindex and __pairs looks up entries, with small per table cache of looked up keys
+ *
+ * @param L
+ * @param entries Constant entries, must outlive Lua state
+ */
+void l_rotable_push(lua_State* L, const l_rotable_entry_t* entries);
+
+#endif /* L_ROTABLE_H_ */
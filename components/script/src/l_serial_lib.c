@@ -1,18 +1,58 @@
 #include "l_serial_lib.h"
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "l_bytes_lib.h"
+#include "l_rotable.h"
 #include "lauxlib.h"
 #include "lua.h"
+#include "script_utils.h"
 #include "serial_script.h"
 
-#define BUF_SIZE 256
+#define BUF_SIZE        256
+#define RX_WAIT_TIMEOUT 1000
+
+static volatile bool is_opened;
+
+// incremented on each open and close, task of previous port ends when differs
+static volatile uint32_t rx_generation = 0;
+
+static TaskHandle_t rx_task = NULL;
+
+static void rx_task_func(void* param)
+{
+    uint32_t generation = (uintptr_t)param;
+
+    while (generation == rx_generation) {
+        // armed by open and after each read, post single event per received data
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (generation == rx_generation) {
+            if (serial_script_wait_read(RX_WAIT_TIMEOUT)) {
+                if (generation == rx_generation) {
+                    script_event_post(SCRIPT_EVENT_SERIAL);
+                }
+                break;
+            }
+        }
+    }
 
-static bool is_opened;
+    vTaskDelete(NULL);
+}
 
 static int l_open(lua_State* L)
 {
     if (!serial_script_is_available() || is_opened) {
         lua_pushnil(L);
     } else {
+        rx_generation++;
+        if (xTaskCreate(rx_task_func, "script_rx", 2 * 1024, (void*)(uintptr_t)rx_generation, 5, &rx_task) != pdPASS) {
+            rx_task = NULL;
+            return luaL_error(L, "failed to create rx task");
+        }
+        xTaskNotifyGive(rx_task);
+
         is_opened = true;
         lua_newtable(L);
         luaL_setmetatable(L, "serial.port");
@@ -36,6 +76,29 @@ static int l_port_read(lua_State* L)
         lua_pushlstring(L, buf, len);
     }
 
+    xTaskNotifyGive(rx_task);
+
+    return 1;
+}
+
+static int l_port_read_into(lua_State* L)
+{
+    size_t size;
+    uint8_t* buf = l_bytes_check(L, 2, &size);
+    lua_Integer pos = luaL_optinteger(L, 3, 1);
+    luaL_argcheck(L, pos >= 1 && pos <= size + 1, 3, "out of range");
+    size_t len = luaL_optinteger(L, 4, size - pos + 1);
+    luaL_argcheck(L, pos - 1 + len <= size, 4, "out of range");
+
+    // directly into bytes memory, no intermediate string
+    if (serial_script_read((char*)buf + pos - 1, &len) != ESP_OK) {
+        luaL_error(L, "serial error");
+    }
+
+    lua_pushinteger(L, len);
+
+    xTaskNotifyGive(rx_task);
+
     return 1;
 }
 
@@ -49,10 +112,8 @@ static int l_port_write(lua_State* L)
         buf_num = lua_tonumber(L, 2);
         len = 1;
         buf = &buf_num;
-    } else if (lua_isstring(L, 2)) {
-        buf = lua_tolstring(L, 2, &len);
-    } else {
-        luaL_argerror(L, 2, "argument must be number or string");
+    } else if ((buf = l_bytes_todata(L, 2, &len)) == NULL) {
+        luaL_argerror(L, 2, "argument must be number, string or bytes");
         return 0;
     }
 
@@ -76,17 +137,25 @@ static int l_port_gc(lua_State* L)
 {
     is_opened = false;
 
+    // task ends after wait in progress
+    rx_generation++;
+    if (rx_task) {
+        xTaskNotifyGive(rx_task);
+        rx_task = NULL;
+    }
+
     return 0;
 }
 
-static const luaL_Reg lib[] = {
-    { "open", l_open },
-    { NULL, NULL },
+static const l_rotable_entry_t lib[] = {
+    L_ROTABLE_FUNCTION("open", l_open),
+    L_ROTABLE_END,
 };
 
 static const luaL_Reg port_fields[] = {
     { "write", l_port_write },
     { "read", l_port_read },
+    { "readinto", l_port_read_into },
     { "flush", l_port_flush },
     { NULL, NULL },
 };
@@ -101,7 +170,7 @@ int luaopen_serial(lua_State* L)
 {
     is_opened = false;
 
-    luaL_newlib(L, lib);
+    l_rotable_push(L, lib);
 
     luaL_newmetatable(L, "serial.port");
     luaL_setfuncs(L, port_metadata, 0);
@@ -1,16 +1,22 @@
 #include "script.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
+#include <inttypes.h>
 #include <nvs.h>
 #include <string.h>
+#include <sys/param.h>
 #include <sys/stat.h>
 
+#include "aux_io.h"
 #include "component_params.h"
+#include "evse.h"
 #include "l_aux_lib.h"
 #include "l_board_config_lib.h"
+#include "l_bytes_lib.h"
 #include "l_component.h"
 #include "l_energy_meter_lib.h"
 #include "l_evse_lib.h"
@@ -22,15 +28,24 @@
 #include "lualib.h"
 #include "output_buffer.h"
 #include "script.h"
+#include "script_alloc.h"
+#include "script_cache.h"
+#include "script_profiler.h"
 #include "script_utils.h"
 #include "script_watchdog.h"
 
 #define SHUTDOWN_TIMEOUT   1000
 #define OUTPUT_BUFFER_SIZE 4096
+#define MIN_SLEEP          1000  // us
+
+#define NOTIFY_TIMER    BIT0
+#define NOTIFY_SCHEDULE BIT1
 
 #define NVS_NAMESPACE   "script"
 #define NVS_ENABLED     "enabled"
 #define NVS_AUTO_RELOAD "auto_reload"
+#define NVS_MEM_LIMIT   "mem_limit"
+#define NVS_CPU_BUDGET  "cpu_budget"
 
 static const char* TAG = "script";
 
@@ -50,22 +65,62 @@ static SemaphoreHandle_t output_mutex;
 
 static bool auto_reload = false;
 
-static void script_task_func(void* param)
+static uint32_t memory_limit = 0;
+
+static esp_timer_handle_t wakeup_timer = NULL;
+
+static void notify(uint32_t bits)
 {
-    xSemaphoreTake(output_mutex, portMAX_DELAY);
-    output_buffer = output_buffer_create(OUTPUT_BUFFER_SIZE);
-    xSemaphoreGive(output_mutex);
+    TaskHandle_t task = script_task;
+    if (task) {
+        xTaskNotify(task, bits, eSetBits);
+    }
+}
 
-    lua_writestring(LUA_COPYRIGHT, strlen(LUA_COPYRIGHT));
-    lua_writeline();
+static void wakeup_timer_cb(void* arg)
+{
+    notify(NOTIFY_TIMER);
+}
+
+static uint32_t sleep_until(int64_t resume_after)
+{
+    // sleep until next component deadline with esp timer resolution, or until event
+    int64_t delay = resume_after - esp_timer_get_time();
+    if (delay < MIN_SLEEP) delay = MIN_SLEEP;
+
+    if (resume_after != INT64_MAX) {
+        esp_timer_start_once(wakeup_timer, delay);
+    }
+
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+    esp_timer_stop(wakeup_timer);
+
+    return bits;
+}
 
-    L = luaL_newstate();
+/**
+ * Callbacks registered by libraries on open, must be removed before Lua state close
+ */
+static void unregister_callbacks(void)
+{
+    evse_set_state_change_cb(NULL);
+    aux_set_input_change_cb(NULL);
+}
 
+/**
+ * Open standard and firmware libraries, called in protected mode, out of memory is raised as error
+ */
+static int open_libs(lua_State* L)
+{
     luaL_openlibs(L);
 
     luaL_requiref(L, "component", luaopen_component, 1);
     lua_pop(L, 1);
 
+    luaL_requiref(L, "bytes", luaopen_bytes, 1);
+    lua_pop(L, 1);
+
     luaL_requiref(L, "evse", luaopen_evse, 0);
     lua_pop(L, 1);
 
@@ -87,11 +142,45 @@ static void script_task_func(void* param)
     luaL_requiref(L, "serial", luaopen_serial, 0);
     lua_pop(L, 1);
 
+    return 0;
+}
+
+/**
+ * Create Lua state with opened libraries, memory limit applies only after libraries are opened
+ */
+static lua_State* create_state(void)
+{
+    lua_State* state = script_alloc_new_state(0);
+    if (!state) {
+        ESP_LOGE(TAG, "Failed to create Lua state");
+        return NULL;
+    }
+
+    lua_pushcfunction(state, open_libs);
+    if (lua_pcall(state, 0, 0, 0) != LUA_OK) {
+        ESP_LOGE(TAG, "Failed to open libraries: %s", lua_tostring(state, -1));
+        unregister_callbacks();
+        script_alloc_close(state);
+        return NULL;
+    }
+
+    script_alloc_set_limit(state, memory_limit);
+
+    return state;
+}
+
+/**
+ * Load init file and resume components until stop
+ */
+static void script_run(void)
+{
     lua_gc(L, LUA_GCSETPAUSE, 110);
     lua_gc(L, LUA_GCSETSTEPMUL, 200);
 
     script_watchdog_init(L);
 
+    script_cache_init(L);
+
     char* init_file = NULL;
     struct stat sb;
     // access() not works
@@ -109,25 +198,34 @@ static void script_task_func(void* param)
         lua_writestring(loading_msg_2, strlen(loading_msg_2));
         lua_writeline();
 
-        if (luaL_dofile(L, init_file) != LUA_OK) {
+        int64_t start = esp_timer_get_time();
+        if (script_cache_loadfile(L, init_file) != LUA_OK || lua_pcall(L, 0, LUA_MULTRET, 0) != LUA_OK) {
             const char* err = lua_tostring(L, -1);
             lua_writestring(err, strlen(err));
             lua_writeline();
             lua_pop(L, 1);
         }
+        ESP_LOGI(TAG, "Script loaded in %" PRId64 " ms", (esp_timer_get_time() - start) / 1000);
     } else {
         const char* not_init_msg = "failed to load file '/usr/lua/init.lua'";
         lua_writestring(not_init_msg, strlen(not_init_msg));
         lua_writeline();
     }
 
+    uint32_t bits = 0;
     while (true) {
         if (shutdown_sem != NULL) {
             break;
         }
         xSemaphoreTake(script_mutex, portMAX_DELAY);
         script_watchdog_reset();
-        l_component_resume(L);
+        if (bits & SCRIPT_EVENT_MQTT) {
+            l_mqtt_process(L);
+        }
+        if (bits & SCRIPT_EVENT_ALL) {
+            l_component_notify_event(L, bits & SCRIPT_EVENT_ALL);
+        }
+        int64_t resume_after = l_component_resume(L);
         xSemaphoreGive(script_mutex);
 
         int top = lua_gettop(L);
@@ -135,11 +233,34 @@ static void script_task_func(void* param)
             ESP_LOGW(TAG, "Top is %d, %d", top, lua_type(L, top));
         }
 
-        vTaskDelay(pdMS_TO_TICKS(50));
+        bits = sleep_until(resume_after);
+    }
+}
+
+static void script_task_func(void* param)
+{
+    xSemaphoreTake(output_mutex, portMAX_DELAY);
+    output_buffer = output_buffer_create(OUTPUT_BUFFER_SIZE);
+    xSemaphoreGive(output_mutex);
+
+    lua_writestring(LUA_COPYRIGHT, strlen(LUA_COPYRIGHT));
+    lua_writeline();
+
+    L = create_state();
+    if (L) {
+        script_run();
+    } else {
+        // wait for stop, state is created again on reload
+        while (shutdown_sem == NULL) {
+            sleep_until(INT64_MAX);
+        }
     }
 
-    lua_close(L);
-    L = NULL;
+    unregister_callbacks();
+    if (L) {
+        script_alloc_close(L);
+        L = NULL;
+    }
 
     xSemaphoreTake(output_mutex, portMAX_DELAY);
     output_buffer_delete(output_buffer);
@@ -165,12 +286,14 @@ static void script_stop(void)
     if (script_task) {
         ESP_LOGI(TAG, "Stopping script");
         shutdown_sem = xSemaphoreCreateBinary();
+        notify(NOTIFY_SCHEDULE);
 
         if (!xSemaphoreTake(shutdown_sem, pdMS_TO_TICKS(SHUTDOWN_TIMEOUT))) {
             ESP_LOGE(TAG, "Task stop timeout, will be force stoped");
             vTaskDelete(script_task);
+            unregister_callbacks();
             if (L != NULL) {
-                lua_close(L);
+                script_alloc_close(L);
                 L = NULL;
                 xSemaphoreGive(script_mutex);
             }
@@ -199,14 +322,49 @@ void script_init(void)
         auto_reload = u8;
     }
 
+    nvs_get_u32(nvs, NVS_MEM_LIMIT, &memory_limit);
+    if (memory_limit && memory_limit < SCRIPT_MEMORY_LIMIT_MIN) {
+        // stored by previous version without validation
+        memory_limit = SCRIPT_MEMORY_LIMIT_MIN;
+    }
+
+    uint32_t u32;
+    if (nvs_get_u32(nvs, NVS_CPU_BUDGET, &u32) == ESP_OK) {
+        script_watchdog_set_budget(MIN(u32, SCRIPT_CPU_BUDGET_MAX));
+    }
+
     output_mutex = xSemaphoreCreateMutex();
     script_mutex = xSemaphoreCreateMutex();
 
+    const esp_timer_create_args_t timer_args = {
+        .callback = wakeup_timer_cb,
+        .name = "script",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &wakeup_timer));
+
     if (script_is_enabled()) {
         script_start();
     }
 }
 
+void script_event_post(uint32_t events)
+{
+    notify(events);
+}
+
+void IRAM_ATTR script_event_post_from_isr(uint32_t events)
+{
+    TaskHandle_t task = script_task;
+    if (task) {
+        BaseType_t higher_task_woken = pdFALSE;
+        xTaskNotifyFromISR(task, events, eSetBits, &higher_task_woken);
+
+        if (higher_task_woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
 void script_output_append_buf(const char* str, uint16_t len)
 {
     xSemaphoreTake(output_mutex, portMAX_DELAY);
@@ -216,16 +374,16 @@ void script_output_append_buf(const char* str, uint16_t len)
     xSemaphoreGive(output_mutex);
 }
 
-uint16_t script_output_count(void)
+uint32_t script_output_count(void)
 {
     xSemaphoreTake(output_mutex, portMAX_DELAY);
-    uint16_t count = output_buffer ? output_buffer->count : 0;
+    uint32_t count = output_buffer ? output_buffer->next : 0;
     xSemaphoreGive(output_mutex);
 
     return count;
 }
 
-bool script_output_read(uint16_t* index, char** str, uint16_t* len)
+bool script_output_read(uint32_t* index, char** str, uint16_t* len)
 {
     xSemaphoreTake(output_mutex, portMAX_DELAY);
     bool has_next = output_buffer ? output_buffer_read(output_buffer, index, str, len) : false;
@@ -279,8 +437,102 @@ bool script_is_auto_reload(void)
     return auto_reload;
 }
 
+esp_err_t script_set_memory_limit(uint32_t limit)
+{
+    if (limit && limit < SCRIPT_MEMORY_LIMIT_MIN) {
+        ESP_LOGE(TAG, "Memory limit too small");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memory_limit = limit;
+
+    nvs_set_u32(nvs, NVS_MEM_LIMIT, memory_limit);
+    nvs_commit(nvs);
+
+    xSemaphoreTake(script_mutex, portMAX_DELAY);
+    if (L) {
+        script_alloc_set_limit(L, memory_limit);
+    }
+    xSemaphoreGive(script_mutex);
+
+    return ESP_OK;
+}
+
+uint32_t script_get_memory_limit(void)
+{
+    return memory_limit;
+}
+
+esp_err_t script_set_cpu_budget(uint32_t budget)
+{
+    if (budget > SCRIPT_CPU_BUDGET_MAX) {
+        ESP_LOGE(TAG, "CPU budget too large");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_set_u32(nvs, NVS_CPU_BUDGET, budget);
+    nvs_commit(nvs);
+
+    xSemaphoreTake(script_mutex, portMAX_DELAY);
+    script_watchdog_set_budget(budget);
+    xSemaphoreGive(script_mutex);
+
+    return ESP_OK;
+}
+
+uint32_t script_get_cpu_budget(void)
+{
+    return script_watchdog_get_budget();
+}
+
+esp_err_t script_get_memory_info(script_memory_info_t* info)
+{
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(script_mutex, portMAX_DELAY);
+    script_alloc_stats_t stats;
+    if (L && script_alloc_get_stats(L, &stats)) {
+        info->used = stats.used;
+        info->peak = stats.peak;
+        info->pool_size = stats.pool_size;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(script_mutex);
+
+    return ret;
+}
+
+esp_err_t script_set_profiler_enabled(bool enabled, uint32_t period)
+{
+    if (enabled) {
+        return script_profiler_start(period);
+    } else {
+        script_profiler_stop();
+        return ESP_OK;
+    }
+}
+
+bool script_is_profiler_enabled(void)
+{
+    return script_profiler_running;
+}
+
+void script_clear_profile(void)
+{
+    script_profiler_clear();
+}
+
+bool script_read_profile(uint16_t* index, char* buf, size_t size)
+{
+    return script_profiler_read(index, buf, size);
+}
+
 void script_file_changed(const char* path)
 {
+    if (path_has_suffix(path, ".lua")) {
+        script_cache_invalidate(path);
+    }
+
     if (auto_reload && (path_has_suffix(path, ".lua") || path_has_suffix(path, ".luac"))) {
         script_reload();
     }
@@ -393,6 +645,8 @@ void script_set_component_params(const char* id, script_component_param_list_t*
         l_component_restart(L, id);
     }
     xSemaphoreGive(script_mutex);
+
+    notify(NOTIFY_SCHEDULE);
 }
 
 void script_component_params_free(script_component_param_list_t* list)
@@ -410,4 +664,9 @@ void script_component_params_free(script_component_param_list_t* list)
     }
 
     free((void*)list);
+}
+
+esp_err_t script_export_component_params(script_component_params_export_cb_t cb, void* ctx)
+{
+    return component_params_export(cb, ctx);
 }
\ No newline at end of file
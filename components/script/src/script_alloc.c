@@ -0,0 +1,311 @@
+#include "script_alloc.h"
+
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include "lauxlib.h"
+
+#define POOL_CHUNK_SIZE 1024  // aligned to size, chunk of block found by masking block address
+#define POOL_GRANULE    8
+#define POOL_CLASSES    8  // blocks up to 64 bytes including header
+
+#ifdef CONFIG_SPIRAM
+#define ALLOC_CAPS (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define ALLOC_CAPS MALLOC_CAP_8BIT
+#endif
+
+typedef struct {
+    uint8_t owner;
+    uint8_t reserved[3];
+} block_header_t;
+
+typedef struct pool_block_s {
+    struct pool_block_s* next;
+} pool_block_t;
+
+typedef struct pool_chunk_s {
+    LIST_ENTRY(pool_chunk_s) entries;  // in list of chunks with free blocks
+    pool_block_t* free;
+    uint16_t used;
+    uint8_t class;
+} pool_chunk_t;
+
+#define POOL_CHUNK_HEADER_SIZE ((sizeof(pool_chunk_t) + POOL_GRANULE - 1) & ~(POOL_GRANULE - 1))
+
+typedef struct {
+    size_t limit;
+    size_t used;
+    size_t peak;
+    size_t pool_size;
+    uint8_t owner;
+    size_t owner_used[SCRIPT_ALLOC_OWNERS];
+    LIST_HEAD(pool_chunk_list_s, pool_chunk_s) chunks[POOL_CLASSES];
+} script_alloc_t;
+
+static inline block_header_t* block_header(void* ptr)
+{
+    return (block_header_t*)ptr - 1;
+}
+
+static inline bool is_pool_size(size_t size)
+{
+    return size + sizeof(block_header_t) <= POOL_GRANULE * POOL_CLASSES;
+}
+
+static inline uint8_t pool_class(size_t size)
+{
+    return (size + sizeof(block_header_t) - 1) / POOL_GRANULE;
+}
+
+static void* heap_alloc(size_t size)
+{
+#ifdef CONFIG_SPIRAM
+    return heap_caps_malloc_prefer(size, 2, ALLOC_CAPS, MALLOC_CAP_8BIT);
+#else
+    return malloc(size);
+#endif
+}
+
+static void* heap_realloc(void* ptr, size_t size)
+{
+#ifdef CONFIG_SPIRAM
+    return heap_caps_realloc_prefer(ptr, size, 2, ALLOC_CAPS, MALLOC_CAP_8BIT);
+#else
+    return realloc(ptr, size);
+#endif
+}
+
+static pool_chunk_t* pool_chunk_create(script_alloc_t* alloc, uint8_t class)
+{
+    pool_chunk_t* chunk = (pool_chunk_t*)heap_caps_aligned_alloc(POOL_CHUNK_SIZE, POOL_CHUNK_SIZE, ALLOC_CAPS);
+#ifdef CONFIG_SPIRAM
+    if (!chunk) chunk = (pool_chunk_t*)heap_caps_aligned_alloc(POOL_CHUNK_SIZE, POOL_CHUNK_SIZE, MALLOC_CAP_8BIT);
+#endif
+    if (!chunk) return NULL;
+
+    int block_size = (class + 1) * POOL_GRANULE;
+    chunk->free = NULL;
+    chunk->used = 0;
+    chunk->class = class;
+    for (int offset = POOL_CHUNK_SIZE - block_size; offset >= (int)POOL_CHUNK_HEADER_SIZE; offset -= block_size) {
+        pool_block_t* block = (pool_block_t*)((char*)chunk + offset);
+        block->next = chunk->free;
+        chunk->free = block;
+    }
+
+    LIST_INSERT_HEAD(&alloc->chunks[class], chunk, entries);
+    alloc->pool_size += POOL_CHUNK_SIZE;
+
+    return chunk;
+}
+
+static void* pool_alloc(script_alloc_t* alloc, size_t size)
+{
+    uint8_t class = pool_class(size);
+
+    pool_chunk_t* chunk = LIST_FIRST(&alloc->chunks[class]);
+    if (!chunk) {
+        chunk = pool_chunk_create(alloc, class);
+        if (!chunk) return NULL;
+    }
+
+    pool_block_t* block = chunk->free;
+    chunk->free = block->next;
+    chunk->used++;
+    if (!chunk->free) {
+        // full chunk is not in list
+        LIST_REMOVE(chunk, entries);
+    }
+
+    return block;
+}
+
+static void pool_free(script_alloc_t* alloc, void* block)
+{
+    pool_chunk_t* chunk = (pool_chunk_t*)((uintptr_t)block & ~(uintptr_t)(POOL_CHUNK_SIZE - 1));
+
+    if (!chunk->free) {
+        LIST_INSERT_HEAD(&alloc->chunks[chunk->class], chunk, entries);
+    }
+    ((pool_block_t*)block)->next = chunk->free;
+    chunk->free = (pool_block_t*)block;
+    chunk->used--;
+
+    // release empty chunk, when is not the only one with free blocks
+    if (chunk->used == 0 && (LIST_FIRST(&alloc->chunks[chunk->class]) != chunk || LIST_NEXT(chunk, entries) != NULL)) {
+        LIST_REMOVE(chunk, entries);
+        heap_caps_free(chunk);
+        alloc->pool_size -= POOL_CHUNK_SIZE;
+    }
+}
+
+static void* block_alloc(script_alloc_t* alloc, size_t size)
+{
+    block_header_t* header = is_pool_size(size) ? pool_alloc(alloc, size) : heap_alloc(size + sizeof(block_header_t));
+    return header ? header + 1 : NULL;
+}
+
+static void block_free(script_alloc_t* alloc, void* ptr, size_t size)
+{
+    if (is_pool_size(size)) {
+        pool_free(alloc, block_header(ptr));
+    } else {
+        free(block_header(ptr));
+    }
+}
+
+static void* block_realloc(script_alloc_t* alloc, void* ptr, size_t osize, size_t nsize)
+{
+    if (is_pool_size(osize) && is_pool_size(nsize) && pool_class(osize) == pool_class(nsize)) {
+        return ptr;
+    }
+
+    if (!is_pool_size(osize) && !is_pool_size(nsize)) {
+        block_header_t* header = heap_realloc(block_header(ptr), nsize + sizeof(block_header_t));
+        return header ? header + 1 : NULL;
+    }
+
+    void* new_ptr = block_alloc(alloc, nsize);
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, MIN(osize, nsize));
+        block_header(new_ptr)->owner = block_header(ptr)->owner;
+        block_free(alloc, ptr, osize);
+    }
+    return new_ptr;
+}
+
+static void account(script_alloc_t* alloc, uint8_t owner, size_t osize, size_t nsize)
+{
+    alloc->used = alloc->used - osize + nsize;
+    alloc->owner_used[owner] = alloc->owner_used[owner] - osize + nsize;
+    if (alloc->used > alloc->peak) {
+        alloc->peak = alloc->used;
+    }
+}
+
+static void* l_alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+    script_alloc_t* alloc = (script_alloc_t*)ud;
+
+    if (ptr == NULL) {
+        osize = 0;  // osize is type of object
+    }
+
+    if (nsize == 0) {
+        if (ptr) {
+            account(alloc, block_header(ptr)->owner, osize, 0);
+            block_free(alloc, ptr, osize);
+        }
+        return NULL;
+    }
+
+    if (alloc->limit && nsize > osize && alloc->used + (nsize - osize) > alloc->limit) {
+        // Lua run full collection and retry
+        return NULL;
+    }
+
+    void* new_ptr;
+    if (ptr == NULL) {
+        new_ptr = block_alloc(alloc, nsize);
+        if (new_ptr) block_header(new_ptr)->owner = alloc->owner;
+    } else {
+        new_ptr = block_realloc(alloc, ptr, osize, nsize);
+    }
+
+    if (new_ptr) {
+        account(alloc, block_header(new_ptr)->owner, osize, nsize);
+    }
+
+    return new_ptr;
+}
+
+static int l_panic(lua_State* L)
+{
+    const char* msg = lua_tostring(L, -1);
+    if (msg == NULL) msg = "error object is not a string";
+    lua_writestringerror("PANIC: unprotected error in call to Lua API (%s)\n", msg);
+    return 0;
+}
+
+static script_alloc_t* get_alloc(lua_State* L)
+{
+    void* ud;
+    return lua_getallocf(L, &ud) == l_alloc ? (script_alloc_t*)ud : NULL;
+}
+
+lua_State* script_alloc_new_state(size_t limit)
+{
+    script_alloc_t* alloc = (script_alloc_t*)calloc(1, sizeof(script_alloc_t));
+    if (!alloc) return NULL;
+
+    alloc->limit = limit;
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        LIST_INIT(&alloc->chunks[i]);
+    }
+
+    lua_State* L = lua_newstate(l_alloc, alloc);
+    if (L) {
+        lua_atpanic(L, l_panic);
+    } else {
+        free((void*)alloc);
+    }
+
+    return L;
+}
+
+void script_alloc_close(lua_State* L)
+{
+    script_alloc_t* alloc = get_alloc(L);
+
+    lua_close(L);
+
+    if (alloc) {
+        for (int i = 0; i < POOL_CLASSES; i++) {
+            while (!LIST_EMPTY(&alloc->chunks[i])) {
+                pool_chunk_t* chunk = LIST_FIRST(&alloc->chunks[i]);
+                LIST_REMOVE(chunk, entries);
+                heap_caps_free(chunk);
+            }
+        }
+        free((void*)alloc);
+    }
+}
+
+void script_alloc_set_limit(lua_State* L, size_t limit)
+{
+    script_alloc_t* alloc = get_alloc(L);
+    if (alloc) {
+        alloc->limit = limit;
+    }
+}
+
+uint8_t script_alloc_set_owner(lua_State* L, uint8_t owner)
+{
+    uint8_t prev_owner = 0;
+
+    script_alloc_t* alloc = get_alloc(L);
+    if (alloc) {
+        prev_owner = alloc->owner;
+        alloc->owner = owner < SCRIPT_ALLOC_OWNERS ? owner : 0;
+    }
+
+    return prev_owner;
+}
+
+bool script_alloc_get_stats(lua_State* L, script_alloc_stats_t* stats)
+{
+    script_alloc_t* alloc = get_alloc(L);
+    if (!alloc) return false;
+
+    stats->used = alloc->used;
+    stats->peak = alloc->peak;
+    stats->limit = alloc->limit;
+    stats->pool_size = alloc->pool_size;
+    memcpy(stats->owner_used, alloc->owner_used, sizeof(stats->owner_used));
+
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef SCRIPT_ALLOC_H_
+#define SCRIPT_ALLOC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lua.h"
+
+#define SCRIPT_ALLOC_OWNERS 16
+
+typedef struct {
+    size_t used;
+    size_t peak;
+    size_t limit;
+    size_t pool_size;
+    size_t owner_used[SCRIPT_ALLOC_OWNERS];
+} script_alloc_stats_t;
+
+/**
+ * @brief Create Lua state with script allocator, small blocks are served from size class pools, allocations are accounted per owner
+ *
+ * @param limit Memory limit in bytes, 0 for unlimited
+ * @return lua_State*
+ */
+lua_State* script_alloc_new_state(size_t limit);
+
+/**
+ * @brief Close Lua state created by script_alloc_new_state and release pools
+ *
+ * @param L
+ */
+void script_alloc_close(lua_State* L);
+
+/**
+ * @brief Set memory limit, allocation over limit fails as out of memory
+ *
+ * @param L
+ * @param limit Memory limit in bytes, 0 for unlimited
+ */
+void script_alloc_set_limit(lua_State* L, size_t limit);
+
+/**
+ * @brief Set owner of next allocations, no effect for state not created by script_alloc_new_state
+ *
+ * @param L
+ * @param owner 0 for shared, otherwise less than SCRIPT_ALLOC_OWNERS
+ * @return uint8_t Previous owner
+ */
+uint8_t script_alloc_set_owner(lua_State* L, uint8_t owner);
+
+/**
+ * @brief Get allocation statistics
+ *
+ * @param L
+ * @param stats
+ * @return true
+ * @return false State not created by script_alloc_new_state
+ */
+bool script_alloc_get_stats(lua_State* L, script_alloc_stats_t* stats);
+
+#endif /* SCRIPT_ALLOC_H_ */
@@ -0,0 +1,207 @@
+#include "script_cache.h"
+
+#include <esp_log.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "lauxlib.h"
+
+#define CACHE_DIR      "/usr/lua/.cache"
+#define CACHE_MAGIC    0x4C434143  // CACL
+#define CACHE_PATH_LEN sizeof(CACHE_DIR "/01234567.luac.tmp")
+#define READ_BUF_SIZE  256
+#define FNV_OFFSET     2166136261
+
+static const char* TAG = "script_cache";
+
+typedef struct {
+    uint32_t magic;
+    uint32_t hash;
+    uint32_t size;
+} cache_header_t;
+
+typedef struct {
+    FILE* file;
+    char buf[READ_BUF_SIZE];
+} cache_reader_t;
+
+static uint32_t fnv1a(uint32_t hash, const void* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ ((const uint8_t*)data)[i]) * 16777619;
+    }
+    return hash;
+}
+
+static void cache_path(const char* path, char* cache_path)
+{
+    // FNV-1a of source path
+    uint32_t hash = fnv1a(FNV_OFFSET, path, strlen(path));
+    snprintf(cache_path, CACHE_PATH_LEN, CACHE_DIR "/%08" PRIx32 ".luac", hash);
+}
+
+/**
+ * Hash content of source file, file system timestamps are not reliable without time sync
+ */
+static bool source_header(const char* path, cache_header_t* header)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+
+    header->magic = CACHE_MAGIC;
+    header->hash = FNV_OFFSET;
+    header->size = 0;
+
+    char buf[READ_BUF_SIZE];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
+        header->hash = fnv1a(header->hash, buf, len);
+        header->size += len;
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+
+    return ok;
+}
+
+static const char* reader(lua_State* L, void* ud, size_t* size)
+{
+    cache_reader_t* reader = (cache_reader_t*)ud;
+
+    *size = fread(reader->buf, 1, sizeof(reader->buf), reader->file);
+    return *size > 0 ? reader->buf : NULL;
+}
+
+static int writer(lua_State* L, const void* p, size_t size, void* ud)
+{
+    return size > 0 && fwrite(p, size, 1, (FILE*)ud) != 1;
+}
+
+static int cache_load(lua_State* L, const char* path, const char* cache, const cache_header_t* header)
+{
+    int status = LUA_ERRFILE;
+
+    FILE* file = fopen(cache, "rb");
+    if (file) {
+        cache_header_t file_header;
+        if (fread(&file_header, sizeof(cache_header_t), 1, file) == 1 && memcmp(&file_header, header, sizeof(cache_header_t)) == 0) {
+            cache_reader_t* reader_ud = (cache_reader_t*)malloc(sizeof(cache_reader_t));
+            if (reader_ud) {
+                reader_ud->file = file;
+                lua_pushfstring(L, "@%s", path);
+                status = lua_load(L, reader, reader_ud, lua_tostring(L, -1), "b");
+                lua_remove(L, -2);
+                if (status != LUA_OK) {
+                    ESP_LOGW(TAG, "Invalid cache of %s: %s", path, lua_tostring(L, -1));
+                    lua_pop(L, 1);
+                }
+                free((void*)reader_ud);
+            }
+        }
+        fclose(file);
+    }
+
+    return status;
+}
+
+static void cache_store(lua_State* L, const char* path, const char* cache, const cache_header_t* header)
+{
+    char tmp[CACHE_PATH_LEN];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", cache) >= sizeof(tmp)) {
+        return;
+    }
+
+    mkdir(CACHE_DIR, 0777);
+
+    FILE* file = fopen(tmp, "wb");
+    if (!file) {
+        ESP_LOGW(TAG, "Can't create %s", tmp);
+        return;
+    }
+
+    bool ok = fwrite(header, sizeof(cache_header_t), 1, file) == 1 && lua_dump(L, writer, file, 1) == 0;
+    ok = fclose(file) == 0 && ok;
+
+    remove(cache);
+    if (!ok || rename(tmp, cache) != 0) {
+        ESP_LOGW(TAG, "Can't store cache of %s", path);
+        remove(tmp);
+    }
+}
+
+static bool path_has_suffix(const char* path, const char* suffix)
+{
+    size_t path_len = strlen(path);
+    size_t suffix_len = strlen(suffix);
+
+    return (path_len > suffix_len) && strcmp(path + (path_len - suffix_len), suffix) == 0;
+}
+
+int script_cache_loadfile(lua_State* L, const char* path)
+{
+    cache_header_t header;
+    if (!path_has_suffix(path, ".lua") || !source_header(path, &header)) {
+        // precompiled file or file error
+        return luaL_loadfile(L, path);
+    }
+
+    char cache[CACHE_PATH_LEN];
+    cache_path(path, cache);
+
+    if (cache_load(L, path, cache, &header) == LUA_OK) {
+        return LUA_OK;
+    }
+
+    int status = luaL_loadfilex(L, path, "t");
+    if (status == LUA_OK) {
+        cache_store(L, path, cache, &header);
+    }
+
+    return status;
+}
+
+void script_cache_invalidate(const char* path)
+{
+    char cache[CACHE_PATH_LEN];
+    cache_path(path, cache);
+
+    remove(cache);
+}
+
+static int searcher(lua_State* L)
+{
+    const char* name = luaL_checkstring(L, 1);
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchpath");
+    lua_pushstring(L, name);
+    lua_getfield(L, -3, "path");
+    lua_call(L, 2, 2);
+    if (lua_isnil(L, -2)) {
+        // not found, error message
+        return 1;
+    }
+
+    lua_pop(L, 1);
+    const char* filename = lua_tostring(L, -1);
+    if (script_cache_loadfile(L, filename) != LUA_OK) {
+        return luaL_error(L, "error loading module '%s' from file '%s':\n\t%s", name, filename, lua_tostring(L, -1));
+    }
+    lua_insert(L, -2);
+
+    return 2;
+}
+
+void script_cache_init(lua_State* L)
+{
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchers");
+    lua_pushcfunction(L, searcher);
+    lua_rawseti(L, -2, 2);
+    lua_pop(L, 2);
+}
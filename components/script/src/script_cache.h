@@ -0,0 +1,30 @@
+#ifndef SCRIPT_CACHE_H_
+#define SCRIPT_CACHE_H_
+
+#include "lua.h"
+
+/**
+ * @brief Replace Lua file searcher of require by searcher which load files through bytecode cache
+ *
+ * @param L
+ */
+void script_cache_init(lua_State* L);
+
+/**
+ * @brief Load Lua file as chunk, source file is compiled only when is not in cache or its content is modified, then stored in cache as
+ * stripped bytecode
+ *
+ * @param L
+ * @param path
+ * @return int Status as luaL_loadfile
+ */
+int script_cache_loadfile(lua_State* L, const char* path);
+
+/**
+ * @brief Remove bytecode of source file from cache
+ *
+ * @param path
+ */
+void script_cache_invalidate(const char* path);
+
+#endif /* SCRIPT_CACHE_H_ */
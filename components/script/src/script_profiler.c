@@ -0,0 +1,199 @@
+#include "script_profiler.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#define MAX_FRAMES     128
+#define MAX_STACKS     128
+#define MAX_DEPTH      12
+#define FRAME_NAME_LEN 48
+#define HASH_NONE      0
+
+typedef struct {
+    uint32_t hash;
+    char name[FRAME_NAME_LEN];
+} frame_entry_t;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t weight;
+    uint8_t depth;
+    uint16_t frames[MAX_DEPTH];  // root first
+} stack_entry_t;
+
+typedef struct {
+    frame_entry_t frames[MAX_FRAMES];
+    stack_entry_t stacks[MAX_STACKS];
+    uint32_t dropped;  // weight of samples not fitting in tables
+} profile_t;
+
+volatile bool script_profiler_running = false;
+
+uint32_t script_profiler_period = SCRIPT_PROFILER_DEFAULT_PERIOD;
+
+static profile_t* profile = NULL;
+
+static SemaphoreHandle_t mutex = NULL;
+
+static uint32_t fnv1a(uint32_t hash, const void* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ ((const uint8_t*)data)[i]) * 16777619;
+    }
+    return hash == HASH_NONE ? 1 : hash;
+}
+
+esp_err_t script_profiler_start(uint32_t period)
+{
+    if (!mutex) {
+        mutex = xSemaphoreCreateMutex();
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (!profile) {
+        profile = (profile_t*)malloc(sizeof(profile_t));
+    }
+    if (profile) {
+        memset(profile, 0, sizeof(profile_t));
+        script_profiler_period = period > 0 ? period : SCRIPT_PROFILER_DEFAULT_PERIOD;
+        script_profiler_running = true;
+    }
+    xSemaphoreGive(mutex);
+
+    return profile ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void script_profiler_stop(void)
+{
+    script_profiler_running = false;
+}
+
+void script_profiler_clear(void)
+{
+    script_profiler_running = false;
+
+    if (mutex) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        free((void*)profile);
+        profile = NULL;
+        xSemaphoreGive(mutex);
+    }
+}
+
+static int frame_index(const lua_Debug* ar, bool leaf)
+{
+    char name[FRAME_NAME_LEN];
+    const char* fn_name = ar->name ? ar->name : (*ar->what == 'm' ? "main" : "?");
+    if (*ar->what == 'C') {
+        snprintf(name, sizeof(name), "%s [C]", fn_name);
+    } else {
+        // keep line and end of source, when name is too long
+        char line[16];
+        int line_len = snprintf(line, sizeof(line), ":%d)", leaf ? ar->currentline : ar->linedefined);
+        int src_len = strlen(ar->short_src);
+        int src_max = MAX((int)sizeof(name) - (int)strlen(fn_name) - line_len - 3, 0);
+        const char* src = ar->short_src + MAX(src_len - src_max, 0);
+        snprintf(name, sizeof(name), "%s (%s%s", fn_name, src, line);
+    }
+    // semicolon separates frames in folded format
+    for (char* c = name; *c; c++) {
+        if (*c == ';') *c = ':';
+    }
+
+    uint32_t hash = fnv1a(2166136261, name, strlen(name));
+    for (int i = 0; i < MAX_FRAMES; i++) {
+        frame_entry_t* frame = &profile->frames[(hash + i) % MAX_FRAMES];
+        if (frame->hash == HASH_NONE) {
+            frame->hash = hash;
+            strcpy(frame->name, name);
+            return frame - profile->frames;
+        }
+        if (frame->hash == hash && strcmp(frame->name, name) == 0) {
+            return frame - profile->frames;
+        }
+    }
+
+    return -1;
+}
+
+void script_profiler_sample(lua_State* L, uint32_t weight)
+{
+    if (xSemaphoreTake(mutex, 0) != pdTRUE) return;
+    if (!profile) goto end;
+
+    uint16_t frames[MAX_DEPTH];
+    int depth = 0;
+    lua_Debug ar;
+    while (depth < MAX_DEPTH && lua_getstack(L, depth, &ar)) {
+        lua_getinfo(L, "Sln", &ar);
+        int index = frame_index(&ar, depth == 0);
+        if (index < 0) {
+            profile->dropped += weight;
+            goto end;
+        }
+        frames[depth++] = index;
+    }
+    if (depth == 0) goto end;
+
+    // stored root first
+    uint16_t root_first[MAX_DEPTH];
+    for (int i = 0; i < depth; i++) {
+        root_first[i] = frames[depth - 1 - i];
+    }
+    uint32_t hash = fnv1a(2166136261, root_first, depth * sizeof(uint16_t));
+
+    for (int i = 0; i < MAX_STACKS; i++) {
+        stack_entry_t* stack = &profile->stacks[(hash + i) % MAX_STACKS];
+        if (stack->hash == HASH_NONE) {
+            stack->hash = hash;
+            stack->depth = depth;
+            memcpy(stack->frames, root_first, depth * sizeof(uint16_t));
+        }
+        if (stack->hash == hash && stack->depth == depth && memcmp(stack->frames, root_first, depth * sizeof(uint16_t)) == 0) {
+            stack->weight += weight;
+            goto end;
+        }
+    }
+    profile->dropped += weight;
+
+end:
+    xSemaphoreGive(mutex);
+}
+
+bool script_profiler_read(uint16_t* index, char* buf, size_t size)
+{
+    if (!mutex) return false;
+
+    bool ret = false;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (profile) {
+        while (*index < MAX_STACKS && profile->stacks[*index].hash == HASH_NONE) {
+            (*index)++;
+        }
+
+        if (*index < MAX_STACKS) {
+            const stack_entry_t* stack = &profile->stacks[*index];
+            size_t len = 0;
+            for (int i = 0; i < stack->depth && len < size; i++) {
+                len += snprintf(buf + len, size - len, "%s%s", i ? ";" : "", profile->frames[stack->frames[i]].name);
+            }
+            if (len < size) {
+                snprintf(buf + len, size - len, " %" PRIu32 "\n", stack->weight);
+            }
+            (*index)++;
+            ret = true;
+        } else if (*index == MAX_STACKS && profile->dropped) {
+            snprintf(buf, size, "(dropped) %" PRIu32 "\n", profile->dropped);
+            (*index)++;
+            ret = true;
+        }
+    }
+    xSemaphoreGive(mutex);
+
+    return ret;
+}
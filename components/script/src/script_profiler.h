@@ -0,0 +1,63 @@
+#ifndef SCRIPT_PROFILER_H_
+#define SCRIPT_PROFILER_H_
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lua.h"
+
+#define SCRIPT_PROFILER_DEFAULT_PERIOD 1000  // us
+
+/**
+ * @brief Start sampling, previous samples are cleared
+ *
+ * @param period Sampling period in us, 0 for default
+ * @return esp_err_t
+ */
+esp_err_t script_profiler_start(uint32_t period);
+
+/**
+ * @brief Stop sampling, samples are kept for reading
+ *
+ */
+void script_profiler_stop(void);
+
+/**
+ * @brief Free samples
+ *
+ */
+void script_profiler_clear(void);
+
+/**
+ * @brief Profiler is sampling, checked in watchdog hook
+ *
+ */
+extern volatile bool script_profiler_running;
+
+/**
+ * @brief Sampling period, valid when running
+ *
+ */
+extern uint32_t script_profiler_period;
+
+/**
+ * @brief Take sample of stack, must be called from hook
+ *
+ * @param L
+ * @param weight Time in us since previous hook call
+ */
+void script_profiler_sample(lua_State* L, uint32_t weight);
+
+/**
+ * @brief Format one stack with its time in folded format "frame;frame;frame weight\n"
+ *
+ * @param index Stack index, is set for reading next stack
+ * @param buf
+ * @param size
+ * @return true When stack was read
+ * @return false When no stack left
+ */
+bool script_profiler_read(uint16_t* index, char* buf, size_t size);
+
+#endif /* SCRIPT_PROFILER_H_ */
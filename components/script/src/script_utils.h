@@ -4,6 +4,27 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
+#define SCRIPT_EVENT_EVSE   BIT8
+#define SCRIPT_EVENT_MQTT   BIT9
+#define SCRIPT_EVENT_SERIAL BIT10
+#define SCRIPT_EVENT_AUX    BIT11
+#define SCRIPT_EVENT_ALL    (SCRIPT_EVENT_EVSE | SCRIPT_EVENT_MQTT | SCRIPT_EVENT_SERIAL | SCRIPT_EVENT_AUX)
+
 extern SemaphoreHandle_t script_mutex;
 
+/**
+ * @brief Post events to script task, events are coalesced until script task process them.
+ * Wakes components awaiting the events and components yielded without timeout
+ *
+ * @param events SCRIPT_EVENT_x bits
+ */
+void script_event_post(uint32_t events);
+
+/**
+ * @brief Post events to script task from ISR
+ *
+ * @param events SCRIPT_EVENT_x bits
+ */
+void script_event_post_from_isr(uint32_t events);
+
 #endif /* SCRIPT_UTILS_H_ */
@@ -1,28 +1,106 @@
 #include "script_watchdog.h"
 
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
+#include <esp_timer.h>
+#include <sys/param.h>
 
 #include "lauxlib.h"
+#include "script_profiler.h"
 
-#define TIMEOUT 100
+#define HOOK_COUNT_INITIAL 1000
+#define HOOK_COUNT_MIN     100
+#define HOOK_COUNT_MAX     100000
+#define HOOK_INTERVAL_MIN  500    // us
+#define HOOK_INTERVAL_MAX  10000  // us
+#define HOOK_SLICES        8      // hook calls per budget
 
-static TickType_t reset_tick;
+static uint32_t default_budget = SCRIPT_WATCHDOG_DEFAULT_BUDGET;
+
+static int64_t start_time;
+
+static int64_t deadline;
+
+static bool overrun;
+
+// instructions between hook calls, adapted to hit hook_interval
+static int hook_count = HOOK_COUNT_INITIAL;
+
+static int64_t hook_interval;
+
+static int64_t last_hook_time;
+
+static void set_hook_interval(uint32_t budget)
+{
+    hook_interval = MIN(MAX((int64_t)budget * 1000 / HOOK_SLICES, HOOK_INTERVAL_MIN), HOOK_INTERVAL_MAX);
+}
 
 static void watchdog_hook(lua_State *L, lua_Debug *ar)
 {
-    if (xTaskGetTickCount() > reset_tick + pdMS_TO_TICKS(TIMEOUT)) {
+    int64_t now = esp_timer_get_time();
+    int64_t interval = script_profiler_running ? MIN(hook_interval, script_profiler_period) : hook_interval;
+
+    if (script_profiler_running) {
+        script_profiler_sample(L, MIN(now - last_hook_time, 4 * interval));
+    }
+
+    if (now - last_hook_time < 4 * interval) {
+        // hook is per coroutine, interval from other coroutine hook is only approximation, smooth it
+        int64_t count = (int64_t)hook_count * interval / MAX(now - last_hook_time, 1);
+        hook_count = MIN(MAX((hook_count + count) / 2, HOOK_COUNT_MIN), HOOK_COUNT_MAX);
+    }
+    last_hook_time = now;
+
+    if (lua_gethookcount(L) != hook_count) {
+        lua_sethook(L, watchdog_hook, LUA_MASKCOUNT, hook_count);
+    }
+
+    if (now > deadline) {
+        overrun = true;
+        // code running after caught error is ended soon
+        hook_count = HOOK_COUNT_MIN;
+        lua_sethook(L, watchdog_hook, LUA_MASKCOUNT, hook_count);
         luaL_error(L, "watchdog end execution");
     }
 }
 
 void script_watchdog_init(lua_State *L)
 {
-    lua_sethook(L, watchdog_hook, LUA_MASKCOUNT, 1000);
+    hook_count = HOOK_COUNT_INITIAL;
+    lua_sethook(L, watchdog_hook, LUA_MASKCOUNT, hook_count);
     script_watchdog_reset();
 }
 
+void script_watchdog_set_budget(uint32_t budget)
+{
+    default_budget = budget > 0 ? budget : SCRIPT_WATCHDOG_DEFAULT_BUDGET;
+}
+
+uint32_t script_watchdog_get_budget(void)
+{
+    return default_budget;
+}
+
 void script_watchdog_reset(void)
 {
-    reset_tick = xTaskGetTickCount();
+    script_watchdog_start(0);
+}
+
+void script_watchdog_start(uint32_t budget)
+{
+    if (budget == 0) budget = default_budget;
+
+    start_time = esp_timer_get_time();
+    deadline = start_time + (int64_t)budget * 1000;
+    last_hook_time = start_time;
+    overrun = false;
+    set_hook_interval(budget);
+}
+
+int64_t script_watchdog_stop(bool *slice_overrun)
+{
+    int64_t elapsed = esp_timer_get_time() - start_time;
+    if (slice_overrun) *slice_overrun = overrun;
+
+    script_watchdog_reset();
+
+    return elapsed;
 }
@@ -1,5 +1,43 @@
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "lua.h"
 
+#define SCRIPT_WATCHDOG_DEFAULT_BUDGET 100  // ms
+
 void script_watchdog_init(lua_State *L);
 
+/**
+ * @brief Set default CPU budget of one slice
+ *
+ * @param budget Budget in ms
+ */
+void script_watchdog_set_budget(uint32_t budget);
+
+/**
+ * @brief Get default CPU budget of one slice
+ *
+ * @return uint32_t Budget in ms
+ */
+uint32_t script_watchdog_get_budget(void);
+
+/**
+ * @brief Start new slice with default budget
+ *
+ */
 void script_watchdog_reset(void);
+
+/**
+ * @brief Start new slice, script is ended with error when slice run longer than budget
+ *
+ * @param budget Budget in ms, 0 for default budget
+ */
+void script_watchdog_start(uint32_t budget);
+
+/**
+ * @brief End slice, new slice with default budget is started
+ *
+ * @param overrun Set true when slice was ended by watchdog, optional
+ * @return int64_t Slice time in us
+ */
+int64_t script_watchdog_stop(bool *overrun);
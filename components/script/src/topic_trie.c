@@ -0,0 +1,155 @@
+#include "topic_trie.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/queue.h>
+
+struct topic_trie_node_s {
+    int value;
+    SLIST_HEAD(topic_trie_children_s, topic_trie_node_s) children;
+    SLIST_ENTRY(topic_trie_node_s) entries;
+    char level[];
+};
+
+static topic_trie_node_t* node_create(const char* level, size_t level_len)
+{
+    topic_trie_node_t* node = (topic_trie_node_t*)malloc(sizeof(topic_trie_node_t) + level_len + 1);
+    if (node) {
+        node->value = TOPIC_TRIE_NONE;
+        SLIST_INIT(&node->children);
+        memcpy(node->level, level, level_len);
+        node->level[level_len] = '\0';
+    }
+    return node;
+}
+
+static void node_delete(topic_trie_node_t* node, topic_trie_cb_t cb, void* ctx)
+{
+    while (!SLIST_EMPTY(&node->children)) {
+        topic_trie_node_t* child = SLIST_FIRST(&node->children);
+        SLIST_REMOVE_HEAD(&node->children, entries);
+        node_delete(child, cb, ctx);
+    }
+    if (cb && node->value != TOPIC_TRIE_NONE) {
+        cb(node->value, ctx);
+    }
+    free((void*)node);
+}
+
+static topic_trie_node_t* node_find_child(const topic_trie_node_t* node, const char* level, size_t level_len)
+{
+    topic_trie_node_t* child;
+    SLIST_FOREACH (child, &node->children, entries) {
+        if (strncmp(child->level, level, level_len) == 0 && child->level[level_len] == '\0') {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+static const char* level_end(const char* level, const char* end)
+{
+    const char* slash = memchr(level, '/', end - level);
+    return slash ? slash : end;
+}
+
+topic_trie_t* topic_trie_create(void)
+{
+    topic_trie_t* trie = (topic_trie_t*)malloc(sizeof(topic_trie_t));
+    if (trie) {
+        trie->root = node_create("", 0);
+        if (!trie->root) {
+            free((void*)trie);
+            trie = NULL;
+        }
+    }
+    return trie;
+}
+
+void topic_trie_delete(topic_trie_t* trie, topic_trie_cb_t cb, void* ctx)
+{
+    node_delete(trie->root, cb, ctx);
+    free((void*)trie);
+}
+
+bool topic_trie_insert(topic_trie_t* trie, const char* pattern, int value, int* prev_value)
+{
+    topic_trie_node_t* node = trie->root;
+    const char* level = pattern;
+    const char* end = pattern + strlen(pattern);
+
+    while (true) {
+        const char* next = level_end(level, end);
+        topic_trie_node_t* child = node_find_child(node, level, next - level);
+        if (!child) {
+            child = node_create(level, next - level);
+            if (!child) return false;
+            SLIST_INSERT_HEAD(&node->children, child, entries);
+        }
+        node = child;
+        if (next == end) break;
+        level = next + 1;
+    }
+
+    if (prev_value) *prev_value = node->value;
+    node->value = value;
+
+    return true;
+}
+
+static int node_remove(topic_trie_node_t* node, const char* level, const char* end)
+{
+    const char* next = level_end(level, end);
+    topic_trie_node_t* child = node_find_child(node, level, next - level);
+    if (!child) return TOPIC_TRIE_NONE;
+
+    int value;
+    if (next == end) {
+        value = child->value;
+        child->value = TOPIC_TRIE_NONE;
+    } else {
+        value = node_remove(child, next + 1, end);
+    }
+
+    // prune empty branch
+    if (child->value == TOPIC_TRIE_NONE && SLIST_EMPTY(&child->children)) {
+        SLIST_REMOVE(&node->children, child, topic_trie_node_s, entries);
+        free((void*)child);
+    }
+
+    return value;
+}
+
+int topic_trie_remove(topic_trie_t* trie, const char* pattern)
+{
+    return node_remove(trie->root, pattern, pattern + strlen(pattern));
+}
+
+static void node_match(const topic_trie_node_t* node, const char* level, const char* end, topic_trie_cb_t cb, void* ctx)
+{
+    if (!level) {
+        // all topic levels matched, "#" match also parent level
+        if (node->value != TOPIC_TRIE_NONE) cb(node->value, ctx);
+        topic_trie_node_t* child = node_find_child(node, "#", 1);
+        if (child && child->value != TOPIC_TRIE_NONE) cb(child->value, ctx);
+        return;
+    }
+
+    const char* next = level_end(level, end);
+    size_t level_len = next - level;
+    const char* next_level = next == end ? NULL : next + 1;
+
+    topic_trie_node_t* child;
+    SLIST_FOREACH (child, &node->children, entries) {
+        if (child->level[0] == '#' && child->level[1] == '\0') {
+            if (child->value != TOPIC_TRIE_NONE) cb(child->value, ctx);
+        } else if ((child->level[0] == '+' && child->level[1] == '\0') || (strncmp(child->level, level, level_len) == 0 && child->level[level_len] == '\0')) {
+            node_match(child, next_level, end, cb, ctx);
+        }
+    }
+}
+
+void topic_trie_match(const topic_trie_t* trie, const char* topic, size_t topic_len, topic_trie_cb_t cb, void* ctx)
+{
+    node_match(trie->root, topic, topic + topic_len, cb, ctx);
+}
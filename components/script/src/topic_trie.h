@@ -0,0 +1,69 @@
+#ifndef TOPIC_TRIE_H_
+#define TOPIC_TRIE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TOPIC_TRIE_NONE (-1)
+
+typedef struct topic_trie_node_s topic_trie_node_t;
+
+typedef struct {
+    topic_trie_node_t* root;
+} topic_trie_t;
+
+/**
+ * @brief Callback for each value of matched or deleted pattern
+ *
+ */
+typedef void (*topic_trie_cb_t)(int value, void* ctx);
+
+/**
+ * @brief Create empty trie of MQTT topic patterns, levels are split by '/' and can be wildcards '+' and '#'
+ *
+ * @return topic_trie_t*
+ */
+topic_trie_t* topic_trie_create(void);
+
+/**
+ * @brief Delete trie
+ *
+ * @param trie
+ * @param cb called for each stored value, can be NULL
+ * @param ctx
+ */
+void topic_trie_delete(topic_trie_t* trie, topic_trie_cb_t cb, void* ctx);
+
+/**
+ * @brief Insert or replace value of pattern
+ *
+ * @param trie
+ * @param pattern
+ * @param value
+ * @param prev_value replaced value or TOPIC_TRIE_NONE
+ * @return true
+ * @return false out of memory
+ */
+bool topic_trie_insert(topic_trie_t* trie, const char* pattern, int value, int* prev_value);
+
+/**
+ * @brief Remove pattern
+ *
+ * @param trie
+ * @param pattern
+ * @return int Removed value or TOPIC_TRIE_NONE
+ */
+int topic_trie_remove(topic_trie_t* trie, const char* pattern);
+
+/**
+ * @brief Call callback for value of each pattern matching the topic, matching cost is proportional to topic length
+ *
+ * @param trie
+ * @param topic not null terminated
+ * @param topic_len
+ * @param cb
+ * @param ctx
+ */
+void topic_trie_match(const topic_trie_t* trie, const char* topic, size_t topic_len, topic_trie_cb_t cb, void* ctx);
+
+#endif /* TOPIC_TRIE_H_ */
@@ -13,6 +13,12 @@ typedef struct {
     uint32_t flash_size;
 } serial_nextion_info_t;
 
+typedef struct {
+    size_t file_size;
+    size_t offset;
+    uint32_t rate;  // B/s
+} serial_nextion_upload_progress_t;
+
 /**
  * @brief Get nextion info
  *
@@ -31,14 +37,21 @@ esp_err_t serial_nextion_get_info(serial_nextion_info_t *info);
 esp_err_t serial_nextion_upload_begin(size_t file_size, uint32_t baud_rate);
 
 /**
- * @brief Upload chunk, if fail not need call serial_nextion_upload_end
+ * @brief Start upload of chunk in background, data must be valid until serial_nextion_upload_wait returns
  *
  * @param data
  * @param len
- * @param skip_to
  * @return esp_err_t
  */
-esp_err_t serial_nextion_upload_write(char *data, uint16_t len, size_t *skip_to);
+esp_err_t serial_nextion_upload_send(const char *data, uint16_t len);
+
+/**
+ * @brief Wait for acknowledge of sent chunk, if fail not need call serial_nextion_upload_end
+ *
+ * @param skip_to file offset where upload continues, zero when no skip
+ * @return esp_err_t
+ */
+esp_err_t serial_nextion_upload_wait(size_t *skip_to);
 
 /**
  * @brief Finish upload
@@ -47,4 +60,12 @@ esp_err_t serial_nextion_upload_write(char *data, uint16_t len, size_t *skip_to)
  */
 esp_err_t serial_nextion_upload_end(void);
 
+/**
+ * @brief Get progress of running upload
+ *
+ * @param progress
+ * @return true when upload is running
+ */
+bool serial_nextion_get_upload_progress(serial_nextion_upload_progress_t *progress);
+
 #endif /* SERIAL_NEXTION_H_ */
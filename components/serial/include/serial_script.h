@@ -2,6 +2,8 @@
 #define SERIAL_SCRIPT_H_
 
 #include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 bool serial_script_is_available(void);
 
@@ -11,4 +13,6 @@ esp_err_t serial_script_read(char *buf, size_t *len);
 
 esp_err_t serial_script_flush(void);
 
+bool serial_script_wait_read(uint32_t timeout);
+
 #endif /* SERIAL_SCRIPT_H_ */
\ No newline at end of file
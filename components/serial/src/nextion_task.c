@@ -3,22 +3,22 @@
 #include <esp_log.h>
 #include <esp_ota_ops.h>
 #include <esp_timer.h>
-#include <fcntl.h>
 #include <freertos/semphr.h>
 #include <string.h>
 #include <time.h>
-#include <unistd.h>
 
 #include "board_config.h"
 #include "energy_meter.h"
 #include "evse.h"
+#include "serial_port.h"
 #include "temp_sensor.h"
 #include "wifi.h"
 
 #define NEXTION_TASK_CONTEXT_INDEX    1
 #define NEXTION_TASK_SHUTDOWN_TIMEOUT 500
 
-#define BUF_SIZE 256
+#define TX_BUF_SIZE 512
+#define CYCLE_MS    50
 
 #define NEX_RET_BUF_OVERFLOW 0x24
 #define NEX_RET_AUTO_SLEEP   0x86
@@ -59,40 +59,15 @@ static const char* VAR_APP_VERSION = "appVer";
 static const char* VAR_HEAP_SIZE = "heap";
 static const char* VAR_MAX_HEAP_SIZE = "maxHeap";
 
-static const char* VAR_FMT_STATE = "state.txt=\"%s\"";
-static const char* VAR_FMT_ENABLED = "en.val=%" PRIu8;
-static const char* VAR_FMT_ERROR = "err.val=%" PRIu16;
-static const char* VAR_FMT_PENDING_AUTH = "pendAuth.val=%" PRIu8;
-static const char* VAR_FMT_LIMIT_REACHED = "limReach.val=%" PRIu8;
-static const char* VAR_FMT_MAX_CHARGING_CURRENT = "maxChCur.val=%" PRIu8;
-static const char* VAR_FMT_CHARGING_CURRENT = "chCur.val=%" PRIu16;
-static const char* VAR_FMT_DEFAULT_CHARGING_CURRENT = "defChCur.val=%" PRIu16;
-static const char* VAR_FMT_SESSION_TIME = "sesTime.val=%" PRIu32;
-static const char* VAR_FMT_CHARGING_TIME = "chTime.val=%" PRIu32;
-static const char* VAR_FMT_POWER = "power.val=%" PRIu16;
-static const char* VAR_FMT_CONSUMPTION = "consum.val=%" PRIu32;
-static const char* VAR_FMT_TOTAL_CONSUMPTION = "totConsum.val=%" PRIu64;
-static const char* VAR_FMT_VOLTAGE_L1 = "vltL1.val=%" PRIu16;
-static const char* VAR_FMT_VOLTAGE_L2 = "vltL2.val=%" PRIu16;
-static const char* VAR_FMT_VOLTAGE_L3 = "vltL3.val=%" PRIu16;
-static const char* VAR_FMT_CURRENT_L1 = "curL1.val=%" PRIu16;
-static const char* VAR_FMT_CURRENT_L2 = "curL2.val=%" PRIu16;
-static const char* VAR_FMT_CURRENT_L3 = "curL3.val=%" PRIu16;
-static const char* VAR_FMT_CONSUMPTION_LIMIT = "consumLim.val=%" PRIu32;
-static const char* VAR_FMT_CHARGING_TIME_LIMIT = "chTimeLim.val=%" PRIu32;
-static const char* VAR_FMT_UNDER_POWER_LIMIT = "uPowerLim.val=%" PRIu16;
-static const char* VAR_FMT_DEFAULT_CONSUMPTION_LIMIT = "defConsumLim.val=%" PRIu32;
-static const char* VAR_FMT_DEFAULT_CHARGING_TIME_LIMIT = "defChTimeLim.val=%" PRIu32;
-static const char* VAR_FMT_DEFAULT_UNDER_POWER_LIMIT = "defUPowerLim.val=%" PRIu16;
-static const char* VAR_FMT_DEVICE_NAME = "devName.txt=\"%s\"";
-static const char* VAR_FMT_UPTIME = "uptime.val=%" PRIu32;
-static const char* VAR_FMT_TEMPERATURE = "temp.val=%" PRIi16;  // TODO deprecated, same as VAR_FMT_HIGH_TEMPERATURE
-static const char* VAR_FMT_LOW_TEMPERATURE = "loTemp.val=%" PRIi16;
-static const char* VAR_FMT_HIGH_TEMPERATURE = "hiTemp.val=%" PRIi16;
-static const char* VAR_FMT_IP = "ip.txt=\"%s\"";
-static const char* VAR_FMT_APP_VERSION = "appVer.txt=\"%s\"";
-static const char* VAR_FMT_HEAP_SIZE = "heap.val=%" PRIu32;
-static const char* VAR_FMT_MAX_HEAP_SIZE = "maxHeap.val=%" PRIu32;
+static const char* VAR_FMT_NUM = "%s.val=%" PRIi64;
+static const char* VAR_FMT_STR = "%s.txt=\"%s\"";
+
+// minimal change of analog values to be sent, in units sent to display
+#define DEADBAND_POWER       10    // W
+#define DEADBAND_VOLTAGE     50    // 0.01 V
+#define DEADBAND_CURRENT     10    // 0.01 A
+#define DEADBAND_TEMPERATURE 10    // 0.01 C
+#define DEADBAND_HEAP_SIZE   1024  // B
 
 static const char* CMD_SUBSCRIBE = "sub %s";
 static const char* CMD_UNSUBSCRIBE = "unsub %s";
@@ -113,6 +88,44 @@ static const uint8_t DELIMITER[] = { 0xFF, 0xFF, 0xFF };
 
 static const char* TAG = "nextion_task";
 
+typedef enum {
+    VAR_ID_STATE,
+    VAR_ID_ENABLED,
+    VAR_ID_ERROR,
+    VAR_ID_PENDING_AUTH,
+    VAR_ID_LIMIT_REACHED,
+    VAR_ID_CHARGING_CURRENT,
+    VAR_ID_MAX_CHARGING_CURRENT,
+    VAR_ID_DEFAULT_CHARGING_CURRENT,
+    VAR_ID_SESSION_TIME,
+    VAR_ID_CHARGING_TIME,
+    VAR_ID_POWER,
+    VAR_ID_CONSUMPTION,
+    VAR_ID_TOTAL_CONSUMPTION,
+    VAR_ID_VOLTAGE_L1,
+    VAR_ID_VOLTAGE_L2,
+    VAR_ID_VOLTAGE_L3,
+    VAR_ID_CURRENT_L1,
+    VAR_ID_CURRENT_L2,
+    VAR_ID_CURRENT_L3,
+    VAR_ID_CONSUMPTION_LIMIT,
+    VAR_ID_CHARGING_TIME_LIMIT,
+    VAR_ID_UNDER_POWER_LIMIT,
+    VAR_ID_DEFAULT_CONSUMPTION_LIMIT,
+    VAR_ID_DEFAULT_CHARGING_TIME_LIMIT,
+    VAR_ID_DEFAULT_UNDER_POWER_LIMIT,
+    VAR_ID_UPTIME,
+    VAR_ID_TEMPERATURE,  // TODO deprecated, same as VAR_ID_HIGH_TEMPERATURE
+    VAR_ID_LOW_TEMPERATURE,
+    VAR_ID_HIGH_TEMPERATURE,
+    VAR_ID_IP,
+    VAR_ID_HEAP_SIZE,
+    VAR_ID_MAX_HEAP_SIZE,
+    VAR_ID_DEVICE_NAME,
+    VAR_ID_APP_VERSION,
+    VAR_ID_MAX,
+} var_id_t;
+
 typedef struct {
     bool state : 1;
     bool enabled : 1;
@@ -150,43 +163,92 @@ typedef struct {
 
 typedef struct {
     SemaphoreHandle_t mutex;
-    int fd;
+    uart_port_t port;
     bool sleep : 1;
     var_sub_t var_sub;
     evse_state_t state;
-    bool enabled;
-    uint16_t charging_current;
-    uint16_t max_charging_current;
-    uint16_t default_charging_current;
-    uint32_t consumption_limit;
-    uint32_t charging_time_limit;
-    uint16_t under_power_limit;
-    uint32_t default_consumption_limit;
-    uint32_t default_charging_time_limit;
-    uint16_t default_under_power_limit;
-    char ip[16];
+    uint64_t var_sent;           // bit per var_id_t, value in var_last is valid
+    int64_t var_last[VAR_ID_MAX];  // last sent value, hash for strings
+    uint8_t tx_buf[TX_BUF_SIZE];
+    uint16_t tx_len;
 } task_context_t;
 
-static void tx_str(int fd, const char* cmd)
+static void tx_flush(task_context_t* ctx)
 {
-    write(fd, cmd, strlen(cmd));
-    write(fd, DELIMITER, sizeof(DELIMITER));
+    if (ctx->tx_len > 0) {
+        serial_port_write(ctx->port, ctx->tx_buf, ctx->tx_len);
+        ctx->tx_len = 0;
+    }
 }
 
-static void set_subscribe(task_context_t* ctx, const char* var, bool subscribe)
+/**
+ * Append command to tx buffer, it is written once per cycle by tx_flush
+ */
+static void tx_str(task_context_t* ctx, const char* cmd)
 {
-    char tx_cmd[64];
+    size_t len = strlen(cmd);
+
+    if (ctx->tx_len + len + sizeof(DELIMITER) > sizeof(ctx->tx_buf)) {
+        tx_flush(ctx);
+    }
+    if (len + sizeof(DELIMITER) > sizeof(ctx->tx_buf)) return;
+
+    memcpy(&ctx->tx_buf[ctx->tx_len], cmd, len);
+    ctx->tx_len += len;
+    memcpy(&ctx->tx_buf[ctx->tx_len], DELIMITER, sizeof(DELIMITER));
+    ctx->tx_len += sizeof(DELIMITER);
+}
+
+/**
+ * Return true when value differs from last sent at least by deadband, or changed to zero
+ */
+static bool var_changed(task_context_t* ctx, var_id_t id, int64_t value, int64_t deadband)
+{
+    uint64_t bit = 1ULL << id;
+
+    if (ctx->var_sent & bit) {
+        int64_t diff = value - ctx->var_last[id];
+        if (diff < 0) diff = -diff;
+        if (diff == 0 || (diff < deadband && value != 0)) return false;
+    }
+
+    ctx->var_sent |= bit;
+    ctx->var_last[id] = value;
+
+    return true;
+}
 
+static void tx_var_num(task_context_t* ctx, var_id_t id, const char* var, int64_t value, int64_t deadband)
+{
+    if (var_changed(ctx, id, value, deadband)) {
+        char tx_cmd[64];
+        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_NUM, var, value);
+        tx_str(ctx, tx_cmd);
+    }
+}
+
+static void tx_var_str(task_context_t* ctx, var_id_t id, const char* var, const char* value)
+{
+    // FNV-1a of value
+    uint32_t hash = 2166136261;
+    for (const char* c = value; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619;
+    }
+
+    if (var_changed(ctx, id, hash, 0)) {
+        char tx_cmd[64];
+        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_STR, var, value);
+        tx_str(ctx, tx_cmd);
+    }
+}
+
+static void set_subscribe(task_context_t* ctx, const char* var, bool subscribe)
+{
     if (!strcmp(var, VAR_STATE)) {
         ctx->var_sub.state = subscribe;
         ctx->state = EVSE_STATE_A;
     } else if (!strcmp(var, VAR_ENABLED)) {
         ctx->var_sub.enabled = subscribe;
-        if (subscribe) {
-            ctx->enabled = evse_is_enabled();
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_ENABLED, ctx->enabled);
-            tx_str(ctx->fd, tx_cmd);
-        }
     } else if (!strcmp(var, VAR_ERROR)) {
         ctx->var_sub.error = subscribe;
     } else if (!strcmp(var, VAR_PENDING_AUTH)) {
@@ -195,25 +257,10 @@ static void set_subscribe(task_context_t* ctx, const char* var, bool subscribe)
         ctx->var_sub.limit_reached = subscribe;
     } else if (!strcmp(var, VAR_CHARGING_CURRENT)) {
         ctx->var_sub.charging_current = subscribe;
-        if (subscribe) {
-            ctx->charging_current = evse_get_charging_current();
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CHARGING_CURRENT, ctx->charging_current);
-            tx_str(ctx->fd, tx_cmd);
-        }
     } else if (!strcmp(var, VAR_DEFAULT_CHARGING_CURRENT)) {
         ctx->var_sub.default_charging_current = subscribe;
-        if (subscribe) {
-            ctx->default_charging_current = evse_get_default_charging_current();
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_DEFAULT_CHARGING_CURRENT, ctx->default_charging_current);
-            tx_str(ctx->fd, tx_cmd);
-        }
     } else if (!strcmp(var, VAR_MAX_CHARGING_CURRENT)) {
         ctx->var_sub.max_charging_current = subscribe;
-        if (subscribe) {
-            ctx->max_charging_current = evse_get_max_charging_current();
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_MAX_CHARGING_CURRENT, ctx->max_charging_current);
-            tx_str(ctx->fd, tx_cmd);
-        }
     } else if (!strcmp(var, VAR_SESSION_TIME)) {
         ctx->var_sub.session_time = subscribe;
     } else if (!strcmp(var, VAR_CHARGING_TIME)) {
@@ -238,42 +285,16 @@ static void set_subscribe(task_context_t* ctx, const char* var, bool subscribe)
         ctx->var_sub.current_l3 = subscribe;
     } else if (!strcmp(var, VAR_CONSUMPTION_LIMIT)) {
         ctx->var_sub.consumption_limit = subscribe;
-        if (subscribe) {
-            ctx->consumption_limit = evse_get_consumption_limit();
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CONSUMPTION_LIMIT, ctx->consumption_limit);
-            tx_str(ctx->fd, tx_cmd);
-        }
     } else if (!strcmp(var, VAR_CHARGING_TIME_LIMIT)) {
         ctx->var_sub.charging_time_limit = subscribe;
-        ctx->charging_time_limit = evse_get_charging_time_limit();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CHARGING_TIME_LIMIT, ctx->charging_time_limit);
-        tx_str(ctx->fd, tx_cmd);
     } else if (!strcmp(var, VAR_UNDER_POWER_LIMIT)) {
-        ctx->var_sub.default_under_power_limit = subscribe;
-        if (subscribe) {
-            ctx->default_under_power_limit = evse_get_default_under_power_limit();
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_UNDER_POWER_LIMIT, ctx->default_under_power_limit);
-            tx_str(ctx->fd, tx_cmd);
-        }
+        ctx->var_sub.under_power_limit = subscribe;
     } else if (!strcmp(var, VAR_DEFAULT_CONSUMPTION_LIMIT)) {
         ctx->var_sub.default_consumption_limit = subscribe;
-        if (subscribe) {
-            ctx->default_consumption_limit = evse_get_default_consumption_limit();
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_DEFAULT_CONSUMPTION_LIMIT, ctx->default_consumption_limit);
-            tx_str(ctx->fd, tx_cmd);
-        }
     } else if (!strcmp(var, VAR_DEFAULT_CHARGING_TIME_LIMIT)) {
         ctx->var_sub.default_charging_time_limit = subscribe;
-        ctx->default_charging_time_limit = evse_get_default_charging_time_limit();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_DEFAULT_CHARGING_TIME_LIMIT, ctx->default_charging_time_limit);
-        tx_str(ctx->fd, tx_cmd);
     } else if (!strcmp(var, VAR_DEFAULT_UNDER_POWER_LIMIT)) {
         ctx->var_sub.default_under_power_limit = subscribe;
-        if (subscribe) {
-            ctx->default_under_power_limit = evse_get_default_under_power_limit();
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_DEFAULT_UNDER_POWER_LIMIT, ctx->default_under_power_limit);
-            tx_str(ctx->fd, tx_cmd);
-        }
     } else if (!strcmp(var, VAR_UPTIME)) {
         ctx->var_sub.uptime = subscribe;
     } else if (!strcmp(var, VAR_TEMPERATURE)) {
@@ -284,25 +305,18 @@ static void set_subscribe(task_context_t* ctx, const char* var, bool subscribe)
         ctx->var_sub.high_temperature = subscribe;
     } else if (!strcmp(var, VAR_IP)) {
         ctx->var_sub.ip = subscribe;
-        if (subscribe) {
-            wifi_get_ip(false, ctx->ip, sizeof(ctx->ip));
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_IP, ctx->ip);
-            tx_str(ctx->fd, tx_cmd);
-        }
     } else if (!strcmp(var, VAR_HEAP_SIZE)) {
         ctx->var_sub.heap_size = subscribe;
     } else if (!strcmp(var, VAR_MAX_HEAP_SIZE)) {
         ctx->var_sub.max_heap_size = subscribe;
     } else if (!strcmp(var, VAR_DEVICE_NAME)) {
         if (subscribe) {
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_DEVICE_NAME, board_config.device_name);
-            tx_str(ctx->fd, tx_cmd);
+            tx_var_str(ctx, VAR_ID_DEVICE_NAME, VAR_DEVICE_NAME, board_config.device_name);
         }
     } else if (!strcmp(var, VAR_APP_VERSION)) {
         if (subscribe) {
             const esp_app_desc_t* app_desc = esp_app_get_description();
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_APP_VERSION, app_desc->version);
-            tx_str(ctx->fd, tx_cmd);
+            tx_var_str(ctx, VAR_ID_APP_VERSION, VAR_APP_VERSION, app_desc->version);
         }
     } else {
         ESP_LOGW(TAG, "Unknown variable: %s", var);
@@ -321,6 +335,7 @@ static void handle_cmd(task_context_t* ctx, const uint8_t* cmd, uint8_t cmd_len)
     switch (cmd[0]) {
     case NEX_RET_BUF_OVERFLOW:
         ESP_LOGW(TAG, "Buffer overflow");
+        ctx->var_sent = 0;  // some values was lost, send all again
         vTaskDelay(pdMS_TO_TICKS(250));
         return;
     case NEX_RET_AUTO_SLEEP:
@@ -330,6 +345,7 @@ static void handle_cmd(task_context_t* ctx, const uint8_t* cmd, uint8_t cmd_len)
         return;
     case NEX_RET_READY:
         ESP_LOGI(TAG, "Display ready");
+        ctx->var_sent = 0;
         break;
     default:
         break;
@@ -348,6 +364,7 @@ static void handle_cmd(task_context_t* ctx, const uint8_t* cmd, uint8_t cmd_len)
     } else if (sscanf(rx_cmd, CMD_SUBSCRIBE, var_str) > 0) {
         ESP_LOGD(TAG, "Subscribe %s", var_str);
         ctx->sleep = false;
+        ctx->var_sent = 0;  // page was (re)loaded, send all subscribed values
         set_subscribe(ctx, var_str, true);
     } else if (sscanf(rx_cmd, CMD_ENABLED, &var_u8) > 0) {
         evse_set_enabled(var_u8);
@@ -370,173 +387,130 @@ static void handle_cmd(task_context_t* ctx, const uint8_t* cmd, uint8_t cmd_len)
 
 static void tx_vars(task_context_t* ctx)
 {
-    char tx_cmd[64];
-
     if (ctx->var_sub.state) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_STATE, evse_state_to_str(evse_get_state()));
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_str(ctx, VAR_ID_STATE, VAR_STATE, evse_state_to_str(evse_get_state()));
     }
-    if (ctx->var_sub.enabled && ctx->enabled != evse_is_enabled()) {
-        ctx->enabled = evse_is_enabled();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_ENABLED, ctx->enabled);
-        tx_str(ctx->fd, tx_cmd);
+    if (ctx->var_sub.enabled) {
+        tx_var_num(ctx, VAR_ID_ENABLED, VAR_ENABLED, evse_is_enabled(), 0);
     }
     if (ctx->var_sub.error) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_ERROR, evse_get_error());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_ERROR, VAR_ERROR, evse_get_error(), 0);
     }
     if (ctx->var_sub.pending_auth) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_PENDING_AUTH, evse_is_pending_auth());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_PENDING_AUTH, VAR_PENDING_AUTH, evse_is_pending_auth(), 0);
     }
     if (ctx->var_sub.limit_reached) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_LIMIT_REACHED, evse_is_limit_reached());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_LIMIT_REACHED, VAR_LIMIT_REACHED, evse_is_limit_reached(), 0);
     }
-    if (ctx->var_sub.charging_current && ctx->charging_current != evse_get_charging_current()) {
-        ctx->charging_current = evse_get_charging_current();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CHARGING_CURRENT, ctx->charging_current);
-        tx_str(ctx->fd, tx_cmd);
+    if (ctx->var_sub.charging_current) {
+        tx_var_num(ctx, VAR_ID_CHARGING_CURRENT, VAR_CHARGING_CURRENT, evse_get_charging_current(), 0);
     }
-    if (ctx->var_sub.max_charging_current && ctx->max_charging_current != evse_get_max_charging_current()) {
-        ctx->max_charging_current = evse_get_max_charging_current();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_MAX_CHARGING_CURRENT, ctx->max_charging_current);
-        tx_str(ctx->fd, tx_cmd);
+    if (ctx->var_sub.max_charging_current) {
+        tx_var_num(ctx, VAR_ID_MAX_CHARGING_CURRENT, VAR_MAX_CHARGING_CURRENT, evse_get_max_charging_current(), 0);
     }
-    if (ctx->var_sub.default_charging_current && ctx->default_charging_current != evse_get_default_charging_current()) {
-        ctx->default_charging_current = evse_get_default_charging_current();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_DEFAULT_CHARGING_CURRENT, ctx->default_charging_current);
-        tx_str(ctx->fd, tx_cmd);
+    if (ctx->var_sub.default_charging_current) {
+        tx_var_num(ctx, VAR_ID_DEFAULT_CHARGING_CURRENT, VAR_DEFAULT_CHARGING_CURRENT, evse_get_default_charging_current(), 0);
     }
     if (ctx->var_sub.session_time) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_SESSION_TIME, energy_meter_get_session_time());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_SESSION_TIME, VAR_SESSION_TIME, energy_meter_get_session_time(), 0);
     }
     if (ctx->var_sub.charging_time) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CHARGING_TIME, energy_meter_get_charging_time());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_CHARGING_TIME, VAR_CHARGING_TIME, energy_meter_get_charging_time(), 0);
     }
     if (ctx->var_sub.power) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_POWER, energy_meter_get_power());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_POWER, VAR_POWER, energy_meter_get_power(), DEADBAND_POWER);
     }
     if (ctx->var_sub.consumption) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CONSUMPTION, energy_meter_get_consumption());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_CONSUMPTION, VAR_CONSUMPTION, energy_meter_get_consumption(), 0);
     }
     if (ctx->var_sub.total_consumption) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_TOTAL_CONSUMPTION, energy_meter_get_total_consumption());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_TOTAL_CONSUMPTION, VAR_TOTAL_CONSUMPTION, energy_meter_get_total_consumption(), 0);
     }
     if (ctx->var_sub.voltage_l1) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_VOLTAGE_L1, (uint16_t)(energy_meter_get_l1_voltage() * 100));
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_VOLTAGE_L1, VAR_VOLTAGE_L1, (uint16_t)(energy_meter_get_l1_voltage() * 100), DEADBAND_VOLTAGE);
     }
     if (ctx->var_sub.voltage_l2) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_VOLTAGE_L2, (uint16_t)(energy_meter_get_l2_voltage() * 100));
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_VOLTAGE_L2, VAR_VOLTAGE_L2, (uint16_t)(energy_meter_get_l2_voltage() * 100), DEADBAND_VOLTAGE);
     }
     if (ctx->var_sub.voltage_l3) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_VOLTAGE_L3, (uint16_t)(energy_meter_get_l3_voltage() * 100));
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_VOLTAGE_L3, VAR_VOLTAGE_L3, (uint16_t)(energy_meter_get_l3_voltage() * 100), DEADBAND_VOLTAGE);
     }
     if (ctx->var_sub.current_l1) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CURRENT_L1, (uint16_t)(energy_meter_get_l1_current() * 100));
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_CURRENT_L1, VAR_CURRENT_L1, (uint16_t)(energy_meter_get_l1_current() * 100), DEADBAND_CURRENT);
     }
     if (ctx->var_sub.current_l2) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CURRENT_L2, (uint16_t)(energy_meter_get_l2_current() * 100));
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_CURRENT_L2, VAR_CURRENT_L2, (uint16_t)(energy_meter_get_l2_current() * 100), DEADBAND_CURRENT);
     }
     if (ctx->var_sub.current_l3) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CURRENT_L3, (uint16_t)(energy_meter_get_l3_current() * 100));
-        tx_str(ctx->fd, tx_cmd);
-    }
-    if (ctx->var_sub.consumption_limit && ctx->consumption_limit != evse_get_consumption_limit()) {
-        ctx->consumption_limit = evse_get_consumption_limit();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CONSUMPTION_LIMIT, ctx->consumption_limit);
-        tx_str(ctx->fd, tx_cmd);
-    }
-    if (ctx->var_sub.charging_time_limit && ctx->charging_time_limit != evse_get_charging_time_limit()) {
-        ctx->charging_time_limit = evse_get_charging_time_limit();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CHARGING_TIME_LIMIT, ctx->charging_time_limit);
-        tx_str(ctx->fd, tx_cmd);
-    }
-    if (ctx->var_sub.under_power_limit && ctx->under_power_limit != evse_get_under_power_limit()) {
-        ctx->under_power_limit = evse_get_under_power_limit();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_UNDER_POWER_LIMIT, ctx->under_power_limit);
-        tx_str(ctx->fd, tx_cmd);
-    }
-    if (ctx->var_sub.default_consumption_limit && ctx->default_consumption_limit != evse_get_default_consumption_limit()) {
-        ctx->default_consumption_limit = evse_get_default_consumption_limit();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CONSUMPTION_LIMIT, ctx->default_consumption_limit);
-        tx_str(ctx->fd, tx_cmd);
-    }
-    if (ctx->var_sub.default_charging_time_limit && ctx->default_charging_time_limit != evse_get_default_charging_time_limit()) {
-        ctx->default_charging_time_limit = evse_get_default_charging_time_limit();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_CHARGING_TIME_LIMIT, ctx->default_charging_time_limit);
-        tx_str(ctx->fd, tx_cmd);
-    }
-    if (ctx->var_sub.default_under_power_limit && ctx->default_under_power_limit != evse_get_default_under_power_limit()) {
-        ctx->default_under_power_limit = evse_get_default_under_power_limit();
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_UNDER_POWER_LIMIT, ctx->default_under_power_limit);
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_CURRENT_L3, VAR_CURRENT_L3, (uint16_t)(energy_meter_get_l3_current() * 100), DEADBAND_CURRENT);
+    }
+    if (ctx->var_sub.consumption_limit) {
+        tx_var_num(ctx, VAR_ID_CONSUMPTION_LIMIT, VAR_CONSUMPTION_LIMIT, evse_get_consumption_limit(), 0);
+    }
+    if (ctx->var_sub.charging_time_limit) {
+        tx_var_num(ctx, VAR_ID_CHARGING_TIME_LIMIT, VAR_CHARGING_TIME_LIMIT, evse_get_charging_time_limit(), 0);
+    }
+    if (ctx->var_sub.under_power_limit) {
+        tx_var_num(ctx, VAR_ID_UNDER_POWER_LIMIT, VAR_UNDER_POWER_LIMIT, evse_get_under_power_limit(), 0);
+    }
+    if (ctx->var_sub.default_consumption_limit) {
+        tx_var_num(ctx, VAR_ID_DEFAULT_CONSUMPTION_LIMIT, VAR_DEFAULT_CONSUMPTION_LIMIT, evse_get_default_consumption_limit(), 0);
+    }
+    if (ctx->var_sub.default_charging_time_limit) {
+        tx_var_num(ctx, VAR_ID_DEFAULT_CHARGING_TIME_LIMIT, VAR_DEFAULT_CHARGING_TIME_LIMIT, evse_get_default_charging_time_limit(), 0);
+    }
+    if (ctx->var_sub.default_under_power_limit) {
+        tx_var_num(ctx, VAR_ID_DEFAULT_UNDER_POWER_LIMIT, VAR_DEFAULT_UNDER_POWER_LIMIT, evse_get_default_under_power_limit(), 0);
     }
     if (ctx->var_sub.uptime) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_UPTIME, (uint32_t)(esp_timer_get_time() / 1000000));
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_UPTIME, VAR_UPTIME, (uint32_t)(esp_timer_get_time() / 1000000), 0);
     }
     if (ctx->var_sub.temperature) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_TEMPERATURE, temp_sensor_get_high());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_TEMPERATURE, VAR_TEMPERATURE, temp_sensor_get_high(), DEADBAND_TEMPERATURE);
     }
     if (ctx->var_sub.low_temperature) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_LOW_TEMPERATURE, temp_sensor_get_low());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_LOW_TEMPERATURE, VAR_LOW_TEMPERATURE, temp_sensor_get_low(), DEADBAND_TEMPERATURE);
     }
     if (ctx->var_sub.high_temperature) {
-        snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_HIGH_TEMPERATURE, temp_sensor_get_high());
-        tx_str(ctx->fd, tx_cmd);
+        tx_var_num(ctx, VAR_ID_HIGH_TEMPERATURE, VAR_HIGH_TEMPERATURE, temp_sensor_get_high(), DEADBAND_TEMPERATURE);
     }
     if (ctx->var_sub.ip) {
         char str[16];
         wifi_get_ip(false, str, sizeof(str));
-        if (strncmp(ctx->ip, str, 16) != 0) {
-            strncpy(ctx->ip, str, 16);
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_IP, str);
-            tx_str(ctx->fd, tx_cmd);
-        }
+        tx_var_str(ctx, VAR_ID_IP, VAR_IP, str);
     }
     if (ctx->var_sub.heap_size || ctx->var_sub.max_heap_size) {
         multi_heap_info_t heap_info;
         heap_caps_get_info(&heap_info, MALLOC_CAP_INTERNAL);
         if (ctx->var_sub.heap_size) {
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_HEAP_SIZE, heap_info.total_allocated_bytes);
-            tx_str(ctx->fd, tx_cmd);
+            tx_var_num(ctx, VAR_ID_HEAP_SIZE, VAR_HEAP_SIZE, heap_info.total_allocated_bytes, DEADBAND_HEAP_SIZE);
         }
         if (ctx->var_sub.max_heap_size) {
-            snprintf(tx_cmd, sizeof(tx_cmd), VAR_FMT_MAX_HEAP_SIZE, heap_info.total_free_bytes + heap_info.total_allocated_bytes);
-            tx_str(ctx->fd, tx_cmd);
+            tx_var_num(ctx, VAR_ID_MAX_HEAP_SIZE, VAR_MAX_HEAP_SIZE, heap_info.total_free_bytes + heap_info.total_allocated_bytes, 0);
         }
     }
 }
 
 static void nextion_task_func(void* param)
 {
-    uint8_t buf[BUF_SIZE];
-
     task_context_t context = { 0 };
-    context.fd = (int)param;
+    context.port = (uart_port_t)(intptr_t)param;
     context.mutex = xSemaphoreCreateMutex();
     vTaskSetThreadLocalStoragePointer(NULL, NEXTION_TASK_CONTEXT_INDEX, &context);
 
-    tx_str(context.fd, NEX_CMD_RESET);
-    tx_str(context.fd, NEX_CMD_WAKE);
+    // wake up on end of each received message
+    serial_port_set_pattern(context.port, 0xFF, sizeof(DELIMITER));
+
+    tx_str(&context, NEX_CMD_RESET);
+    tx_str(&context, NEX_CMD_WAKE);
+    tx_flush(&context);
 
     while (true) {
         xSemaphoreTake(context.mutex, portMAX_DELAY);
 
-        int len = read(context.fd, buf, BUF_SIZE);
+        // messages are parsed in place of receive span, incomplete message is kept for next cycle
+        const uint8_t* buf;
+        int len = serial_port_read_span(context.port, &buf);
         if (len > 0) {
             int start = 0;
             for (int i = 1; i < len - 2; i++) {
@@ -549,28 +523,36 @@ static void nextion_task_func(void* param)
                     start = i + 3;
                 }
             }
+            if (start == 0 && len >= NEXTION_TASK_RX_SPAN_SIZE) {
+                // span is full without delimiter
+                start = len;
+            }
+            serial_port_consume(context.port, start);
         }
 
         if (context.sleep) {
             evse_state_t state = evse_get_state();
             if (context.state != state) {
-                tx_str(context.fd, NEX_CMD_WAKE);
+                tx_str(&context, NEX_CMD_WAKE);
                 context.state = state;
             }
         } else {
             tx_vars(&context);
         }
 
+        // all commands of cycle at once
+        tx_flush(&context);
+
         xSemaphoreGive(context.mutex);
 
-        vTaskDelay(pdMS_TO_TICKS(50));
+        serial_port_wait(context.port, CYCLE_MS);
     }
 }
 
-TaskHandle_t nextion_task_start(int fd)
+TaskHandle_t nextion_task_start(uart_port_t port)
 {
     TaskHandle_t handle = NULL;
-    xTaskCreate(nextion_task_func, "nextion", 3 * 1024, (void*)fd, 5, &handle);
+    xTaskCreate(nextion_task_func, "nextion", 4 * 1024, (void*)port, 5, &handle);
     return handle;
 }
 
@@ -583,6 +565,7 @@ void nextion_task_stop(TaskHandle_t task)
     }
     vTaskSuspend(task);
 
+    serial_port_set_pattern(context->port, 0, 0);
     vSemaphoreDelete(context->mutex);
     vTaskDelete(task);
 }
@@ -1,19 +1,21 @@
 #ifndef NEXTION_TASK_H_
 #define NEXTION_TASK_H_
 
+#include <driver/uart.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
-#define NEXTION_TASK_RX_BUFFER_SIZE 256
+#define NEXTION_TASK_RX_BUFFER_SIZE 256
+#define NEXTION_TASK_RX_SPAN_SIZE   128
 #define NEXTION_TASK_TX_BUFFER_SIZE 0
 
 /**
  * @brief Start Nextion task
  *
- * @param file
+ * @param port uart number
  * @return TaskHandle_t
  */
-TaskHandle_t nextion_task_start(int fd);
+TaskHandle_t nextion_task_start(uart_port_t port);
 
 /**
  * @brief Stop Nextion task
@@ -4,10 +4,8 @@
 #include <driver/uart.h>
 #include <driver/uart_vfs.h>
 #include <esp_log.h>
-#include <fcntl.h>
 #include <nvs.h>
 #include <string.h>
-#include <unistd.h>
 
 #include "at_task.h"
 #include "board_config.h"
@@ -37,6 +35,7 @@ serial_mode_conf_t serial_mode_configs[] = {
         .start = logger_task_start,
         .stop = logger_task_stop,
         .rx_buffer_size = LOGGER_TASK_RX_BUFFER_SIZE,
+        .rx_span_size = LOGGER_TASK_RX_SPAN_SIZE,
         .tx_buffer_size = LOGGER_TASK_TX_BUFFER_SIZE,
     },
     {
@@ -44,6 +43,7 @@ serial_mode_conf_t serial_mode_configs[] = {
         .start = at_task_start,
         .stop = at_task_stop,
         .rx_buffer_size = AT_TASK_RX_BUFFER_SIZE,
+        .rx_span_size = AT_TASK_RX_SPAN_SIZE,
         .tx_buffer_size = AT_TASK_TX_BUFFER_SIZE,
     },
     {
@@ -51,6 +51,7 @@ serial_mode_conf_t serial_mode_configs[] = {
         .start = nextion_task_start,
         .stop = nextion_task_stop,
         .rx_buffer_size = NEXTION_TASK_RX_BUFFER_SIZE,
+        .rx_span_size = NEXTION_TASK_RX_SPAN_SIZE,
         .tx_buffer_size = NEXTION_TASK_TX_BUFFER_SIZE,
     },
     {
@@ -58,6 +59,7 @@ serial_mode_conf_t serial_mode_configs[] = {
         .start = modbus_rtu_task_start,
         .stop = modbus_rtu_task_stop,
         .rx_buffer_size = MODBUS_RTU_TASK_RX_BUFFER_SIZE,
+        .rx_span_size = MODBUS_RTU_TASK_RX_SPAN_SIZE,
         .tx_buffer_size = MODBUS_RTU_TASK_TX_BUFFER_SIZE,
     },
     {
@@ -65,6 +67,7 @@ serial_mode_conf_t serial_mode_configs[] = {
         .start = NULL,
         .stop = NULL,
         .rx_buffer_size = 256,
+        .rx_span_size = 0,
         .tx_buffer_size = 0,
     },
 };
@@ -80,15 +83,6 @@ uart_port_t serial_port_find(const char* mode_name)
     return -1;
 }
 
-int serial_fd_find(const char* mode_name)
-{
-    for (uart_port_t port = UART_NUM_0; port < UART_NUM_MAX; port++) {
-        if (serial_tasks[port].mode && strcmp(mode_name, serial_tasks[port].mode->name) == 0) return serial_tasks[port].fd;
-    }
-
-    return -1;
-}
-
 static serial_mode_conf_t* mode_config_find(const char* name)
 {
     if (!name) return NULL;
@@ -132,9 +126,9 @@ static esp_err_t serial_start(uart_port_t port, uint32_t baud_rate, uart_word_le
             return err;
         }
 
-        err = uart_driver_install(port, serial_tasks[port].mode->rx_buffer_size, serial_tasks[port].mode->tx_buffer_size, 0, NULL, 0);
+        err = serial_port_open(port, serial_tasks[port].mode->rx_buffer_size, serial_tasks[port].mode->rx_span_size, serial_tasks[port].mode->tx_buffer_size);
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "uart_driver_install() returned 0x%x", err);
+            ESP_LOGE(TAG, "serial_port_open() returned 0x%x", err);
             return err;
         }
 
@@ -151,17 +145,8 @@ static esp_err_t serial_start(uart_port_t port, uint32_t baud_rate, uart_word_le
             }
         }
 
-        char file_name[16];
-        snprintf(file_name, sizeof(file_name), "/dev/uart/%d", port);
-
-        serial_tasks[port].fd = open(file_name, O_RDWR | O_NONBLOCK);
-        if (serial_tasks[port].fd == -1) {
-            ESP_LOGE(TAG, "Cant open file %s", file_name);
-            return ESP_ERR_NOT_FOUND;
-        }
-
         if (serial_tasks[port].mode->start) {
-            serial_tasks[port].task = serial_tasks[port].mode->start(serial_tasks[port].fd);
+            serial_tasks[port].task = serial_tasks[port].mode->start(port);
         } else {
             serial_tasks[port].task = NULL;
         }
@@ -178,14 +163,9 @@ static void serial_stop(uart_port_t port)
             serial_tasks[port].task = NULL;
         }
 
-        if (serial_tasks[port].fd != -1) {
-            close(serial_tasks[port].fd);
-            serial_tasks[port].fd = -1;
-        }
-
-        esp_err_t err = uart_driver_delete(port);
+        esp_err_t err = serial_port_close(port);
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "uart_driver_delete() returned 0x%x", err);
+            ESP_LOGE(TAG, "serial_port_close() returned 0x%x", err);
         }
 
         // make sure the gpio are in virgin state, before any driver installation
@@ -203,7 +183,7 @@ void serial_init(void)
 
     for (uart_port_t port = UART_NUM_0; port < UART_NUM_MAX; port++) {
         if (board_config.serials[port].type != BOARD_CFG_SERIAL_TYPE_NONE) {
-            //  uart_vfs_dev_use_nonblocking(port);
+            // modes use serial_port directly, vfs is kept for console stdout
             uart_vfs_dev_use_driver(port);
             uart_vfs_dev_port_set_rx_line_endings(port, ESP_LINE_ENDINGS_LF);
             uart_vfs_dev_port_set_tx_line_endings(port, ESP_LINE_ENDINGS_LF);
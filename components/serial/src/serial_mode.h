@@ -13,19 +13,20 @@
 #include <freertos/task.h>
 
 #include "serial.h"
+#include "serial_port.h"
 
 typedef struct {
     const char* name;
-    TaskHandle_t (*start)(int fd);
+    TaskHandle_t (*start)(uart_port_t port);
     void (*stop)(TaskHandle_t task);
-    int rx_buffer_size;
+    int rx_buffer_size;
+    int rx_span_size;
     int tx_buffer_size;
 } serial_mode_conf_t;
 
 extern serial_mode_conf_t serial_mode_configs[];
 
 typedef struct {
-    int fd;
     TaskHandle_t task;
     serial_mode_conf_t* mode;
 } serial_task_t;
@@ -34,6 +35,4 @@ extern serial_task_t serial_tasks[UART_NUM_MAX];
 
 uart_port_t serial_port_find(const char* mode_name);
 
-int serial_fd_find(const char* mode_name);
-
 #endif /* SERIAL_MODE_H_ */
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "serial_nextion.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/queue.h>
 #include <inttypes_ext.h>
 #include <string.h>
 #include <unistd.h>
@@ -8,7 +10,12 @@
 #include "nextion_task.h"
 #include "serial_mode.h"
 
-#define BUF_SIZE 256
+#define BUF_SIZE                  256
+#define UPLOAD_TASK_STACK_SIZE    2048
+#define UPLOAD_TASK_PRIORITY      6
+#define UPLOAD_PROGRESS_PERIOD_US 1000000
+
+static const char* TAG = "serial_nextion";
 
 static const char* NEX_CMD_WAKE = "sleep=0";
 static const char* NEX_CMD_FULL_BRIGHTNESS = "dims=100";
@@ -19,10 +26,41 @@ static uart_port_t port;
 
 static bool upload_first_chunk;
 
+typedef struct {
+    const char* data;
+    uint16_t len;
+} upload_chunk_t;
+
+typedef struct {
+    esp_err_t err;
+    size_t skip_to;
+} upload_ack_t;
+
+static TaskHandle_t upload_task = NULL;
+
+static QueueHandle_t upload_chunk_queue = NULL;
+
+static QueueHandle_t upload_ack_queue = NULL;
+
+static bool upload_pending = false;
+
+static size_t upload_file_size;
+
+static size_t upload_offset;
+
+static uint16_t upload_sent_len;
+
+static int64_t upload_start_time;
+
+static int64_t upload_log_time;
+
 static void tx_str(const char* cmd)
 {
-    uart_write_bytes(port, cmd, strlen(cmd));
-    uart_write_bytes(port, DELIMITER, sizeof(DELIMITER));
+    serial_port_iov_t iov[] = {
+        { .data = cmd, .len = strlen(cmd) },
+        { .data = DELIMITER, .len = sizeof(DELIMITER) },
+    };
+    serial_port_writev(port, iov, sizeof(iov) / sizeof(iov[0]));
 }
 
 esp_err_t serial_nextion_get_info(serial_nextion_info_t* info)
@@ -103,12 +141,74 @@ static size_t upload_read_skip_to(void)
     return 0;
 }
 
+/**
+ * Transmit chunks and read acknowledges, so uart transfer and flashing run while caller receives next chunk
+ */
+static void upload_task_func(void* param)
+{
+    upload_chunk_t chunk;
+
+    while (xQueueReceive(upload_chunk_queue, &chunk, portMAX_DELAY)) {
+        upload_ack_t ack = {
+            .err = ESP_OK,
+            .skip_to = 0,
+        };
+
+        if (chunk.data == NULL) {
+            // stop request
+            xQueueSend(upload_ack_queue, &ack, portMAX_DELAY);
+            break;
+        }
+
+        serial_port_write(port, chunk.data, chunk.len);
+
+        switch (upload_read_response()) {
+        case 0x05:
+            break;
+        case 0x08:
+            ack.skip_to = upload_read_skip_to();
+            break;
+        default:
+            ack.err = ESP_ERR_INVALID_STATE;
+            break;
+        }
+
+        xQueueSend(upload_ack_queue, &ack, portMAX_DELAY);
+    }
+
+    vTaskDelete(NULL);
+}
+
+static uint32_t upload_rate(int64_t now)
+{
+    int64_t elapsed = now - upload_start_time;
+
+    return elapsed > 0 ? (uint64_t)upload_offset * 1000000 / elapsed : 0;
+}
+
+static void upload_log_progress(bool force)
+{
+    int64_t now = esp_timer_get_time();
+    if (!force && now - upload_log_time < UPLOAD_PROGRESS_PERIOD_US) return;
+    upload_log_time = now;
+
+    uint32_t rate = upload_rate(now);
+    int percent = upload_file_size > 0 ? (uint64_t)upload_offset * 100 / upload_file_size : 100;
+
+    ESP_LOGI(TAG, "Upload %" PRIuSIZE "/%" PRIuSIZE " bytes (%d%%), %" PRIu32 " B/s", upload_offset, upload_file_size, percent, rate);
+}
+
 esp_err_t serial_nextion_upload_begin(size_t file_size, uint32_t baud_rate)
 {
     port = serial_port_find(SERIAL_MODE_NEXTION_NAME);
 
     if (port == -1) return ESP_ERR_NOT_FOUND;
 
+    if (!upload_chunk_queue) {
+        upload_chunk_queue = xQueueCreate(1, sizeof(upload_chunk_t));
+        upload_ack_queue = xQueueCreate(1, sizeof(upload_ack_t));
+    }
+
     nextion_task_stop(serial_tasks[port].task);
     serial_tasks[port].task = NULL;
 
@@ -132,30 +232,62 @@ esp_err_t serial_nextion_upload_begin(size_t file_size, uint32_t baud_rate)
     }
 
     upload_first_chunk = true;
+    upload_pending = false;
+    upload_file_size = file_size;
+    upload_offset = 0;
+    upload_start_time = esp_timer_get_time();
+    upload_log_time = upload_start_time;
+
+    if (xTaskCreate(upload_task_func, "nextion_upload", UPLOAD_TASK_STACK_SIZE, NULL, UPLOAD_TASK_PRIORITY, &upload_task) != pdPASS) {
+        upload_task = NULL;
+        serial_nextion_upload_end();
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Upload started, %" PRIuSIZE " bytes at %" PRIu32 " baud", file_size, baud_rate);
+
+    return ESP_OK;
+}
+
+esp_err_t serial_nextion_upload_send(const char* data, uint16_t len)
+{
+    if (port == -1) return ESP_ERR_NOT_FOUND;
+
+    if (upload_pending) return ESP_ERR_INVALID_STATE;
+
+    upload_chunk_t chunk = {
+        .data = data,
+        .len = len,
+    };
+    xQueueSend(upload_chunk_queue, &chunk, portMAX_DELAY);
+
+    upload_pending = true;
+    upload_sent_len = len;
 
     return ESP_OK;
 }
 
-esp_err_t serial_nextion_upload_write(char* data, uint16_t len, size_t* skip_to)
+esp_err_t serial_nextion_upload_wait(size_t* skip_to)
 {
     if (port == -1) return ESP_ERR_NOT_FOUND;
 
-    uart_write_bytes(port, data, len);
+    if (!upload_pending) return ESP_ERR_INVALID_STATE;
 
-    switch (upload_read_response()) {
-    case 0x05:
-        *skip_to = 0;
-        break;
-    case 0x08:
-        *skip_to = upload_read_skip_to();
-        break;
-    default:
+    upload_ack_t ack;
+    xQueueReceive(upload_ack_queue, &ack, portMAX_DELAY);
+    upload_pending = false;
+
+    if (ack.err != ESP_OK) {
         serial_nextion_upload_end();
-        return ESP_ERR_INVALID_STATE;
+        return ack.err;
     }
 
+    *skip_to = ack.skip_to;
+    upload_offset = ack.skip_to > upload_offset ? ack.skip_to : upload_offset + upload_sent_len;
     upload_first_chunk = false;
 
+    upload_log_progress(false);
+
     return ESP_OK;
 }
 
@@ -163,6 +295,26 @@ esp_err_t serial_nextion_upload_end(void)
 {
     if (port == -1) return ESP_ERR_NOT_FOUND;
 
+    if (upload_pending) {
+        // drop acknowledge of chunk in flight
+        upload_ack_t ack;
+        xQueueReceive(upload_ack_queue, &ack, portMAX_DELAY);
+        upload_pending = false;
+    }
+
+    if (upload_task) {
+        upload_chunk_t chunk = {
+            .data = NULL,
+            .len = 0,
+        };
+        upload_ack_t ack;
+        xQueueSend(upload_chunk_queue, &chunk, portMAX_DELAY);
+        xQueueReceive(upload_ack_queue, &ack, portMAX_DELAY);
+        upload_task = NULL;
+
+        upload_log_progress(true);
+    }
+
     uart_wait_tx_done(port, pdMS_TO_TICKS(1000));
 
     int baud_rate = serial_get_baud_rate(port);
@@ -170,7 +322,18 @@ esp_err_t serial_nextion_upload_end(void)
     uart_get_baudrate(port, &curr_baud_rate);
     if (curr_baud_rate != baud_rate) uart_set_baudrate(port, baud_rate);
 
-    serial_tasks[port].task = nextion_task_start(serial_tasks[port].fd);
+    serial_tasks[port].task = nextion_task_start(port);
 
     return ESP_OK;
 }
+
+bool serial_nextion_get_upload_progress(serial_nextion_upload_progress_t* progress)
+{
+    if (!upload_task) return false;
+
+    progress->file_size = upload_file_size;
+    progress->offset = upload_offset;
+    progress->rate = upload_rate(esp_timer_get_time());
+
+    return true;
+}
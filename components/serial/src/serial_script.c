@@ -1,59 +1,70 @@
 #include "serial_script.h"
 
 #include <esp_log.h>
-#include <sys/param.h>
-#include <unistd.h>
 
 #include "serial_mode.h"
 
+#define FLUSH_TIMEOUT_MS 1000
+
 static const char* TAG = "serial_script";
 
 bool serial_script_is_available(void)
 {
-    int fd = serial_fd_find(SERIAL_MODE_SCRIPT_NAME);
+    uart_port_t port = serial_port_find(SERIAL_MODE_SCRIPT_NAME);
 
-    return fd != -1;
+    return port != -1;
 }
 
 esp_err_t serial_script_write(const char* buf, size_t len)
 {
-    int fd = serial_fd_find(SERIAL_MODE_SCRIPT_NAME);
+    uart_port_t port = serial_port_find(SERIAL_MODE_SCRIPT_NAME);
 
-    if (fd == -1) {
+    if (port == -1) {
         ESP_LOGW(TAG, "No script serial available");
         return ESP_ERR_NOT_FOUND;
     }
 
-    write(fd, buf, len);
+    serial_port_write(port, buf, len);
 
     return ESP_OK;
 }
 
 esp_err_t serial_script_flush(void)
 {
-    int fd = serial_fd_find(SERIAL_MODE_SCRIPT_NAME);
+    uart_port_t port = serial_port_find(SERIAL_MODE_SCRIPT_NAME);
 
-    if (fd == -1) {
+    if (port == -1) {
         ESP_LOGW(TAG, "No script serial available");
         return ESP_ERR_NOT_FOUND;
     }
 
-    fsync(fd);
+    serial_port_flush(port, FLUSH_TIMEOUT_MS);
 
     return ESP_OK;
 }
 
 esp_err_t serial_script_read(char* buf, size_t* len)
 {
-    int fd = serial_fd_find(SERIAL_MODE_SCRIPT_NAME);
+    uart_port_t port = serial_port_find(SERIAL_MODE_SCRIPT_NAME);
 
-    if (fd == -1) {
+    if (port == -1) {
         ESP_LOGW(TAG, "No script serial available");
         return ESP_ERR_NOT_FOUND;
     }
 
-    int readed = read(fd, buf, *len);
-    *len = MAX(0, readed);
+    *len = serial_port_read(port, buf, *len);
 
     return ESP_OK;
+}
+
+bool serial_script_wait_read(uint32_t timeout)
+{
+    uart_port_t port = serial_port_find(SERIAL_MODE_SCRIPT_NAME);
+
+    if (port == -1) {
+        vTaskDelay(pdMS_TO_TICKS(timeout));
+        return false;
+    }
+
+    return serial_port_wait(port, timeout) != SERIAL_PORT_EVENT_NONE;
 }
\ No newline at end of file
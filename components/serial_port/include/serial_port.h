@@ -0,0 +1,125 @@
+#ifndef SERIAL_PORT_H_
+#define SERIAL_PORT_H_
+
+#include <driver/uart.h>
+#include <esp_err.h>
+
+typedef enum {
+    SERIAL_PORT_EVENT_NONE,
+    SERIAL_PORT_EVENT_DATA,
+    SERIAL_PORT_EVENT_PATTERN,
+    SERIAL_PORT_EVENT_OVERFLOW,
+} serial_port_event_t;
+
+typedef struct {
+    const void* data;
+    size_t len;
+} serial_port_iov_t;
+
+/**
+ * @brief Install uart driver with event queue and allocate receive span buffer
+ *
+ * Span buffer is not driver ring buffer, received data are copied to it by single bulk read,
+ * it should be smaller than driver ring buffer, sized to longest message parsed in place
+ *
+ * @param port uart number
+ * @param rx_buffer_size size of driver receive ring buffer
+ * @param rx_span_size size of span buffer, zero when only serial_port_read is used
+ * @param tx_buffer_size size of driver transmit ring buffer, zero for blocking writes
+ * @return esp_err_t
+ */
+esp_err_t serial_port_open(uart_port_t port, int rx_buffer_size, int rx_span_size, int tx_buffer_size);
+
+/**
+ * @brief Delete uart driver and free span buffer
+ *
+ * @param port uart number
+ * @return esp_err_t
+ */
+esp_err_t serial_port_close(uart_port_t port);
+
+/**
+ * @brief Enable pattern detection, SERIAL_PORT_EVENT_PATTERN is reported when pattern is received
+ *
+ * @param port uart number
+ * @param chr pattern character
+ * @param count count of repeated pattern characters, zero disable detection
+ * @return esp_err_t
+ */
+esp_err_t serial_port_set_pattern(uart_port_t port, uint8_t chr, uint8_t count);
+
+/**
+ * @brief Wait for driver event, returns immediately when driver has unread data
+ *
+ * Queued events of already read data are dropped, data kept in span are not reported
+ *
+ * @param port uart number
+ * @param timeout_ms
+ * @return serial_port_event_t SERIAL_PORT_EVENT_NONE on timeout
+ */
+serial_port_event_t serial_port_wait(uart_port_t port, uint32_t timeout_ms);
+
+/**
+ * @brief Get received data in span buffer, not consumed data from previous call are at start of span
+ *
+ * Span is refilled from driver ring buffer up to rx_span_size, it is valid until next call,
+ * consumer must call serial_port_consume with processed length,
+ * when span is full and no data can be processed, consumer should drop it
+ *
+ * @param port uart number
+ * @param data span start
+ * @return size_t span length
+ */
+size_t serial_port_read_span(uart_port_t port, const uint8_t** data);
+
+/**
+ * @brief Release processed data from start of span
+ *
+ * @param port uart number
+ * @param len
+ */
+void serial_port_consume(uart_port_t port, size_t len);
+
+/**
+ * @brief Copy received data, without waiting
+ *
+ * @param port uart number
+ * @param buf
+ * @param len
+ * @return size_t copied length
+ */
+size_t serial_port_read(uart_port_t port, void* buf, size_t len);
+
+/**
+ * @brief Write data
+ *
+ * @param port uart number
+ * @param data
+ * @param len
+ * @return int written length, -1 on error
+ */
+int serial_port_write(uart_port_t port, const void* data, size_t len);
+
+/**
+ * @brief Write data from multiple buffers
+ *
+ * Driver has no gather write, buffers are written one by one without intermediate copy,
+ * write of other task to same port can be placed between them
+ *
+ * @param port uart number
+ * @param iov
+ * @param iov_count
+ * @return int written length, -1 on error
+ */
+int serial_port_writev(uart_port_t port, const serial_port_iov_t* iov, int iov_count);
+
+/**
+ * @brief Wait until all data are transmitted
+ *
+ * @param port uart number
+ * @param timeout_ms
+ * @return esp_err_t
+ */
+esp_err_t serial_port_flush(uart_port_t port, uint32_t timeout_ms);
+
+#endif /* SERIAL_PORT_H_ */
@@ -0,0 +1,247 @@
+#include "serial_port.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#define EVENT_QUEUE_SIZE   16
+#define PATTERN_QUEUE_SIZE 16
+#define PATTERN_CHR_TOUT   9
+
+/**
+ * Span buffer is filled by bulk copy from driver ring buffer, it is used by task of serial mode and by script task,
+ * which read it while watcher task waits for events
+ */
+typedef struct {
+    SemaphoreHandle_t mutex;
+    QueueHandle_t event_queue;
+    uint8_t* rx_buf;
+    size_t rx_buf_size;
+    size_t rx_pos;  // start of not consumed data
+    size_t rx_len;  // end of received data
+} port_context_t;
+
+static port_context_t contexts[UART_NUM_MAX];
+
+esp_err_t serial_port_open(uart_port_t port, int rx_buffer_size, int rx_span_size, int tx_buffer_size)
+{
+    port_context_t* ctx = &contexts[port];
+
+    if (!ctx->mutex) {
+        // kept for lifetime, script task may wait on it while port is closed
+        ctx->mutex = xSemaphoreCreateMutex();
+        if (!ctx->mutex) return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    esp_err_t err = ESP_OK;
+    if (rx_span_size > 0) {
+        ctx->rx_buf = (uint8_t*)malloc(rx_span_size);
+        if (!ctx->rx_buf) err = ESP_ERR_NO_MEM;
+    }
+    ctx->rx_buf_size = ctx->rx_buf ? rx_span_size : 0;
+    ctx->rx_pos = 0;
+    ctx->rx_len = 0;
+
+    if (err == ESP_OK) {
+        err = uart_driver_install(port, rx_buffer_size, tx_buffer_size, EVENT_QUEUE_SIZE, &ctx->event_queue, 0);
+        if (err != ESP_OK) {
+            free((void*)ctx->rx_buf);
+            ctx->rx_buf = NULL;
+            ctx->rx_buf_size = 0;
+        }
+    }
+
+    xSemaphoreGive(ctx->mutex);
+
+    return err;
+}
+
+esp_err_t serial_port_close(uart_port_t port)
+{
+    port_context_t* ctx = &contexts[port];
+
+    if (!ctx->mutex) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    esp_err_t err = uart_driver_delete(port);
+
+    free((void*)ctx->rx_buf);
+    ctx->rx_buf = NULL;
+    ctx->rx_buf_size = 0;
+    ctx->rx_pos = 0;
+    ctx->rx_len = 0;
+    ctx->event_queue = NULL;
+
+    xSemaphoreGive(ctx->mutex);
+
+    return err;
+}
+
+esp_err_t serial_port_set_pattern(uart_port_t port, uint8_t chr, uint8_t count)
+{
+    if (count == 0) {
+        return uart_disable_pattern_det_intr(port);
+    }
+
+    esp_err_t err = uart_enable_pattern_det_baud_intr(port, (char)chr, count, PATTERN_CHR_TOUT, 0, 0);
+    if (err != ESP_OK) return err;
+
+    return uart_pattern_queue_reset(port, PATTERN_QUEUE_SIZE);
+}
+
+/**
+ * Handle overflow of driver buffer, driver stops receiving until buffer is read, already returned span stays valid
+ */
+static serial_port_event_t handle_overflow(uart_port_t port, port_context_t* ctx)
+{
+    uart_flush_input(port);
+    xQueueReset(ctx->event_queue);
+
+    return SERIAL_PORT_EVENT_OVERFLOW;
+}
+
+serial_port_event_t serial_port_wait(uart_port_t port, uint32_t timeout_ms)
+{
+    port_context_t* ctx = &contexts[port];
+
+    if (!ctx->event_queue) return SERIAL_PORT_EVENT_NONE;
+
+    // events of data, which were already read, would wake up next wait without new data
+    bool pattern = false;
+    uart_event_t event;
+    while (xQueueReceive(ctx->event_queue, &event, 0)) {
+        if (event.type == UART_PATTERN_DET) {
+            pattern = true;
+        } else if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+            return handle_overflow(port, ctx);
+        }
+    }
+
+    size_t buffered = 0;
+    if (uart_get_buffered_data_len(port, &buffered) == ESP_OK && buffered > 0) {
+        return pattern ? SERIAL_PORT_EVENT_PATTERN : SERIAL_PORT_EVENT_DATA;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    TickType_t elapsed = 0;
+
+    while (xQueueReceive(ctx->event_queue, &event, timeout - elapsed)) {
+        switch (event.type) {
+        case UART_DATA:
+            return SERIAL_PORT_EVENT_DATA;
+        case UART_PATTERN_DET:
+            return SERIAL_PORT_EVENT_PATTERN;
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            return handle_overflow(port, ctx);
+        default:
+            // line errors are not reported
+            break;
+        }
+
+        elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) break;
+    }
+
+    return SERIAL_PORT_EVENT_NONE;
+}
+
+size_t serial_port_read_span(uart_port_t port, const uint8_t** data)
+{
+    port_context_t* ctx = &contexts[port];
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    if (ctx->rx_pos > 0) {
+        // move not consumed data to start, so span is contiguous
+        memmove(ctx->rx_buf, &ctx->rx_buf[ctx->rx_pos], ctx->rx_len - ctx->rx_pos);
+        ctx->rx_len -= ctx->rx_pos;
+        ctx->rx_pos = 0;
+    }
+
+    size_t buffered = 0;
+    uart_get_buffered_data_len(port, &buffered);
+    if (buffered > 0 && ctx->rx_len < ctx->rx_buf_size) {
+        int len = uart_read_bytes(port, &ctx->rx_buf[ctx->rx_len], MIN(buffered, ctx->rx_buf_size - ctx->rx_len), 0);
+        if (len > 0) ctx->rx_len += len;
+
+        // pattern is used only as wake up event, positions must not fill the queue
+        while (uart_pattern_pop_pos(port) != -1) {
+        }
+    }
+
+    *data = ctx->rx_buf;
+    size_t len = ctx->rx_len;
+
+    xSemaphoreGive(ctx->mutex);
+
+    return len;
+}
+
+void serial_port_consume(uart_port_t port, size_t len)
+{
+    port_context_t* ctx = &contexts[port];
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->rx_pos = MIN(ctx->rx_pos + len, ctx->rx_len);
+    xSemaphoreGive(ctx->mutex);
+}
+
+size_t serial_port_read(uart_port_t port, void* buf, size_t len)
+{
+    port_context_t* ctx = &contexts[port];
+
+    if (!ctx->mutex) return 0;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    // not consumed span data first
+    size_t copied = MIN(len, ctx->rx_len - ctx->rx_pos);
+    if (copied > 0) {
+        memcpy(buf, &ctx->rx_buf[ctx->rx_pos], copied);
+        ctx->rx_pos += copied;
+    }
+
+    if (copied < len && ctx->event_queue) {
+        int readed = uart_read_bytes(port, (uint8_t*)buf + copied, len - copied, 0);
+        if (readed > 0) copied += readed;
+    }
+
+    xSemaphoreGive(ctx->mutex);
+
+    return copied;
+}
+
+int serial_port_write(uart_port_t port, const void* data, size_t len)
+{
+    return uart_write_bytes(port, data, len);
+}
+
+int serial_port_writev(uart_port_t port, const serial_port_iov_t* iov, int iov_count)
+{
+    int written = 0;
+
+    // driver has no gather write, each segment is copied to driver separately
+
+    for (int i = 0; i < iov_count; i++) {
+        if (iov[i].len == 0) continue;
+
+        int len = uart_write_bytes(port, iov[i].data, iov[i].len);
+        if (len < 0) return -1;
+        written += len;
+    }
+
+    return written;
+}
+
+esp_err_t serial_port_flush(uart_port_t port, uint32_t timeout_ms)
+{
+    return uart_wait_tx_done(port, pdMS_TO_TICKS(timeout_ms));
+}
@@ -0,0 +1,232 @@
+/*
+Host throughput benchmark of the AT parser over a pseudo-tty.
+
+Parser is served in the same way as components/at/src/at_task.c, either with per-char
+read/write syscalls and linear command search (char mode) or with block io buffers and
+commands hash index (buffered mode). Client pipelines read commands and counts responses.
+
+Build & run:
+  gcc -O2 -I libs/cat/include libs/cat/src/cat.c libs/cat/bench/cat_pty_bench.c -o cat_pty_bench -lutil -lpthread
+  ./cat_pty_bench char 20000
+  ./cat_pty_bench buffered 20000
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <pty.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cat.h"
+
+#define IO_BUF_SIZE 128
+#define CMD_INDEX_SIZE 128
+
+static const char *names[] = {
+        "+CMD", "E0", "E1", "+SUB", "+UNSUB", "+SERIALS", "+AUXINPUTS", "+AUXOUPUTS", "+AUXANALOGINPUTS", "+DEVNAME",
+        "+SOCKETLOCK", "+SOCKETLOCKMINBREAKTIME", "+PROXIMITY", "+TEMPSENSOR", "+EMETER", "+EMETERMODE", "+EMETERACVOLTAGE",
+        "+EMETERTHREEPHASE", "+EMETERPOWER", "+EMETERSESTIME", "+EMETERCHTIME", "+EMETERCONSUM", "+EMETERTOTCONSUM",
+        "+EMETERVOLTAGE", "+EMETERCURRENT", "+STATE", "+ERROR", "+ENABLE", "+AVAILABLE", "+REQAUTH", "+PENDAUTH", "+AUTH",
+        "+CHCUR", "+DEFCHCUR", "+MAXCHCUR", "+CONSUMLIM", "+DEFCONSUMLIM", "+CHTIMELIM", "+DEFCHTIMELIM", "+UNDERPOWERLIM",
+        "+DEFUNDERPOWERLIM", "+LIMREACH", "+SOCKETOUTLET", "+WIFIAPSCAN", "+WIFISTACFG", "+WIFIAPCFG", "+WIFISTACONN",
+        "+WIFIAPCONN", "+WIFISTASTATIC", "+WIFISTAIP", "+WIFISTAMAC", "+WIFIAPIP", "+WIFIAPMAC", "+HOSTNAME", "+INSTNAME",
+        "+SERIAL0", "+SERIAL1", "+SERIAL2", "+RST", "+CHIP", "+HEAP", "+VER", "+IDFVER", "+BUILDTIME", "+TEMP", "+TZ",
+        "+TZRULE", "+TIME", "+UPTIME", "+SYSLOG",
+};
+
+#define CMD_NUM (sizeof(names) / sizeof(names[0]))
+
+static struct cat_command commands[CMD_NUM];
+static struct cat_command_group group = {.cmd = commands, .cmd_num = CMD_NUM};
+static struct cat_command_group *groups[] = {&group};
+
+static bool buffered;
+static int fd;
+static volatile bool running = true;
+
+static char rx_buf[IO_BUF_SIZE];
+static size_t rx_pos, rx_len;
+static char tx_buf[IO_BUF_SIZE];
+static size_t tx_len;
+
+static cat_return_state cmd_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size)
+{
+        *data_size += snprintf((char *)data + *data_size, max_data_size - *data_size, "%s,0123456789abcdef0123456789abcdef", cmd->name);
+        return CAT_RETURN_STATE_DATA_OK;
+}
+
+static void flush_tx(void)
+{
+        size_t pos = 0;
+        while (pos < tx_len) {
+                ssize_t len = write(fd, &tx_buf[pos], tx_len - pos);
+                if (len > 0) {
+                        pos += len;
+                } else if (len < 0 && errno == EAGAIN) {
+                        fd_set write_set;
+                        FD_ZERO(&write_set);
+                        FD_SET(fd, &write_set);
+                        select(fd + 1, NULL, &write_set, NULL, NULL);
+                } else {
+                        break;
+                }
+        }
+        tx_len = 0;
+}
+
+static int write_char(char ch)
+{
+        if (!buffered)
+                return write(fd, &ch, 1);
+
+        if (tx_len >= sizeof(tx_buf))
+                flush_tx();
+        tx_buf[tx_len++] = ch;
+        return 1;
+}
+
+static int read_char(char *ch)
+{
+        if (!buffered)
+                return read(fd, ch, 1) > 0 ? 1 : 0;
+
+        if (rx_pos >= rx_len) {
+                ssize_t len = read(fd, rx_buf, sizeof(rx_buf));
+                rx_pos = 0;
+                rx_len = len > 0 ? len : 0;
+                if (rx_len == 0)
+                        return 0;
+        }
+        *ch = rx_buf[rx_pos++];
+        return 1;
+}
+
+static void *parser_thread(void *param)
+{
+        uint8_t buf[256];
+        uint16_t cmd_index[CMD_INDEX_SIZE];
+        struct cat_descriptor desc = {
+                .cmd_group = groups,
+                .cmd_group_num = 1,
+                .buf = buf,
+                .buf_size = sizeof(buf),
+                .cmd_index = buffered ? cmd_index : NULL,
+                .cmd_index_size = CMD_INDEX_SIZE,
+        };
+        struct cat_io_interface iface = {.read = read_char, .write = write_char};
+        struct cat_object at;
+
+        cat_init(&at, &desc, &iface, NULL);
+
+        while (running) {
+                bool readable = rx_pos < rx_len;
+                if (!readable) {
+                        struct timeval tv = {.tv_sec = 0, .tv_usec = 10 * 1000};
+                        fd_set read_set;
+                        FD_ZERO(&read_set);
+                        FD_SET(fd, &read_set);
+                        readable = select(fd + 1, &read_set, NULL, NULL, &tv) > 0;
+                }
+                if (readable) {
+                        while (cat_service(&at) != 0) {
+                        };
+                }
+                flush_tx();
+        }
+
+        return NULL;
+}
+
+static int client_fd;
+static size_t total;
+
+static void *writer_thread(void *param)
+{
+        char line[64];
+        size_t i;
+
+        for (i = 0; i < total; i++) {
+                int len = snprintf(line, sizeof(line), "AT%s?\n", names[i % CMD_NUM]);
+                if (write(client_fd, line, len) != len)
+                        break;
+        }
+
+        return NULL;
+}
+
+static void set_raw(int tty_fd)
+{
+        struct termios tio;
+        tcgetattr(tty_fd, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(tty_fd, TCSANOW, &tio);
+}
+
+int main(int argc, char **argv)
+{
+        int master, slave;
+        size_t i, ok = 0, errors = 0, bytes = 0;
+        char buf[4096], tail[4] = {0};
+        pthread_t parser, writer;
+        struct timespec start, end;
+
+        if (argc < 2) {
+                fprintf(stderr, "usage: %s char|buffered [commands]\n", argv[0]);
+                return 1;
+        }
+        buffered = strcmp(argv[1], "buffered") == 0;
+        total = argc > 2 ? strtoul(argv[2], NULL, 10) : 10000;
+
+        for (i = 0; i < CMD_NUM; i++) {
+                commands[i].name = names[i];
+                commands[i].read = cmd_read;
+        }
+
+        if (openpty(&master, &slave, NULL, NULL, NULL) != 0) {
+                perror("openpty");
+                return 1;
+        }
+        set_raw(master);
+        set_raw(slave);
+        fd = slave;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        client_fd = master;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        pthread_create(&parser, NULL, parser_thread, NULL);
+        pthread_create(&writer, NULL, writer_thread, NULL);
+
+        while (ok + errors < total) {
+                ssize_t len = read(master, buf, sizeof(buf));
+                if (len <= 0)
+                        break;
+                bytes += len;
+                for (ssize_t j = 0; j < len; j++) {
+                        // sliding window over response stream, OK or ERROR line end
+                        memmove(tail, tail + 1, 2);
+                        tail[2] = buf[j];
+                        if (memcmp(tail, "OK\n", 3) == 0)
+                                ok++;
+                        else if (memcmp(tail, "OR\n", 3) == 0)
+                                errors++;
+                }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        running = false;
+        pthread_join(writer, NULL);
+        pthread_join(parser, NULL);
+
+        double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%s: %zu commands (%zu errors), %zu bytes in %.3f s, %.0f commands/s, %.0f KiB/s\n", argv[1], ok, errors, bytes, secs,
+               ok / secs, bytes / secs / 1024);
+
+        return errors > 0 ? 1 : 0;
+}
@@ -232,7 +232,6 @@ typedef enum {
         CAT_STATE_IDLE,
         CAT_STATE_PARSE_PREFIX,
         CAT_STATE_PARSE_COMMAND_CHAR,
-        CAT_STATE_UPDATE_COMMAND_STATE,
         CAT_STATE_WAIT_READ_ACKNOWLEDGE,
         CAT_STATE_SEARCH_COMMAND,
         CAT_STATE_COMMAND_FOUND,
@@ -319,6 +318,11 @@ struct cat_descriptor {
         /* then the buf will be divided into two smaller buffers */
         uint8_t *unsolicited_buf; /* pointer to unsolicited working buffer (used to parse command argument) */
         size_t unsolicited_buf_size; /* unsolicited working buffer length */
+
+        /* optional command names hash index, if not configured (NULL) */
+        /* then commands are searched linearly, size must be power of two greater than number of commands */
+        uint16_t *cmd_index; /* pointer to hash index table (filled by cat_init) */
+        size_t cmd_index_size; /* hash index table entries count */
 };
 
 /* strcuture with unsolicited command buffered infos */
@@ -376,7 +380,7 @@ struct cat_object {
         struct cat_mutex_interface const *mutex; /* pointer to at command parser mutex interface */
 
         size_t index; /* index used to iterate over commands and variables */
-        size_t partial_cntr; /* partial match commands counter */
+        size_t partial_cntr; /* partial match commands counter (linear search) */
         size_t length; /* length of input command name and command arguments */
         size_t position; /* position of actually parsed char in arguments string */
         size_t write_size; /* size of parsed buffer hex or buffer string */
@@ -28,9 +28,10 @@ SOFTWARE.
 #include <assert.h>
 #include <inttypes.h>   //Add support 64 bit decimal
 
-#define CAT_CMD_STATE_NOT_MATCH (0)
-#define CAT_CMD_STATE_PARTIAL_MATCH (1U)
-#define CAT_CMD_STATE_FULL_MATCH (2U)
+#define CAT_CMD_INDEX_EMPTY (0)
+
+#define CAT_HASH_OFFSET (2166136261U)
+#define CAT_HASH_PRIME (16777619U)
 
 #define CAT_WRITE_STATE_BEFORE (0)
 #define CAT_WRITE_STATE_MAIN_BUFFER (1U)
@@ -489,6 +490,126 @@ static struct cat_command const* get_command_by_index(struct cat_object *self, s
         return NULL;
 }
 
+static bool is_command_disable(struct cat_object *self, size_t index)
+{
+        size_t i, j;
+        struct cat_command_group const *cmd_group;
+
+        assert(self != NULL);
+        assert(index < self->commands_num);
+
+        j = 0;
+        for (i = 0; i < self->desc->cmd_group_num; i++) {
+                cmd_group = self->desc->cmd_group[i];
+
+                if (index >= j + cmd_group->cmd_num) {
+                        j += cmd_group->cmd_num;
+                        continue;
+                }
+
+                if (cmd_group->disable != false)
+                        return true;
+
+                if (cmd_group->cmd[index - j].disable != false)
+                        return true;
+        }
+        
+        return false;
+}
+
+static uint32_t hash_command_name(const char *name, size_t length)
+{
+        uint32_t hash = CAT_HASH_OFFSET;
+        size_t i;
+
+        /* case insensitive, same slot for parser (upper case) and api lookups */
+        for (i = 0; i < length; i++)
+                hash = (hash ^ (uint8_t)to_upper(name[i])) * CAT_HASH_PRIME;
+
+        return hash;
+}
+
+static void build_command_index(struct cat_object *self)
+{
+        size_t i, slot, mask;
+        struct cat_command const *cmd;
+
+        assert(self != NULL);
+
+        if (self->desc->cmd_index == NULL)
+                return;
+
+        assert(self->desc->cmd_index_size > self->commands_num);
+        assert((self->desc->cmd_index_size & (self->desc->cmd_index_size - 1)) == 0);
+        assert(self->commands_num < UINT16_MAX);
+
+        mask = self->desc->cmd_index_size - 1;
+        memset(self->desc->cmd_index, CAT_CMD_INDEX_EMPTY, self->desc->cmd_index_size * sizeof(uint16_t));
+
+        for (i = 0; i < self->commands_num; i++) {
+                cmd = get_command_by_index(self, i);
+                slot = hash_command_name(cmd->name, strlen(cmd->name)) & mask;
+                while (self->desc->cmd_index[slot] != CAT_CMD_INDEX_EMPTY)
+                        slot = (slot + 1) & mask;
+                self->desc->cmd_index[slot] = i + 1;
+        }
+}
+
+static bool is_command_name_prefix(const char *cmd_name, const char *name, size_t length, bool ignore_case)
+{
+        size_t i;
+
+        for (i = 0; i < length; i++) {
+                if (cmd_name[i] == 0)
+                        return false;
+                if ((ignore_case != false) ? (to_upper(cmd_name[i]) != name[i]) : (cmd_name[i] != name[i]))
+                        return false;
+        }
+
+        return true;
+}
+
+static bool is_command_name_equal(const char *cmd_name, const char *name, size_t length, bool ignore_case)
+{
+        return (is_command_name_prefix(cmd_name, name, length, ignore_case) != false) && (cmd_name[length] == 0);
+}
+
+/**
+ * Find command with exactly matching name.
+ * Parser lookups (ignore_case) compare against upper case name and skip disabled commands.
+ */
+static struct cat_command const* find_command(struct cat_object *self, const char *name, size_t length, bool ignore_case)
+{
+        size_t i, slot, mask;
+        struct cat_command const *cmd;
+
+        assert(self != NULL);
+
+        if (self->desc->cmd_index != NULL) {
+                mask = self->desc->cmd_index_size - 1;
+                slot = hash_command_name(name, length) & mask;
+
+                while (self->desc->cmd_index[slot] != CAT_CMD_INDEX_EMPTY) {
+                        i = self->desc->cmd_index[slot] - 1;
+                        cmd = get_command_by_index(self, i);
+                        if ((is_command_name_equal(cmd->name, name, length, ignore_case) != false) &&
+                            ((ignore_case == false) || (is_command_disable(self, i) == false)))
+                                return cmd;
+                        slot = (slot + 1) & mask;
+                }
+                return NULL;
+        }
+
+        for (i = 0; i < self->commands_num; i++) {
+                cmd = get_command_by_index(self, i);
+                if ((is_command_name_equal(cmd->name, name, length, ignore_case) != false) &&
+                    ((ignore_case == false) || (is_command_disable(self, i) == false)))
+                        return cmd;
+        }
+
+        return NULL;
+}
+
 static void unsolicited_init(struct cat_object *self)
 {
         self->unsolicited_fsm.unsolicited_cmd_buffer_tail = 0;
@@ -524,7 +645,6 @@ void cat_init(struct cat_object *self, const struct cat_descriptor *desc, const
         }
 
         assert(desc->buf != NULL);
-        assert(desc->buf_size * 4U >= self->commands_num);
 
         self->desc = desc;
         self->io = io;
@@ -532,6 +652,8 @@ void cat_init(struct cat_object *self, const struct cat_descriptor *desc, const
         self->hold_state_flag = false;
         self->hold_exit_status = 0;
 
+        build_command_index(self);
+
         reset_state(self);
 
         unsolicited_init(self);
@@ -560,13 +682,8 @@ static cat_status error_state(struct cat_object *self)
 
 static void prepare_parse_command(struct cat_object *self)
 {
-        uint8_t val = (CAT_CMD_STATE_PARTIAL_MATCH << 0) | (CAT_CMD_STATE_PARTIAL_MATCH << 2) | (CAT_CMD_STATE_PARTIAL_MATCH << 4) |
-                      (CAT_CMD_STATE_PARTIAL_MATCH << 6);
-
         assert(self != NULL);
 
-        memset(get_atcmd_buf(self), val, get_atcmd_buf_size(self));
-
         self->index = 0;
         self->length = 0;
         self->cmd_type = CAT_CMD_TYPE_RUN;
@@ -749,9 +866,9 @@ static cat_status parse_command(struct cat_object *self)
                 self->state = CAT_STATE_SEARCH_COMMAND;
                 break;
         default:
-                if (is_valid_cmd_name_char(self->current_char) != 0) {
-                        self->length++;
-                        self->state = CAT_STATE_UPDATE_COMMAND_STATE;
+                if ((is_valid_cmd_name_char(self->current_char) != 0) && (self->length < get_atcmd_buf_size(self))) {
+                        /* command name is collected in working buffer and searched at once */
+                        get_atcmd_buf(self)[self->length++] = self->current_char;
                         break;
                 }
                 self->state = CAT_STATE_ERROR;
@@ -760,92 +877,6 @@ static cat_status parse_command(struct cat_object *self)
         return CAT_STATUS_BUSY;
 }
 
-static bool is_command_disable(struct cat_object *self, size_t index)
-{
-        size_t i, j;
-        struct cat_command_group const *cmd_group;
-
-        assert(self != NULL);
-        assert(index < self->commands_num);
-
-        j = 0;
-        for (i = 0; i < self->desc->cmd_group_num; i++) {
-                cmd_group = self->desc->cmd_group[i];
-
-                if (index >= j + cmd_group->cmd_num) {
-                        j += cmd_group->cmd_num;
-                        continue;
-                }
-
-                if (cmd_group->disable != false)
-                        return true;
-
-                if (cmd_group->cmd[index - j].disable != false)
-                        return true;
-        }
-        
-        return false;
-}
-
-static uint8_t get_cmd_state(struct cat_object *self, size_t i)
-{
-        uint8_t s;
-
-        assert(self != NULL);
-        assert(i < self->commands_num);
-
-        s = get_atcmd_buf(self)[i >> 2];
-        s >>= (i % 4) << 1;
-        s &= 0x03;
-
-        if (is_command_disable(self, i) != false)
-                return CAT_CMD_STATE_NOT_MATCH;
-
-        return s;
-}
-
-static void set_cmd_state(struct cat_object *self, size_t i, uint8_t state)
-{
-        uint8_t s;
-        size_t n;
-        uint8_t k;
-
-        n = i >> 2;
-        k = ((i % 4) << 1);
-
-        s = get_atcmd_buf(self)[n];
-        s &= ~(0x03 << k);
-        s |= (state & 0x03) << k;
-        get_atcmd_buf(self)[n] = s;
-}
-
-static cat_status update_command(struct cat_object *self)
-{
-        assert(self != NULL);
-
-        struct cat_command const *cmd = get_command_by_index(self, self->index);
-        size_t cmd_name_len;
-
-        if (get_cmd_state(self, self->index) != CAT_CMD_STATE_NOT_MATCH) {
-                cmd_name_len = strlen(cmd->name);
-
-                if (self->length > cmd_name_len) {
-                        set_cmd_state(self, self->index, CAT_CMD_STATE_NOT_MATCH);
-                } else if (to_upper(cmd->name[self->length - 1]) != self->current_char) {
-                        set_cmd_state(self, self->index, CAT_CMD_STATE_NOT_MATCH);
-                } else if (self->length == cmd_name_len) {
-                        set_cmd_state(self, self->index, CAT_CMD_STATE_FULL_MATCH);
-                }
-        }
-
-        if (++self->index >= self->commands_num) {
-                self->index = 0;
-                self->state = CAT_STATE_PARSE_COMMAND_CHAR;
-        }
-
-        return CAT_STATUS_BUSY;
-}
-
 static cat_status wait_read_acknowledge(struct cat_object *self)
 {
         assert(self != NULL);
@@ -939,23 +970,29 @@ static cat_status search_command(struct cat_object *self)
 {
         assert(self != NULL);
 
-        uint8_t cmd_state = get_cmd_state(self, self->index);
+        struct cat_command const *cmd;
 
-        if (cmd_state != CAT_CMD_STATE_NOT_MATCH) {
-                if (cmd_state == CAT_CMD_STATE_PARTIAL_MATCH) {
-                        if ((self->cmd != NULL) && ((self->index + 1) == self->commands_num)) {
-                                self->state = (self->current_char == '\n') ? CAT_STATE_COMMAND_NOT_FOUND : CAT_STATE_ERROR;
-                                return CAT_STATUS_BUSY;
-                        }
-                        self->cmd = get_command_by_index(self, self->index);
-                        self->partial_cntr++;
-                } else if (cmd_state == CAT_CMD_STATE_FULL_MATCH) {
-                        self->cmd = get_command_by_index(self, self->index);
+        if (self->index == 0) {
+                /* full match has priority over abbreviated names */
+                self->cmd = find_command(self, get_atcmd_buf(self), self->length, true);
+                if (self->cmd != NULL) {
                         self->state = CAT_STATE_COMMAND_FOUND;
                         return CAT_STATUS_BUSY;
                 }
         }
 
+        /* unique prefix match, one command per call */
+        if (is_command_disable(self, self->index) == false) {
+                cmd = get_command_by_index(self, self->index);
+                if (is_command_name_prefix(cmd->name, get_atcmd_buf(self), self->length, true) != false) {
+                        self->cmd = cmd;
+                        if (++self->partial_cntr > 1) {
+                                self->state = CAT_STATE_COMMAND_NOT_FOUND;
+                                return CAT_STATUS_BUSY;
+                        }
+                }
+        }
+
         if (++self->index >= self->commands_num) {
                 if (self->cmd == NULL) {
                         self->state = (self->current_char == '\n') ? CAT_STATE_COMMAND_NOT_FOUND : CAT_STATE_ERROR;
@@ -2289,19 +2326,10 @@ cat_status cat_hold_exit(struct cat_object *self, cat_status status)
 
 struct cat_command const* cat_search_command_by_name(struct cat_object *self, const char *name)
 {
-        size_t i;
-        struct cat_command const *cmd;
-
         assert(self != NULL);
         assert(name != NULL);
 
-        for (i = 0; i < self->commands_num; i++) {
-                cmd = get_command_by_index(self, i);
-                if (strcmp(cmd->name, name) == 0)
-                        return cmd;
-        }
-
-        return NULL;
+        return find_command(self, name, strlen(name), false);
 }
 
 struct cat_command_group const* cat_search_command_group_by_name(struct cat_object *self, const char *name)
@@ -2494,9 +2522,6 @@ cat_status cat_service(struct cat_object *self)
         case CAT_STATE_PARSE_COMMAND_CHAR:
                 s = parse_command(self);
                 break;
-        case CAT_STATE_UPDATE_COMMAND_STATE:
-                s = update_command(self);
-                break;
         case CAT_STATE_WAIT_READ_ACKNOWLEDGE:
                 s = wait_read_acknowledge(self);
                 break;
@@ -4,6 +4,7 @@
 #include <esp_littlefs.h>
 #include <esp_log.h>
 #include <esp_ota_ops.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 #include <freertos/task.h>
@@ -15,6 +16,7 @@
 #include "sdkconfig.h"
 
 #include "board_config.h"
+#include "boot.h"
 #include "evse.h"
 #include "led.h"
 #include "logger.h"
@@ -24,6 +26,7 @@
 #include "protocols.h"
 #include "script.h"
 #include "serial.h"
+#include "temp_sensor.h"
 #include "wifi.h"
 
 #define AP_CONNECTION_TIMEOUT 60000  // 60sec
@@ -32,6 +35,9 @@
 #define BUTTON_PRESSED_BIT  BIT0
 #define BUTTON_RELEASED_BIT BIT1
 
+#define BOOT_WORKERS       3
+#define BOOT_READY_TIMEOUT 5000  // 5sec
+
 static const char* TAG = "app_main";
 
 typedef enum {
@@ -56,6 +62,21 @@ static evse_state_t led_state = -1;
 
 static RTC_NOINIT_ATTR uint8_t init_count = 0;
 
+typedef enum {
+    STAGE_FS,
+    STAGE_BOARD_CONFIG,
+    STAGE_NETWORK,
+    STAGE_PERIPHERALS,
+    STAGE_TEMP_SENSOR,
+    STAGE_EVSE,
+    STAGE_MODBUS,
+    STAGE_SERIAL,
+    STAGE_PROTOCOLS,
+    STAGE_SCRIPT,
+    //
+    STAGE_MAX
+} stage_t;
+
 static void reset_and_reboot(void)
 {
     ESP_LOGW(TAG, "All settings will be erased...");
@@ -192,8 +213,35 @@ static void fs_init(void)
     size_t total = 0, used = 0;
     ESP_ERROR_CHECK(esp_littlefs_info(conf.partition_label, &total, &used));
     ESP_LOGI(TAG, "File system partition total size: %d, used: %d", total, used);
+
+    logger_storage_init();
+}
+
+static void board_config_init(void)
+{
+    board_config_load(init_count > 5);
+}
+
+static void evse_button_init(void)
+{
+    evse_init();
+    button_init();
 }
 
+// independent stages run concurrently, order of array is only preference
+static const boot_stage_t boot_stages[STAGE_MAX] = {
+    [STAGE_FS] = { "fs", fs_init, 0 },
+    [STAGE_BOARD_CONFIG] = { "board_config", board_config_init, BOOT_STAGE_BIT(STAGE_FS) },
+    [STAGE_NETWORK] = { "network", network_init, 0 },
+    [STAGE_PERIPHERALS] = { "peripherals", peripherals_init, BOOT_STAGE_BIT(STAGE_BOARD_CONFIG) },
+    [STAGE_TEMP_SENSOR] = { "temp_sensor", temp_sensor_init, BOOT_STAGE_BIT(STAGE_BOARD_CONFIG) },
+    [STAGE_EVSE] = { "evse", evse_button_init, BOOT_STAGE_BIT(STAGE_PERIPHERALS) },
+    [STAGE_MODBUS] = { "modbus", modbus_init, BOOT_STAGE_BIT(STAGE_NETWORK) | BOOT_STAGE_BIT(STAGE_EVSE) },
+    [STAGE_SERIAL] = { "serial", serial_init, BOOT_STAGE_BIT(STAGE_NETWORK) | BOOT_STAGE_BIT(STAGE_EVSE) },
+    [STAGE_PROTOCOLS] = { "protocols", protocols_init, BOOT_STAGE_BIT(STAGE_NETWORK) | BOOT_STAGE_BIT(STAGE_EVSE) },
+    [STAGE_SCRIPT] = { "script", script_init, BOOT_STAGE_BIT(STAGE_SERIAL) | BOOT_STAGE_BIT(STAGE_PROTOCOLS) },
+};
+
 static bool ota_diagnostic(void)
 {
     // TODO diagnostic after ota
@@ -282,6 +330,7 @@ void print_task_hwm(uint16_t interval)
 
 void app_main(void)
 {
+    int64_t start = esp_timer_get_time();
     logger_init();
 
     const esp_partition_t* running = esp_ota_get_running_partition();
@@ -309,7 +358,7 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
-    fs_init();
+    logger_syslog_init();
 
     ESP_ERROR_CHECK(esp_event_loop_create_default());
     ESP_ERROR_CHECK(gpio_install_isr_service(0));
@@ -317,25 +366,31 @@ void app_main(void)
     if (esp_reset_reason() != ESP_RST_PANIC) init_count = 0;
     init_count++;
 
-    board_config_load(init_count > 5);
+    boot_record("system", start);
 
-    network_init();
-    peripherals_init();
-    modbus_init();
-    serial_init();
-    protocols_init();
-    evse_init();
-    button_init();
-    script_init();
+    boot_run(boot_stages, STAGE_MAX, BOOT_WORKERS);
 
-    init_count--;
+    // safety loop starts as soon as evse is ready, rest of stages continue in background
+    while (!boot_wait(BOOT_STAGE_BIT(STAGE_EVSE), BOOT_READY_TIMEOUT)) {
+        ESP_LOGE(TAG, "EVSE not ready after %d ms", BOOT_READY_TIMEOUT);
+    }
+    boot_record("ready", 0);
+
+    bool boot_complete = false;
 
     while (true) {
         evse_process();
         button_process();
-        wifi_event_process();
+        if (boot_is_done(BOOT_STAGE_BIT(STAGE_NETWORK))) {
+            wifi_event_process();
+        }
         update_leds();
 
+        if (!boot_complete && boot_is_complete()) {
+            boot_complete = true;
+            init_count--;
+        }
+
         vTaskDelay(pdMS_TO_TICKS(50));
 
 #ifdef CONFIG_FREERTOS_USE_TRACE_FACILITY
@@ -0,0 +1,81 @@
+#include "at.h"
+#include "board_config.h"
+#include "cat.h"
+#include "schedule_restart.h"
+
+/**
+ * Command groups of components, which are not part of host build, reduced to commands without hardware dependency
+ */
+
+static cat_return_state cmd_rst_run(const struct cat_command* cmd)
+{
+    schedule_restart();
+
+    return CAT_RETURN_STATE_OK;
+}
+
+static struct cat_variable vars_device_name[] = {
+    {
+        .type = CAT_VAR_BUF_STRING,
+        .data = board_config.device_name,
+        .data_size = sizeof(board_config.device_name),
+        .access = CAT_VAR_ACCESS_READ_ONLY,
+    },
+};
+
+static cat_return_state cmd_not_available_run(const struct cat_command* cmd)
+{
+    return CAT_RETURN_STATE_ERROR;
+}
+
+static struct cat_command cmds_system[] = {
+    {
+        .name = "+RST",
+        .run = cmd_rst_run,
+    },
+};
+
+static struct cat_command cmds_board_config[] = {
+    {
+        .name = "+DEVNAME",
+        .var = vars_device_name,
+        .var_num = sizeof(vars_device_name) / sizeof(vars_device_name[0]),
+    },
+};
+
+static struct cat_command cmds_network[] = {
+    {
+        .name = "+WIFISTACONN",
+        .run = cmd_not_available_run,
+    },
+};
+
+static struct cat_command cmds_serial[] = {
+    {
+        .name = "+SERIALS",
+        .run = cmd_not_available_run,
+    },
+};
+
+struct cat_command_group at_cmd_system_group = {
+    .cmd = cmds_system,
+    .cmd_num = sizeof(cmds_system) / sizeof(cmds_system[0]),
+};
+
+struct cat_command_group at_cmd_board_config_group = {
+    .cmd = cmds_board_config,
+    .cmd_num = sizeof(cmds_board_config) / sizeof(cmds_board_config[0]),
+};
+
+struct cat_command_group at_cmd_network_group = {
+    .cmd = cmds_network,
+    .cmd_num = sizeof(cmds_network) / sizeof(cmds_network[0]),
+};
+
+struct cat_command_group at_cmd_serial_group = {
+    .cmd = cmds_serial,
+    .cmd_num = sizeof(cmds_serial) / sizeof(cmds_serial[0]),
+};
+
+void wifi_scan_aps_free(wifi_scan_ap_list_t* list)
+{}
@@ -0,0 +1,346 @@
+#include <driver/uart.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "at_task.h"
+#include "board_config.h"
+#include "board_config_parser.h"
+#include "energy_meter.h"
+#include "evse.h"
+#include "modbus.h"
+#include "peripherals_mock.h"
+#include "script.h"
+#include "serial_port.h"
+#include "sim_bench.h"
+#include "sim_pilot.h"
+#include "vfs_sim.h"
+
+#define CONTROL_PERIOD_MS 50
+#define AT_PORT           UART_NUM_1
+#define DEFAULT_CYCLE_MS  10000
+#define BENCH_TIMEOUT_MS  60000
+
+static const char* TAG = "sim";
+
+typedef struct {
+    const char* name;
+    uint32_t count;
+    sim_bench_result_t result;
+    esp_err_t err;
+    SemaphoreHandle_t done;
+} bench_t;
+
+// loaded directly from yaml, board_config.c binary cache and embedded default are not used
+board_cfg_t board_config;
+
+static volatile sig_atomic_t running = 1;
+
+static uint32_t session_count = 0;
+
+static uint32_t charging_count = 0;
+
+static uint32_t error_count = 0;
+
+static void signal_handler(int sig)
+{
+    running = 0;
+}
+
+static void print_usage(const char* prog)
+{
+    fprintf(stderr,
+            "usage: %s [-b board.yaml] [-u usr_dir] [-d seconds] [-c cycle_ms] [-a at_requests] [-m modbus_requests] [-v]\n"
+            "  -b  board config, default %s\n"
+            "  -u  directory mapped to /usr, script is started from lua/init.lua, default %s\n"
+            "  -d  run duration, 0 runs until interrupted, default 0\n"
+            "  -c  period of vehicle scenario, default %d\n"
+            "  -a  count of AT requests sent by benchmark client\n"
+            "  -m  count of Modbus-TCP requests sent by benchmark client\n"
+            "  -v  debug log, -vv verbose log\n",
+            prog,
+            SIM_BOARD_YAML,
+            SIM_USR_DIR,
+            DEFAULT_CYCLE_MS);
+}
+
+static void board_config_init(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        ESP_LOGE(TAG, "Can't open %s", path);
+        exit(EXIT_FAILURE);
+    }
+    ESP_ERROR_CHECK(board_config_parse_file(file, &board_config));
+    fclose(file);
+
+    ESP_LOGI(TAG, "Board %s", board_config.device_name);
+}
+
+/**
+ * State change callback of evse is owned by script, states are compared after each evse_process
+ */
+static void state_changed(evse_state_t state)
+{
+    switch (state) {
+    case EVSE_STATE_B1:
+        session_count++;
+        break;
+    case EVSE_STATE_C2:
+        charging_count++;
+        break;
+    case EVSE_STATE_E:
+    case EVSE_STATE_F:
+        error_count++;
+        ESP_LOGW(TAG, "Error state %s, error bits %" PRIu32 "", evse_state_to_str(state), evse_get_error());
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Vehicle is plugged in for 80% of cycle, charging is requested in middle of it
+ */
+static sim_vehicle_state_t scenario_vehicle_state(int64_t time_ms, uint32_t cycle_ms)
+{
+    switch ((time_ms % cycle_ms) * 10 / cycle_ms) {
+    case 0:
+    case 9:
+        return SIM_VEHICLE_DISCONNECTED;
+    case 1:
+    case 8:
+        return SIM_VEHICLE_CONNECTED;
+    default:
+        return SIM_VEHICLE_CHARGE_REQUEST;
+    }
+}
+
+/**
+ * Vehicle draw current advertised by pilot, while relay is closed
+ */
+static void energy_meter_update(sim_vehicle_state_t vehicle_state, uint32_t period_ms)
+{
+    static uint64_t consumption_wms = 0;
+    static uint32_t charging_ms = 0;
+
+    if (vehicle_state == SIM_VEHICLE_DISCONNECTED) {
+        consumption_wms = 0;
+        charging_ms = 0;
+    }
+
+    if (ac_relay_mock_state) {
+        uint32_t power = energy_meter_get_ac_voltage() * sim_pilot_get_amps() / 10 * (energy_meter_is_three_phases() ? 3 : 1);
+        energy_meter_mock_power = power;
+        consumption_wms += (uint64_t)power * period_ms;
+        charging_ms += period_ms;
+    } else {
+        energy_meter_mock_power = 0;
+    }
+
+    energy_meter_mock_consumption = consumption_wms / 3600000;
+    energy_meter_mock_charging_time = charging_ms / 1000;
+}
+
+static void at_bench_task_func(void* param)
+{
+    bench_t* bench = (bench_t*)param;
+    bench->err = sim_bench_at(uart_sim_get_tty_name(AT_PORT), bench->count, &bench->result);
+    xSemaphoreGive(bench->done);
+    vTaskDelete(NULL);
+}
+
+static void modbus_bench_task_func(void* param)
+{
+    bench_t* bench = (bench_t*)param;
+    bench->err = sim_bench_modbus(SIM_MODBUS_TCP_PORT, bench->count, &bench->result);
+    xSemaphoreGive(bench->done);
+    vTaskDelete(NULL);
+}
+
+static void bench_start(bench_t* bench, TaskFunction_t func)
+{
+    if (bench->count > 0) {
+        bench->done = xSemaphoreCreateBinary();
+        xTaskCreate(func, bench->name, 4 * 1024, bench, 5, NULL);
+    }
+}
+
+static bool bench_report(bench_t* bench)
+{
+    if (bench->count == 0) return true;
+
+    if (!xSemaphoreTake(bench->done, pdMS_TO_TICKS(BENCH_TIMEOUT_MS))) {
+        printf("%s: timeout\n", bench->name);
+        return false;
+    }
+    vSemaphoreDelete(bench->done);
+
+    sim_bench_result_t* result = &bench->result;
+    double secs = result->total_us / 1e6;
+    printf("%s: %" PRIu32 " requests (%" PRIu32 " errors), avg %.1f us, max %" PRId64 " us, %.0f requests/s\n",
+           bench->name,
+           result->count,
+           result->errors,
+           result->count ? (double)result->total_us / result->count : 0,
+           result->max_us,
+           secs > 0 ? result->count / secs : 0);
+
+    return bench->err == ESP_OK && result->errors == 0 && result->count == bench->count;
+}
+
+static void script_output_print(void)
+{
+    uint32_t index = 0;
+    char* str;
+    uint16_t len;
+
+    // entries are chunks of Lua output, not lines
+    printf("script output:\n");
+    while (script_output_read(&index, &str, &len)) {
+        fwrite(str, sizeof(char), len, stdout);
+    }
+}
+
+static int compare_int32(const void* a, const void* b)
+{
+    return *(const int32_t*)a - *(const int32_t*)b;
+}
+
+int main(int argc, char** argv)
+{
+    const char* board_yaml = SIM_BOARD_YAML;
+    const char* usr_dir = SIM_USR_DIR;
+    uint32_t duration_s = 0;
+    uint32_t cycle_ms = DEFAULT_CYCLE_MS;
+    bench_t at_bench = { .name = "at" };
+    bench_t modbus_bench = { .name = "modbus" };
+    esp_log_level_t log_level = ESP_LOG_INFO;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:u:d:c:a:m:vh")) != -1) {
+        switch (opt) {
+        case 'b':
+            board_yaml = optarg;
+            break;
+        case 'u':
+            usr_dir = optarg;
+            break;
+        case 'd':
+            duration_s = strtoul(optarg, NULL, 10);
+            break;
+        case 'c':
+            cycle_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 'a':
+            at_bench.count = strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            modbus_bench.count = strtoul(optarg, NULL, 10);
+            break;
+        case 'v':
+            if (log_level < ESP_LOG_VERBOSE) log_level++;
+            break;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (cycle_ms < 10 * CONTROL_PERIOD_MS) {
+        fprintf(stderr, "Cycle must be at least %d ms\n", 10 * CONTROL_PERIOD_MS);
+        return EXIT_FAILURE;
+    }
+
+    esp_log_level_set("*", log_level);
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    board_config_init(board_yaml);
+    vfs_sim_mount_usr(usr_dir);
+
+    evse_init();
+    evse_state_t state = evse_get_state();
+
+    script_init();
+    script_set_enabled(true);
+
+    modbus_init();
+    modbus_set_tcp_enabled(true);
+    ESP_LOGI(TAG, "Modbus-TCP on port %d", SIM_MODBUS_TCP_PORT);
+
+    ESP_ERROR_CHECK(serial_port_open(AT_PORT, AT_TASK_RX_BUFFER_SIZE, AT_TASK_RX_SPAN_SIZE, AT_TASK_TX_BUFFER_SIZE));
+    at_task_start(AT_PORT);
+    ESP_LOGI(TAG, "AT on %s", uart_sim_get_tty_name(AT_PORT));
+
+    bench_start(&at_bench, at_bench_task_func);
+    bench_start(&modbus_bench, modbus_bench_task_func);
+
+    uint32_t iterations_size = 1024;
+    int32_t* process_us = (int32_t*)malloc(iterations_size * sizeof(int32_t));
+    uint32_t iterations = 0;
+    int64_t process_total_us = 0;
+    int64_t max_period_us = 0;
+
+    int64_t start = esp_timer_get_time();
+    int64_t prev = start;
+    TickType_t wake_time = xTaskGetTickCount();
+
+    while (running && (duration_s == 0 || esp_timer_get_time() - start < duration_s * 1000000LL)) {
+        int64_t now = esp_timer_get_time();
+        if (now - prev > max_period_us && iterations > 0) max_period_us = now - prev;
+        prev = now;
+
+        sim_vehicle_state_t vehicle_state = scenario_vehicle_state((now - start) / 1000, cycle_ms);
+        sim_pilot_set_vehicle_state(vehicle_state);
+
+        evse_process();
+
+        if (evse_get_state() != state) {
+            state = evse_get_state();
+            state_changed(state);
+        }
+
+        int32_t us = esp_timer_get_time() - now;
+        if (iterations >= iterations_size) {
+            iterations_size *= 2;
+            process_us = (int32_t*)realloc(process_us, iterations_size * sizeof(int32_t));
+        }
+        process_us[iterations++] = us;
+        process_total_us += us;
+
+        energy_meter_update(vehicle_state, CONTROL_PERIOD_MS);
+
+        xTaskDelayUntil(&wake_time, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
+    }
+
+    int64_t elapsed_ms = (esp_timer_get_time() - start) / 1000;
+    uint32_t cycles = elapsed_ms / cycle_ms;
+
+    qsort(process_us, iterations, sizeof(int32_t), compare_int32);
+
+    printf("control loop: %" PRIu32 " iterations, evse_process avg %.1f us, p99 %" PRId32 " us, max %" PRId32 " us, max period %" PRId64 " us\n",
+           iterations,
+           iterations ? (double)process_total_us / iterations : 0,
+           iterations ? process_us[iterations * 99 / 100] : 0,
+           iterations ? process_us[iterations - 1] : 0,
+           max_period_us);
+    printf("sessions: %" PRIu32 ", charging: %" PRIu32 ", errors: %" PRIu32 ", scenario cycles: %" PRIu32 "\n", session_count, charging_count, error_count, cycles);
+    free((void*)process_us);
+
+    script_output_print();
+
+    bool ok = charging_count >= cycles && error_count == 0;
+    ok = bench_report(&at_bench) && ok;
+    ok = bench_report(&modbus_bench) && ok;
+
+    fflush(stdout);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,9 @@
+#include "serial_mode.h"
+
+/**
+ * Serial component is not part of host build, AT is served on its port by simulator and no port is in script mode
+ */
+uart_port_t serial_port_find(const char* mode_name)
+{
+    return -1;
+}
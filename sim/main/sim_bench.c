@@ -0,0 +1,161 @@
+#include "sim_bench.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <fcntl.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define RESPONSE_TIMEOUT_MS 1000
+#define CONNECT_TIMEOUT_MS  2000
+#define AT_COMMAND          "AT+STATE?\n"
+#define MODBUS_REG_ADDR     100
+#define MODBUS_REG_COUNT    12
+
+static const char* TAG = "bench";
+
+/**
+ * Read to buffer, wait up to timeout for any data
+ */
+static ssize_t read_timeout(int fd, void* buf, size_t len)
+{
+    struct pollfd pfd = {
+        .fd = fd,
+        .events = POLLIN,
+    };
+    if (poll(&pfd, 1, RESPONSE_TIMEOUT_MS) <= 0) return -1;
+
+    return read(fd, buf, len);
+}
+
+static void result_add(sim_bench_result_t* result, int64_t start, bool ok)
+{
+    int64_t us = esp_timer_get_time() - start;
+    result->count++;
+    result->total_us += us;
+    if (us > result->max_us) result->max_us = us;
+    if (!ok) result->errors++;
+}
+
+esp_err_t sim_bench_at(const char* tty_name, uint32_t count, sim_bench_result_t* result)
+{
+    memset(result, 0, sizeof(sim_bench_result_t));
+
+    int fd = open(tty_name, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Can't open %s: errno %d", tty_name, errno);
+        return ESP_FAIL;
+    }
+
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+    tcflush(fd, TCIFLUSH);
+
+    char buf[256];
+    for (uint32_t i = 0; i < count; i++) {
+        int64_t start = esp_timer_get_time();
+        if (write(fd, AT_COMMAND, sizeof(AT_COMMAND) - 1) != sizeof(AT_COMMAND) - 1) {
+            result_add(result, start, false);
+            break;
+        }
+
+        // response ends with OK or ERROR line, sliding window over received stream
+        char tail[3] = { 0 };
+        bool done = false;
+        bool ok = false;
+        while (!done) {
+            ssize_t len = read_timeout(fd, buf, sizeof(buf));
+            if (len <= 0) break;
+            for (ssize_t j = 0; j < len; j++) {
+                memmove(tail, tail + 1, 2);
+                tail[2] = buf[j];
+                if (memcmp(tail, "OK\n", 3) == 0) {
+                    done = ok = true;
+                } else if (memcmp(tail, "OR\n", 3) == 0) {
+                    done = true;
+                }
+            }
+        }
+        result_add(result, start, ok);
+    }
+
+    close(fd);
+
+    return ESP_OK;
+}
+
+static int modbus_connect(uint16_t port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr = {
+            .s_addr = htonl(INADDR_LOOPBACK),
+        },
+        .sin_port = htons(port),
+    };
+
+    // server task may not listen yet
+    TickType_t start = xTaskGetTickCount();
+    do {
+        int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            int opt = 1;
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            return sock;
+        }
+        close(sock);
+        vTaskDelay(pdMS_TO_TICKS(100));
+    } while (xTaskGetTickCount() - start < pdMS_TO_TICKS(CONNECT_TIMEOUT_MS));
+
+    return -1;
+}
+
+esp_err_t sim_bench_modbus(uint16_t port, uint32_t count, sim_bench_result_t* result)
+{
+    memset(result, 0, sizeof(sim_bench_result_t));
+
+    int sock = modbus_connect(port);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Can't connect to port %d: errno %d", port, errno);
+        return ESP_FAIL;
+    }
+
+    uint8_t buf[256];
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t req[] = {
+            i >> 8, i & 0xFF,  // transaction id
+            0, 0,              // protocol id
+            0, 6,              // length
+            1,                 // unit id
+            3,                 // read holding registers
+            MODBUS_REG_ADDR >> 8, MODBUS_REG_ADDR & 0xFF, MODBUS_REG_COUNT >> 8, MODBUS_REG_COUNT & 0xFF,
+        };
+
+        int64_t start = esp_timer_get_time();
+        if (send(sock, req, sizeof(req), 0) != sizeof(req)) {
+            result_add(result, start, false);
+            break;
+        }
+
+        // response is small, received in one segment on loopback
+        ssize_t len = read_timeout(sock, buf, sizeof(buf));
+        bool ok = len == 9 + MODBUS_REG_COUNT * 2 && buf[0] == req[0] && buf[1] == req[1] && buf[7] == 3;
+        result_add(result, start, ok);
+        if (len <= 0) break;
+    }
+
+    close(sock);
+
+    return ESP_OK;
+}
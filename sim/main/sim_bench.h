@@ -0,0 +1,38 @@
+#ifndef SIM_BENCH_H_
+#define SIM_BENCH_H_
+
+#include <esp_err.h>
+#include <stdint.h>
+
+/**
+ * @brief Result of request-response benchmark
+ *
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t errors;
+    int64_t total_us;
+    int64_t max_us;
+} sim_bench_result_t;
+
+/**
+ * @brief Send read command to AT port and wait for response, repeat count times
+ *
+ * @param tty_name Pseudo terminal of AT port
+ * @param count
+ * @param result
+ * @return esp_err_t
+ */
+esp_err_t sim_bench_at(const char* tty_name, uint32_t count, sim_bench_result_t* result);
+
+/**
+ * @brief Send read holding registers request to Modbus-TCP server and wait for response, repeat count times
+ *
+ * @param port TCP port on localhost
+ * @param count
+ * @param result
+ * @return esp_err_t
+ */
+esp_err_t sim_bench_modbus(uint16_t port, uint32_t count, sim_bench_result_t* result);
+
+#endif /* SIM_BENCH_H_ */
@@ -0,0 +1,160 @@
+#include "sim_pilot.h"
+
+#include <esp_log.h>
+#include <stdlib.h>
+
+#include "board_config.h"
+#include "pilot.h"
+
+#define PILOT_PWM_MAX_DUTY  1023
+#define PILOT_SAMPLES       250  // during 1000us pilot period, should be divisible
+#define PILOT_HI_LO_SAMPLES 3
+#define PILOT_NOISE_MV      40
+
+static const char* TAG = "pilot";
+
+static bool level = true;
+
+static uint32_t duty = 0;  // 0 when pilot is not oscillating
+
+static uint16_t pwm_amps = 0;
+
+static sim_vehicle_state_t vehicle_state = SIM_VEHICLE_DISCONNECTED;
+
+static unsigned int noise_seed = 1;
+
+void pilot_init(void)
+{}
+
+void pilot_set_level(bool _level)
+{
+    ESP_LOGI(TAG, "Set level %d", _level);
+
+    level = _level;
+    duty = 0;
+    pwm_amps = 0;
+}
+
+void pilot_set_amps(uint16_t amps)
+{
+    // same duty as ledc output of pilot.c
+    if ((amps >= 60) && (amps <= 510)) {
+        duty = (amps / 10) * (PILOT_PWM_MAX_DUTY / 60);
+    } else if ((amps > 510) && (amps <= 800)) {
+        duty = ((amps / 10) * (PILOT_PWM_MAX_DUTY / 250)) + (64 * (PILOT_PWM_MAX_DUTY / 100));
+    } else {
+        ESP_LOGE(TAG, "Try set invalid ampere value %d A*10", amps);
+        return;
+    }
+    pwm_amps = amps;
+
+    ESP_LOGI(TAG, "Set amp %dA*10 duty %lu/%d", amps, (unsigned long)duty, PILOT_PWM_MAX_DUTY);
+}
+
+/**
+ * Voltage on ADC input for pilot voltage, linear divider is fitted to thresholds of board config,
+ * which lie in the middle between nominal levels
+ */
+static int pilot_voltage_to_mv(float voltage)
+{
+    float slope = (board_config.pilot.levels[BOARD_CFG_PILOT_LEVEL_12] - board_config.pilot.levels[BOARD_CFG_PILOT_LEVEL_3]) / 9.0f;
+    float offset = board_config.pilot.levels[BOARD_CFG_PILOT_LEVEL_12] - 10.5f * slope;
+
+    return offset + voltage * slope;
+}
+
+/**
+ * Up voltage is given by resistors of vehicle, vehicle close S2 only when pilot is oscillating
+ */
+static float vehicle_up_voltage(void)
+{
+    switch (vehicle_state) {
+    case SIM_VEHICLE_CONNECTED:
+        return 9;
+    case SIM_VEHICLE_CHARGE_REQUEST:
+        return duty > 0 ? 6 : 9;
+    case SIM_VEHICLE_VENTILATION_REQUEST:
+        return duty > 0 ? 3 : 9;
+    default:
+        return 12;
+    }
+}
+
+static int read_sample(int index)
+{
+    bool high = duty > 0 ? index < (int)(duty * PILOT_SAMPLES / (PILOT_PWM_MAX_DUTY + 1)) : level;
+    int mv = pilot_voltage_to_mv(high ? vehicle_up_voltage() : -12);
+
+    return mv + rand_r(&noise_seed) % (2 * PILOT_NOISE_MV + 1) - PILOT_NOISE_MV;
+}
+
+void pilot_measure(pilot_voltage_t* up_voltage, bool* down_voltage_n12)
+{
+    int high_samples[PILOT_HI_LO_SAMPLES];
+    int low_samples[PILOT_HI_LO_SAMPLES];
+
+    for (int i = 0; i < PILOT_HI_LO_SAMPLES; i++) {
+        high_samples[i] = 0;
+        low_samples[i] = 3300;
+    }
+
+    for (int i = 0; i < PILOT_SAMPLES; i++) {
+        int adc_reading = read_sample(i);
+
+        for (int j = 0; j < PILOT_HI_LO_SAMPLES; j++) {
+            if (adc_reading > high_samples[j]) {
+                for (int m = PILOT_HI_LO_SAMPLES - 1; m > j; m--) high_samples[m] = high_samples[m - 1];
+                high_samples[j] = adc_reading;
+                break;
+            }
+        }
+
+        for (int j = 0; j < PILOT_HI_LO_SAMPLES; j++) {
+            if (adc_reading < low_samples[j]) {
+                for (int m = PILOT_HI_LO_SAMPLES - 1; m > j; m--) low_samples[m] = low_samples[m - 1];
+                low_samples[j] = adc_reading;
+                break;
+            }
+        }
+    }
+
+    int high = 0;
+    int low = 0;
+
+    for (int i = 0; i < PILOT_HI_LO_SAMPLES; i++) {
+        high += high_samples[i];
+        low += low_samples[i];
+    }
+
+    high /= PILOT_HI_LO_SAMPLES;
+    low /= PILOT_HI_LO_SAMPLES;
+
+    ESP_LOGV(TAG, "Measure: %dmV - %dmV", low, high);
+
+    if (high >= board_config.pilot.levels[BOARD_CFG_PILOT_LEVEL_12]) {
+        *up_voltage = PILOT_VOLTAGE_12;
+    } else if (high >= board_config.pilot.levels[BOARD_CFG_PILOT_LEVEL_9]) {
+        *up_voltage = PILOT_VOLTAGE_9;
+    } else if (high >= board_config.pilot.levels[BOARD_CFG_PILOT_LEVEL_6]) {
+        *up_voltage = PILOT_VOLTAGE_6;
+    } else if (high >= board_config.pilot.levels[BOARD_CFG_PILOT_LEVEL_3]) {
+        *up_voltage = PILOT_VOLTAGE_3;
+    } else {
+        *up_voltage = PILOT_VOLTAGE_1;
+    }
+
+    *down_voltage_n12 = low <= board_config.pilot.levels[BOARD_CFG_PILOT_LEVEL_N12];
+
+    ESP_LOGV(TAG, "Up voltage %d", *up_voltage);
+    ESP_LOGV(TAG, "Down voltage below 12V %d", *down_voltage_n12);
+}
+
+void sim_pilot_set_vehicle_state(sim_vehicle_state_t state)
+{
+    vehicle_state = state;
+}
+
+uint16_t sim_pilot_get_amps(void)
+{
+    return pwm_amps;
+}
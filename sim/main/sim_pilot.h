@@ -0,0 +1,32 @@
+#ifndef SIM_PILOT_H_
+#define SIM_PILOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Simulated vehicle side of control pilot
+ *
+ */
+typedef enum {
+    SIM_VEHICLE_DISCONNECTED,
+    SIM_VEHICLE_CONNECTED,
+    SIM_VEHICLE_CHARGE_REQUEST,  // S2 is closed, while pilot is oscillating
+    SIM_VEHICLE_VENTILATION_REQUEST
+} sim_vehicle_state_t;
+
+/**
+ * @brief Set vehicle state, applied on next pilot measure
+ *
+ * @param state
+ */
+void sim_pilot_set_vehicle_state(sim_vehicle_state_t state);
+
+/**
+ * @brief Get current advertised by pilot pwm
+ *
+ * @return uint16_t Current in A*10, 0 when pilot is not oscillating
+ */
+uint16_t sim_pilot_get_amps(void);
+
+#endif /* SIM_PILOT_H_ */
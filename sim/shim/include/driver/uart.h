@@ -0,0 +1,100 @@
+#ifndef UART_H_
+#define UART_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "soc/soc_caps.h"
+
+/**
+ * @brief Host UART driver, each installed port is backed by pseudo terminal
+ *
+ */
+
+typedef int uart_port_t;
+
+#define UART_NUM_0   0
+#define UART_NUM_1   1
+#define UART_NUM_2   2
+#define UART_NUM_MAX SOC_UART_NUM
+
+/**
+ * @brief Frame format, pseudo terminal is raw and format has no effect
+ *
+ */
+typedef enum {
+    UART_DATA_5_BITS = 0x0,
+    UART_DATA_6_BITS = 0x1,
+    UART_DATA_7_BITS = 0x2,
+    UART_DATA_8_BITS = 0x3,
+    UART_DATA_BITS_MAX = 0x4,
+} uart_word_length_t;
+
+typedef enum {
+    UART_STOP_BITS_1 = 0x1,
+    UART_STOP_BITS_1_5 = 0x2,
+    UART_STOP_BITS_2 = 0x3,
+    UART_STOP_BITS_MAX = 0x4,
+} uart_stop_bits_t;
+
+typedef enum {
+    UART_PARITY_DISABLE = 0x0,
+    UART_PARITY_EVEN = 0x2,
+    UART_PARITY_ODD = 0x3,
+} uart_parity_t;
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_DATA_BREAK,
+    UART_PATTERN_DET,
+    UART_EVENT_MAX
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size, QueueHandle_t* uart_queue, int intr_alloc_flags);
+
+esp_err_t uart_driver_delete(uart_port_t uart_num);
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t* size);
+
+int uart_read_bytes(uart_port_t uart_num, void* buf, uint32_t length, TickType_t ticks_to_wait);
+
+int uart_write_bytes(uart_port_t uart_num, const void* src, size_t size);
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait);
+
+esp_err_t uart_flush_input(uart_port_t uart_num);
+
+esp_err_t uart_enable_pattern_det_baud_intr(uart_port_t uart_num, char pattern_chr, uint8_t chr_num, int chr_tout, int post_idle, int pre_idle);
+
+esp_err_t uart_disable_pattern_det_intr(uart_port_t uart_num);
+
+esp_err_t uart_pattern_queue_reset(uart_port_t uart_num, int queue_length);
+
+int uart_pattern_pop_pos(uart_port_t uart_num);
+
+/**
+ * @brief Get path of pseudo terminal slave, where client connect to installed port
+ *
+ * @param uart_num
+ * @return const char* Path or NULL when driver is not installed
+ */
+const char* uart_sim_get_tty_name(uart_port_t uart_num);
+
+#endif /* UART_H_ */
@@ -0,0 +1,6 @@
+#ifndef ESP_ASSERT_H_
+#define ESP_ASSERT_H_
+
+#define ESP_STATIC_ASSERT _Static_assert
+
+#endif /* ESP_ASSERT_H_ */
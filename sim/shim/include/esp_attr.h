@@ -0,0 +1,13 @@
+#ifndef ESP_ATTR_H_
+#define ESP_ATTR_H_
+
+/**
+ * @brief Placement attributes have no effect on host
+ *
+ */
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif /* ESP_ATTR_H_ */
@@ -0,0 +1,14 @@
+#ifndef ESP_EVENT_H_
+#define ESP_EVENT_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef const char* esp_event_base_t;
+
+typedef void (*esp_event_handler_t)(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+
+#define ESP_EVENT_ANY_ID -1
+
+#endif /* ESP_EVENT_H_ */
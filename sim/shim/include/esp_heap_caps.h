@@ -0,0 +1,29 @@
+#ifndef ESP_HEAP_CAPS_H_
+#define ESP_HEAP_CAPS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Host has one heap, capabilities are ignored
+ *
+ */
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+void* heap_caps_malloc(size_t size, uint32_t caps);
+
+void* heap_caps_malloc_prefer(size_t size, size_t num, ...);
+
+void* heap_caps_realloc_prefer(void* ptr, size_t size, size_t num, ...);
+
+void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps);
+
+void heap_caps_free(void* ptr);
+
+size_t heap_caps_get_free_size(uint32_t caps);
+
+#endif /* ESP_HEAP_CAPS_H_ */
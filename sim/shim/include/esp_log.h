@@ -0,0 +1,82 @@
+#ifndef ESP_LOG_H_
+#define ESP_LOG_H_
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+/**
+ * @brief Options of Log V2 call, same layout as in ESP-IDF
+ *
+ */
+typedef struct {
+    union {
+        struct {
+            esp_log_level_t log_level : 3;
+            uint32_t constrained_env : 1;
+            uint32_t require_formatting : 1;
+            uint32_t dis_color : 1;
+            uint32_t dis_timestamp : 1;
+            uint32_t reserved : 25;
+        } opts;
+        uint32_t data;
+    };
+} esp_log_config_t;
+
+typedef int (*vprintf_like_t)(const char*, va_list);
+
+/**
+ * @brief Set log level, tag "*" sets level of all tags, host build does not support per tag levels
+ *
+ */
+void esp_log_level_set(const char* tag, esp_log_level_t level);
+
+esp_log_level_t esp_log_level_get(const char* tag);
+
+/**
+ * @brief Set output function, default writes to stderr
+ *
+ * @return vprintf_like_t Previous output function
+ */
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func);
+
+/**
+ * @brief Log V2, with formatting prefix, message and new line are written with separate output calls as in ESP-IDF
+ *
+ */
+void esp_log(esp_log_config_t config, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+void esp_log_va(esp_log_config_t config, const char* tag, const char* format, va_list args);
+
+/**
+ * @brief Log V1 compatible, format contains prefix and is written with one output call
+ *
+ */
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+void esp_log_buffer_hex_internal(const char* tag, const void* buffer, uint16_t buff_len, esp_log_level_t level);
+
+#define ESP_LOG_CONFIG_INIT(level) ((esp_log_config_t){ .opts = { .log_level = (level), .require_formatting = 1 } })
+
+#define ESP_LOG_LEVEL(level, tag, format, ...) esp_log(ESP_LOG_CONFIG_INIT(level), tag, format, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#define ESP_LOG_BUFFER_HEX_LEVEL(tag, buffer, buff_len, level) esp_log_buffer_hex_internal(tag, buffer, buff_len, level)
+
+#endif /* ESP_LOG_H_ */
@@ -0,0 +1,14 @@
+#ifndef ESP_MEMORY_UTILS_H_
+#define ESP_MEMORY_UTILS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "soc/soc.h"
+
+static inline bool esp_ptr_in_drom(const void* p)
+{
+    return (uintptr_t)p >= SOC_DROM_LOW && (uintptr_t)p < SOC_DROM_HIGH;
+}
+
+#endif /* ESP_MEMORY_UTILS_H_ */
@@ -0,0 +1,6 @@
+#ifndef ESP_OTA_OPS_H_
+#define ESP_OTA_OPS_H_
+
+#include "esp_app_desc.h"
+
+#endif /* ESP_OTA_OPS_H_ */
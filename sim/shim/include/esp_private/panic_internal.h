@@ -0,0 +1,6 @@
+#ifndef PANIC_INTERNAL_H_
+#define PANIC_INTERNAL_H_
+
+typedef struct panic_info_t panic_info_t;
+
+#endif /* PANIC_INTERNAL_H_ */
@@ -0,0 +1,16 @@
+#ifndef ESP_SYSTEM_H_
+#define ESP_SYSTEM_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**
+ * @brief Restart is handled as exit of simulator process
+ *
+ */
+void esp_restart(void) __attribute__((noreturn));
+
+uint32_t esp_get_free_heap_size(void);
+
+#endif /* ESP_SYSTEM_H_ */
@@ -0,0 +1,48 @@
+#ifndef ESP_TIMER_H_
+#define ESP_TIMER_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**
+ * @brief Host esp_timer, every timer has own thread and callback is called from it
+ *
+ */
+
+typedef struct esp_timer* esp_timer_handle_t;
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    const char* name;
+} esp_timer_create_args_t;
+
+/**
+ * @brief Get time since process start
+ *
+ * @return int64_t Time in us
+ */
+int64_t esp_timer_get_time(void);
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle);
+
+/**
+ * @brief Start one shot timer
+ *
+ * @return esp_err_t ESP_ERR_INVALID_STATE when timer is running
+ */
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+
+/**
+ * @brief Stop timer
+ *
+ * @return esp_err_t ESP_ERR_INVALID_STATE when timer is not running
+ */
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+
+#endif /* ESP_TIMER_H_ */
@@ -0,0 +1,36 @@
+#ifndef FREERTOS_H_
+#define FREERTOS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_attr.h"
+#include "esp_bit_defs.h"
+
+/**
+ * @brief Host subset of FreeRTOS API, tasks are pthreads and tick is 1ms of monotonic clock
+ *
+ */
+
+#define configTICK_RATE_HZ                      1000
+#define configMAX_PRIORITIES                    25
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 4
+
+#define portNUM_PROCESSORS 1
+#define portMAX_DELAY      ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+#define pdFAIL  pdFALSE
+#define pdPASS  pdTRUE
+
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTICKS_TO_MS(ticks) ((uint32_t)(((uint64_t)(ticks) * 1000) / configTICK_RATE_HZ))
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#endif /* FREERTOS_H_ */
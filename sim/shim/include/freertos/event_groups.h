@@ -0,0 +1,24 @@
+#ifndef EVENT_GROUPS_H_
+#define EVENT_GROUPS_H_
+
+#include "FreeRTOS.h"
+
+typedef struct event_group_s* EventGroupHandle_t;
+
+typedef TickType_t EventBits_t;
+
+/**
+ * @brief Only bits access is provided, waiting for bits is not supported
+ *
+ */
+EventGroupHandle_t xEventGroupCreate(void);
+
+void vEventGroupDelete(EventGroupHandle_t group);
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, const EventBits_t bits);
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, const EventBits_t bits);
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+
+#endif /* EVENT_GROUPS_H_ */
@@ -0,0 +1,20 @@
+#ifndef SEMPHR_H_
+#define SEMPHR_H_
+
+#include "queue.h"
+
+/**
+ * @brief Semaphores are queues of zero sized items, as in FreeRTOS
+ *
+ */
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+#define xSemaphoreTake(sem, ticks_to_wait) xQueueReceive(sem, NULL, ticks_to_wait)
+#define xSemaphoreGive(sem)                xQueueSend(sem, NULL, 0)
+#define vSemaphoreDelete(sem)              vQueueDelete(sem)
+
+#endif /* SEMPHR_H_ */
@@ -0,0 +1,80 @@
+#ifndef TASK_H_
+#define TASK_H_
+
+#include "FreeRTOS.h"
+
+typedef struct task_s* TaskHandle_t;
+
+typedef void (*TaskFunction_t)(void*);
+
+typedef enum {
+    eNoAction,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+} eNotifyAction;
+
+#define portYIELD_FROM_ISR()
+
+BaseType_t xTaskCreate(TaskFunction_t func, const char* name, uint32_t stack_depth, void* param, UBaseType_t priority, TaskHandle_t* handle);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char* name, uint32_t stack_depth, void* param, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core_id);
+
+/**
+ * @brief Delete task, other than calling task is cancelled on next blocking call
+ *
+ */
+void vTaskDelete(TaskHandle_t task);
+
+/**
+ * @brief Not supported on host, task continues running
+ *
+ */
+void vTaskSuspend(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+
+BaseType_t xTaskDelayUntil(TickType_t* prev_wake_time, TickType_t increment);
+
+TickType_t xTaskGetTickCount(void);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void* value);
+
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+/**
+ * @brief Same as xTaskNotifyGive, host has no interrupts
+ *
+ */
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+
+/**
+ * @brief Same as xTaskNotify, host has no interrupts
+ *
+ */
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* higher_priority_task_woken);
+
+/**
+ * @brief Wait for notification, notification is pending while value is not zero or it was notified by eNoAction
+ *
+ */
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit, uint32_t* value, TickType_t ticks);
+
+/**
+ * @brief Host runs all tasks as one core
+ *
+ */
+BaseType_t xPortGetCoreID(void);
+
+BaseType_t xPortInIsrContext(void);
+
+#endif /* TASK_H_ */
@@ -0,0 +1,20 @@
+#ifndef TIMERS_H_
+#define TIMERS_H_
+
+#include "FreeRTOS.h"
+
+typedef struct timer_s* TimerHandle_t;
+
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t auto_reload, void* id, TimerCallbackFunction_t callback);
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks_to_wait);
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks_to_wait);
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks_to_wait);
+
+void* pvTimerGetTimerID(TimerHandle_t timer);
+
+#endif /* TIMERS_H_ */
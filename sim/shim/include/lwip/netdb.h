@@ -0,0 +1,6 @@
+#ifndef LWIP_NETDB_H_
+#define LWIP_NETDB_H_
+
+#include <netdb.h>
+
+#endif /* LWIP_NETDB_H_ */
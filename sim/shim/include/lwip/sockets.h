@@ -0,0 +1,17 @@
+#ifndef LWIP_SOCKETS_H_
+#define LWIP_SOCKETS_H_
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief lwIP socket API is mapped to host BSD sockets
+ *
+ */
+#define inet_ntoa_r(addr, buf, buflen) inet_ntop(AF_INET, &(addr), buf, buflen)
+
+#endif /* LWIP_SOCKETS_H_ */
@@ -0,0 +1,9 @@
+#ifndef LWIP_SYS_H_
+#define LWIP_SYS_H_
+
+// FreeRTOS port of lwIP system layer exposes FreeRTOS primitives
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#endif /* LWIP_SYS_H_ */
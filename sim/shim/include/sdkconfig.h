@@ -0,0 +1,17 @@
+#ifndef SDKCONFIG_H_
+#define SDKCONFIG_H_
+
+/**
+ * @brief Host build configuration, subset of options read by simulated components
+ *
+ */
+#define CONFIG_IDF_TARGET       "linux"
+#define CONFIG_IDF_TARGET_LINUX 1
+
+#define CONFIG_LOG_VERSION_2                    1
+#define CONFIG_LOG_VERSION                      2
+#define CONFIG_LOG_DEFAULT_LEVEL                3
+#define CONFIG_LOG_DYNAMIC_LEVEL_CONTROL        1
+#define CONFIG_LOG_TIMESTAMP_SOURCE_SYSTEM_FULL 1
+
+#endif /* SDKCONFIG_H_ */
@@ -0,0 +1,16 @@
+#ifndef SOC_H_
+#define SOC_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Read-only data segment of executable, string literals are there as in flash of target
+ *
+ */
+extern uintptr_t sim_drom_low;
+extern uintptr_t sim_drom_high;
+
+#define SOC_DROM_LOW  sim_drom_low
+#define SOC_DROM_HIGH sim_drom_high
+
+#endif /* SOC_H_ */
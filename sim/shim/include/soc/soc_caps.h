@@ -0,0 +1,6 @@
+#ifndef SOC_CAPS_H_
+#define SOC_CAPS_H_
+
+#define SOC_UART_NUM 3
+
+#endif /* SOC_CAPS_H_ */
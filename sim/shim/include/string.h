@@ -0,0 +1,24 @@
+#ifndef SIM_STRING_H_
+#define SIM_STRING_H_
+
+#include_next <string.h>
+
+/**
+ * @brief BSD string functions of newlib, which are provided by glibc since 2.38
+ *
+ */
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+static inline size_t strlcpy(char* dst, const char* src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+#endif /* SIM_STRING_H_ */
@@ -0,0 +1,12 @@
+#ifndef VFS_SIM_H_
+#define VFS_SIM_H_
+
+/**
+ * @brief File system of firmware is mounted on /usr, simulator maps paths under /usr to host directory.
+ * File functions of libc are wrapped by linker, --wrap=fopen etc.
+ *
+ * @param dir Host directory, NULL disables mapping
+ */
+void vfs_sim_mount_usr(const char* dir);
+
+#endif /* VFS_SIM_H_ */
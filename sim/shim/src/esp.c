@@ -0,0 +1,378 @@
+#define _GNU_SOURCE
+
+#include <esp_app_desc.h>
+#include <esp_err.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_ota_ops.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <link.h>
+#include <pthread.h>
+#include <soc/soc.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef SIM_VERSION
+#define SIM_VERSION "sim"
+#endif
+
+static esp_log_level_t log_level = ESP_LOG_INFO;
+
+static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const char LOG_LETTERS[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+
+static const esp_app_desc_t app_desc = {
+    .magic_word = 0xABCD5432,
+    .version = SIM_VERSION,
+    .project_name = "esp32-evse",
+    .time = __TIME__,
+    .date = __DATE__,
+    .idf_ver = "linux",
+};
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND:
+        return "ESP_ERR_NVS_NOT_FOUND";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+uintptr_t sim_drom_low = 0;
+
+uintptr_t sim_drom_high = 0;
+
+static int log_vprintf_stderr(const char* format, va_list args)
+{
+    return vfprintf(stderr, format, args);
+}
+
+static vprintf_like_t log_vprintf = log_vprintf_stderr;
+
+static int log_printf(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int ret = log_vprintf(format, args);
+    va_end(args);
+
+    return ret;
+}
+
+void esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+    log_level = level;
+}
+
+esp_log_level_t esp_log_level_get(const char* tag)
+{
+    return log_level;
+}
+
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func)
+{
+    pthread_mutex_lock(&log_mutex);
+    vprintf_like_t prev = log_vprintf;
+    log_vprintf = func;
+    pthread_mutex_unlock(&log_mutex);
+
+    return prev;
+}
+
+void esp_log_va(esp_log_config_t config, const char* tag, const char* format, va_list args)
+{
+    esp_log_level_t level = config.opts.log_level;
+    if (level > log_level) return;
+
+    pthread_mutex_lock(&log_mutex);
+    if (config.opts.require_formatting) {
+        log_printf("%c (%lld) %s: ", LOG_LETTERS[level], (long long)(esp_timer_get_time() / 1000), tag);
+    }
+    log_vprintf(format, args);
+    if (config.opts.require_formatting) {
+        log_printf("\n");
+    }
+    pthread_mutex_unlock(&log_mutex);
+}
+
+void esp_log(esp_log_config_t config, const char* tag, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    esp_log_va(config, tag, format, args);
+    va_end(args);
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    if (level > log_level) return;
+
+    va_list args;
+    va_start(args, format);
+
+    pthread_mutex_lock(&log_mutex);
+    log_vprintf(format, args);
+    pthread_mutex_unlock(&log_mutex);
+
+    va_end(args);
+}
+
+void esp_log_buffer_hex_internal(const char* tag, const void* buffer, uint16_t buff_len, esp_log_level_t level)
+{
+    if (level > log_level) return;
+
+    const uint8_t* data = (const uint8_t*)buffer;
+    char line[16 * 3 + 1];
+
+    for (uint16_t offset = 0; offset < buff_len; offset += 16) {
+        int pos = 0;
+        for (uint16_t i = offset; i < buff_len && i < offset + 16; i++) {
+            pos += snprintf(&line[pos], sizeof(line) - pos, "%02x ", data[i]);
+        }
+        esp_log(ESP_LOG_CONFIG_INIT(level), tag, "%s", line);
+    }
+}
+
+static struct timespec start;
+
+static int drom_find(struct dl_phdr_info* info, size_t size, void* data)
+{
+    uintptr_t anchor = (uintptr_t)data;
+
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)* phdr = &info->dlpi_phdr[i];
+        uintptr_t low = info->dlpi_addr + phdr->p_vaddr;
+        if (phdr->p_type == PT_LOAD && anchor >= low && anchor < low + phdr->p_memsz) {
+            sim_drom_low = low;
+            sim_drom_high = low + phdr->p_memsz;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void __attribute__((constructor)) start_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // segment with string literals of executable stands for flash data of target
+    dl_iterate_phdr(drom_find, (void*)"drom");
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)(now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+struct esp_timer {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    esp_timer_cb_t callback;
+    void* arg;
+    int64_t deadline;  // INT64_MAX when stopped
+    bool deleted;
+};
+
+static void* esp_timer_thread(void* param)
+{
+    struct esp_timer* timer = (struct esp_timer*)param;
+
+    pthread_mutex_lock(&timer->mutex);
+    while (!timer->deleted) {
+        if (timer->deadline == INT64_MAX) {
+            pthread_cond_wait(&timer->cond, &timer->mutex);
+        } else if (esp_timer_get_time() >= timer->deadline) {
+            timer->deadline = INT64_MAX;
+            pthread_mutex_unlock(&timer->mutex);
+            timer->callback(timer->arg);
+            pthread_mutex_lock(&timer->mutex);
+        } else {
+            // deadline in esp_timer time base to absolute monotonic time
+            int64_t us = timer->deadline;
+            struct timespec ts = {
+                .tv_sec = start.tv_sec + us / 1000000,
+                .tv_nsec = start.tv_nsec + (us % 1000000) * 1000,
+            };
+            if (ts.tv_nsec >= 1000000000) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&timer->cond, &timer->mutex, &ts);
+        }
+    }
+    pthread_mutex_unlock(&timer->mutex);
+
+    pthread_mutex_destroy(&timer->mutex);
+    pthread_cond_destroy(&timer->cond);
+    free((void*)timer);
+
+    return NULL;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct esp_timer* timer = (struct esp_timer*)calloc(1, sizeof(struct esp_timer));
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->deadline = INT64_MAX;
+
+    pthread_mutex_init(&timer->mutex, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, esp_timer_thread, timer) != 0) {
+        pthread_mutex_destroy(&timer->mutex);
+        pthread_cond_destroy(&timer->cond);
+        free((void*)timer);
+        return ESP_ERR_NO_MEM;
+    }
+    if (create_args->name) {
+        pthread_setname_np(thread, create_args->name);
+    }
+    pthread_detach(thread);
+
+    *out_handle = timer;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&timer->mutex);
+    if (timer->deadline != INT64_MAX) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        timer->deadline = esp_timer_get_time() + timeout_us;
+        pthread_cond_signal(&timer->cond);
+    }
+    pthread_mutex_unlock(&timer->mutex);
+
+    return ret;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&timer->mutex);
+    if (timer->deadline == INT64_MAX) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        timer->deadline = INT64_MAX;
+        pthread_cond_signal(&timer->cond);
+    }
+    pthread_mutex_unlock(&timer->mutex);
+
+    return ret;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    // released by timer thread
+    pthread_mutex_lock(&timer->mutex);
+    timer->deleted = true;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->mutex);
+
+    return ESP_OK;
+}
+
+void esp_restart(void)
+{
+    ESP_LOGW("system", "Restart requested, exiting");
+    fflush(NULL);
+    exit(EXIT_SUCCESS);
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return 0;
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+void* heap_caps_malloc_prefer(size_t size, size_t num, ...)
+{
+    return malloc(size);
+}
+
+void* heap_caps_realloc_prefer(void* ptr, size_t size, size_t num, ...)
+{
+    return realloc(ptr, size);
+}
+
+void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
+{
+    return aligned_alloc(alignment, size);
+}
+
+void heap_caps_free(void* ptr)
+{
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return 0;
+}
+
+const esp_app_desc_t* esp_app_get_description(void)
+{
+    return &app_desc;
+}
+
+int esp_app_get_elf_sha256(char* dst, size_t size)
+{
+    int len = 0;
+    for (size_t i = 0; i < sizeof(app_desc.app_elf_sha256) && len + 2 < size; i++) {
+        len += snprintf(&dst[len], size - len, "%02x", app_desc.app_elf_sha256[i]);
+    }
+
+    return len;
+}
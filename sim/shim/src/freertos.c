@@ -0,0 +1,496 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct task_s {
+    pthread_t thread;
+    TaskFunction_t func;
+    void* param;
+    void* tls[configNUM_THREAD_LOCAL_STORAGE_POINTERS];
+    pthread_mutex_t notify_mutex;
+    pthread_cond_t notify_cond;
+    uint32_t notify_value;
+    bool notify_pending;
+};
+
+struct queue_s {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint8_t* items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct event_group_s {
+    atomic_uint bits;
+};
+
+struct timer_s {
+    TickType_t period;
+    bool auto_reload;
+    void* id;
+    TimerCallbackFunction_t callback;
+    bool running;
+    bool deleted;
+};
+
+static __thread struct task_s* current_task = NULL;
+
+static void abs_timeout(TickType_t ticks, struct timespec* ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    uint64_t ms = pdTICKS_TO_MS(ticks);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+static void cond_init(pthread_cond_t* cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct task_s* task_alloc(void)
+{
+    struct task_s* task = (struct task_s*)calloc(1, sizeof(struct task_s));
+    pthread_mutex_init(&task->notify_mutex, NULL);
+    cond_init(&task->notify_cond);
+
+    return task;
+}
+
+/**
+ * Task of thread not created by xTaskCreate, eg. main thread
+ */
+static struct task_s* get_current_task(void)
+{
+    if (!current_task) {
+        current_task = task_alloc();
+        current_task->thread = pthread_self();
+    }
+    return current_task;
+}
+
+static void* task_thread(void* arg)
+{
+    current_task = (struct task_s*)arg;
+    current_task->func(current_task->param);
+    // task function should never return
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t func, const char* name, uint32_t stack_depth, void* param, UBaseType_t priority, TaskHandle_t* handle)
+{
+    struct task_s* task = task_alloc();
+    task->func = func;
+    task->param = param;
+
+    if (pthread_create(&task->thread, NULL, task_thread, task) != 0) {
+        free((void*)task);
+        return pdFAIL;
+    }
+    pthread_setname_np(task->thread, name);
+    pthread_detach(task->thread);
+
+    if (handle) *handle = task;
+
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char* name, uint32_t stack_depth, void* param, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core_id)
+{
+    return xTaskCreate(func, name, stack_depth, param, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == current_task) {
+        free((void*)current_task);
+        current_task = NULL;
+        pthread_exit(NULL);
+    }
+    pthread_cancel(task->thread);
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts;
+    abs_timeout(ticks, &ts);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+BaseType_t xTaskDelayUntil(TickType_t* prev_wake_time, TickType_t increment)
+{
+    *prev_wake_time += increment;
+
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*prev_wake_time - now) <= 0) {
+        return pdFALSE;
+    }
+    vTaskDelay(*prev_wake_time - now);
+
+    return pdTRUE;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    // shares time base with esp_timer
+    return pdMS_TO_TICKS(esp_timer_get_time() / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return get_current_task();
+}
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void* value)
+{
+    if (task == NULL) task = get_current_task();
+    if (index >= 0 && index < configNUM_THREAD_LOCAL_STORAGE_POINTERS) {
+        task->tls[index] = value;
+    }
+}
+
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index)
+{
+    if (task == NULL) task = get_current_task();
+    if (index >= 0 && index < configNUM_THREAD_LOCAL_STORAGE_POINTERS) {
+        return task->tls[index];
+    }
+    return NULL;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->notify_mutex);
+    task->notify_value++;
+    task->notify_pending = true;
+    pthread_cond_signal(&task->notify_cond);
+    pthread_mutex_unlock(&task->notify_mutex);
+
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken)
+{
+    xTaskNotifyGive(task);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct task_s* task = get_current_task();
+    struct timespec ts;
+    abs_timeout(ticks, &ts);
+
+    pthread_mutex_lock(&task->notify_mutex);
+    while (task->notify_value == 0 && ticks > 0) {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&task->notify_cond, &task->notify_mutex);
+        } else if (pthread_cond_timedwait(&task->notify_cond, &task->notify_mutex, &ts) == ETIMEDOUT) {
+            break;
+        }
+    }
+    uint32_t value = task->notify_value;
+    if (value) task->notify_value = clear_on_exit ? 0 : value - 1;
+    task->notify_pending = false;
+    pthread_mutex_unlock(&task->notify_mutex);
+
+    return value;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    pthread_mutex_lock(&task->notify_mutex);
+    switch (action) {
+    case eSetBits:
+        task->notify_value |= value;
+        break;
+    case eIncrement:
+        task->notify_value++;
+        break;
+    case eSetValueWithOverwrite:
+        task->notify_value = value;
+        break;
+    default:
+        break;
+    }
+    task->notify_pending = true;
+    pthread_cond_signal(&task->notify_cond);
+    pthread_mutex_unlock(&task->notify_mutex);
+
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* higher_priority_task_woken)
+{
+    return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit, uint32_t* value, TickType_t ticks)
+{
+    struct task_s* task = get_current_task();
+    struct timespec ts;
+    abs_timeout(ticks, &ts);
+
+    pthread_mutex_lock(&task->notify_mutex);
+    if (!task->notify_pending) {
+        task->notify_value &= ~bits_to_clear_on_entry;
+    }
+    while (!task->notify_pending && ticks > 0) {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&task->notify_cond, &task->notify_mutex);
+        } else if (pthread_cond_timedwait(&task->notify_cond, &task->notify_mutex, &ts) == ETIMEDOUT) {
+            break;
+        }
+    }
+    BaseType_t notified = task->notify_pending;
+    if (value) *value = task->notify_value;
+    if (notified) {
+        task->notify_value &= ~bits_to_clear_on_exit;
+        task->notify_pending = false;
+    }
+    pthread_mutex_unlock(&task->notify_mutex);
+
+    return notified;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+BaseType_t xPortInIsrContext(void)
+{
+    return pdFALSE;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct queue_s* queue = (struct queue_s*)calloc(1, sizeof(struct queue_s));
+    pthread_mutex_init(&queue->mutex, NULL);
+    cond_init(&queue->cond);
+    queue->length = length;
+    queue->item_size = item_size;
+    if (item_size > 0) {
+        queue->items = (uint8_t*)malloc(length * item_size);
+    }
+
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_cond_destroy(&queue->cond);
+    pthread_mutex_destroy(&queue->mutex);
+    free((void*)queue->items);
+    free((void*)queue);
+}
+
+/**
+ * Wait on queue condition until predicate is true, mutex must be locked
+ */
+static bool queue_wait(QueueHandle_t queue, bool for_space, TickType_t ticks_to_wait)
+{
+    struct timespec ts;
+    if (ticks_to_wait != portMAX_DELAY) abs_timeout(ticks_to_wait, &ts);
+
+    while (for_space ? queue->count >= queue->length : queue->count == 0) {
+        if (ticks_to_wait == 0) return false;
+
+        if (ticks_to_wait == portMAX_DELAY) {
+            pthread_cond_wait(&queue->cond, &queue->mutex);
+        } else if (pthread_cond_timedwait(&queue->cond, &queue->mutex, &ts) == ETIMEDOUT) {
+            return for_space ? queue->count < queue->length : queue->count > 0;
+        }
+    }
+
+    return true;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait)
+{
+    pthread_mutex_lock(&queue->mutex);
+
+    bool ret = queue_wait(queue, true, ticks_to_wait);
+    if (ret) {
+        if (queue->item_size > 0) {
+            UBaseType_t tail = (queue->head + queue->count) % queue->length;
+            memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+        }
+        queue->count++;
+        pthread_cond_broadcast(&queue->cond);
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+
+    return ret ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks_to_wait)
+{
+    pthread_mutex_lock(&queue->mutex);
+
+    bool ret = queue_wait(queue, false, ticks_to_wait);
+    if (ret) {
+        if (queue->item_size > 0) {
+            memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+        }
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+
+    return ret ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->mutex);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->mutex);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+
+    return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+    xSemaphoreGive(mutex);
+
+    return mutex;
+}
+
+/**
+ * Every started timer has own task, timer service task is not simulated
+ */
+static void timer_task_func(void* param)
+{
+    TimerHandle_t timer = (TimerHandle_t)param;
+
+    do {
+        vTaskDelay(timer->period);
+        if (timer->running && !timer->deleted) {
+            timer->callback(timer);
+        }
+    } while (timer->auto_reload && timer->running && !timer->deleted);
+
+    timer->running = false;
+    if (timer->deleted) {
+        free((void*)timer);
+    }
+    vTaskDelete(NULL);
+}
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t auto_reload, void* id, TimerCallbackFunction_t callback)
+{
+    struct timer_s* timer = (struct timer_s*)calloc(1, sizeof(struct timer_s));
+    timer->period = period;
+    timer->auto_reload = auto_reload;
+    timer->id = id;
+    timer->callback = callback;
+
+    return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks_to_wait)
+{
+    if (timer->running) return pdPASS;
+
+    timer->running = true;
+
+    return xTaskCreate(timer_task_func, "timer", 0, timer, 1, NULL);
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks_to_wait)
+{
+    timer->running = false;
+
+    return pdPASS;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks_to_wait)
+{
+    if (timer->running) {
+        // released by timer task
+        timer->deleted = true;
+    } else {
+        free((void*)timer);
+    }
+
+    return pdPASS;
+}
+
+void* pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer->id;
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return (EventGroupHandle_t)calloc(1, sizeof(struct event_group_s));
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    free((void*)group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    return atomic_fetch_or(&group->bits, bits) | bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    return atomic_fetch_and(&group->bits, ~bits);
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    return atomic_load(&group->bits);
+}
@@ -0,0 +1,61 @@
+#include <esp_log.h>
+#include <mqtt_client.h>
+#include <stdlib.h>
+
+static const char* TAG = "mqtt_client";
+
+struct esp_mqtt_client {
+    esp_event_handler_t event_handler;
+    void* event_handler_arg;
+};
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config)
+{
+    if (!config || !config->broker.address.uri) {
+        return NULL;
+    }
+
+    return (esp_mqtt_client_handle_t)calloc(1, sizeof(struct esp_mqtt_client));
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event, esp_event_handler_t event_handler, void* event_handler_arg)
+{
+    client->event_handler = event_handler;
+    client->event_handler_arg = event_handler_arg;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
+{
+    ESP_LOGW(TAG, "No network on host");
+
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_mqtt_client_disconnect(esp_mqtt_client_handle_t client)
+{
+    return ESP_OK;
+}
+
+int esp_mqtt_client_subscribe_single(esp_mqtt_client_handle_t client, const char* topic, int qos)
+{
+    return -1;
+}
+
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client, const char* topic)
+{
+    return -1;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data, int len, int qos, int retain)
+{
+    return -1;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client)
+{
+    free((void*)client);
+
+    return ESP_OK;
+}
@@ -0,0 +1,231 @@
+#include <nvs.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/queue.h>
+
+#define NAMESPACE_COUNT 16
+#define NAME_SIZE       16
+
+typedef enum {
+    ENTRY_TYPE_U8,
+    ENTRY_TYPE_U16,
+    ENTRY_TYPE_U32,
+    ENTRY_TYPE_I32,
+    ENTRY_TYPE_U64,
+    ENTRY_TYPE_STR
+} entry_type_t;
+
+typedef struct entry_s {
+    nvs_handle_t handle;
+    char key[NAME_SIZE];
+    entry_type_t type;
+    uint64_t value;
+    char* str;
+    SLIST_ENTRY(entry_s) entries;
+} entry_t;
+
+static SLIST_HEAD(entry_list_s, entry_s) entry_list = SLIST_HEAD_INITIALIZER(entry_list);
+
+static char namespaces[NAMESPACE_COUNT][NAME_SIZE];
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Find entry, mutex must be locked
+ */
+static entry_t* find_entry(nvs_handle_t handle, const char* key)
+{
+    entry_t* entry;
+    SLIST_FOREACH (entry, &entry_list, entries) {
+        if (entry->handle == handle && strcmp(entry->key, key) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t set_value(nvs_handle_t handle, const char* key, entry_type_t type, uint64_t value, const char* str)
+{
+    if (strlen(key) >= NAME_SIZE) return ESP_ERR_NVS_INVALID_NAME;
+
+    pthread_mutex_lock(&mutex);
+
+    entry_t* entry = find_entry(handle, key);
+    if (!entry) {
+        entry = (entry_t*)calloc(1, sizeof(entry_t));
+        entry->handle = handle;
+        strcpy(entry->key, key);
+        SLIST_INSERT_HEAD(&entry_list, entry, entries);
+    }
+    entry->type = type;
+    entry->value = value;
+    free((void*)entry->str);
+    entry->str = str ? strdup(str) : NULL;
+
+    pthread_mutex_unlock(&mutex);
+
+    return ESP_OK;
+}
+
+static esp_err_t get_value(nvs_handle_t handle, const char* key, entry_type_t type, uint64_t* value)
+{
+    esp_err_t ret = ESP_ERR_NVS_NOT_FOUND;
+
+    pthread_mutex_lock(&mutex);
+
+    entry_t* entry = find_entry(handle, key);
+    if (entry && entry->type == type) {
+        *value = entry->value;
+        ret = ESP_OK;
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return ret;
+}
+
+esp_err_t nvs_open(const char* namespace_name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+    if (strlen(namespace_name) >= NAME_SIZE) return ESP_ERR_NVS_INVALID_NAME;
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    pthread_mutex_lock(&mutex);
+
+    // handle is namespace index + 1, so same namespace share entries
+    for (nvs_handle_t i = 0; i < NAMESPACE_COUNT; i++) {
+        if (namespaces[i][0] == '\0') {
+            strcpy(namespaces[i], namespace_name);
+        }
+        if (strcmp(namespaces[i], namespace_name) == 0) {
+            *out_handle = i + 1;
+            ret = ESP_OK;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return ret;
+}
+
+void nvs_close(nvs_handle_t handle)
+{}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key)
+{
+    esp_err_t ret = ESP_ERR_NVS_NOT_FOUND;
+
+    pthread_mutex_lock(&mutex);
+
+    entry_t* entry = find_entry(handle, key);
+    if (entry) {
+        SLIST_REMOVE(&entry_list, entry, entry_s, entries);
+        free((void*)entry->str);
+        free((void*)entry);
+        ret = ESP_OK;
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return ret;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value)
+{
+    return set_value(handle, key, ENTRY_TYPE_U8, value, NULL);
+}
+
+esp_err_t nvs_set_u16(nvs_handle_t handle, const char* key, uint16_t value)
+{
+    return set_value(handle, key, ENTRY_TYPE_U16, value, NULL);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value)
+{
+    return set_value(handle, key, ENTRY_TYPE_U32, value, NULL);
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char* key, int32_t value)
+{
+    return set_value(handle, key, ENTRY_TYPE_I32, (uint32_t)value, NULL);
+}
+
+esp_err_t nvs_set_u64(nvs_handle_t handle, const char* key, uint64_t value)
+{
+    return set_value(handle, key, ENTRY_TYPE_U64, value, NULL);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value)
+{
+    return set_value(handle, key, ENTRY_TYPE_STR, 0, value);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* out_value)
+{
+    uint64_t value;
+    esp_err_t ret = get_value(handle, key, ENTRY_TYPE_U8, &value);
+    if (ret == ESP_OK) *out_value = value;
+    return ret;
+}
+
+esp_err_t nvs_get_u16(nvs_handle_t handle, const char* key, uint16_t* out_value)
+{
+    uint64_t value;
+    esp_err_t ret = get_value(handle, key, ENTRY_TYPE_U16, &value);
+    if (ret == ESP_OK) *out_value = value;
+    return ret;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value)
+{
+    uint64_t value;
+    esp_err_t ret = get_value(handle, key, ENTRY_TYPE_U32, &value);
+    if (ret == ESP_OK) *out_value = value;
+    return ret;
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char* key, int32_t* out_value)
+{
+    uint64_t value;
+    esp_err_t ret = get_value(handle, key, ENTRY_TYPE_I32, &value);
+    if (ret == ESP_OK) *out_value = (int32_t)(uint32_t)value;
+    return ret;
+}
+
+esp_err_t nvs_get_u64(nvs_handle_t handle, const char* key, uint64_t* out_value)
+{
+    return get_value(handle, key, ENTRY_TYPE_U64, out_value);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length)
+{
+    esp_err_t ret = ESP_ERR_NVS_NOT_FOUND;
+
+    pthread_mutex_lock(&mutex);
+
+    entry_t* entry = find_entry(handle, key);
+    if (entry && entry->type == ENTRY_TYPE_STR) {
+        size_t len = strlen(entry->str) + 1;
+        if (out_value == NULL) {
+            *length = len;
+            ret = ESP_OK;
+        } else if (*length < len) {
+            ret = ESP_ERR_NVS_INVALID_LENGTH;
+        } else {
+            memcpy(out_value, entry->str, len);
+            *length = len;
+            ret = ESP_OK;
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return ret;
+}
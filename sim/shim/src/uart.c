@@ -0,0 +1,329 @@
+#include <driver/uart.h>
+#include <errno.h>
+#include <esp_log.h>
+#include <fcntl.h>
+#include <freertos/task.h>
+#include <poll.h>
+#include <pthread.h>
+#include <pty.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define READ_CHUNK_SIZE  256
+#define POLL_TIMEOUT_MS  100
+#define WRITE_TIMEOUT_MS 100
+#define TTY_NAME_SIZE    64
+
+static const char* TAG = "uart";
+
+/**
+ * Port is pty master, received bytes are moved to ring buffer by reader task same as by UART ISR
+ */
+typedef struct {
+    int fd;
+    char tty_name[TTY_NAME_SIZE];
+    pthread_mutex_t mutex;
+    uint8_t* rx_buf;
+    size_t rx_buf_size;
+    size_t rx_head;
+    size_t rx_len;
+    QueueHandle_t event_queue;
+    char pattern_chr;
+    uint8_t pattern_count;
+    uint8_t pattern_run;
+    int pattern_pos_count;
+    volatile bool stop;
+    volatile bool stopped;
+} uart_ctx_t;
+
+static uart_ctx_t* ports[UART_NUM_MAX] = { 0 };
+
+static void post_event(uart_ctx_t* ctx, uart_event_type_t type, size_t size)
+{
+    if (ctx->event_queue) {
+        uart_event_t event = {
+            .type = type,
+            .size = size,
+            .timeout_flag = false,
+        };
+        xQueueSend(ctx->event_queue, &event, 0);
+    }
+}
+
+/**
+ * Store received bytes, mutex must be locked
+ */
+static void rx_push(uart_ctx_t* ctx, const uint8_t* data, size_t len)
+{
+    size_t pushed = 0;
+    bool pattern = false;
+
+    for (size_t i = 0; i < len; i++) {
+        if (ctx->rx_len >= ctx->rx_buf_size) break;
+
+        ctx->rx_buf[(ctx->rx_head + ctx->rx_len) % ctx->rx_buf_size] = data[i];
+        ctx->rx_len++;
+        pushed++;
+
+        if (ctx->pattern_count > 0) {
+            if (data[i] == (uint8_t)ctx->pattern_chr) {
+                if (++ctx->pattern_run == ctx->pattern_count) {
+                    ctx->pattern_run = 0;
+                    ctx->pattern_pos_count++;
+                    pattern = true;
+                }
+            } else {
+                ctx->pattern_run = 0;
+            }
+        }
+    }
+
+    if (pushed > 0) post_event(ctx, pattern ? UART_PATTERN_DET : UART_DATA, pushed);
+    if (pushed < len) post_event(ctx, UART_BUFFER_FULL, len - pushed);
+}
+
+static void reader_task_func(void* param)
+{
+    uart_ctx_t* ctx = (uart_ctx_t*)param;
+    uint8_t buf[READ_CHUNK_SIZE];
+
+    while (!ctx->stop) {
+        struct pollfd pfd = {
+            .fd = ctx->fd,
+            .events = POLLIN,
+        };
+        int ret = poll(&pfd, 1, POLL_TIMEOUT_MS);
+        if (ret <= 0) continue;
+
+        if (pfd.revents & POLLHUP) {
+            // no client is connected to slave side
+            vTaskDelay(pdMS_TO_TICKS(POLL_TIMEOUT_MS));
+            continue;
+        }
+
+        ssize_t len = read(ctx->fd, buf, sizeof(buf));
+        if (len > 0) {
+            pthread_mutex_lock(&ctx->mutex);
+            rx_push(ctx, buf, len);
+            pthread_mutex_unlock(&ctx->mutex);
+        } else if (len < 0 && errno != EAGAIN && errno != EINTR) {
+            vTaskDelay(pdMS_TO_TICKS(POLL_TIMEOUT_MS));
+        }
+    }
+
+    ctx->stopped = true;
+    vTaskDelete(NULL);
+}
+
+static uart_ctx_t* get_ctx(uart_port_t uart_num)
+{
+    if (uart_num < 0 || uart_num >= UART_NUM_MAX) return NULL;
+    return ports[uart_num];
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size, QueueHandle_t* uart_queue, int intr_alloc_flags)
+{
+    if (uart_num < 0 || uart_num >= UART_NUM_MAX || rx_buffer_size <= 0) return ESP_ERR_INVALID_ARG;
+    if (ports[uart_num]) return ESP_ERR_INVALID_STATE;
+
+    int master, slave;
+    char tty_name[TTY_NAME_SIZE];
+    if (openpty(&master, &slave, tty_name, NULL, NULL) != 0) {
+        ESP_LOGE(TAG, "Can't open pty: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    // line discipline settings are kept while master is open, client may change them
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    close(slave);
+
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    uart_ctx_t* ctx = (uart_ctx_t*)calloc(1, sizeof(uart_ctx_t));
+    ctx->fd = master;
+    strcpy(ctx->tty_name, tty_name);
+    pthread_mutex_init(&ctx->mutex, NULL);
+    ctx->rx_buf = (uint8_t*)malloc(rx_buffer_size);
+    ctx->rx_buf_size = rx_buffer_size;
+    if (uart_queue && queue_size > 0) {
+        ctx->event_queue = xQueueCreate(queue_size, sizeof(uart_event_t));
+        *uart_queue = ctx->event_queue;
+    }
+
+    ports[uart_num] = ctx;
+
+    xTaskCreate(reader_task_func, "uart_rx", 0, ctx, 12, NULL);
+
+    ESP_LOGI(TAG, "Port %d on %s", uart_num, ctx->tty_name);
+
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    if (!ctx) return ESP_ERR_INVALID_STATE;
+
+    ctx->stop = true;
+    while (!ctx->stopped) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    ports[uart_num] = NULL;
+
+    close(ctx->fd);
+    if (ctx->event_queue) vQueueDelete(ctx->event_queue);
+    pthread_mutex_destroy(&ctx->mutex);
+    free((void*)ctx->rx_buf);
+    free((void*)ctx);
+
+    return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t* size)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    if (!ctx) return ESP_ERR_INVALID_STATE;
+
+    pthread_mutex_lock(&ctx->mutex);
+    *size = ctx->rx_len;
+    pthread_mutex_unlock(&ctx->mutex);
+
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void* buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    if (!ctx) return -1;
+
+    TickType_t start = xTaskGetTickCount();
+    uint32_t copied = 0;
+
+    while (true) {
+        pthread_mutex_lock(&ctx->mutex);
+        while (copied < length && ctx->rx_len > 0) {
+            size_t chunk = MIN(length - copied, MIN(ctx->rx_len, ctx->rx_buf_size - ctx->rx_head));
+            memcpy((uint8_t*)buf + copied, &ctx->rx_buf[ctx->rx_head], chunk);
+            ctx->rx_head = (ctx->rx_head + chunk) % ctx->rx_buf_size;
+            ctx->rx_len -= chunk;
+            copied += chunk;
+        }
+        pthread_mutex_unlock(&ctx->mutex);
+
+        if (copied >= length || xTaskGetTickCount() - start >= ticks_to_wait) break;
+        vTaskDelay(1);
+    }
+
+    return copied;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void* src, size_t size)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    if (!ctx) return -1;
+
+    // written data are dropped, when client does not read them, as on not connected wire
+    size_t written = 0;
+    while (written < size) {
+        ssize_t len = write(ctx->fd, (const uint8_t*)src + written, size - written);
+        if (len > 0) {
+            written += len;
+        } else if (len < 0 && errno == EAGAIN) {
+            struct pollfd pfd = {
+                .fd = ctx->fd,
+                .events = POLLOUT,
+            };
+            if (poll(&pfd, 1, WRITE_TIMEOUT_MS) <= 0 || (pfd.revents & POLLHUP)) break;
+        } else if (len < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+
+    return size;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    if (!ctx) return ESP_ERR_INVALID_STATE;
+
+    // writes are not buffered
+    return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    if (!ctx) return ESP_ERR_INVALID_STATE;
+
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->rx_head = 0;
+    ctx->rx_len = 0;
+    ctx->pattern_run = 0;
+    ctx->pattern_pos_count = 0;
+    pthread_mutex_unlock(&ctx->mutex);
+
+    return ESP_OK;
+}
+
+esp_err_t uart_enable_pattern_det_baud_intr(uart_port_t uart_num, char pattern_chr, uint8_t chr_num, int chr_tout, int post_idle, int pre_idle)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    if (!ctx) return ESP_ERR_INVALID_STATE;
+
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->pattern_chr = pattern_chr;
+    ctx->pattern_count = chr_num;
+    ctx->pattern_run = 0;
+    pthread_mutex_unlock(&ctx->mutex);
+
+    return ESP_OK;
+}
+
+esp_err_t uart_disable_pattern_det_intr(uart_port_t uart_num)
+{
+    return uart_enable_pattern_det_baud_intr(uart_num, 0, 0, 0, 0, 0);
+}
+
+esp_err_t uart_pattern_queue_reset(uart_port_t uart_num, int queue_length)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    if (!ctx) return ESP_ERR_INVALID_STATE;
+
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->pattern_pos_count = 0;
+    pthread_mutex_unlock(&ctx->mutex);
+
+    return ESP_OK;
+}
+
+int uart_pattern_pop_pos(uart_port_t uart_num)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    if (!ctx) return -1;
+
+    // positions are not tracked, only count of detected patterns
+    int pos = -1;
+    pthread_mutex_lock(&ctx->mutex);
+    if (ctx->pattern_pos_count > 0) {
+        ctx->pattern_pos_count--;
+        pos = 0;
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+
+    return pos;
+}
+
+const char* uart_sim_get_tty_name(uart_port_t uart_num)
+{
+    uart_ctx_t* ctx = get_ctx(uart_num);
+    return ctx ? ctx->tty_name : NULL;
+}
@@ -0,0 +1,120 @@
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vfs_sim.h>
+
+#define MOUNT_POINT "/usr"
+
+FILE* __real_fopen(const char* path, const char* mode);
+FILE* __real_freopen(const char* path, const char* mode, FILE* stream);
+FILE* __real_fopen64(const char* path, const char* mode);
+FILE* __real_freopen64(const char* path, const char* mode, FILE* stream);
+int __real_stat(const char* path, struct stat* st);
+DIR* __real_opendir(const char* path);
+int __real_mkdir(const char* path, mode_t mode);
+int __real_rmdir(const char* path);
+int __real_remove(const char* path);
+int __real_unlink(const char* path);
+int __real_rename(const char* old_path, const char* new_path);
+int __real_access(const char* path, int mode);
+
+static const char* usr_dir = NULL;
+
+void vfs_sim_mount_usr(const char* dir)
+{
+    usr_dir = dir;
+}
+
+/**
+ * Path under mount point is mapped to host directory, other paths are same
+ */
+static const char* map_path(const char* path, char* buf)
+{
+    size_t len = strlen(MOUNT_POINT);
+
+    if (usr_dir && path && strncmp(path, MOUNT_POINT, len) == 0 && (path[len] == '\0' || path[len] == '/')) {
+        snprintf(buf, PATH_MAX, "%s%s", usr_dir, &path[len]);
+        return buf;
+    }
+
+    return path;
+}
+
+FILE* __wrap_fopen(const char* path, const char* mode)
+{
+    char buf[PATH_MAX];
+    return __real_fopen(map_path(path, buf), mode);
+}
+
+FILE* __wrap_freopen(const char* path, const char* mode, FILE* stream)
+{
+    char buf[PATH_MAX];
+    return __real_freopen(map_path(path, buf), mode, stream);
+}
+
+// Lua is compiled with _FILE_OFFSET_BITS 64
+FILE* __wrap_fopen64(const char* path, const char* mode)
+{
+    char buf[PATH_MAX];
+    return __real_fopen64(map_path(path, buf), mode);
+}
+
+FILE* __wrap_freopen64(const char* path, const char* mode, FILE* stream)
+{
+    char buf[PATH_MAX];
+    return __real_freopen64(map_path(path, buf), mode, stream);
+}
+
+int __wrap_stat(const char* path, struct stat* st)
+{
+    char buf[PATH_MAX];
+    return __real_stat(map_path(path, buf), st);
+}
+
+DIR* __wrap_opendir(const char* path)
+{
+    char buf[PATH_MAX];
+    return __real_opendir(map_path(path, buf));
+}
+
+int __wrap_mkdir(const char* path, mode_t mode)
+{
+    char buf[PATH_MAX];
+    return __real_mkdir(map_path(path, buf), mode);
+}
+
+int __wrap_rmdir(const char* path)
+{
+    char buf[PATH_MAX];
+    return __real_rmdir(map_path(path, buf));
+}
+
+int __wrap_remove(const char* path)
+{
+    char buf[PATH_MAX];
+    return __real_remove(map_path(path, buf));
+}
+
+int __wrap_unlink(const char* path)
+{
+    char buf[PATH_MAX];
+    return __real_unlink(map_path(path, buf));
+}
+
+int __wrap_rename(const char* old_path, const char* new_path)
+{
+    char old_buf[PATH_MAX];
+    char new_buf[PATH_MAX];
+    return __real_rename(map_path(old_path, old_buf), map_path(new_path, new_buf));
+}
+
+int __wrap_access(const char* path, int mode)
+{
+    char buf[PATH_MAX];
+    return __real_access(map_path(path, buf), mode);
+}
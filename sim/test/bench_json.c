@@ -0,0 +1,190 @@
+#include <cJSON.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "l_bytes_lib.h"
+#include "l_json_lib.h"
+#include "lauxlib.h"
+#include "lua.h"
+#include "lualib.h"
+
+/**
+ * Round trip of json library compared with previous implementation, which converted through cJSON tree
+ */
+
+#define RECORD_COUNT 50
+#define ITERATIONS   2000
+
+void script_output_append_buf(const char* str, uint16_t len)
+{
+    fwrite(str, 1, len, stdout);
+}
+
+static void cjson_decode_child(lua_State* L, cJSON* obj)
+{
+    if (cJSON_IsBool(obj)) {
+        lua_pushboolean(L, cJSON_IsTrue(obj));
+    } else if (cJSON_IsNumber(obj)) {
+        lua_pushnumber(L, cJSON_GetNumberValue(obj));
+    } else if (cJSON_IsString(obj)) {
+        lua_pushstring(L, cJSON_GetStringValue(obj));
+    } else if (cJSON_IsObject(obj)) {
+        lua_newtable(L);
+        cJSON* child = obj->child;
+        while (child) {
+            lua_pushstring(L, child->string);
+            cjson_decode_child(L, child);
+            lua_settable(L, -3);
+
+            child = child->next;
+        }
+    } else if (cJSON_IsArray(obj)) {
+        lua_newtable(L);
+        cJSON* child = obj->child;
+        int array_index = 1;
+        while (child) {
+            cjson_decode_child(L, child);
+            lua_rawseti(L, -2, array_index++);
+
+            child = child->next;
+        }
+    } else {
+        lua_pushnil(L);
+    }
+}
+
+static cJSON* cjson_encode_child(lua_State* L)
+{
+    cJSON* obj;
+
+    switch (lua_type(L, -1)) {
+    case LUA_TSTRING:
+        obj = cJSON_CreateString(lua_tostring(L, -1));
+        break;
+    case LUA_TNUMBER:
+        obj = cJSON_CreateNumber(lua_tonumber(L, -1));
+        break;
+    case LUA_TBOOLEAN:
+        obj = cJSON_CreateBool(lua_toboolean(L, -1));
+        break;
+    case LUA_TTABLE: {
+        int len = lua_rawlen(L, -1);
+        if (len > 0) {
+            obj = cJSON_CreateArray();
+            for (int i = 1; i <= len; i++) {
+                lua_rawgeti(L, -1, i);
+                cJSON_AddItemToArray(obj, cjson_encode_child(L));
+                lua_pop(L, 1);
+            }
+        } else {
+            obj = cJSON_CreateObject();
+            lua_pushnil(L);
+            while (lua_next(L, -2)) {
+                cJSON_AddItemToObject(obj, lua_tostring(L, -2), cjson_encode_child(L));
+                lua_pop(L, 1);
+            }
+        }
+        break;
+    }
+    default:
+        obj = cJSON_CreateNull();
+    }
+
+    return obj;
+}
+
+static int l_cjson_decode(lua_State* L)
+{
+    cJSON* root = cJSON_Parse(luaL_checkstring(L, 1));
+    if (root == NULL) {
+        luaL_error(L, "failed to decode json");
+    }
+    cjson_decode_child(L, root);
+    cJSON_Delete(root);
+
+    return 1;
+}
+
+static int l_cjson_encode(lua_State* L)
+{
+    lua_pushvalue(L, 1);
+    cJSON* root = cjson_encode_child(L);
+    lua_pop(L, 1);
+
+    char* json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    lua_pushstring(L, json);
+    free((void*)json);
+
+    return 1;
+}
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static double bench(lua_State* L, const char* encode, const char* decode)
+{
+    char chunk[256];
+    snprintf(chunk, sizeof(chunk), "local s = %s(data) local t = %s(s) assert(#t == %d)", encode, decode, RECORD_COUNT);
+    if (luaL_loadstring(L, chunk) != LUA_OK) {
+        fprintf(stderr, "%s\n", lua_tostring(L, -1));
+        exit(EXIT_FAILURE);
+    }
+
+    int64_t start = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        lua_pushvalue(L, -1);
+        if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+            fprintf(stderr, "%s\n", lua_tostring(L, -1));
+            exit(EXIT_FAILURE);
+        }
+    }
+    int64_t elapsed = now_us() - start;
+    lua_pop(L, 1);
+
+    return (double)elapsed / ITERATIONS;
+}
+
+int main(int argc, char** argv)
+{
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+
+    luaL_requiref(L, "bytes", luaopen_bytes, 1);
+    lua_pop(L, 1);
+    luaL_requiref(L, "json", luaopen_json, 1);
+    lua_pop(L, 1);
+    lua_register(L, "cjson_encode", l_cjson_encode);
+    lua_register(L, "cjson_decode", l_cjson_decode);
+
+    // records alike of energy meter history sent by script over MQTT
+    char chunk[512];
+    snprintf(chunk,
+             sizeof(chunk),
+             "data = {} for i = 1, %d do data[i] = { id = i, name = 'session ' .. i, energy = i * 1.5, power = i * 100, "
+             "charging = i %% 2 == 0, phases = { 230, 231, 229 } } end size = #json.encode(data)",
+             RECORD_COUNT);
+    if (luaL_dostring(L, chunk) != LUA_OK) {
+        fprintf(stderr, "%s\n", lua_tostring(L, -1));
+        return EXIT_FAILURE;
+    }
+    lua_getglobal(L, "size");
+    printf("%d records, %" PRId64 " bytes of json, %d iterations\n", RECORD_COUNT, (int64_t)lua_tointeger(L, -1), ITERATIONS);
+    lua_pop(L, 1);
+
+    printf("json: %.1f us per round trip\n", bench(L, "json.encode", "json.decode"));
+    printf("cJSON tree: %.1f us per round trip\n", bench(L, "cjson_encode", "cjson_decode"));
+
+    lua_close(L);
+
+    return EXIT_SUCCESS;
+}
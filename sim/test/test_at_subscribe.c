@@ -0,0 +1,287 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "at.h"
+#include "at_task.h"
+#include "cat.h"
+#include "serial_port.h"
+
+/**
+ * Subscription reports of AT task over simulated uart, each as line or joined to lines by AT+SUBJOIN
+ */
+
+#define AT_PORT   UART_NUM_1
+#define LONG_SIZE 101  // response fits half of cat buffer
+
+static uint32_t num = 1;
+
+static char str[32] = "a;b\\c";
+
+static char long1[LONG_SIZE];
+
+static char long2[LONG_SIZE];
+
+static char long3[LONG_SIZE];
+
+static struct cat_variable vars_num[] = {
+    {
+        .type = CAT_VAR_UINT_DEC,
+        .data = &num,
+        .data_size = sizeof(num),
+        .access = CAT_VAR_ACCESS_READ_ONLY,
+    },
+};
+
+#define DEF_VARS_STR(vars_name, buf)               \
+    static struct cat_variable vars_name[] = {     \
+        {                                          \
+            .type = CAT_VAR_BUF_STRING,            \
+            .data = buf,                           \
+            .data_size = sizeof(buf),              \
+            .access = CAT_VAR_ACCESS_READ_ONLY,    \
+        },                                         \
+    };
+
+DEF_VARS_STR(vars_str, str);
+
+DEF_VARS_STR(vars_long1, long1);
+
+DEF_VARS_STR(vars_long2, long2);
+
+DEF_VARS_STR(vars_long3, long3);
+
+static cat_return_state cmd_run(const struct cat_command* cmd)
+{
+    return CAT_RETURN_STATE_OK;
+}
+
+static struct cat_command cmds[] = {
+    {
+        .name = "+TNUM",
+        .var = vars_num,
+        .var_num = 1,
+    },
+    {
+        .name = "+TSTR",
+        .var = vars_str,
+        .var_num = 1,
+    },
+    {
+        .name = "+TLONG1",
+        .var = vars_long1,
+        .var_num = 1,
+    },
+    {
+        .name = "+TLONG2",
+        .var = vars_long2,
+        .var_num = 1,
+    },
+    {
+        .name = "+TLONG3",
+        .var = vars_long3,
+        .var_num = 1,
+    },
+    {
+        .name = "+TSYSTEM",
+        .run = cmd_run,
+    },
+    {
+        .name = "+TSERIAL",
+        .run = cmd_run,
+    },
+    {
+        .name = "+TNETWORK",
+        .run = cmd_run,
+    },
+    {
+        .name = "+TBOARD",
+        .run = cmd_run,
+    },
+};
+
+// command groups of firmware are replaced by test commands
+struct cat_command_group at_cmd_evse_group = {
+    .cmd = &cmds[0],
+    .cmd_num = 2,
+};
+
+struct cat_command_group at_cmd_energy_meter_group = {
+    .cmd = &cmds[2],
+    .cmd_num = 3,
+};
+
+struct cat_command_group at_cmd_system_group = {
+    .cmd = &cmds[5],
+    .cmd_num = 1,
+};
+
+struct cat_command_group at_cmd_serial_group = {
+    .cmd = &cmds[6],
+    .cmd_num = 1,
+};
+
+struct cat_command_group at_cmd_network_group = {
+    .cmd = &cmds[7],
+    .cmd_num = 1,
+};
+
+struct cat_command_group at_cmd_board_config_group = {
+    .cmd = &cmds[8],
+    .cmd_num = 1,
+};
+
+void wifi_scan_aps_free(wifi_scan_ap_list_t* list)
+{}
+
+static int client_open(void)
+{
+    int fd = open(uart_sim_get_tty_name(AT_PORT), O_RDWR | O_NOCTTY);
+    assert(fd >= 0);
+
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+
+    return fd;
+}
+
+/**
+ * Receive everything for duration
+ */
+static size_t receive(int fd, char* buf, size_t size, int duration_ms)
+{
+    size_t len = 0;
+    struct pollfd pfd = {
+        .fd = fd,
+        .events = POLLIN,
+    };
+
+    for (int elapsed = 0; elapsed < duration_ms; elapsed += 10) {
+        if (poll(&pfd, 1, 10) > 0) {
+            ssize_t ret = read(fd, &buf[len], size - len - 1);
+            if (ret > 0) len += ret;
+        }
+    }
+    buf[len] = '\0';
+
+    return len;
+}
+
+static void command(int fd, const char* cmd)
+{
+    char buf[1024];
+
+    write(fd, cmd, strlen(cmd));
+    receive(fd, buf, sizeof(buf), 100);
+    assert(strstr(buf, "OK"));
+}
+
+static int count_str(const char* buf, const char* str)
+{
+    int count = 0;
+    while ((buf = strstr(buf, str)) != NULL) {
+        count++;
+        buf += strlen(str);
+    }
+
+    return count;
+}
+
+static void test_separate(int fd)
+{
+    char buf[1024];
+
+    command(fd, "AT+SUB=\"+TNUM\",250\n");
+    command(fd, "AT+SUB=\"+TSTR\",250\n");
+    receive(fd, buf, sizeof(buf), 600);
+
+    // each response on own line, separator is not escaped, cat escapes backslash in strings
+    assert(strstr(buf, "\n+TNUM=1\n"));
+    assert(strstr(buf, "\n+TSTR=\"a;b\\\\c\"\n"));
+    assert(!strstr(buf, "+TNUM=1;"));
+
+    command(fd, "AT+UNSUB=\"\"\n");
+}
+
+static void test_join(int fd)
+{
+    char buf[1024];
+
+    write(fd, "AT+SUBJOIN?\n", 12);
+    receive(fd, buf, sizeof(buf), 100);
+    assert(strstr(buf, "+SUBJOIN=0"));
+
+    command(fd, "AT+SUBJOIN=1\n");
+    command(fd, "AT+SUB=\"+TNUM\",250\n");
+    command(fd, "AT+SUB=\"+TSTR\",250\n");
+    receive(fd, buf, sizeof(buf), 600);
+
+    // separator in value is escaped
+    assert(strstr(buf, "\n+TSTR=\"a\\;b\\\\c\";+TNUM=1\n"));
+
+    command(fd, "AT+UNSUB=\"\"\n");
+}
+
+static void test_join_overflow(int fd)
+{
+    char buf[2048];
+    char expected[2 * AT_TASK_REPORT_BUF_SIZE];
+
+    memset(long1, '1', LONG_SIZE - 1);
+    memset(long2, '2', LONG_SIZE - 1);
+    memset(long3, '3', LONG_SIZE - 1);
+
+    command(fd, "AT+SUB=\"+TLONG1\",1000\n");
+    command(fd, "AT+SUB=\"+TLONG2\",1000\n");
+    command(fd, "AT+SUB=\"+TLONG3\",1000\n");
+    receive(fd, buf, sizeof(buf), 1100);
+
+    // report buffer is full, last response continues on next line, nothing is truncated
+    snprintf(expected, sizeof(expected), "\n+TLONG3=\"%s\";+TLONG2=\"%s\"\n\n+TLONG1=\"%s\"\n", long3, long2, long1);
+    assert(strstr(buf, expected));
+
+    command(fd, "AT+UNSUB=\"\"\n");
+}
+
+static void test_on_change(int fd)
+{
+    char buf[1024];
+
+    command(fd, "AT+SUB=\"+TNUM\",250,1\n");
+    command(fd, "AT+SUB=\"+TSTR\",250\n");
+    receive(fd, buf, sizeof(buf), 600);
+    assert(count_str(buf, "+TNUM=1") == 0);  // first report was received with OK
+    assert(count_str(buf, "+TSTR=") >= 2);
+
+    num = 2;
+    receive(fd, buf, sizeof(buf), 600);
+    assert(count_str(buf, "+TNUM=2") == 1);
+
+    command(fd, "AT+UNSUB=\"\"\n");
+}
+
+int main(void)
+{
+    assert(serial_port_open(AT_PORT, AT_TASK_RX_BUFFER_SIZE, AT_TASK_RX_SPAN_SIZE, AT_TASK_TX_BUFFER_SIZE) == ESP_OK);
+    at_task_start(AT_PORT);
+
+    int fd = client_open();
+
+    char buf[256];
+    receive(fd, buf, sizeof(buf), 200);
+
+    test_separate(fd);
+    test_join(fd);
+    test_join_overflow(fd);
+    test_on_change(fd);
+
+    close(fd);
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+// static keys table and perfect hash are tested directly
+#include "board_config_parser.c"
+
+/**
+ * Every key must resolve through key_slots, table must be regenerated when keys change
+ */
+
+static uint32_t key_hash(uint32_t seed, const char* key)
+{
+    uint32_t hash = seed;
+    for (const char* c = key; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619;
+    }
+
+    return hash;
+}
+
+/**
+ * Search seed where all keys have distinct slot and print new table
+ */
+static void print_key_slots(void)
+{
+    for (uint32_t seed = 0; seed < UINT32_MAX; seed++) {
+        uint64_t used = 0;
+        cfg_key_t i;
+        for (i = 0; i < KEY_MAX; i++) {
+            uint64_t bit = 1ULL << (key_hash(seed, keys[i]) >> KEY_HASH_SHIFT);
+            if (used & bit) break;
+            used |= bit;
+        }
+        if (i < KEY_MAX) continue;
+
+        printf("#define KEY_HASH_SEED  0x%" PRIX32 "\n\n", seed);
+        printf("static const int8_t key_slots[KEY_HASH_SIZE] = {\n");
+        for (uint32_t slot = 0; slot < KEY_HASH_SIZE; slot++) {
+            for (i = 0; i < KEY_MAX; i++) {
+                if (key_hash(seed, keys[i]) >> KEY_HASH_SHIFT == slot) printf("    [%" PRIu32 "] = %d,  // %s\n", slot, i, keys[i]);
+            }
+        }
+        printf("};\n");
+        return;
+    }
+}
+
+int main(void)
+{
+    bool ok = true;
+    for (cfg_key_t i = 0; ok && i < KEY_MAX; i++) {
+        ok = get_key(keys[i]) == i;
+        if (!ok) fprintf(stderr, "Key %s is not in key_slots\n", keys[i]);
+    }
+
+    if (!ok) {
+        fprintf(stderr, "keys changed, regenerate key_slots in board_config_parser.c:\n");
+        print_key_slots();
+        fflush(stdout);
+    }
+    assert(ok);
+
+    assert(get_key("unknown") == KEY_NONE);
+    assert(get_key("") == KEY_NONE);
+
+    return 0;
+}
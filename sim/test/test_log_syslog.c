@@ -0,0 +1,158 @@
+#include <assert.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <lwip/sockets.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "discovery.h"
+#include "log_syslog.h"
+#include "logger.h"
+#include "wifi.h"
+
+/**
+ * Syslog sink sends datagrams to local listener, records are captured as by logger
+ */
+
+EventGroupHandle_t wifi_event_group = NULL;
+
+void discovery_get_hostname(char* value, size_t value_size)
+{
+    strlcpy(value, "evse", value_size);
+}
+
+static int listener_open(uint16_t* port)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    assert(sock >= 0);
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        .sin_port = 0,
+    };
+    assert(bind(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+
+    socklen_t addr_len = sizeof(addr);
+    assert(getsockname(sock, (struct sockaddr*)&addr, &addr_len) == 0);
+    *port = ntohs(addr.sin_port);
+
+    struct timeval tv = { .tv_sec = 0, .tv_usec = 200000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    return sock;
+}
+
+static int receive(int sock, char* buf, size_t size)
+{
+    int len = recv(sock, buf, size - 1, 0);
+    buf[len > 0 ? len : 0] = '\0';
+
+    return len;
+}
+
+/**
+ * Capture record of esp_log call with tag, or of vprintf without tag, and append it with its line as flush task of logger does
+ */
+static void append(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    log_record_t record;
+    char line[LOGGER_LINE_SIZE];
+
+    va_list l;
+    va_start(l, format);
+    log_record_capture(&record, sizeof(record), level, tag, format, l);
+    va_end(l);
+
+    log_syslog_append(&record, line, log_record_render(&record, line, sizeof(line)));
+}
+
+static void test_rfc5424(int sock, uint16_t port)
+{
+    char buf[1500];
+
+    assert(logger_set_syslog_config(true, "127.0.0.1", port, LOGGER_SYSLOG_FORMAT_RFC5424, 0) == ESP_OK);
+
+    append(ESP_LOG_INFO, "evse", "Enter %s state", "C2");
+    append(ESP_LOG_NONE, NULL, "\033[0;31mE (%lu) %s: Disconnected\nreason %d\033[0m\n", 1240UL, "wifi", 2);
+    append(ESP_LOG_NONE, NULL, "plain line\n");
+
+    // one message per line, level and tag of record, without trailing newline
+    assert(receive(sock, buf, sizeof(buf)) > 0);
+    assert(!strncmp(buf, "<134>1 ", 7));
+    assert(strstr(buf, " evse esp32-evse - evse - Enter C2 state") != NULL);
+    assert(strchr(buf, '\n') == NULL);
+
+    // Log V1 prefix of esp_log_write is stripped
+    assert(receive(sock, buf, sizeof(buf)) > 0);
+    assert(!strncmp(buf, "<131>1 ", 7));
+    assert(strstr(buf, " wifi - Disconnected reason 2") != NULL);
+    assert(strchr(buf, '<') == buf && strrchr(buf, '<') == buf);
+    assert(strstr(buf, "1240") == NULL);
+
+    assert(receive(sock, buf, sizeof(buf)) > 0);
+    assert(!strncmp(buf, "<133>1 ", 7));
+    assert(strstr(buf, " - - plain line") != NULL);
+
+    assert(receive(sock, buf, sizeof(buf)) < 0);
+}
+
+static void test_raw_rate(int sock, uint16_t port)
+{
+    char buf[1500];
+
+    assert(logger_set_syslog_config(true, NULL, port, LOGGER_SYSLOG_FORMAT_RAW, 2) == ESP_OK);
+
+    // each line takes one token
+    append(ESP_LOG_NONE, NULL, "I (%lu) %s: first\n", 1UL, "test");
+    append(ESP_LOG_NONE, NULL, "I (%lu) %s: second\n", 2UL, "test");
+    append(ESP_LOG_INFO, "test", "third");
+
+    assert(receive(sock, buf, sizeof(buf)) > 0);
+    assert(!strcmp(buf, "I (1) test: first\n"));
+    assert(receive(sock, buf, sizeof(buf)) > 0);
+    assert(!strcmp(buf, "I (2) test: second\n"));
+    assert(receive(sock, buf, sizeof(buf)) < 0);
+
+    // count of suppressed messages is sent before next message
+    vTaskDelay(pdMS_TO_TICKS(600));
+    append(ESP_LOG_INFO, "test", "fourth");
+    assert(receive(sock, buf, sizeof(buf)) > 0);
+    assert(!strcmp(buf, "1 messages suppressed by rate limit\n"));
+    assert(receive(sock, buf, sizeof(buf)) > 0);
+    assert(!strncmp(buf, "I (", 3));
+    assert(strstr(buf, ") test: fourth\n") != NULL);
+}
+
+static void test_disabled(int sock, uint16_t port)
+{
+    char buf[1500];
+
+    assert(logger_set_syslog_config(false, NULL, port, LOGGER_SYSLOG_FORMAT_RAW, 0) == ESP_OK);
+    append(ESP_LOG_INFO, "test", "disabled");
+    assert(receive(sock, buf, sizeof(buf)) < 0);
+
+    // host is required
+    assert(logger_set_syslog_config(true, "", port, LOGGER_SYSLOG_FORMAT_RAW, 0) == ESP_ERR_INVALID_ARG);
+}
+
+int main(void)
+{
+    wifi_event_group = xEventGroupCreate();
+    xEventGroupSetBits(wifi_event_group, WIFI_STA_CONNECTED_BIT);
+
+    log_syslog_init();
+
+    uint16_t port;
+    int sock = listener_open(&port);
+
+    test_rfc5424(sock, port);
+    test_raw_rate(sock, port);
+    test_disabled(sock, port);
+
+    close(sock);
+    printf("test_log_syslog: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include <assert.h>
+#include <esp_private/panic_internal.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log_storage.h"
+#include "log_syslog.h"
+#include "logger.h"
+
+/**
+ * Records captured from Log V2 calls, same as ESP_LOGx of firmware, are read back from log buffer
+ */
+
+#define FLUSH_WAIT  300  // flush task period is 100ms
+#define ERROR_WAIT  30   // errors wake flush task
+#define BURST_COUNT 50
+#define LONG_LEN    300
+#define MAX_LINES   64
+
+static const char* TAG = "test";
+
+static char lines[MAX_LINES][LOGGER_LINE_SIZE];
+
+void log_storage_init(void)
+{}
+
+void log_storage_append(const char* str, uint16_t len)
+{}
+
+void log_storage_process(void)
+{}
+
+bool logger_is_storage_enabled(void)
+{
+    return false;
+}
+
+void log_syslog_init(void)
+{}
+
+void log_syslog_append(const log_record_t* record, const char* line, uint16_t len)
+{}
+
+bool logger_is_syslog_enabled(void)
+{
+    return false;
+}
+
+void __real_esp_panic_handler(panic_info_t* info)
+{}
+
+/**
+ * Read lines logged since index, returns count
+ */
+static int read_lines(uint32_t* index, const logger_filter_t* filter)
+{
+    int count = 0;
+    uint16_t len;
+    while (count < MAX_LINES && logger_log_bugger_read(index, filter, lines[count], LOGGER_LINE_SIZE, &len)) {
+        assert(len < LOGGER_LINE_SIZE && lines[count][len] == '\0');
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * Line has esp_log prefix with full system timestamp and expected level, tag and message
+ */
+static void assert_line(const char* line, char level, const char* tag, const char* msg)
+{
+    int year, month, day, hour, min, sec, ms, n = 0;
+    assert(line[0] == level);
+    assert(sscanf(line, "%*c (%4d-%2d-%2d %2d:%2d:%2d.%3d) %n", &year, &month, &day, &hour, &min, &sec, &ms, &n) == 7 && n > 0);
+
+    char expected[LOGGER_LINE_SIZE];
+    snprintf(expected, sizeof(expected), "%s: %s\n", tag, msg);
+    assert(!strcmp(&line[n], expected));
+}
+
+static void test_one_record_per_line(void)
+{
+    uint32_t index = logger_log_buffer_get_count();
+
+    ESP_LOGI(TAG, "value %d of %s", 42, "x");
+    ESP_LOGW("other", "no args");
+    vTaskDelay(pdMS_TO_TICKS(FLUSH_WAIT));
+
+    // prefix, message and new line of Log V2 are one record
+    assert(read_lines(&index, NULL) == 2);
+    assert_line(lines[0], 'I', TAG, "value 42 of x");
+    assert_line(lines[1], 'W', "other", "no args");
+}
+
+static void test_burst(void)
+{
+    uint32_t index = logger_log_buffer_get_count();
+    uint32_t dropped = logger_get_dropped_count();
+
+    for (int i = 0; i < BURST_COUNT; i++) {
+        ESP_LOGI(TAG, "burst %d", i);
+    }
+    vTaskDelay(pdMS_TO_TICKS(FLUSH_WAIT));
+
+    assert(logger_get_dropped_count() == dropped);
+    assert(read_lines(&index, NULL) == BURST_COUNT);
+    for (int i = 0; i < BURST_COUNT; i++) {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "burst %d", i);
+        assert_line(lines[i], 'I', TAG, msg);
+    }
+}
+
+static void test_long_line(void)
+{
+    uint32_t index = logger_log_buffer_get_count();
+
+    char str[LONG_LEN + 1];
+    for (int i = 0; i < LONG_LEN; i++) {
+        str[i] = 'a' + i % 26;
+    }
+    str[LONG_LEN] = '\0';
+
+    // strings not in flash are copied whole, as was line of vprintf
+    ESP_LOGI(TAG, "%s", str);
+    vTaskDelay(pdMS_TO_TICKS(FLUSH_WAIT));
+
+    assert(read_lines(&index, NULL) == 1);
+    assert_line(lines[0], 'I', TAG, str);
+}
+
+static void test_format_not_in_flash(void)
+{
+    uint32_t index = logger_log_buffer_get_count();
+
+    char format[32];
+    strcpy(format, "dynamic %d");
+    esp_log(ESP_LOG_CONFIG_INIT(ESP_LOG_INFO), TAG, format, 7);
+    strcpy(format, "overwritten");
+    vTaskDelay(pdMS_TO_TICKS(FLUSH_WAIT));
+
+    assert(read_lines(&index, NULL) == 1);
+    assert_line(lines[0], 'I', TAG, "dynamic 7");
+}
+
+static void test_log_v1(void)
+{
+    uint32_t index = logger_log_buffer_get_count();
+
+    // precompiled libraries write whole line with prefix through vprintf
+    esp_log_write(ESP_LOG_WARN, "v1", "W (%lu) %s: old style\n", 5UL, "v1");
+    vTaskDelay(pdMS_TO_TICKS(FLUSH_WAIT));
+
+    assert(read_lines(&index, NULL) == 1);
+    assert(!strcmp(lines[0], "W (5) v1: old style\n"));
+}
+
+static void test_error_wake(void)
+{
+    uint32_t index = logger_log_buffer_get_count();
+
+    ESP_LOGE(TAG, "failed");
+    vTaskDelay(pdMS_TO_TICKS(ERROR_WAIT));
+
+    assert(read_lines(&index, NULL) == 1);
+    assert_line(lines[0], 'E', TAG, "failed");
+}
+
+static void test_filter(void)
+{
+    uint32_t index = logger_log_buffer_get_count();
+
+    ESP_LOGI(TAG, "info");
+    ESP_LOGW(TAG, "warning");
+    ESP_LOGE("other", "error");
+    esp_log_write(ESP_LOG_ERROR, "v1", "E (%lu) %s: old style\n", 6UL, "v1");
+    vTaskDelay(pdMS_TO_TICKS(FLUSH_WAIT));
+
+    logger_filter_t filter = {
+        .level = ESP_LOG_WARN,
+        .tag = NULL,
+    };
+    uint32_t i = index;
+    assert(read_lines(&i, &filter) == 3);
+    assert_line(lines[0], 'W', TAG, "warning");
+    assert_line(lines[1], 'E', "other", "error");
+    assert(!strcmp(lines[2], "E (6) v1: old style\n"));
+
+    filter.level = ESP_LOG_VERBOSE;
+    filter.tag = TAG;
+    i = index;
+    assert(read_lines(&i, &filter) == 2);
+    assert_line(lines[0], 'I', TAG, "info");
+    assert_line(lines[1], 'W', TAG, "warning");
+
+    // tag of Log V1 prefix
+    filter.tag = "v1";
+    i = index;
+    assert(read_lines(&i, &filter) == 1);
+
+    // binary records are filtered same, tag and format in flash are references
+    filter.level = ESP_LOG_ERROR;
+    filter.tag = "other";
+    uint8_t data[LOGGER_BINARY_SIZE];
+    uint16_t len;
+    i = index;
+    assert(logger_log_buffer_read_binary(&i, &filter, data, sizeof(data), &len));
+    assert((data[0] & 0x07) == ESP_LOG_ERROR && len < 16);
+    assert(!logger_log_buffer_read_binary(&i, &filter, data, sizeof(data), &len));
+}
+
+static void test_level(void)
+{
+    uint32_t index = logger_log_buffer_get_count();
+
+    ESP_LOGD(TAG, "debug is under default level");
+    vTaskDelay(pdMS_TO_TICKS(FLUSH_WAIT));
+
+    assert(read_lines(&index, NULL) == 0);
+}
+
+int main(void)
+{
+    logger_init();
+
+    test_one_record_per_line();
+    test_burst();
+    test_long_line();
+    test_format_not_in_flash();
+    test_log_v1();
+    test_error_wake();
+    test_filter();
+    test_level();
+
+    printf("test_logger: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "serial_port.h"
+
+/**
+ * Receive span and events of serial port over simulated uart
+ */
+
+#define PORT             UART_NUM_1
+#define PORT_NO_SPAN     UART_NUM_2
+#define RX_BUFFER_SIZE   256
+#define RX_SPAN_SIZE     64
+#define DELIVERY_TIME_US 300000  // reader task of uart polls with 100ms timeout
+
+static int client_open(uart_port_t port)
+{
+    int fd = open(uart_sim_get_tty_name(port), O_RDWR | O_NOCTTY);
+    assert(fd >= 0);
+
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+
+    return fd;
+}
+
+/**
+ * Send data and wait until they are in driver ring buffer
+ */
+static void send(int fd, const void* data, size_t len)
+{
+    assert(write(fd, data, len) == len);
+    usleep(DELIVERY_TIME_US);
+}
+
+static void send_pattern(int fd, uint8_t first, size_t len)
+{
+    uint8_t buf[RX_BUFFER_SIZE];
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = first + i;
+    }
+    send(fd, buf, len);
+}
+
+static void assert_pattern(const uint8_t* data, uint8_t first, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        assert(data[i] == (uint8_t)(first + i));
+    }
+}
+
+static void test_span(int fd)
+{
+    const uint8_t* data;
+
+    send_pattern(fd, 0, 100);
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_DATA);
+
+    // span is limited by its size, rest stays in driver
+    assert(serial_port_read_span(PORT, &data) == RX_SPAN_SIZE);
+    assert_pattern(data, 0, RX_SPAN_SIZE);
+
+    // without consume span is same
+    assert(serial_port_read_span(PORT, &data) == RX_SPAN_SIZE);
+    assert_pattern(data, 0, RX_SPAN_SIZE);
+
+    // partially consumed span is moved to start and filled from driver
+    serial_port_consume(PORT, 10);
+    assert(serial_port_read_span(PORT, &data) == RX_SPAN_SIZE);
+    assert_pattern(data, 10, RX_SPAN_SIZE);
+
+    serial_port_consume(PORT, RX_SPAN_SIZE);
+    assert(serial_port_read_span(PORT, &data) == 100 - 10 - RX_SPAN_SIZE);
+    assert_pattern(data, 10 + RX_SPAN_SIZE, 100 - 10 - RX_SPAN_SIZE);
+
+    // consume is limited by span length
+    serial_port_consume(PORT, RX_BUFFER_SIZE);
+    assert(serial_port_read_span(PORT, &data) == 0);
+}
+
+static void test_stale_events(int fd)
+{
+    const uint8_t* data;
+
+    // each delivery posts data event
+    send(fd, "a", 1);
+    send(fd, "b", 1);
+    send(fd, "c", 1);
+
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_DATA);
+    assert(serial_port_read_span(PORT, &data) == 3);
+    assert(memcmp(data, "abc", 3) == 0);
+
+    // not consumed data in span are not reported, events of read data are dropped
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_NONE);
+    serial_port_consume(PORT, 3);
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_NONE);
+
+    send(fd, "d", 1);
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_DATA);
+    assert(serial_port_read_span(PORT, &data) == 1);
+    serial_port_consume(PORT, 1);
+}
+
+static void test_read(int fd)
+{
+    const uint8_t* data;
+    uint8_t buf[RX_BUFFER_SIZE];
+
+    send_pattern(fd, 0, 100);
+    assert(serial_port_read_span(PORT, &data) == RX_SPAN_SIZE);
+    serial_port_consume(PORT, 20);
+
+    // not consumed span data are read first, then driver ring buffer
+    assert(serial_port_read(PORT, buf, sizeof(buf)) == 80);
+    assert_pattern(buf, 20, 80);
+
+    assert(serial_port_read_span(PORT, &data) == 0);
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_NONE);
+}
+
+static void test_pattern(int fd)
+{
+    const uint8_t* data;
+
+    assert(serial_port_set_pattern(PORT, 0xFF, 3) == ESP_OK);
+
+    send(fd, "msg\xFF\xFF\xFF", 6);
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_PATTERN);
+    assert(serial_port_read_span(PORT, &data) == 6);
+    serial_port_consume(PORT, 6);
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_NONE);
+
+    assert(serial_port_set_pattern(PORT, 0, 0) == ESP_OK);
+}
+
+static void test_overflow(int fd)
+{
+    const uint8_t* data;
+
+    send_pattern(fd, 0, RX_BUFFER_SIZE);
+    send_pattern(fd, 0, 10);
+
+    // received data are dropped
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_OVERFLOW);
+    assert(serial_port_read_span(PORT, &data) == 0);
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_NONE);
+}
+
+static void test_writev(int fd)
+{
+    char buf[32];
+
+    serial_port_iov_t iov[] = {
+        { .data = "ab", .len = 2 },
+        { .data = "", .len = 0 },
+        { .data = "cde", .len = 3 },
+    };
+    assert(serial_port_writev(PORT, iov, sizeof(iov) / sizeof(iov[0])) == 5);
+
+    struct pollfd pfd = {
+        .fd = fd,
+        .events = POLLIN,
+    };
+    size_t len = 0;
+    while (len < 5 && poll(&pfd, 1, 100) > 0) {
+        len += read(fd, &buf[len], sizeof(buf) - len);
+    }
+    assert(len == 5);
+    assert(memcmp(buf, "abcde", 5) == 0);
+}
+
+static void test_no_span(void)
+{
+    const uint8_t* data;
+    uint8_t buf[16];
+
+    int fd = client_open(PORT_NO_SPAN);
+
+    send(fd, "xyz", 3);
+    assert(serial_port_wait(PORT_NO_SPAN, 100) == SERIAL_PORT_EVENT_DATA);
+    assert(serial_port_read_span(PORT_NO_SPAN, &data) == 0);
+    assert(serial_port_read(PORT_NO_SPAN, buf, sizeof(buf)) == 3);
+    assert(memcmp(buf, "xyz", 3) == 0);
+
+    close(fd);
+}
+
+int main(void)
+{
+    assert(serial_port_open(PORT, RX_BUFFER_SIZE, RX_SPAN_SIZE, 0) == ESP_OK);
+    assert(serial_port_open(PORT_NO_SPAN, RX_BUFFER_SIZE, 0, 0) == ESP_OK);
+
+    int fd = client_open(PORT);
+
+    test_span(fd);
+    test_stale_events(fd);
+    test_read(fd);
+    test_pattern(fd);
+    test_overflow(fd);
+    test_writev(fd);
+    test_no_span();
+
+    close(fd);
+
+    assert(serial_port_close(PORT) == ESP_OK);
+    assert(serial_port_close(PORT_NO_SPAN) == ESP_OK);
+
+    // closed port has no data
+    uint8_t buf[16];
+    assert(serial_port_read(PORT, buf, sizeof(buf)) == 0);
+    assert(serial_port_wait(PORT, 100) == SERIAL_PORT_EVENT_NONE);
+
+    return 0;
+}
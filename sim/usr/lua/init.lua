@@ -0,0 +1,23 @@
+-- Script of simulator, component scheduler resumes it on evse state change
+local evse = require("evse")
+
+component.register({
+    id = "sessions",
+    name = "Sessions",
+    description = "Print charging sessions",
+    start = function()
+        return coroutine.create(function()
+            local count = 0
+            local charging = false
+            while true do
+                local state = evse.getstate()
+                if state == evse.STATEC2 and not charging then
+                    count = count + 1
+                    print("charging session " .. count)
+                end
+                charging = state == evse.STATEC2
+                await("evse")
+            end
+        end)
+    end
+})
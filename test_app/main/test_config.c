@@ -1,4 +1,5 @@
 #include <soc/uart_pins.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <unity.h>
 #include <unity_fixture.h>
@@ -7,6 +8,7 @@
 #include "board_config_parser.h"
 
 #define BOARD_YAML "/usr/board.yaml"
+#define BOARD_BIN  "/usr/board.bin"
 
 #ifdef CONFIG_IDF_TARGET_ESP32
 #define DEVICE_NANE       "ESP32 minimal EVSE"
@@ -220,8 +222,33 @@ TEST(config, custom)
     TEST_ASSERT_EQUAL_STRING("https://dzurikmiroslav.github.io/esp32-evse/ota/testing/esp32.json", config.ota.channels[1].path);
 }
 
+TEST(config, cached)
+{
+    remove(BOARD_YAML);
+    remove(BOARD_BIN);
+
+    board_config_load(false);
+    board_cfg_t parsed = board_config;
+
+    struct stat st;
+    TEST_ASSERT_EQUAL(0, stat(BOARD_BIN, &st));
+
+    memset(&board_config, 0, sizeof(board_cfg_t));
+    board_config_load(false);
+    TEST_ASSERT_EQUAL_MEMORY(&parsed, &board_config, sizeof(board_cfg_t));
+
+    // changed yaml is parsed again
+    FILE* file = fopen(BOARD_YAML, "a");
+    fputs("\nbutton:\n  gpio: 7\n", file);
+    fclose(file);
+
+    board_config_load(false);
+    TEST_ASSERT_EQUAL(7, board_config.button.gpio);
+}
+
 TEST_GROUP_RUNNER(config)
 {
     RUN_TEST_CASE(config, custom);
     RUN_TEST_CASE(config, minimal);
+    RUN_TEST_CASE(config, cached);
 }
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unity.h>
+#include <unity_fixture.h>
+
+#include "log_lz.h"
+#include "log_queue.h"
+
+#define LZ_RAW_PATH "/usr/test_lz.log"
+#define LZ_PATH     "/usr/test_lz.lz"
+#define LZ_RAW_SIZE (3 * LOG_LZ_BLOCK_SIZE + 1000)
+#define RECORD_SIZE 120  // with header of entry 128 bytes, ring holds exact count
+#define RECORD_MAX  (offsetof(log_record_t, args) + LOG_RECORD_ARGS_SIZE)
+
+static log_queue_t* queue = NULL;
+
+static void push_sized(int64_t time, size_t size)
+{
+    log_record_t* record = log_queue_reserve(queue, size);
+    TEST_ASSERT_NOT_NULL(record);
+    record->time = time;
+    memset(record->args, (uint8_t)time, size - offsetof(log_record_t, args));
+    log_queue_commit(record);
+}
+
+static void push(int64_t time)
+{
+    push_sized(time, RECORD_SIZE);
+}
+
+typedef struct {
+    char* data;
+    size_t len;
+} lz_output_t;
+
+static esp_err_t lz_read_cb(const char* buf, size_t len, void* ctx)
+{
+    lz_output_t* output = (lz_output_t*)ctx;
+    TEST_ASSERT_LESS_OR_EQUAL(LZ_RAW_SIZE, output->len + len);
+    memcpy(&output->data[output->len], buf, len);
+    output->len += len;
+
+    return ESP_OK;
+}
+
+TEST_GROUP(logger);
+
+TEST_SETUP(logger)
+{
+    queue = (log_queue_t*)malloc(sizeof(log_queue_t));
+    log_queue_init(queue);
+}
+
+TEST_TEAR_DOWN(logger)
+{
+    free((void*)queue);
+    queue = NULL;
+}
+
+TEST(logger, queue_order)
+{
+    TEST_ASSERT_NULL(log_queue_peek(queue));
+
+    push(1);
+    push(2);
+    push(3);
+    TEST_ASSERT_EQUAL(3 * (RECORD_SIZE + 8), log_queue_get_used(queue));
+
+    for (int64_t i = 1; i <= 3; i++) {
+        log_record_t* record = log_queue_peek(queue);
+        TEST_ASSERT_NOT_NULL(record);
+        TEST_ASSERT_EQUAL(i, record->time);
+        log_queue_pop(queue);
+    }
+
+    TEST_ASSERT_NULL(log_queue_peek(queue));
+    TEST_ASSERT_EQUAL(0, log_queue_get_used(queue));
+}
+
+TEST(logger, queue_full)
+{
+    const int count = LOG_QUEUE_SIZE / (RECORD_SIZE + 8);
+
+    // wrap around several times
+    for (int64_t i = 0; i < 3 * count; i++) {
+        push(i);
+        TEST_ASSERT_EQUAL(i, log_queue_peek(queue)->time);
+        log_queue_pop(queue);
+    }
+
+    for (int64_t i = 0; i < count; i++) {
+        push(i);
+    }
+    TEST_ASSERT_NULL(log_queue_reserve(queue, RECORD_SIZE));
+    TEST_ASSERT_NULL(log_queue_reserve(queue, RECORD_SIZE));
+    TEST_ASSERT_EQUAL(2, log_queue_take_dropped(queue));
+    TEST_ASSERT_EQUAL(0, log_queue_take_dropped(queue));
+
+    log_queue_pop(queue);
+    push(count);
+    TEST_ASSERT_EQUAL(LOG_QUEUE_SIZE, log_queue_get_used(queue));
+    TEST_ASSERT_EQUAL(1, log_queue_peek(queue)->time);
+}
+
+TEST(logger, queue_variable)
+{
+    // records of different size wrap with padding, arguments are contiguous
+    int64_t next = 0;
+    for (int64_t i = 0; i < 200; i++) {
+        size_t size = offsetof(log_record_t, args) + (i * 37) % LOG_RECORD_ARGS_SIZE;
+        push_sized(i, size);
+
+        if (i % 3 == 2 || log_queue_get_used(queue) > LOG_QUEUE_SIZE - 2 * (RECORD_MAX + 16)) {
+            while (next <= i) {
+                log_record_t* record = log_queue_peek(queue);
+                TEST_ASSERT_NOT_NULL(record);
+                TEST_ASSERT_EQUAL(next, record->time);
+                size_t args_len = (next * 37) % LOG_RECORD_ARGS_SIZE;
+                for (size_t j = 0; j < args_len; j++) {
+                    TEST_ASSERT_EQUAL_UINT8((uint8_t)next, record->args[j]);
+                }
+                log_queue_pop(queue);
+                next++;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(0, log_queue_take_dropped(queue));
+}
+
+TEST(logger, queue_uncommitted)
+{
+    // reserved but not yet committed record blocks consumer, later records are not visible
+    log_record_t* first = log_queue_reserve(queue, RECORD_SIZE);
+    first->time = 1;
+    push(2);
+    TEST_ASSERT_NULL(log_queue_peek(queue));
+
+    log_queue_commit(first);
+    TEST_ASSERT_EQUAL(1, log_queue_peek(queue)->time);
+    log_queue_pop(queue);
+    TEST_ASSERT_EQUAL(2, log_queue_peek(queue)->time);
+}
+
+TEST(logger, lz_round_trip)
+{
+    char* raw = (char*)malloc(LZ_RAW_SIZE);
+    lz_output_t output = {
+        .data = (char*)malloc(LZ_RAW_SIZE),
+        .len = 0,
+    };
+
+    // log lines followed by not compressible block
+    size_t len = 0;
+    for (int i = 0; len < 2 * LOG_LZ_BLOCK_SIZE; i++) {
+        len += snprintf(&raw[len], LZ_RAW_SIZE - len, "I (%d) test: line %d\n", i * 10, i);
+    }
+    srand(1);
+    while (len < LZ_RAW_SIZE) {
+        raw[len++] = rand();
+    }
+
+    FILE* file = fopen(LZ_RAW_PATH, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL(LZ_RAW_SIZE, fwrite(raw, 1, LZ_RAW_SIZE, file));
+    fclose(file);
+
+    TEST_ASSERT_EQUAL(ESP_OK, log_lz_compress_file(LZ_RAW_PATH, LZ_PATH));
+
+    struct stat st;
+    TEST_ASSERT_EQUAL(0, stat(LZ_PATH, &st));
+    TEST_ASSERT_LESS_THAN(LZ_RAW_SIZE, st.st_size);
+
+    TEST_ASSERT_EQUAL(ESP_OK, log_lz_decompress_file(LZ_PATH, lz_read_cb, &output));
+    TEST_ASSERT_EQUAL(LZ_RAW_SIZE, output.len);
+    TEST_ASSERT_EQUAL_MEMORY(raw, output.data, LZ_RAW_SIZE);
+
+    // truncated file
+    char* compressed = (char*)malloc(st.st_size);
+    file = fopen(LZ_PATH, "r");
+    TEST_ASSERT_EQUAL(st.st_size, fread(compressed, 1, st.st_size, file));
+    fclose(file);
+    file = fopen(LZ_PATH, "w");
+    TEST_ASSERT_EQUAL(st.st_size - 10, fwrite(compressed, 1, st.st_size - 10, file));
+    fclose(file);
+    free((void*)compressed);
+    output.len = 0;
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, log_lz_decompress_file(LZ_PATH, lz_read_cb, &output));
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, log_lz_decompress_file("/usr/not_exists.lz", lz_read_cb, &output));
+
+    remove(LZ_RAW_PATH);
+    remove(LZ_PATH);
+    free((void*)raw);
+    free((void*)output.data);
+}
+
+TEST_GROUP_RUNNER(logger)
+{
+    RUN_TEST_CASE(logger, queue_order);
+    RUN_TEST_CASE(logger, queue_full);
+    RUN_TEST_CASE(logger, queue_variable);
+    RUN_TEST_CASE(logger, queue_uncommitted);
+    RUN_TEST_CASE(logger, lz_round_trip);
+}
@@ -0,0 +1,111 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include <unity_fixture.h>
+
+#include "output_buffer.h"
+
+#define BUFFER_SIZE 256
+
+static output_buffer_t* buffer = NULL;
+
+TEST_GROUP(output_buffer);
+
+TEST_SETUP(output_buffer)
+{
+    buffer = output_buffer_create(BUFFER_SIZE);
+}
+
+TEST_TEAR_DOWN(output_buffer)
+{
+    output_buffer_delete(buffer);
+    buffer = NULL;
+}
+
+TEST(output_buffer, read)
+{
+    uint32_t index = 0;
+    char* str;
+    uint16_t len;
+
+    TEST_ASSERT_FALSE(output_buffer_read(buffer, &index, &str, &len));
+
+    output_buffer_append_str(buffer, "first");
+    output_buffer_append_str(buffer, "second");
+
+    TEST_ASSERT_TRUE(output_buffer_read(buffer, &index, &str, &len));
+    TEST_ASSERT_EQUAL(1, index);
+    TEST_ASSERT_EQUAL(5, len);
+    TEST_ASSERT_EQUAL_STRING_LEN("first", str, len);
+
+    TEST_ASSERT_TRUE(output_buffer_read(buffer, &index, &str, &len));
+    TEST_ASSERT_EQUAL(2, index);
+    TEST_ASSERT_EQUAL_STRING_LEN("second", str, len);
+
+    TEST_ASSERT_FALSE(output_buffer_read(buffer, &index, &str, &len));
+    TEST_ASSERT_EQUAL(2, index);
+
+    // resume from sequence
+    output_buffer_append_str(buffer, "third");
+    TEST_ASSERT_TRUE(output_buffer_read(buffer, &index, &str, &len));
+    TEST_ASSERT_EQUAL(3, index);
+    TEST_ASSERT_EQUAL_STRING_LEN("third", str, len);
+
+    // index after end
+    index = 10;
+    TEST_ASSERT_FALSE(output_buffer_read(buffer, &index, &str, &len));
+    TEST_ASSERT_EQUAL(3, index);
+}
+
+TEST(output_buffer, rotate)
+{
+    char line[32];
+
+    for (int i = 0; i < 1000; i++) {
+        int line_len = snprintf(line, sizeof(line), "line %d %.*s", i, i % 16, "................");
+        output_buffer_append_buf(buffer, line, line_len);
+    }
+
+    TEST_ASSERT_EQUAL(1000, buffer->next);
+    TEST_ASSERT_GREATER_THAN(0, buffer->first);
+
+    // overwritten entries are skipped, sequence continuous
+    uint32_t index = 0;
+    char* str;
+    uint16_t len;
+    uint32_t expected = buffer->first;
+    while (output_buffer_read(buffer, &index, &str, &len)) {
+        int line_len = snprintf(line, sizeof(line), "line %" PRIu32 " %.*s", expected, (int)(expected % 16), "................");
+        TEST_ASSERT_EQUAL(line_len, len);
+        TEST_ASSERT_EQUAL_STRING_LEN(line, str, len);
+        expected++;
+        TEST_ASSERT_EQUAL(expected, index);
+    }
+    TEST_ASSERT_EQUAL(1000, expected);
+}
+
+TEST(output_buffer, long_entry)
+{
+    char line[BUFFER_SIZE * 2];
+    memset(line, 'x', sizeof(line));
+
+    output_buffer_append_str(buffer, "short");
+    output_buffer_append_buf(buffer, line, sizeof(line));
+
+    uint32_t index = 0;
+    char* str;
+    uint16_t len;
+    TEST_ASSERT_TRUE(output_buffer_read(buffer, &index, &str, &len));
+    TEST_ASSERT_EQUAL(2, index);
+    TEST_ASSERT_EQUAL(BUFFER_SIZE - sizeof(uint16_t), len);
+    TEST_ASSERT_FALSE(output_buffer_read(buffer, &index, &str, &len));
+}
+
+TEST_GROUP_RUNNER(output_buffer)
+{
+    RUN_TEST_CASE(output_buffer, read);
+    RUN_TEST_CASE(output_buffer, rotate);
+    RUN_TEST_CASE(output_buffer, long_entry);
+}
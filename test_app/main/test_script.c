@@ -16,6 +16,7 @@
 #include "evse.h"
 #include "l_aux_lib.h"
 #include "l_board_config_lib.h"
+#include "l_bytes_lib.h"
 #include "l_component.h"
 #include "l_energy_meter_lib.h"
 #include "l_evse_lib.h"
@@ -25,10 +26,14 @@
 #include "lua.h"
 #include "lualib.h"
 #include "peripherals_mock.h"
+#include "script_alloc.h"
+#include "script_profiler.h"
 #include "script_utils.h"
 #include "script_watchdog.h"
+#include "topic_trie.h"
 
-#define PARAMS_YAML "/usr/lua/params.yaml"
+#define PARAMS_YAML        "/usr/lua/params.yaml"
+#define PARAMS_EXPORT_YAML "/usr/lua/params_export.yaml"
 
 static lua_State* L = NULL;
 
@@ -49,6 +54,9 @@ TEST_SETUP(script)
     luaL_requiref(L, "component", luaopen_component, 1);
     lua_pop(L, 1);
 
+    luaL_requiref(L, "bytes", luaopen_bytes, 1);
+    lua_pop(L, 1);
+
     luaL_requiref(L, "evse", luaopen_evse, 1);
     lua_pop(L, 1);
 
@@ -172,12 +180,24 @@ TEST(script, watchdog)
     lua_pop(L, 1);
 
     TEST_ASSERT_EQUAL(counter2 + 1000, counter3);
+
+    bool overrun;
+    script_watchdog_start(20);
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "for i = 1,1000 do\ncounter = counter + 1\nend"));
+    script_watchdog_stop(&overrun);
+    TEST_ASSERT_FALSE(overrun);
+
+    script_watchdog_start(20);
+    TEST_ASSERT_NOT_EQUAL(LUA_OK, luaL_dostring(L, "while true do end"));
+    lua_pop(L, 1);
+    TEST_ASSERT_GREATER_OR_EQUAL(20000, script_watchdog_stop(&overrun));
+    TEST_ASSERT_TRUE(overrun);
 }
 
 TEST(script, component)
 {
     // default values
-    remove(PARAMS_YAML);
+    component_params_clear();
 
     luaL_loadbuffer(L, script_lua_start, script_lua_end - script_lua_start, script_lua_start);
     lua_pcall(L, 0, LUA_MULTRET, 0);
@@ -284,11 +304,11 @@ TEST(script, component)
     l_component_resume(L);
     TEST_ASSERT_EQUAL_STRING("loop1", get_global_var("stage"));
 
-    vTaskStepTick(pdMS_TO_TICKS(1100));
+    vTaskDelay(pdMS_TO_TICKS(1100));  // deadlines are in esp timer time
     l_component_resume(L);
     TEST_ASSERT_EQUAL_STRING("loop2", get_global_var("stage"));
 
-    vTaskStepTick(pdMS_TO_TICKS(1100));
+    vTaskDelay(pdMS_TO_TICKS(1100));  // deadlines are in esp timer time
     l_component_resume(L);
     TEST_ASSERT_EQUAL_STRING("loop3", get_global_var("stage"));
 
@@ -298,24 +318,158 @@ TEST(script, component)
     l_component_resume(L);
     TEST_ASSERT_EQUAL_STRING("loop1", get_global_var("stage"));
 
-    vTaskStepTick(pdMS_TO_TICKS(1100));
+    vTaskDelay(pdMS_TO_TICKS(1100));  // deadlines are in esp timer time
     l_component_resume(L);
     TEST_ASSERT_EQUAL_STRING("loop2", get_global_var("stage"));
 
     TEST_ASSERT_EQUAL(0, lua_gettop(L));  // after all Lua stack should be empty
 }
 
+TEST(script, await)
+{
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "stage = 'init'\n"
+                                               "component.register({id = 'await', name = 'Await', start = function()\n"
+                                               "    return coroutine.create(function()\n"
+                                               "        while true do\n"
+                                               "            stage = tostring(await({'evse', 'aux'}))\n"
+                                               "        end\n"
+                                               "    end)\n"
+                                               "end})"));
+    l_component_resume(L);
+    TEST_ASSERT_EQUAL_STRING("init", get_global_var("stage"));
+
+    // without timeout only awaited event resume
+    TEST_ASSERT_TRUE(l_component_resume(L) == INT64_MAX);
+    l_component_notify_event(L, SCRIPT_EVENT_MQTT);
+    l_component_resume(L);
+    TEST_ASSERT_EQUAL_STRING("init", get_global_var("stage"));
+
+    l_component_notify_event(L, SCRIPT_EVENT_AUX);
+    l_component_resume(L);
+    TEST_ASSERT_EQUAL_STRING("aux", get_global_var("stage"));
+
+    l_component_notify_event(L, SCRIPT_EVENT_EVSE);
+    l_component_resume(L);
+    TEST_ASSERT_EQUAL_STRING("evse", get_global_var("stage"));
+
+    TEST_ASSERT_NOT_EQUAL(LUA_OK, luaL_dostring(L, "await('unknown')"));
+    lua_pop(L, 1);
+
+    TEST_ASSERT_EQUAL(0, lua_gettop(L));
+}
+
+TEST(script, alloc)
+{
+    lua_State* state = script_alloc_new_state(0);
+    TEST_ASSERT_NOT_NULL(state);
+    luaL_openlibs(state);
+
+    script_alloc_stats_t stats;
+    TEST_ASSERT_TRUE(script_alloc_get_stats(state, &stats));
+    TEST_ASSERT_EQUAL(lua_gc(state, LUA_GCCOUNT) * 1024 + lua_gc(state, LUA_GCCOUNTB), stats.used);
+    TEST_ASSERT_EQUAL(0, stats.owner_used[1]);
+
+    script_alloc_set_owner(state, 1);
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(state, "t = {} for i = 1, 100 do t[i] = { tostring(i) } end"));
+    script_alloc_set_owner(state, 0);
+
+    TEST_ASSERT_TRUE(script_alloc_get_stats(state, &stats));
+    TEST_ASSERT_EQUAL(lua_gc(state, LUA_GCCOUNT) * 1024 + lua_gc(state, LUA_GCCOUNTB), stats.used);
+    TEST_ASSERT_GREATER_THAN(100 * 16, stats.owner_used[1]);
+    TEST_ASSERT_GREATER_THAN(0, stats.pool_size);
+
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(state, "t = nil collectgarbage()"));
+    TEST_ASSERT_TRUE(script_alloc_get_stats(state, &stats));
+    TEST_ASSERT_LESS_THAN(100 * 16, stats.owner_used[1]);
+
+    script_alloc_set_limit(state, stats.used + 8 * 1024);
+    TEST_ASSERT_NOT_EQUAL(LUA_OK, luaL_dostring(state, "s = string.rep('x', 16 * 1024)"));
+    TEST_ASSERT_EQUAL_STRING("not enough memory", lua_tostring(state, -1));
+    lua_pop(state, 1);
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(state, "s = string.rep('x', 1024)"));
+
+    script_alloc_close(state);
+}
+
+static void topic_trie_sum(int value, void* ctx)
+{
+    *(int*)ctx += value;
+}
+
+static int topic_trie_match_sum(topic_trie_t* trie, const char* topic)
+{
+    int sum = 0;
+    topic_trie_match(trie, topic, strlen(topic), topic_trie_sum, &sum);
+    return sum;
+}
+
+TEST(script, profiler)
+{
+    script_watchdog_init(L);
+    TEST_ASSERT_EQUAL(ESP_OK, script_profiler_start(100));
+
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "function spin()\nlocal x = 0\nfor i = 1,100000 do x = x + i end\nend\nspin()"));
+    script_profiler_stop();
+
+    char buf[640];
+    uint16_t index = 0;
+    bool found = false;
+    while (script_profiler_read(&index, buf, sizeof(buf))) {
+        found |= strstr(buf, "spin (") != NULL;
+    }
+    TEST_ASSERT_TRUE(found);
+
+    script_profiler_clear();
+    index = 0;
+    TEST_ASSERT_FALSE(script_profiler_read(&index, buf, sizeof(buf)));
+}
+
+TEST(script, topic_trie)
+{
+    topic_trie_t* trie = topic_trie_create();
+    int prev_value;
+
+    TEST_ASSERT_TRUE(topic_trie_insert(trie, "a/b/c", 1, &prev_value));
+    TEST_ASSERT_EQUAL(TOPIC_TRIE_NONE, prev_value);
+    TEST_ASSERT_TRUE(topic_trie_insert(trie, "a/+/c", 2, NULL));
+    TEST_ASSERT_TRUE(topic_trie_insert(trie, "a/#", 4, NULL));
+    TEST_ASSERT_TRUE(topic_trie_insert(trie, "+/b", 8, NULL));
+
+    TEST_ASSERT_EQUAL(1 + 2 + 4, topic_trie_match_sum(trie, "a/b/c"));
+    TEST_ASSERT_EQUAL(2 + 4, topic_trie_match_sum(trie, "a/x/c"));
+    TEST_ASSERT_EQUAL(4, topic_trie_match_sum(trie, "a"));
+    TEST_ASSERT_EQUAL(4 + 8, topic_trie_match_sum(trie, "a/b"));
+    TEST_ASSERT_EQUAL(0, topic_trie_match_sum(trie, "b/b/c"));
+
+    TEST_ASSERT_TRUE(topic_trie_insert(trie, "a/b/c", 16, &prev_value));
+    TEST_ASSERT_EQUAL(1, prev_value);
+    TEST_ASSERT_EQUAL(16 + 2 + 4, topic_trie_match_sum(trie, "a/b/c"));
+
+    TEST_ASSERT_EQUAL(4, topic_trie_remove(trie, "a/#"));
+    TEST_ASSERT_EQUAL(TOPIC_TRIE_NONE, topic_trie_remove(trie, "a/x"));
+    TEST_ASSERT_EQUAL(16 + 2, topic_trie_match_sum(trie, "a/b/c"));
+
+    int sum = 0;
+    topic_trie_delete(trie, topic_trie_sum, &sum);
+    TEST_ASSERT_EQUAL(16 + 2 + 8, sum);
+}
+
+static esp_err_t params_export_write(const char* buf, size_t len, void* ctx)
+{
+    return fwrite(buf, 1, len, (FILE*)ctx) == len ? ESP_OK : ESP_FAIL;
+}
+
 TEST(script, component_params)
 {
     component_param_list_t* list;
-    // no params.yaml exist yet
-    remove(PARAMS_YAML);
+    // no params stored yet
+    component_params_clear();
     TEST_ASSERT_NULL(fopen(PARAMS_YAML, "r"));
 
     list = component_params_read("component1");
     TEST_ASSERT_NULL(list);
 
-    // create new params.yaml
+    // store first component
     list = (component_param_list_t*)malloc(sizeof(component_param_list_t));
     SLIST_INIT(list);
     params_insert(list, "component1_key1", "value1");
@@ -349,7 +503,7 @@ TEST(script, component_params)
 
     component_params_free(list);
 
-    // update existing params.yaml, add second component
+    // update stored params, add second component
     list = (component_param_list_t*)malloc(sizeof(component_param_list_t));
     SLIST_INIT(list);
     params_insert(list, "component2_key1", "value1");
@@ -367,7 +521,7 @@ TEST(script, component_params)
     TEST_ASSERT_EQUAL(1, params_get_length(list));
     component_params_free(list);
 
-    // update existing params.yaml, update first component
+    // update stored params, update first component
     list = (component_param_list_t*)malloc(sizeof(component_param_list_t));
     SLIST_INIT(list);
     params_insert(list, "component1_key1", "value1");
@@ -385,7 +539,7 @@ TEST(script, component_params)
     TEST_ASSERT_EQUAL(1, params_get_length(list));
     component_params_free(list);
 
-    // update existing params.yaml, update second component
+    // update stored params, update second component
     list = (component_param_list_t*)malloc(sizeof(component_param_list_t));
     SLIST_INIT(list);
     params_insert(list, "component2_key1", "value1");
@@ -403,7 +557,7 @@ TEST(script, component_params)
     TEST_ASSERT_EQUAL(1, params_get_length(list));
     component_params_free(list);
 
-    // update existing params.yaml, again update second component
+    // update stored params, again update second component
     list = (component_param_list_t*)malloc(sizeof(component_param_list_t));
     SLIST_INIT(list);
     params_insert(list, "component2_key1", "value1");
@@ -420,6 +574,64 @@ TEST(script, component_params)
     TEST_ASSERT_NOT_NULL(list);
     TEST_ASSERT_EQUAL(1, params_get_length(list));
     component_params_free(list);
+
+    // export to params.yaml and import back
+    FILE* file = fopen(PARAMS_EXPORT_YAML, "w");
+    TEST_ASSERT_EQUAL(ESP_OK, component_params_export(params_export_write, file));
+    fclose(file);
+
+    component_params_clear();
+    TEST_ASSERT_NULL(component_params_read("component2"));
+    rename(PARAMS_EXPORT_YAML, PARAMS_YAML);
+
+    list = component_params_read("component1");
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_EQUAL_STRING("component1_key1", SLIST_FIRST(list)->key);
+    TEST_ASSERT_EQUAL_STRING("value1", SLIST_FIRST(list)->value);
+    component_params_free(list);
+
+    list = component_params_read("component2");
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_EQUAL(1, params_get_length(list));
+    component_params_free(list);
+    TEST_ASSERT_NULL(fopen(PARAMS_YAML, "r"));  // consumed by import
+
+    // invalid upload keeps stored params
+    file = fopen(PARAMS_YAML, "w");
+    fputs("component1:\n  component1_key1: [value2\n", file);
+    fclose(file);
+
+    list = component_params_read("component1");
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_EQUAL_STRING("value1", SLIST_FIRST(list)->value);
+    component_params_free(list);
+    TEST_ASSERT_NULL(fopen(PARAMS_YAML, "r"));  // moved to params_invalid.yaml
+}
+
+TEST(script, bytes)
+{
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "b = bytes.new(8)\npos = b:pack(1, '>I2<i4b', 0x1234, -2, -1)"));
+    TEST_ASSERT_EQUAL(8, atoi(get_global_var("pos")));
+
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "s = b:slice(3)\ns[1] = 0x7F\nret = b[1] + b[3]"));
+    TEST_ASSERT_EQUAL(0x12 + 0x7F, atoi(get_global_var("ret")));
+
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "x, y, z = b:unpack(1, '>I2<i4b')\nret = x + y + z"));
+    TEST_ASSERT_EQUAL(0x1234 - 129 - 1, atoi(get_global_var("ret")));  // slice write changed low byte of -2 to 0x7F
+
+    TEST_ASSERT_NOT_EQUAL(LUA_OK, luaL_dostring(L, "b[9] = 1"));
+    lua_pop(L, 1);
+
+    TEST_ASSERT_NOT_EQUAL(LUA_OK, luaL_dostring(L, "b[1] = 256"));
+    lua_pop(L, 1);
+
+    TEST_ASSERT_NOT_EQUAL(LUA_OK, luaL_dostring(L, "b[1] = -1"));
+    lua_pop(L, 1);
+
+    TEST_ASSERT_NOT_EQUAL(LUA_OK, luaL_dostring(L, "bytes.new(math.maxinteger)"));
+    lua_pop(L, 1);
+
+    TEST_ASSERT_EQUAL(0, lua_gettop(L));
 }
 
 TEST(script, evse)
@@ -531,6 +743,9 @@ TEST(script, json)
     TEST_ASSERT_TRUE(lua_istable(L, -1));
     lua_pop(L, 1);
 
+    TEST_ASSERT_NOT_EQUAL(LUA_OK, luaL_dostring(L, "json.encode = nil"));  // read only
+    lua_pop(L, 1);
+
     // encode
 
     TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "ret = json.encode({number1 = 5, string1 = \"str\", boolean1 = true}, false)"));
@@ -582,6 +797,21 @@ TEST(script, json)
 
     lua_pop(L, 1);
 
+    // integer and float, array and object
+
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "ret = json.decode('[1, 1.0, {}, [], \"\\\\u00e9\"]')"));
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "assert(math.type(ret[1]) == 'integer' and math.type(ret[2]) == 'float')"));
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "assert(json.encode(ret) == '[1,1,{},{},\"\\xC3\\xA9\"]')"));
+
+    // null in array, number grammar and long number
+
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "ret = json.decode('[1, null, 3]')\nassert(#ret == 3 and ret[2] == json.null and json.encode(ret) == '[1,null,3]')"));
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "for _, s in ipairs({'+1', '01', '.5', '1.', '1e', '0x10'}) do assert(not pcall(json.decode, s), s) end"));
+    TEST_ASSERT_EQUAL(LUA_OK, luaL_dostring(L, "assert(json.decode('1.' .. string.rep('0', 60) .. '1') == 1.0)"));
+
+    TEST_ASSERT_NOT_EQUAL(LUA_OK, luaL_dostring(L, "json.decode('[1, 2')"));
+    lua_pop(L, 1);
+
     TEST_ASSERT_EQUAL(0, lua_gettop(L));  // after all Lua stack should be empty
 }
 
@@ -589,7 +819,12 @@ TEST_GROUP_RUNNER(script)
 {
     RUN_TEST_CASE(script, watchdog);
     RUN_TEST_CASE(script, component);
+    RUN_TEST_CASE(script, await);
+    RUN_TEST_CASE(script, topic_trie);
+    RUN_TEST_CASE(script, profiler);
+    RUN_TEST_CASE(script, alloc);
     RUN_TEST_CASE(script, component_params);
+    RUN_TEST_CASE(script, bytes);
     RUN_TEST_CASE(script, evse);
     RUN_TEST_CASE(script, energy_meter);
     RUN_TEST_CASE(script, config)
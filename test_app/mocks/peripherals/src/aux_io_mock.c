@@ -13,4 +13,7 @@ esp_err_t aux_write(const char *name, bool value)
 esp_err_t aux_analog_read(const char *name, int *value)
 {
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+void aux_set_input_change_cb(aux_input_change_cb_t cb)
+{}
\ No newline at end of file
@@ -1,5 +1,58 @@
 #include "socket_lock.h"
 
+static bool detection_high = false;
+
+static uint16_t operating_time = 300;
+
+static uint16_t break_time = 1000;
+
+static uint8_t retry_count = 5;
+
+void socket_lock_init(void)
+{}
+
+bool socket_lock_is_detection_high(void)
+{
+    return detection_high;
+}
+
+void socket_lock_set_detection_high(bool _detection_high)
+{
+    detection_high = _detection_high;
+}
+
+uint16_t socket_lock_get_operating_time(void)
+{
+    return operating_time;
+}
+
+esp_err_t socket_lock_set_operating_time(uint16_t _operating_time)
+{
+    operating_time = _operating_time;
+    return ESP_OK;
+}
+
+uint8_t socket_lock_get_retry_count(void)
+{
+    return retry_count;
+}
+
+void socket_lock_set_retry_count(uint8_t _retry_count)
+{
+    retry_count = _retry_count;
+}
+
+uint16_t socket_lock_get_break_time(void)
+{
+    return break_time;
+}
+
+esp_err_t socket_lock_set_break_time(uint16_t _break_time)
+{
+    break_time = _break_time;
+    return ESP_OK;
+}
+
 void socket_lock_set_locked(bool locked)
 {}
 